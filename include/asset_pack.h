@@ -0,0 +1,158 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "http_parser.h"
+#include "http_response.h"
+
+/**
+ * @file asset_pack.h
+ * @brief Pacote de arquivos estáticos pré-compilado e mapeado em memória
+ * @details A ferramenta http_pack compila um diretório em um único arquivo
+ *          com tudo que o servidor calcularia a cada requisição: índice de
+ *          caminhos com hash perfeito, tipo de conteúdo, ETag, versões gzip e
+ *          brotli e o bloco de headers HTTP/1.1 de cada versão. Com
+ *          asset_pack configurado o servidor mapeia o arquivo com mmap na
+ *          inicialização (sem ler os arquivos) e cada busca é uma única
+ *          sondagem na tabela de hash. O corpo é enviado com sendfile a
+ *          partir do descritor do pacote; como as páginas estão no page
+ *          cache, vários processos com o mesmo pacote compartilham a memória.
+ *
+ *          Formato (inteiros na ordem de bytes da máquina que gerou o pacote):
+ *          - asset_pack_header_t
+ *          - asset_pack_entry_t[entry_count], ordenadas por caminho
+ *          - uint32_t[bucket_count]: deslocamento de cada bucket do hash
+ *          - uint32_t[entry_count]: posição do hash -> índice da entrada
+ *          - strings terminadas em nulo (caminhos, tipos, ETags e headers)
+ *          - conteúdo de cada versão, alinhado a ASSET_PACK_ALIGNMENT
+ *
+ *          Hash perfeito (hash and displace): h = asset_pack_hash(caminho,
+ *          seed); o bucket (h % bucket_count) guarda o deslocamento d e a
+ *          posição é asset_pack_slot(h, d) % entry_count. Caminhos fora do
+ *          pacote também caem em alguma posição, por isso o caminho da
+ *          entrada é comparado.
+ */
+
+#define ASSET_PACK_MAGIC "HTTPPACK"
+#define ASSET_PACK_MAGIC_LENGTH 8
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_ALIGNMENT 4096
+
+// Codificações armazenadas para cada arquivo
+typedef enum {
+    ASSET_ENCODING_IDENTITY = 0,
+    ASSET_ENCODING_GZIP,
+    ASSET_ENCODING_BROTLI,
+    ASSET_ENCODING_COUNT
+} asset_encoding_t;
+
+// Cabeçalho do arquivo
+typedef struct {
+    char magic[ASSET_PACK_MAGIC_LENGTH];
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t bucket_count;
+    uint32_t seed;
+    uint64_t entries_offset;
+    uint64_t buckets_offset;
+    uint64_t slots_offset;
+    uint64_t file_size;
+} asset_pack_header_t;
+
+// Uma versão (codificação) do arquivo; header_length 0 indica ausência
+typedef struct {
+    uint64_t offset;              // Conteúdo, alinhado a ASSET_PACK_ALIGNMENT
+    uint64_t length;
+    uint64_t header_offset;       // Status, headers e linha em branco da resposta 200
+    uint64_t etag_offset;         // ETag com aspas
+    uint32_t header_length;
+    uint32_t reserved;
+} asset_pack_variant_t;
+
+// Arquivo do pacote (todos os offsets são relativos ao início do arquivo)
+typedef struct {
+    uint64_t path_offset;         // Caminho normalizado ("/css/site.css")
+    uint64_t content_type_offset;
+    uint32_t path_length;
+    uint32_t reserved;
+    asset_pack_variant_t variants[ASSET_ENCODING_COUNT];
+} asset_pack_entry_t;
+
+/** @brief Pacote aberto pelo servidor */
+typedef struct asset_pack asset_pack_t;
+
+/**
+ * @brief Calcula o hash de um caminho
+ * @details Usado pelo servidor e por http_pack; os 32 bits baixos escolhem o
+ *          bucket e os altos, combinados ao deslocamento, a posição.
+ *
+ * @param data Caminho
+ * @param length Tamanho do caminho
+ * @param seed Semente do pacote
+ * @return Hash de 64 bits
+ */
+uint64_t asset_pack_hash(const char *data, size_t length, uint32_t seed);
+
+/**
+ * @brief Combina o hash de um caminho com o deslocamento do seu bucket
+ * @param hash Resultado de asset_pack_hash
+ * @param displacement Deslocamento do bucket
+ * @return Valor cujo resto por entry_count é a posição da entrada
+ */
+uint32_t asset_pack_slot(uint64_t hash, uint32_t displacement);
+
+/**
+ * @brief Mapeia um pacote gerado por http_pack
+ * @details Valida o cabeçalho e todos os offsets, para que as buscas e
+ *          envios não precisem verificar limites.
+ *
+ * @param path Caminho do arquivo
+ * @return Ponteiro para o pacote, ou NULL em caso de erro
+ */
+asset_pack_t* asset_pack_open(const char *path);
+
+/**
+ * @brief Desfaz o mapeamento e fecha o pacote
+ * @param pack Ponteiro para o pacote
+ */
+void asset_pack_close(asset_pack_t *pack);
+
+/**
+ * @brief Busca um caminho no pacote
+ * @param pack Ponteiro para o pacote (pode ser NULL)
+ * @param path Caminho normalizado da requisição
+ * @return Entrada correspondente, ou NULL se o caminho não está no pacote
+ */
+const asset_pack_entry_t* asset_pack_find(const asset_pack_t *pack, const char *path);
+
+/**
+ * @brief Responde a um GET ou HEAD com um arquivo do pacote
+ * @details Escolhe a versão pelo Accept-Encoding, responde 304 quando
+ *          If-None-Match corresponde à ETag e, caso contrário, envia o header
+ *          pré-formatado e o corpo com sendfile a partir do pacote.
+ *
+ * @param client_socket Socket do cliente
+ * @param pack Ponteiro para o pacote
+ * @param entry Entrada retornada por asset_pack_find
+ * @param request Requisição parseada
+ * @return Código de status enviado, ou -1 em caso de erro de envio
+ */
+int asset_pack_serve(int client_socket, const asset_pack_t *pack, const asset_pack_entry_t *entry,
+                     const http_request_t *request);
+
+/**
+ * @brief Preenche uma resposta com um arquivo do pacote (HTTP/2)
+ * @details O corpo e os headers apontam para o mapeamento, sem cópia, e
+ *          permanecem válidos enquanto o pacote estiver aberto.
+ *
+ * @param pack Ponteiro para o pacote
+ * @param entry Entrada retornada por asset_pack_find
+ * @param request Requisição parseada
+ * @param response Resposta a preencher
+ */
+void asset_pack_response(const asset_pack_t *pack, const asset_pack_entry_t *entry,
+                         const http_request_t *request, http_response_t *response);
+
+#endif // ASSET_PACK_H
@@ -0,0 +1,89 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+/**
+ * @file capture.h
+ * @brief Captura de tráfego para reprodução em testes de carga
+ * @details Com capture_file configurado o servidor grava cada requisição
+ *          HTTP/1.x exatamente como foi recebida (os bytes entregues a
+ *          parse_http_request), junto com o instante relativo ao início da
+ *          captura. O arquivo é lido pela ferramenta http_replay.
+ *
+ *          Os headers não são filtrados: credenciais (Authorization, Cookie)
+ *          ficam no arquivo, criado com permissão 0600.
+ *
+ *          Formato binário (inteiros little-endian):
+ *          - cabeçalho: CAPTURE_MAGIC (8 bytes)
+ *          - registros: instante em microssegundos (8 bytes), tamanho (4 bytes)
+ *            e os bytes da requisição
+ *
+ *          Cada registro é gravado com uma única chamada writev em um arquivo
+ *          aberto com O_APPEND, portanto threads concorrentes não intercalam
+ *          registros, mas podem gravá-los fora de ordem; a leitura os ordena.
+ */
+
+#define CAPTURE_MAGIC "HTTPCAP1"
+#define CAPTURE_MAGIC_LENGTH 8
+#define CAPTURE_RECORD_HEADER 12
+
+/** @brief Estrutura opaca da captura em andamento */
+typedef struct capture capture_t;
+
+// Requisição capturada
+typedef struct {
+    uint64_t timestamp_us;   // Instante relativo ao início da captura
+    const char *data;        // Bytes da requisição (apontam para o blob do trace)
+    size_t length;
+} capture_record_t;
+
+// Arquivo de captura carregado em memória, ordenado por instante
+typedef struct {
+    capture_record_t *records;
+    size_t count;
+    char *blob;              // Conteúdo do arquivo
+} capture_trace_t;
+
+/**
+ * @brief Inicia a captura no arquivo configurado (truncando-o)
+ * @param config Ponteiro para a configuração do servidor
+ * @return Ponteiro para a captura, ou NULL se desabilitada ou em caso de erro
+ */
+capture_t* capture_open(const server_config_t *config);
+
+/**
+ * @brief Encerra a captura e fecha o arquivo
+ * @param capture Ponteiro para a captura
+ */
+void capture_close(capture_t *capture);
+
+/**
+ * @brief Grava uma requisição recebida
+ * @details Ao atingir capture_max_bytes a captura para silenciosamente.
+ *
+ * @param capture Ponteiro para a captura (pode ser NULL)
+ * @param data Bytes recebidos
+ * @param length Quantidade de bytes
+ *
+ * @note Pode ser chamada concorrentemente por qualquer thread
+ */
+void capture_record(capture_t *capture, const char *data, size_t length);
+
+/**
+ * @brief Carrega um arquivo de captura
+ * @param filename Caminho do arquivo
+ * @param trace Estrutura que recebe os registros ordenados por instante
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ */
+int capture_trace_load(const char *filename, capture_trace_t *trace);
+
+/**
+ * @brief Libera um trace carregado
+ * @param trace Ponteiro para o trace
+ */
+void capture_trace_free(capture_trace_t *trace);
+
+#endif // CAPTURE_H
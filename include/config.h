@@ -8,6 +8,50 @@
  *          as configurações do servidor HTTP.
  */
 
+/** @brief Número máximo de rotas de proxy reverso */
+#define MAX_PROXY_ROUTES 8
+
+/** @brief Número máximo de upstreams por rota de proxy */
+#define MAX_PROXY_UPSTREAMS 8
+
+/**
+ * @brief Rota de proxy reverso
+ * @details Requisições cujo caminho começa com o prefixo são encaminhadas
+ *          para um dos upstreams da rota.
+ */
+typedef struct {
+    /** @brief Prefixo do caminho atendido pela rota (ex: "/api/") */
+    char prefix[256];
+
+    /** @brief Upstreams no formato "host:porta" ou "unix:/caminho/do/socket" */
+    char upstreams[MAX_PROXY_UPSTREAMS][256];
+
+    /** @brief Quantidade de upstreams configurados */
+    int upstream_count;
+} proxy_route_config_t;
+
+/** @brief Número máximo de endereços de escuta */
+#define MAX_LISTENERS 8
+
+/**
+ * @brief Endereço de escuta
+ * @details Todos os listeners são atendidos pelas mesmas threads (ou
+ *          corrotinas) de conexão.
+ */
+typedef struct {
+    /** @brief "ipv4:porta", "[ipv6]:porta" ou "unix:/caminho/do/socket" */
+    char address[256];
+
+    /** @brief Conexões passam pelo handshake TLS */
+    int tls;
+
+    /** @brief Em endereços IPv6, não aceita clientes IPv4 (sem dual-stack) */
+    int ipv6_only;
+
+    /** @brief Permissões do arquivo do socket Unix */
+    int mode;
+} listener_config_t;
+
 /**
  * @brief Estrutura que armazena as configurações do servidor
  * @details Contém todos os parâmetros configuráveis do servidor,
@@ -17,6 +61,12 @@ typedef struct {
     /** @brief Porta em que o servidor irá escutar */
     int port;
 
+    /** @brief Endereços de escuta; quando configurados, substituem port e tls_port */
+    listener_config_t listeners[MAX_LISTENERS];
+
+    /** @brief Quantidade de endereços de escuta configurados */
+    int listener_count;
+
     /** @brief Número máximo de conexões simultâneas */
     int max_connections;
     
@@ -37,12 +87,153 @@ typedef struct {
     
     /** @brief Diretório raiz para servir arquivos estáticos */
     char root_directory[256];
+
+    /** @brief Pacote gerado por http_pack servido para GET e HEAD (vazio desabilita) */
+    char asset_pack[256];
     
     /** @brief Flag que indica se o logging está habilitado */
     int logging_enabled;
     
     /** @brief Caminho para o arquivo de log */
     char log_file[256];
+
+    /** @brief Desabilita o algoritmo de Nagle (TCP_NODELAY) nos sockets aceitos */
+    int tcp_nodelay;
+
+    /** @brief Agrupa header e corpo da resposta no mesmo segmento (TCP_CORK/MSG_MORE) */
+    int tcp_cork;
+
+    /** @brief Segundos que o kernel aguarda dados antes de acordar o accept (TCP_DEFER_ACCEPT), 0 desabilita */
+    int tcp_defer_accept;
+
+    /** @brief Tamanho da fila de TCP Fast Open no socket de escuta, 0 desabilita */
+    int tcp_fastopen;
+
+    /** @brief Tamanho do buffer de envio do socket (SO_SNDBUF), 0 mantém o padrão do kernel */
+    int send_buffer_size;
+
+    /** @brief Tamanho do buffer de recepção do socket (SO_RCVBUF), 0 mantém o padrão do kernel */
+    int recv_buffer_size;
+
+    /** @brief Rotas de proxy reverso */
+    proxy_route_config_t proxy_routes[MAX_PROXY_ROUTES];
+
+    /** @brief Quantidade de rotas de proxy configuradas */
+    int proxy_route_count;
+
+    /** @brief Algoritmo de balanceamento: "round_robin" ou "least_conn" */
+    char proxy_balance[32];
+
+    /** @brief Máximo de conexões keep-alive ociosas mantidas por upstream */
+    int proxy_pool_size;
+
+    /** @brief Intervalo entre health checks dos upstreams (em segundos), 0 desabilita */
+    int proxy_health_interval;
+
+    /** @brief Flag que habilita o microcache de respostas dinâmicas */
+    int cache_enabled;
+
+    /** @brief Tempo de vida das respostas em cache (em milissegundos) */
+    int cache_ttl_ms;
+
+    /** @brief Limite de memória ocupada pelo cache (em bytes) */
+    size_t cache_max_bytes;
+
+    /** @brief Headers, separados por vírgula, que compõem a chave do cache */
+    char cache_vary_headers[256];
+
+    /** @brief Flag que habilita HTTP/2 em texto puro (prior knowledge e Upgrade: h2c) */
+    int http2_enabled;
+
+    /** @brief Máximo de streams simultâneos por conexão HTTP/2 */
+    int http2_max_concurrent_streams;
+
+    /** @brief Janela inicial de recepção de cada stream HTTP/2 (em bytes) */
+    int http2_initial_window_size;
+
+    /** @brief Porta do listener HTTPS, 0 desabilita */
+    int tls_port;
+
+    /** @brief Caminho do certificado (PEM, com a cadeia intermediária) */
+    char tls_certificate[256];
+
+    /** @brief Caminho da chave privada (PEM) */
+    char tls_private_key[256];
+
+    /** @brief Máximo de sessões TLS mantidas no cache do servidor */
+    int tls_session_cache_size;
+
+    /** @brief Tempo de vida das sessões e tickets TLS (em segundos) */
+    int tls_session_timeout;
+
+    /** @brief Flag que habilita session tickets */
+    int tls_session_tickets;
+
+    /** @brief Flag que habilita kernel TLS quando suportado pelo kernel */
+    int tls_ktls;
+
+    /** @brief Tamanho máximo de uma mensagem WebSocket remontada (em bytes) */
+    size_t websocket_max_message_size;
+
+    /** @brief Bytes enfileirados para envio acima dos quais um cliente WebSocket lento é desconectado */
+    size_t websocket_max_queue_bytes;
+
+    /** @brief Requisições por segundo permitidas por cliente (0 desabilita) */
+    int rate_limit_requests;
+
+    /** @brief Rajada de requisições acima da taxa média */
+    int rate_limit_request_burst;
+
+    /** @brief Conexões por segundo permitidas por cliente (0 desabilita) */
+    int rate_limit_connections;
+
+    /** @brief Rajada de conexões acima da taxa média */
+    int rate_limit_connection_burst;
+
+    /** @brief Prefixo que agrupa clientes IPv4 em um único bucket (32 = por endereço) */
+    int rate_limit_ipv4_prefix;
+
+    /** @brief Prefixo que agrupa clientes IPv6 em um único bucket */
+    int rate_limit_ipv6_prefix;
+
+    /** @brief Quantidade de buckets da tabela (arredondada para potência de dois) */
+    int rate_limit_table_size;
+
+    /** @brief Arquivo que recebe as requisições capturadas (vazio desabilita) */
+    char capture_file[256];
+
+    /** @brief Tamanho máximo do arquivo de captura (em bytes) */
+    size_t capture_max_bytes;
+
+    /** @brief Duração a partir da qual uma requisição rastreada é gravada (em ms, 0 desabilita) */
+    int trace_slow_ms;
+
+    /** @brief Rastreia uma a cada trace_sample_rate requisições */
+    int trace_sample_rate;
+
+    /** @brief Arquivo que recebe as requisições lentas */
+    char trace_file[256];
+
+    /** @brief Threads que executam as conexões como corrotinas (0 usa uma thread por conexão) */
+    int coroutine_workers;
+
+    /** @brief Tamanho da pilha de cada corrotina (em bytes) */
+    size_t coroutine_stack_size;
+
+    /** @brief Diretório dos arquivos temporários de upload */
+    char upload_directory[256];
+
+    /** @brief Tamanho máximo do corpo de um upload multipart (em bytes) */
+    size_t upload_max_size;
+
+    /** @brief Tamanho máximo de cada parte de um upload (em bytes) */
+    size_t upload_max_part_size;
+
+    /** @brief Limite da fila de envio de uma resposta em streaming (em bytes) */
+    size_t stream_max_queue_bytes;
+
+    /** @brief Espera para agrupar eventos pequenos antes de escrever (em milissegundos, 0 desabilita) */
+    int stream_coalesce_ms;
 } server_config_t;
 
 /**
@@ -80,4 +271,13 @@ void init_default_config(server_config_t *config);
  */
 int validate_config(const server_config_t *config);
 
+/**
+ * @brief Verifica se algum listener atende HTTPS
+ * @details Sem listeners configurados, considera tls_port.
+ *
+ * @param config Ponteiro para a configuração
+ * @return 1 se há listener TLS, 0 caso contrário
+ */
+int config_tls_enabled(const server_config_t *config);
+
 #endif // CONFIG_H
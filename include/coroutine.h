@@ -0,0 +1,163 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <stddef.h>
+#include <poll.h>
+#include <pthread.h>
+
+/**
+ * @file coroutine.h
+ * @brief Corrotinas com pilha própria sobre um loop de eventos por thread
+ * @details Com coroutine_workers configurado, cada conexão é atendida por uma
+ *          corrotina em vez de uma thread. Um pequeno número de threads
+ *          (workers) executa as corrotinas; cada worker tem seu próprio epoll
+ *          e sua fila de temporizadores, e a corrotina fica presa ao worker
+ *          que a recebeu.
+ *
+ *          O código da conexão continua escrito de forma sequencial: os
+ *          sockets ficam em modo não-bloqueante e, ao receber EAGAIN, os
+ *          wrappers de socket_utils.h chamam socket_wait, que registra o
+ *          descritor no epoll do worker e troca de contexto até que ele fique
+ *          pronto ou o timeout do socket expire. Fora de uma corrotina as mesmas
+ *          funções usam poll(), portanto threads comuns continuam funcionando
+ *          com os mesmos sockets.
+ *
+ *          Um descritor é registrado uma única vez no epoll do worker: duas
+ *          corrotinas do mesmo worker não devem aguardar o mesmo descritor ao
+ *          mesmo tempo.
+ *
+ *          As pilhas são alocadas com mmap, têm uma página de guarda no fim e
+ *          são reaproveitadas por um pool em cada worker; apenas as páginas
+ *          efetivamente usadas ocupam memória.
+ *
+ * @note Chamadas que bloqueiam a thread (mutex disputado, pthread_cond_wait,
+ *       leitura de disco) bloqueiam todas as corrotinas do worker; esperas por
+ *       outras threads ou corrotinas devem usar coroutine_cond_t
+ */
+
+/** @brief Estrutura opaca do escalonador */
+typedef struct coroutine_scheduler coroutine_scheduler_t;
+
+/** @brief Corrotina aguardando em uma coroutine_cond_t */
+typedef struct coroutine_waiter coroutine_waiter_t;
+
+/**
+ * @brief Variável de condição que suspende apenas a corrotina que aguarda
+ * @details Threads comuns aguardam na pthread_cond_t; corrotinas entram na
+ *          lista de espera com um eventfd próprio, aguardado com
+ *          coroutine_poll, e o worker continua executando as demais. A lista
+ *          é protegida pelo mutex passado a coroutine_cond_wait, que também
+ *          deve estar travado em coroutine_cond_broadcast.
+ */
+typedef struct {
+    pthread_cond_t cond;
+    coroutine_waiter_t *waiters;
+} coroutine_cond_t;
+
+/** @brief Função executada por uma corrotina */
+typedef void (*coroutine_fn)(void *arg);
+
+/**
+ * @brief Cria o escalonador e inicia as threads dos workers
+ * @param workers Número de threads
+ * @param stack_size Tamanho da pilha de cada corrotina em bytes
+ * @return Ponteiro para o escalonador, ou NULL em caso de erro
+ */
+coroutine_scheduler_t* coroutine_scheduler_create(int workers, size_t stack_size);
+
+/**
+ * @brief Aguarda o fim de todas as corrotinas e encerra os workers
+ * @param scheduler Ponteiro para o escalonador
+ */
+void coroutine_scheduler_destroy(coroutine_scheduler_t *scheduler);
+
+/**
+ * @brief Cria uma corrotina em um dos workers (distribuição circular)
+ * @param scheduler Ponteiro para o escalonador
+ * @param fn Função a executar
+ * @param arg Argumento passado à função
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ *
+ * @note Pode ser chamada de qualquer thread
+ */
+int coroutine_spawn(coroutine_scheduler_t *scheduler, coroutine_fn fn, void *arg);
+
+/**
+ * @brief Cria uma corrotina no mesmo worker da corrotina atual
+ * @details Corrotinas que dividem estado (ex: streams HTTP/2 e sua conexão)
+ *          nunca executam em paralelo quando estão no mesmo worker.
+ *
+ * @param fn Função a executar
+ * @param arg Argumento passado à função
+ * @return 0 em caso de sucesso, -1 fora de uma corrotina ou em caso de erro
+ */
+int coroutine_spawn_local(coroutine_fn fn, void *arg);
+
+/**
+ * @brief Verifica se o código está executando dentro de uma corrotina
+ * @return 1 dentro de uma corrotina, 0 em uma thread comum
+ */
+int coroutine_active(void);
+
+/**
+ * @brief Identifica a corrotina em execução
+ * @details Junto com pthread_self() distingue o contexto atual: corrotinas do
+ *          mesmo worker compartilham a thread.
+ * @return Ponteiro opaco da corrotina, ou NULL em uma thread comum
+ */
+void* coroutine_self(void);
+
+/**
+ * @brief Equivalente a poll() que suspende apenas a corrotina atual
+ * @details Fora de uma corrotina chama poll() diretamente.
+ *
+ * @param fds Descritores e eventos aguardados (POLLIN, POLLOUT)
+ * @param nfds Quantidade de descritores
+ * @param timeout_ms Timeout em milissegundos (-1 aguarda indefinidamente)
+ * @return Quantidade de descritores prontos, 0 no timeout, -1 em caso de erro
+ */
+int coroutine_poll(struct pollfd *fds, nfds_t nfds, int timeout_ms);
+
+/**
+ * @brief Suspende a corrotina atual (ou a thread) pelo tempo indicado
+ * @param ms Tempo em milissegundos
+ */
+void coroutine_sleep(int ms);
+
+/**
+ * @brief Inicializa uma variável de condição
+ * @param cond Ponteiro para a variável
+ */
+void coroutine_cond_init(coroutine_cond_t *cond);
+
+/**
+ * @brief Libera uma variável de condição sem esperas pendentes
+ * @param cond Ponteiro para a variável
+ */
+void coroutine_cond_destroy(coroutine_cond_t *cond);
+
+/**
+ * @brief Libera o mutex, aguarda um broadcast e trava o mutex novamente
+ * @details Como em pthread_cond_wait, o retorno não garante que a condição
+ *          aguardada seja verdadeira: o chamador deve verificá-la em um laço.
+ *          Dentro de uma corrotina suspende só a corrotina.
+ *
+ * @param cond Ponteiro para a variável
+ * @param mutex Mutex travado pelo chamador
+ */
+void coroutine_cond_wait(coroutine_cond_t *cond, pthread_mutex_t *mutex);
+
+/**
+ * @brief Acorda todas as threads e corrotinas em espera
+ * @param cond Ponteiro para a variável
+ * @note O chamador deve possuir o mutex usado pelas esperas
+ */
+void coroutine_cond_broadcast(coroutine_cond_t *cond);
+
+/**
+ * @brief Devolve o worker às demais corrotinas prontas
+ * @details Útil em laços longos de CPU. Fora de uma corrotina chama sched_yield().
+ */
+void coroutine_yield(void);
+
+#endif // COROUTINE_H
@@ -0,0 +1,144 @@
+#ifndef HPACK_H
+#define HPACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file hpack.h
+ * @brief Compressão de headers HPACK (RFC 7541) para HTTP/2
+ * @details Implementa o decodificador e o codificador de blocos de headers,
+ *          com tabela estática, tabela dinâmica e codificação Huffman.
+ */
+
+// Códigos de retorno do HPACK
+typedef enum {
+    HPACK_OK = 0,
+    HPACK_ERROR = -1,        // Bloco de headers malformado (COMPRESSION_ERROR)
+    HPACK_MEMORY_ERROR = -2,
+    HPACK_BUFFER_FULL = -3   // Buffer de saída insuficiente
+} hpack_error_t;
+
+// Opções de indexação de um header codificado
+typedef enum {
+    HPACK_INDEX = 0,         // Insere o header na tabela dinâmica
+    HPACK_NO_INDEX = 1,      // Literal sem indexação (valores que mudam a cada resposta)
+    HPACK_NEVER_INDEX = 2    // Literal nunca indexado (valores sensíveis)
+} hpack_index_mode_t;
+
+// Entrada da tabela dinâmica
+typedef struct {
+    char *name;
+    size_t name_length;
+    char *value;
+    size_t value_length;
+} hpack_entry_t;
+
+// Tabela dinâmica (buffer circular, entrada mais recente primeiro)
+typedef struct {
+    hpack_entry_t *entries;
+    size_t capacity;         // Entradas alocadas
+    size_t count;            // Entradas em uso
+    size_t head;             // Posição da entrada mais recente
+    size_t size;             // Tamanho conforme a RFC (nome + valor + 32 por entrada)
+    size_t max_size;         // Tamanho máximo atual
+} hpack_table_t;
+
+// Estado do decodificador
+typedef struct {
+    hpack_table_t table;
+    size_t settings_max_size; // Limite anunciado em SETTINGS_HEADER_TABLE_SIZE
+    char *scratch[2];         // Buffers para strings decodificadas com Huffman
+    size_t scratch_size[2];
+} hpack_decoder_t;
+
+// Estado do codificador
+typedef struct {
+    hpack_table_t table;
+    size_t pending_max_size;  // Novo limite a ser sinalizado no próximo bloco
+    int size_update_pending;
+} hpack_encoder_t;
+
+/**
+ * @brief Função chamada para cada header decodificado
+ * @details Nome e valor não são terminados em nulo e só são válidos durante a chamada.
+ * @return 0 para continuar, valor negativo para abortar a decodificação
+ */
+typedef int (*hpack_header_cb)(void *ctx, const char *name, size_t name_length,
+                               const char *value, size_t value_length);
+
+/**
+ * @brief Inicializa o decodificador
+ * @param decoder Ponteiro para o decodificador
+ * @param max_size Tamanho máximo da tabela dinâmica (SETTINGS_HEADER_TABLE_SIZE)
+ */
+void hpack_decoder_init(hpack_decoder_t *decoder, size_t max_size);
+
+/**
+ * @brief Libera os recursos do decodificador
+ * @param decoder Ponteiro para o decodificador
+ */
+void hpack_decoder_cleanup(hpack_decoder_t *decoder);
+
+/**
+ * @brief Decodifica um bloco de headers completo
+ * @param decoder Ponteiro para o decodificador
+ * @param block Bloco de headers (HEADERS + CONTINUATION concatenados)
+ * @param length Tamanho do bloco
+ * @param callback Função chamada para cada header
+ * @param ctx Contexto repassado ao callback
+ * @return HPACK_OK em caso de sucesso, ou código de erro
+ *
+ * @note Mesmo quando o stream é recusado o bloco deve ser decodificado para
+ *       manter a tabela dinâmica sincronizada com o cliente
+ */
+int hpack_decode(hpack_decoder_t *decoder, const uint8_t *block, size_t length,
+                 hpack_header_cb callback, void *ctx);
+
+/**
+ * @brief Inicializa o codificador
+ * @param encoder Ponteiro para o codificador
+ * @param max_size Tamanho máximo da tabela dinâmica
+ */
+void hpack_encoder_init(hpack_encoder_t *encoder, size_t max_size);
+
+/**
+ * @brief Libera os recursos do codificador
+ * @param encoder Ponteiro para o codificador
+ */
+void hpack_encoder_cleanup(hpack_encoder_t *encoder);
+
+/**
+ * @brief Aplica o SETTINGS_HEADER_TABLE_SIZE anunciado pelo cliente
+ * @details A mudança é sinalizada no início do próximo bloco codificado.
+ * @param encoder Ponteiro para o codificador
+ * @param max_size Novo tamanho máximo
+ */
+void hpack_encoder_set_max_size(hpack_encoder_t *encoder, size_t max_size);
+
+/**
+ * @brief Inicia um bloco de headers, emitindo atualizações de tamanho pendentes
+ * @param encoder Ponteiro para o codificador
+ * @param out Buffer de saída
+ * @param capacity Tamanho do buffer
+ * @return Bytes escritos, ou valor negativo em caso de erro
+ */
+int hpack_encode_begin(hpack_encoder_t *encoder, uint8_t *out, size_t capacity);
+
+/**
+ * @brief Codifica um header
+ * @details Usa a representação indexada quando o par já está em uma das
+ *          tabelas e Huffman quando reduz o tamanho da string.
+ *
+ * @param encoder Ponteiro para o codificador
+ * @param out Buffer de saída
+ * @param capacity Espaço disponível no buffer
+ * @param name Nome do header (em minúsculas)
+ * @param value Valor do header
+ * @param mode Modo de indexação
+ * @return Bytes escritos, ou valor negativo em caso de erro
+ */
+int hpack_encode_header(hpack_encoder_t *encoder, uint8_t *out, size_t capacity,
+                        const char *name, const char *value, hpack_index_mode_t mode);
+
+#endif // HPACK_H
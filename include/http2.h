@@ -0,0 +1,70 @@
+#ifndef HTTP2_H
+#define HTTP2_H
+
+#include <stddef.h>
+#include "config.h"
+#include "http_parser.h"
+#include "http_response.h"
+
+/**
+ * @file http2.h
+ * @brief HTTP/2 em texto puro (h2c)
+ * @details Atende conexões HTTP/2 iniciadas com conhecimento prévio (prefácio
+ *          "PRI * HTTP/2.0") ou por Upgrade a partir de uma requisição HTTP/1.1.
+ *          Cada stream completo é despachado em uma thread própria (ou, com
+ *          coroutine_workers, em uma corrotina no worker da conexão), de modo
+ *          que uma única conexão carrega muitas requisições simultâneas; as
+ *          respostas respeitam o controle de fluxo por stream e por conexão.
+ *          Os streams apenas enfileiram frames: só o laço da conexão escreve
+ *          no socket.
+ *          Na recepção, DATA além da janela anunciada é rejeitado com
+ *          FLOW_CONTROL_ERROR, a janela é devolvida à medida que os corpos são
+ *          copiados e a memória dos corpos de uma conexão é limitada (acima
+ *          do limite a requisição recebe 413).
+ */
+
+/**
+ * @brief Função que gera a resposta de um stream
+ * @param ctx Contexto informado em http2_serve_connection()
+ * @param request Requisição montada a partir dos headers e DATA do stream
+ * @param response Resposta a ser preenchida
+ */
+typedef void (*http2_dispatch_fn)(void *ctx, const http_request_t *request, http_response_t *response);
+
+/**
+ * @brief Verifica se os dados recebidos começam com o prefácio do cliente HTTP/2
+ * @param data Dados recebidos
+ * @param length Quantidade de bytes
+ * @return 1 se os dados são (o início de) um prefácio HTTP/2, 0 caso contrário
+ */
+int http2_is_preface(const char *data, size_t length);
+
+/**
+ * @brief Verifica se uma requisição HTTP/1.1 pede upgrade para h2c
+ * @details Exige "Upgrade: h2c", o header HTTP2-Settings e ausência de corpo.
+ * @param request Requisição parseada
+ * @return 1 se o upgrade deve ser feito, 0 caso contrário
+ */
+int http2_is_upgrade_request(const http_request_t *request);
+
+/**
+ * @brief Atende uma conexão HTTP/2 até o cliente encerrá-la
+ * @details Envia o prefácio do servidor, processa os frames recebidos e
+ *          despacha os streams. Em um upgrade responde 101 e trata a requisição
+ *          original como o stream 1.
+ *
+ * @param client_socket Socket do cliente
+ * @param config Ponteiro para a configuração do servidor
+ * @param initial Bytes já recebidos que pertencem à conexão HTTP/2
+ * @param initial_length Quantidade de bytes em initial
+ * @param upgrade_request Requisição HTTP/1.1 de upgrade, ou NULL com conhecimento prévio
+ * @param dispatch Função que gera as respostas
+ * @param ctx Contexto repassado a dispatch
+ * @return 0 em encerramento normal, -1 em caso de erro de protocolo ou de I/O
+ */
+int http2_serve_connection(int client_socket, const server_config_t *config,
+                           const char *initial, size_t initial_length,
+                           const http_request_t *upgrade_request,
+                           http2_dispatch_fn dispatch, void *ctx);
+
+#endif // HTTP2_H
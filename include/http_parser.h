@@ -2,6 +2,7 @@
 #define HTTP_PARSER_H
 
 #include <stddef.h>
+#include <sys/types.h>
 
 // Códigos de erro do parser
 typedef enum {
@@ -25,15 +26,52 @@ typedef struct {
 // Estrutura principal da requisição HTTP
 typedef struct {
     char method[16];          // Método HTTP (GET, POST, etc)
-    char path[1024];         // Caminho requisitado
+    char path[1024];         // Alvo da requisição como recebido (com query string)
+    char normalized_path[1024]; // Caminho decodificado, sem segmentos "." e "..", sem query string
+    size_t query_offset;     // Início da query string em path (após o '?')
+    size_t query_length;     // Tamanho da query string (0 se ausente)
     char version[16];        // Versão do protocolo (HTTP/1.1)
     http_header_t *headers;  // Array de headers
     size_t header_count;     // Quantidade atual de headers
     size_t max_headers;      // Quantidade máxima de headers
     char *body;             // Corpo da requisição (se houver)
     size_t body_length;     // Tamanho do corpo
+    size_t header_length;   // Bytes da linha de requisição + headers (início do corpo nos dados brutos)
+    int borrow_body;        // Se não-zero, o corpo aponta para os dados brutos em vez de ser copiado
 } http_request_t;
 
+// Fatia de texto sem terminação em nulo, apontando para dados de outra estrutura
+typedef struct {
+    const char *data;
+    size_t length;
+} http_string_view_t;
+
+// Visão somente leitura de uma requisição, sem cópias dos dados
+typedef struct {
+    http_string_view_t method;
+    http_string_view_t path;            // Alvo como recebido
+    http_string_view_t normalized_path; // Caminho usado no roteamento
+    http_string_view_t query;           // Query string sem o '?', ainda codificada
+    http_string_view_t version;
+    const http_header_t *headers;
+    size_t header_count;
+    http_string_view_t body;
+    const http_request_t *request; // Requisição completa de origem
+} http_request_view_t;
+
+// Parâmetro da query string; nome e valor apontam para a requisição e continuam codificados
+typedef struct {
+    http_string_view_t name;
+    http_string_view_t value;
+    int encoded;              // Se não-zero, nome ou valor contém '%' ou '+' e requer http_url_decode
+} http_query_param_t;
+
+// Posição da iteração sobre os parâmetros de uma query string
+typedef struct {
+    const char *next;
+    const char *end;
+} http_query_iterator_t;
+
 /**
  * @brief Inicializa uma estrutura de requisição HTTP
  * @param request Ponteiro para a estrutura a ser inicializada
@@ -83,4 +121,76 @@ const http_header_t* http_request_get_header(const http_request_t *request, cons
  */
 int http_request_set_body(http_request_t *request, const char *body, size_t length);
 
+/**
+ * @brief Cria uma visão da requisição sem copiar seus dados
+ * @details A visão aponta para os campos da requisição (e, com borrow_body,
+ *          para o buffer de recepção) e só é válida enquanto eles existirem.
+ * @param view Ponteiro para a visão a ser preenchida
+ * @param request Requisição de origem
+ */
+void http_request_view_init(http_request_view_t *view, const http_request_t *request);
+
+/**
+ * @brief Busca o valor de um header a partir de uma visão da requisição
+ * @param view Visão da requisição
+ * @param name Nome do header (sem diferenciar maiúsculas e minúsculas)
+ * @param value Recebe o valor do header
+ * @return 1 se o header foi encontrado, 0 caso contrário
+ */
+int http_request_view_header(const http_request_view_t *view, const char *name, http_string_view_t *value);
+
+/**
+ * @brief Decodifica o alvo da requisição em normalized_path e localiza a query string
+ * @details Decodifica sequências %XX (apenas quando há '%' no caminho; do
+ *          contrário o caminho é copiado diretamente), remove segmentos "." e
+ *          "..", e junta barras repetidas. O resultado sempre começa com '/',
+ *          portanto pode ser concatenado a root_directory sem sair dele.
+ *          Chamada por parse_http_request; quem preenche path diretamente
+ *          (ex: HTTP/2) deve chamá-la em seguida.
+ *
+ * @param request Ponteiro para a requisição com path preenchido
+ * @return HTTP_PARSE_OK, ou HTTP_PARSE_INVALID_PATH se o caminho não começa
+ *         com '/', contém escape inválido ou %00, ou sobe acima da raiz
+ */
+int http_request_normalize_path(http_request_t *request);
+
+/**
+ * @brief Decodifica sequências %XX de um trecho de URL
+ * @param src Texto codificado
+ * @param length Tamanho do texto
+ * @param dst Buffer de destino (pode ser igual a src)
+ * @param dst_size Tamanho do buffer, incluindo o terminador nulo
+ * @param plus_as_space Se não-zero, '+' vira espaço (query strings)
+ * @return Tamanho do texto decodificado, ou -1 se o escape é inválido,
+ *         decodifica para um byte nulo ou o buffer é pequeno demais
+ */
+ssize_t http_url_decode(const char *src, size_t length, char *dst, size_t dst_size, int plus_as_space);
+
+/**
+ * @brief Inicia a iteração sobre os parâmetros de uma query string
+ * @param iterator Ponteiro para o iterador
+ * @param query Query string (ex: view->query)
+ */
+void http_query_iterator_init(http_query_iterator_t *iterator, http_string_view_t query);
+
+/**
+ * @brief Avança para o próximo parâmetro sem copiar dados
+ * @details Pares vazios ("a=1&&b=2") são ignorados; um parâmetro sem '='
+ *          tem valor vazio.
+ *
+ * @param iterator Ponteiro para o iterador
+ * @param param Recebe o parâmetro
+ * @return 1 se um parâmetro foi lido, 0 no fim da query string
+ */
+int http_query_next(http_query_iterator_t *iterator, http_query_param_t *param);
+
+/**
+ * @brief Busca o primeiro parâmetro da query string com o nome indicado
+ * @param view Visão da requisição
+ * @param name Nome do parâmetro (comparado sem decodificar)
+ * @param value Recebe o valor, ainda codificado
+ * @return 1 se o parâmetro foi encontrado, 0 caso contrário
+ */
+int http_request_view_query(const http_request_view_t *view, const char *name, http_string_view_t *value);
+
 #endif // HTTP_PARSER_H
@@ -0,0 +1,155 @@
+#ifndef HTTP_RESPONSE_H
+#define HTTP_RESPONSE_H
+
+#include <stddef.h>
+#include "config.h"
+
+/**
+ * @file http_response.h
+ * @brief Construção e envio de respostas HTTP
+ * @details Separa a geração da resposta (status, tipo de conteúdo e corpo)
+ *          do envio pelo socket, permitindo que a resposta seja serializada
+ *          em um único buffer (por exemplo, para o cache de respostas).
+ */
+
+// Número máximo de headers adicionais em uma resposta
+#define HTTP_RESPONSE_MAX_HEADERS 16
+
+// Função que libera um corpo cuja posse foi transferida para a resposta
+typedef void (*http_body_free_fn)(void *body);
+
+// Header adicional da resposta (nome e valor não são copiados)
+typedef struct {
+    const char *name;
+    const char *value;
+} http_response_header_t;
+
+// Estrutura de uma resposta HTTP
+typedef struct {
+    int status_code;          // Código de status (ex: 200)
+    const char *status_text;  // Texto do status (ex: "OK")
+    const char *content_type; // Tipo do conteúdo (ex: "text/html")
+    const char *body;         // Corpo da resposta (pode ser NULL)
+    size_t body_length;       // Tamanho do corpo
+    http_body_free_fn body_free; // Se definido, libera o corpo em http_response_cleanup
+    int omit_body;            // Resposta a HEAD: Content-Length do corpo, sem enviá-lo
+    http_response_header_t headers[HTTP_RESPONSE_MAX_HEADERS]; // Headers adicionais
+    size_t header_count;      // Quantidade de headers adicionais
+} http_response_t;
+
+/**
+ * @brief Inicializa uma resposta vazia (200 OK, text/plain, sem corpo)
+ * @param response Ponteiro para a resposta
+ */
+void http_response_init(http_response_t *response);
+
+/**
+ * @brief Libera os recursos da resposta
+ * @param response Ponteiro para a resposta
+ */
+void http_response_cleanup(http_response_t *response);
+
+/**
+ * @brief Define status, tipo de conteúdo e corpo de uma resposta
+ * @details O corpo não é copiado: deve permanecer válido até o envio da resposta.
+ *
+ * @param response Ponteiro para a resposta
+ * @param status_code Código de status HTTP
+ * @param status_text Texto do status
+ * @param content_type Tipo do conteúdo
+ * @param body Corpo terminado em nulo (pode ser NULL)
+ */
+void http_response_set(http_response_t *response, int status_code, const char *status_text,
+                       const char *content_type, const char *body);
+
+/**
+ * @brief Define o código de status da resposta
+ * @param response Ponteiro para a resposta
+ * @param status_code Código de status HTTP
+ * @param status_text Texto do status, ou NULL para o texto padrão do código
+ */
+void http_response_set_status(http_response_t *response, int status_code, const char *status_text);
+
+/**
+ * @brief Define um corpo emprestado, que não é copiado nem liberado
+ * @details O corpo deve permanecer válido até o envio da resposta.
+ *
+ * @param response Ponteiro para a resposta
+ * @param body Dados do corpo
+ * @param length Tamanho do corpo
+ */
+void http_response_set_body(http_response_t *response, const void *body, size_t length);
+
+/**
+ * @brief Transfere a posse de um corpo para a resposta
+ * @details O servidor envia o buffer sem copiá-lo e o libera com free_fn
+ *          após o envio.
+ *
+ * @param response Ponteiro para a resposta
+ * @param body Buffer do corpo
+ * @param length Tamanho do corpo
+ * @param free_fn Função que libera o buffer (ex: free)
+ */
+void http_response_take_body(http_response_t *response, void *body, size_t length, http_body_free_fn free_fn);
+
+/**
+ * @brief Adiciona um header à resposta
+ * @details Nome e valor não são copiados e devem permanecer válidos até o envio.
+ *
+ * @param response Ponteiro para a resposta
+ * @param name Nome do header
+ * @param value Valor do header
+ * @return 0 em caso de sucesso, -1 se o limite de headers foi atingido
+ */
+int http_response_add_header(http_response_t *response, const char *name, const char *value);
+
+/**
+ * @brief Retorna o texto padrão de um código de status HTTP
+ * @param status_code Código de status
+ * @return Texto do status (ex: "Not Found"), ou "Unknown" se desconhecido
+ */
+const char* http_status_text(int status_code);
+
+/**
+ * @brief Escreve a linha de status e os headers da resposta em um buffer
+ * @param response Ponteiro para a resposta
+ * @param buffer Buffer de destino
+ * @param size Tamanho do buffer
+ * @return Quantidade de bytes escritos, ou 0 se o buffer for pequeno demais
+ */
+size_t http_response_format_header(const http_response_t *response, char *buffer, size_t size);
+
+/**
+ * @brief Serializa a resposta completa (headers e corpo) em um novo buffer
+ * @details Com omit_body o buffer contém apenas os headers.
+ *
+ * @param response Ponteiro para a resposta
+ * @param length Recebe o tamanho do buffer gerado
+ * @return Buffer alocado com malloc (liberado pelo chamador), ou NULL em caso de erro
+ */
+char* http_response_serialize(const http_response_t *response, size_t *length);
+
+/**
+ * @brief Envia a resposta pelo socket
+ * @details Envia header e corpo em um único sendmsg; com omit_body (HEAD)
+ *          apenas o header, com o Content-Length do corpo. Com tcp_cork na
+ *          configuração, TCP_CORK fica ativo durante o envio, de modo que um
+ *          corpo grande sai apenas em segmentos cheios.
+ *
+ * @param client_socket Socket do cliente
+ * @param config Ponteiro para a configuração do servidor
+ * @param response Ponteiro para a resposta
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ */
+int http_response_send(int client_socket, const server_config_t *config, const http_response_t *response);
+
+/**
+ * @brief Envia um buffer inteiro pelo socket, repetindo em envios parciais
+ * @param client_socket Socket de destino
+ * @param data Dados a enviar
+ * @param length Quantidade de bytes
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ */
+int http_send_all(int client_socket, const char *data, size_t length);
+
+#endif // HTTP_RESPONSE_H
@@ -0,0 +1,213 @@
+#ifndef HTTP_STREAM_H
+#define HTTP_STREAM_H
+
+#include <stddef.h>
+#include "config.h"
+#include "http_parser.h"
+#include "send_queue.h"
+
+/**
+ * @file http_stream.h
+ * @brief Respostas em streaming: Server-Sent Events e Transfer-Encoding chunked
+ * @details A resposta fica aberta e a aplicação envia pedaços (chunks) a
+ *          qualquer momento, de qualquer thread. Como nas conexões WebSocket,
+ *          os envios vão para uma fila (send_queue.h) escrita pela thread (ou
+ *          corrotina) da conexão, que junta os pedaços pendentes em um único
+ *          sendmsg.
+ *
+ *          Cada chunk é serializado uma única vez, já com o enquadramento
+ *          chunked, em um http_stream_chunk_t com contagem de referências; o
+ *          mesmo buffer pode ser enfileirado em muitas conexões
+ *          (http_stream_group_broadcast). Para clientes HTTP/1.0 o
+ *          enquadramento é omitido e o fim da resposta é o fechamento.
+ *
+ *          Contrapressão: http_stream_send descarta a conexão cuja fila passa
+ *          de stream_max_queue_bytes (cliente lento), enquanto
+ *          http_stream_write suspende o produtor até a fila cair à metade.
+ *          on_writable permite gerar a resposta sob demanda, sem thread
+ *          produtora.
+ */
+
+/** @brief Resposta em streaming */
+typedef struct http_stream http_stream_t;
+
+/** @brief Pedaço serializado e compartilhável (referência contada) */
+typedef send_buffer_t http_stream_chunk_t;
+
+/** @brief Conjunto de respostas que recebem os mesmos pedaços */
+typedef send_group_t http_stream_group_t;
+
+/**
+ * @brief Funções de uma aplicação de streaming
+ * @details Todas são opcionais e executam na thread da conexão.
+ */
+typedef struct {
+    /**
+     * @brief Chamada antes do envio dos headers
+     * @return 0 para aceitar; valor negativo faz o servidor responder 500
+     */
+    int (*on_open)(http_stream_t *stream, const http_request_view_t *request, void *user_data);
+
+    /**
+     * @brief Chamada quando a fila está abaixo de um quarto do limite
+     * @details Deve enfileirar o próximo pedaço; se não enfileirar nada, a
+     *          conexão passa a aguardar envios de outras threads.
+     * @return 0 para continuar, valor positivo encerra a resposta
+     *         (http_stream_end), valor negativo fecha a conexão
+     */
+    int (*on_writable)(http_stream_t *stream, void *user_data);
+
+    /**
+     * @brief Chamada uma única vez quando a resposta termina
+     * @note Após o retorno o http_stream_t é liberado; a aplicação deve
+     *       removê-lo dos grupos e parar seus produtores aqui
+     */
+    void (*on_close)(http_stream_t *stream, void *user_data);
+} http_stream_handler_t;
+
+/**
+ * @brief Envia os headers e atende a resposta até o fim ou a desconexão
+ * @details Com content_type "text/event-stream" adiciona Cache-Control:
+ *          no-cache, como esperado por clientes de Server-Sent Events.
+ *
+ * @param client_socket Socket do cliente
+ * @param config Ponteiro para a configuração do servidor
+ * @param request Requisição parseada
+ * @param content_type Tipo do conteúdo da resposta
+ * @param handler Funções da aplicação
+ * @param user_data Ponteiro repassado às funções da aplicação
+ * @return Código de status enviado (200, ou 500 se on_open recusou), ou -1
+ *         se a resposta não pôde ser iniciada
+ */
+int http_stream_serve(int client_socket, const server_config_t *config, const http_request_t *request,
+                      const char *content_type, const http_stream_handler_t *handler, void *user_data);
+
+/**
+ * @brief Serializa um pedaço da resposta
+ * @param data Dados
+ * @param length Tamanho dos dados (maior que zero)
+ * @return Pedaço com uma referência, ou NULL em caso de erro
+ */
+http_stream_chunk_t* http_stream_chunk_create(const void *data, size_t length);
+
+/**
+ * @brief Serializa um evento no formato Server-Sent Events
+ * @details Cada linha de data vira um campo "data:"; event e id são omitidos
+ *          quando NULL e não podem conter quebras de linha.
+ *
+ * @param event Nome do evento (pode ser NULL)
+ * @param id Identificador do evento (pode ser NULL)
+ * @param data Conteúdo do evento
+ * @param length Tamanho do conteúdo
+ * @return Pedaço com uma referência, ou NULL em caso de erro
+ */
+http_stream_chunk_t* http_stream_event_create(const char *event, const char *id, const char *data, size_t length);
+
+/**
+ * @brief Adiciona uma referência ao pedaço
+ * @param chunk Ponteiro para o pedaço
+ */
+void http_stream_chunk_retain(http_stream_chunk_t *chunk);
+
+/**
+ * @brief Remove uma referência e libera o pedaço na última
+ * @param chunk Ponteiro para o pedaço
+ */
+void http_stream_chunk_release(http_stream_chunk_t *chunk);
+
+/**
+ * @brief Enfileira um pedaço já serializado
+ * @details A fila adiciona sua própria referência. Se a fila ultrapassar
+ *          stream_max_queue_bytes o cliente é considerado lento e a conexão é
+ *          encerrada.
+ *
+ * @param stream Resposta de destino
+ * @param chunk Pedaço serializado
+ * @return 0 em caso de sucesso, -1 se a resposta terminou ou foi descartada
+ *
+ * @note Pode ser chamada de qualquer thread
+ */
+int http_stream_send_chunk(http_stream_t *stream, http_stream_chunk_t *chunk);
+
+/**
+ * @brief Serializa e enfileira dados, descartando o cliente se a fila estiver cheia
+ * @param stream Resposta de destino
+ * @param data Dados
+ * @param length Tamanho dos dados
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ */
+int http_stream_send(http_stream_t *stream, const void *data, size_t length);
+
+/**
+ * @brief Serializa e enfileira um evento Server-Sent Events
+ * @param stream Resposta de destino
+ * @param event Nome do evento (pode ser NULL)
+ * @param id Identificador do evento (pode ser NULL)
+ * @param data Conteúdo do evento
+ * @param length Tamanho do conteúdo
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ */
+int http_stream_send_event(http_stream_t *stream, const char *event, const char *id,
+                           const char *data, size_t length);
+
+/**
+ * @brief Enfileira dados aguardando espaço na fila em vez de descartar o cliente
+ * @details Com a fila acima da metade do limite, suspende a corrotina (ou a
+ *          thread) até a conexão escrever o pendente. Dentro das funções do
+ *          handler, que executam na própria conexão, não aguarda.
+ *
+ * @param stream Resposta de destino
+ * @param data Dados
+ * @param length Tamanho dos dados
+ * @return 0 em caso de sucesso, -1 se a resposta terminou
+ */
+int http_stream_write(http_stream_t *stream, const void *data, size_t length);
+
+/**
+ * @brief Retorna a quantidade de bytes aguardando envio
+ * @param stream Resposta
+ * @return Bytes na fila
+ */
+size_t http_stream_queued_bytes(http_stream_t *stream);
+
+/**
+ * @brief Encerra a resposta após o envio do que já está na fila
+ * @param stream Resposta
+ * @return 0 em caso de sucesso, -1 se já foi encerrada
+ */
+int http_stream_end(http_stream_t *stream);
+
+/**
+ * @brief Cria um grupo vazio
+ * @return Ponteiro para o grupo, ou NULL em caso de erro
+ */
+http_stream_group_t* http_stream_group_create(void);
+
+/**
+ * @brief Libera o grupo (as respostas não são afetadas)
+ * @param group Ponteiro para o grupo
+ */
+void http_stream_group_destroy(http_stream_group_t *group);
+
+/**
+ * @brief Adiciona uma resposta ao grupo
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ */
+int http_stream_group_add(http_stream_group_t *group, http_stream_t *stream);
+
+/**
+ * @brief Remove uma resposta do grupo
+ */
+void http_stream_group_remove(http_stream_group_t *group, http_stream_t *stream);
+
+/**
+ * @brief Enfileira o mesmo pedaço em todas as respostas do grupo
+ * @details Nunca aguarda: membros com a fila cheia são descartados.
+ *
+ * @param group Ponteiro para o grupo
+ * @param chunk Pedaço serializado
+ * @return Quantidade de respostas que receberam o pedaço, -1 em caso de erro
+ */
+int http_stream_group_broadcast(http_stream_group_t *group, http_stream_chunk_t *chunk);
+
+#endif // HTTP_STREAM_H
@@ -0,0 +1,195 @@
+#ifndef HTTPSERVER_H
+#define HTTPSERVER_H
+
+#include "config.h"
+#include "http_parser.h"
+#include "http_response.h"
+#include "websocket.h"
+#include "http_stream.h"
+#include "multipart.h"
+#include "coroutine.h"
+#include "socket_utils.h"
+
+/**
+ * @file httpserver.h
+ * @brief API pública da biblioteca libhttpserver
+ * @details Permite embutir o servidor HTTP em outras aplicações: cria-se um
+ *          servidor a partir de um server_config_t, registram-se handlers por
+ *          método e prefixo de caminho e controla-se o ciclo de vida com
+ *          http_server_start()/http_server_stop().
+ *
+ * Exemplo de uso:
+ * @code
+ * static int hello(const http_request_view_t *req, http_response_t *res, void *user_data) {
+ *     http_response_set(res, 200, "OK", "text/plain", "olá");
+ *     return 0;
+ * }
+ *
+ * server_config_t config;
+ * init_default_config(&config);
+ * http_server_t *server = http_server_create(&config);
+ * http_server_add_handler(server, "GET", "/hello", hello, NULL);
+ * http_server_start(server);
+ * // ...
+ * http_server_stop(server);
+ * http_server_destroy(server);
+ * @endcode
+ */
+
+/** @brief Estrutura opaca do servidor */
+typedef struct http_server http_server_t;
+
+/**
+ * @brief Função que atende uma requisição
+ * @details Recebe uma visão da requisição, sem cópias, válida apenas durante a
+ *          chamada. A resposta pode apontar para dados estáticos
+ *          (http_response_set_body) ou transferir a posse de um buffer para o
+ *          servidor (http_response_take_body), que o envia sem copiar.
+ *
+ * @param request Visão da requisição
+ * @param response Resposta a ser preenchida (inicializada como 200 OK)
+ * @param user_data Ponteiro informado no registro do handler
+ * @return 0 em caso de sucesso; valor negativo faz o servidor responder 500
+ *
+ * @note Handlers são chamados concorrentemente por várias threads
+ * @note Com coroutine_workers configurado o handler executa em uma corrotina:
+ *       esperas devem usar coroutine_sleep, socket_connect, socket_recv e
+ *       socket_send (ou coroutine_poll), que suspendem só a corrotina; sleep,
+ *       poll e leituras bloqueantes diretas travam o worker inteiro
+ */
+typedef int (*http_handler_fn)(const http_request_view_t *request, http_response_t *response, void *user_data);
+
+/**
+ * @brief Cria um servidor a partir da configuração
+ * @details A configuração é copiada. Inicializa proxy reverso, cache de
+ *          respostas, contexto TLS e limite de taxa conforme configurados, mas
+ *          não abre os sockets.
+ *
+ * @param config Ponteiro para a configuração do servidor
+ * @return Ponteiro para o servidor, ou NULL em caso de erro
+ */
+http_server_t* http_server_create(const server_config_t *config);
+
+/**
+ * @brief Registra um handler para um método e prefixo de caminho
+ * @details Entre os handlers que atendem a requisição vence o de maior prefixo.
+ *          O prefixo é comparado com o caminho normalizado (decodificado, sem
+ *          segmentos "." e ".." e sem query string); a query fica disponível
+ *          em request->query e pode ser percorrida com http_query_next.
+ *          Com asset_pack configurado, GET e HEAD de caminhos presentes no
+ *          pacote são respondidos pelo pacote antes dos handlers.
+ *
+ * @param server Ponteiro para o servidor
+ * @param method Método HTTP (ex: "GET"), ou NULL para qualquer método
+ * @param path_prefix Prefixo do caminho (ex: "/api/")
+ * @param handler Função chamada para cada requisição
+ * @param user_data Ponteiro repassado ao handler
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ *
+ * @note Deve ser chamada antes de http_server_start()
+ */
+int http_server_add_handler(http_server_t *server, const char *method, const char *path_prefix,
+                            http_handler_fn handler, void *user_data);
+
+/**
+ * @brief Registra uma aplicação WebSocket para um prefixo de caminho
+ * @details Requisições de upgrade (Upgrade: websocket) cujo caminho começa com
+ *          o prefixo passam ao websocket_serve(); as demais continuam nos
+ *          handlers HTTP.
+ *
+ * @param server Ponteiro para o servidor
+ * @param path_prefix Prefixo do caminho (ex: "/ws")
+ * @param handler Funções da aplicação (copiadas)
+ * @param user_data Ponteiro repassado às funções da aplicação
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ *
+ * @note Deve ser chamada antes de http_server_start()
+ */
+int http_server_add_websocket(http_server_t *server, const char *path_prefix,
+                              const websocket_handler_t *handler, void *user_data);
+
+/**
+ * @brief Registra uma resposta em streaming para um prefixo de caminho
+ * @details Requisições GET cujo caminho começa com o prefixo passam ao
+ *          http_stream_serve(): os headers são enviados e a conexão fica
+ *          aberta recebendo os pedaços enfileirados pela aplicação
+ *          (Transfer-Encoding chunked em HTTP/1.1). Com coroutine_workers
+ *          configurado, milhares de ouvintes ocupam poucas threads.
+ *
+ * @param server Ponteiro para o servidor
+ * @param path_prefix Prefixo do caminho (ex: "/events")
+ * @param content_type Tipo do conteúdo (ex: "text/event-stream")
+ * @param handler Funções da aplicação (copiadas)
+ * @param user_data Ponteiro repassado às funções da aplicação
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ *
+ * @note Deve ser chamada antes de http_server_start()
+ */
+int http_server_add_stream(http_server_t *server, const char *path_prefix, const char *content_type,
+                           const http_stream_handler_t *handler, void *user_data);
+
+/**
+ * @brief Função que atende um upload multipart/form-data já recebido
+ * @details Os arquivos das partes com filename ficam em upload->parts[i].path
+ *          e são removidos após o retorno; para mantê-los, a função deve
+ *          renomeá-los (rename) para o destino final.
+ *
+ * @param request Visão da requisição (o corpo não está disponível)
+ * @param upload Partes recebidas
+ * @param response Resposta a ser preenchida (inicializada como 200 OK)
+ * @param user_data Ponteiro informado no registro
+ * @return 0 em caso de sucesso; valor negativo faz o servidor responder 500
+ */
+typedef int (*http_upload_fn)(const http_request_view_t *request, const multipart_upload_t *upload,
+                              http_response_t *response, void *user_data);
+
+/**
+ * @brief Registra o recebimento de uploads para um prefixo de caminho
+ * @details Requisições POST HTTP/1.1 cujo caminho começa com o prefixo têm o
+ *          corpo multipart/form-data lido em streaming, com memória constante,
+ *          respeitando upload_max_size e upload_max_part_size. Erros de
+ *          formato ou limite são respondidos pelo servidor (400, 411, 413, 415)
+ *          sem chamar a função.
+ *
+ * @param server Ponteiro para o servidor
+ * @param path_prefix Prefixo do caminho (ex: "/upload")
+ * @param handler Função chamada com o upload completo
+ * @param user_data Ponteiro repassado à função
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ *
+ * @note Deve ser chamada antes de http_server_start()
+ */
+int http_server_add_upload(http_server_t *server, const char *path_prefix,
+                           http_upload_fn handler, void *user_data);
+
+/**
+ * @brief Abre os sockets e passa a aceitar conexões em threads próprias
+ * @param server Ponteiro para o servidor
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ */
+int http_server_start(http_server_t *server);
+
+/**
+ * @brief Abre os sockets e aceita conexões na thread atual até http_server_stop()
+ * @details O primeiro listener é atendido na thread atual e os demais (TLS,
+ *          IPv6, sockets Unix) por uma thread de accept cada.
+ * @param server Ponteiro para o servidor
+ * @return 0 ao ser encerrado, -1 em caso de erro
+ */
+int http_server_run(http_server_t *server);
+
+/**
+ * @brief Para de aceitar conexões e aguarda as conexões em andamento
+ * @details Conexões HTTP/2 e WebSocket abertas são encerradas.
+ * @param server Ponteiro para o servidor
+ */
+void http_server_stop(http_server_t *server);
+
+/**
+ * @brief Libera o servidor
+ * @param server Ponteiro para o servidor
+ * @note O servidor deve estar parado
+ */
+void http_server_destroy(http_server_t *server);
+
+#endif // HTTPSERVER_H
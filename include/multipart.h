@@ -0,0 +1,153 @@
+#ifndef MULTIPART_H
+#define MULTIPART_H
+
+#include <stddef.h>
+#include "config.h"
+#include "http_parser.h"
+
+/**
+ * @file multipart.h
+ * @brief Parser incremental de multipart/form-data e recepção de uploads
+ * @details O parser recebe o corpo em pedaços de qualquer tamanho e entrega
+ *          cada parte à aplicação à medida que chega, usando uma janela de
+ *          tamanho fixo: a memória não depende do tamanho do upload. O
+ *          delimitador (CRLF "--" boundary) é procurado com Boyer-Moore-Horspool,
+ *          que salta até o comprimento do delimitador a cada comparação.
+ *
+ *          multipart_upload_receive usa o parser para ler o corpo direto do
+ *          socket para a janela e gravar as partes com filename em arquivos
+ *          temporários em upload_directory, aplicando upload_max_size e
+ *          upload_max_part_size.
+ */
+
+#define MULTIPART_NAME_MAX 256
+#define MULTIPART_CONTENT_TYPE_MAX 128
+#define MULTIPART_PATH_MAX 512
+#define MULTIPART_MAX_PARTS 64
+#define MULTIPART_FIELD_MAX 65536    // Limite de um campo sem filename (mantido em memória)
+#define MULTIPART_WINDOW_SIZE 65536  // Janela do parser; também limita os headers de uma parte
+
+// Códigos de retorno do parser
+typedef enum {
+    MULTIPART_OK = 0,
+    MULTIPART_INVALID = -1,          // Corpo malformado
+    MULTIPART_ABORTED = -2           // Uma função da aplicação retornou erro
+} multipart_error_t;
+
+/** @brief Estrutura opaca do parser */
+typedef struct multipart_parser multipart_parser_t;
+
+// Headers de uma parte
+typedef struct {
+    char name[MULTIPART_NAME_MAX];                  // Parâmetro name de Content-Disposition
+    char filename[MULTIPART_NAME_MAX];              // Parâmetro filename (vazio em campos comuns)
+    int has_filename;
+    char content_type[MULTIPART_CONTENT_TYPE_MAX];  // Vazio quando ausente
+} multipart_part_info_t;
+
+/**
+ * @brief Funções chamadas pelo parser; retornar valor negativo interrompe o parse
+ */
+typedef struct {
+    int (*on_part_begin)(const multipart_part_info_t *part, void *user_data);
+    int (*on_part_data)(const char *data, size_t length, void *user_data);
+    int (*on_part_end)(void *user_data);
+} multipart_callbacks_t;
+
+// Parte recebida por multipart_upload_receive
+typedef struct {
+    multipart_part_info_t info;
+    char path[MULTIPART_PATH_MAX];  // Arquivo temporário (partes com filename)
+    char *value;                    // Conteúdo terminado em nulo (partes sem filename)
+    size_t size;
+} multipart_part_t;
+
+// Upload completo
+typedef struct {
+    multipart_part_t parts[MULTIPART_MAX_PARTS];
+    size_t part_count;
+    size_t total_size;              // Soma dos tamanhos das partes
+} multipart_upload_t;
+
+/**
+ * @brief Cria um parser a partir do header Content-Type
+ * @param content_type Valor do header (multipart/form-data; boundary=...)
+ * @param callbacks Funções da aplicação
+ * @param user_data Ponteiro repassado às funções
+ * @return Ponteiro para o parser, ou NULL se o tipo não é multipart/form-data
+ *         com boundary válido ou em caso de erro de alocação
+ */
+multipart_parser_t* multipart_parser_create(const char *content_type, const multipart_callbacks_t *callbacks,
+                                            void *user_data);
+
+/**
+ * @brief Libera o parser
+ * @param parser Ponteiro para o parser
+ */
+void multipart_parser_destroy(multipart_parser_t *parser);
+
+/**
+ * @brief Processa bytes do corpo, copiando-os para a janela do parser
+ * @param parser Ponteiro para o parser
+ * @param data Bytes recebidos
+ * @param length Quantidade de bytes
+ * @return MULTIPART_OK ou código de erro
+ */
+int multipart_parser_feed(multipart_parser_t *parser, const char *data, size_t length);
+
+/**
+ * @brief Retorna o espaço livre da janela, para leitura direta do socket
+ * @details Evita a cópia de multipart_parser_feed: o chamador lê para o espaço
+ *          retornado e informa a quantidade com multipart_parser_commit.
+ *
+ * @param parser Ponteiro para o parser
+ * @param available Recebe o tamanho do espaço livre (sempre maior que zero)
+ * @return Ponteiro para o espaço livre
+ */
+char* multipart_parser_space(multipart_parser_t *parser, size_t *available);
+
+/**
+ * @brief Processa bytes gravados no espaço retornado por multipart_parser_space
+ * @param parser Ponteiro para o parser
+ * @param length Quantidade de bytes gravados
+ * @return MULTIPART_OK ou código de erro
+ */
+int multipart_parser_commit(multipart_parser_t *parser, size_t length);
+
+/**
+ * @brief Verifica se o delimitador final foi encontrado
+ * @param parser Ponteiro para o parser
+ * @return 1 se o corpo terminou, 0 caso contrário
+ */
+int multipart_parser_done(const multipart_parser_t *parser);
+
+/**
+ * @brief Recebe um corpo multipart/form-data gravando os arquivos em disco
+ * @details Exige Content-Length. Responde "100 Continue" quando o cliente o
+ *          aguarda. Campos sem filename ficam em memória (até
+ *          MULTIPART_FIELD_MAX bytes); partes com filename são gravadas em
+ *          arquivos criados com mkostemp em upload_directory.
+ *
+ * @param client_socket Socket do cliente
+ * @param config Ponteiro para a configuração do servidor
+ * @param request Requisição parseada
+ * @param initial Bytes do corpo recebidos junto com a requisição
+ * @param initial_length Quantidade de bytes em initial
+ * @param upload Estrutura que recebe as partes
+ * @param status Recebe o código HTTP do erro (400, 411, 413, 415 ou 500)
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ *
+ * @note Após o uso, multipart_upload_cleanup remove os arquivos temporários;
+ *       a aplicação que quiser mantê-los deve renomeá-los antes
+ */
+int multipart_upload_receive(int client_socket, const server_config_t *config, const http_request_t *request,
+                             const char *initial, size_t initial_length, multipart_upload_t *upload,
+                             int *status);
+
+/**
+ * @brief Remove os arquivos temporários e libera os campos de um upload
+ * @param upload Ponteiro para o upload
+ */
+void multipart_upload_cleanup(multipart_upload_t *upload);
+
+#endif // MULTIPART_H
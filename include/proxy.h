@@ -0,0 +1,66 @@
+#ifndef PROXY_H
+#define PROXY_H
+
+#include <stddef.h>
+#include "config.h"
+#include "http_parser.h"
+
+/**
+ * @file proxy.h
+ * @brief Proxy reverso com pool de conexões keep-alive para upstreams
+ * @details Encaminha requisições para upstreams TCP ou Unix socket configurados
+ *          nas rotas de proxy, reaproveitando conexões ociosas e transmitindo
+ *          os corpos de requisição e resposta sem bufferizá-los por completo.
+ */
+
+/** @brief Estrutura opaca com o estado do proxy (upstreams, pools e health check) */
+typedef struct proxy proxy_t;
+
+/**
+ * @brief Cria o estado do proxy a partir das rotas configuradas
+ * @details Resolve os endereços dos upstreams, inicializa os pools de conexões
+ *          e inicia a thread de health check quando proxy_health_interval > 0.
+ *
+ * @param config Ponteiro para a configuração do servidor
+ * @return Ponteiro para o proxy criado, ou NULL se não houver rotas ou em caso de erro
+ */
+proxy_t* proxy_create(const server_config_t *config);
+
+/**
+ * @brief Encerra o health check e libera o proxy e suas conexões ociosas
+ * @param proxy Ponteiro para o proxy
+ */
+void proxy_destroy(proxy_t *proxy);
+
+/**
+ * @brief Procura a rota de proxy que atende um caminho
+ * @details Retorna a rota de maior prefixo que case com o caminho.
+ *
+ * @param proxy Ponteiro para o proxy (pode ser NULL)
+ * @param path Caminho da requisição
+ * @return Índice da rota, ou -1 se nenhuma rota atende o caminho
+ */
+int proxy_match(const proxy_t *proxy, const char *path);
+
+/**
+ * @brief Encaminha uma requisição para um upstream da rota e devolve a resposta
+ * @details Escolhe um upstream saudável conforme o algoritmo de balanceamento,
+ *          reutiliza uma conexão do pool (ou abre uma nova), envia a requisição
+ *          e transmite a resposta ao cliente. Corpos com Content-Length são
+ *          transferidos com splice() sempre que possível.
+ *
+ * @param proxy Ponteiro para o proxy
+ * @param route Índice da rota retornado por proxy_match()
+ * @param client_socket Socket do cliente
+ * @param client_ip Endereço do cliente, usado no header X-Forwarded-For
+ * @param request Requisição já parseada
+ * @param raw Dados brutos recebidos do cliente (headers e início do corpo)
+ * @param raw_length Quantidade de bytes em raw
+ * @return 0 em caso de sucesso, -1 se a resposta não pôde ser entregue
+ *
+ * @note Em caso de falha antes do envio da resposta, responde 502 ao cliente
+ */
+int proxy_handle_request(proxy_t *proxy, int route, int client_socket, const char *client_ip,
+                         const http_request_t *request, const char *raw, size_t raw_length);
+
+#endif // PROXY_H
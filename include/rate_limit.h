@@ -0,0 +1,57 @@
+#ifndef RATE_LIMIT_H
+#define RATE_LIMIT_H
+
+#include <sys/socket.h>
+#include "config.h"
+
+/**
+ * @file rate_limit.h
+ * @brief Limite de taxa por endereço de cliente (token bucket)
+ * @details Os buckets ficam em uma tabela de endereçamento aberto de tamanho
+ *          fixo, sem locks: cada slot guarda a chave do endereço e o estado do
+ *          bucket (tokens e instante da última atualização) em palavras de 64
+ *          bits atualizadas com compare-and-swap. A reposição de tokens é
+ *          preguiçosa, calculada a partir de um relógio grosso
+ *          (CLOCK_MONOTONIC_COARSE) no momento da verificação.
+ *
+ *          Os endereços são agrupados pelos prefixos rate_limit_ipv4_prefix e
+ *          rate_limit_ipv6_prefix, permitindo limitar uma rede inteira (CIDR)
+ *          em vez de cada endereço.
+ */
+
+/** @brief Estrutura opaca do limitador */
+typedef struct rate_limiter rate_limiter_t;
+
+// Tipos de evento limitados, cada um com taxa e rajada próprias
+typedef enum {
+    RATE_LIMIT_REQUEST = 0,    // Requisição parseada
+    RATE_LIMIT_CONNECTION = 1  // Conexão aceita
+} rate_limit_kind_t;
+
+/**
+ * @brief Cria o limitador a partir da configuração
+ * @param config Ponteiro para a configuração do servidor
+ * @return Ponteiro para o limitador, ou NULL se nenhum limite está
+ *         configurado ou em caso de erro
+ */
+rate_limiter_t* rate_limiter_create(const server_config_t *config);
+
+/**
+ * @brief Libera o limitador
+ * @param limiter Ponteiro para o limitador
+ */
+void rate_limiter_destroy(rate_limiter_t *limiter);
+
+/**
+ * @brief Consome um token do bucket do cliente
+ * @param limiter Ponteiro para o limitador (pode ser NULL)
+ * @param kind Tipo de evento
+ * @param address Endereço do cliente (AF_INET ou AF_INET6; outras famílias não são limitadas)
+ * @return 0 se o evento é permitido, ou os segundos até o próximo token
+ *         (valor para Retry-After) se o cliente excedeu o limite
+ *
+ * @note Pode ser chamada concorrentemente por qualquer thread
+ */
+int rate_limiter_check(rate_limiter_t *limiter, rate_limit_kind_t kind, const struct sockaddr *address);
+
+#endif // RATE_LIMIT_H
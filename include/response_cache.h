@@ -0,0 +1,104 @@
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <stddef.h>
+#include "config.h"
+#include "http_parser.h"
+#include "http_response.h"
+
+/**
+ * @file response_cache.h
+ * @brief Microcache de respostas dinâmicas
+ * @details Tabela hash particionada em shards que armazena respostas já
+ *          serializadas (headers e corpo) com TTL curto. A chave é formada
+ *          pelo método, caminho e valores dos headers listados em
+ *          cache_vary_headers. Misses simultâneos para a mesma chave são
+ *          agrupados: apenas uma thread executa o handler enquanto as demais
+ *          aguardam o resultado.
+ */
+
+/** @brief Estrutura opaca do cache */
+typedef struct response_cache response_cache_t;
+
+/** @brief Entrada do cache (referência contada) */
+typedef struct cache_entry cache_entry_t;
+
+/**
+ * @brief Cria o cache a partir da configuração
+ * @param config Ponteiro para a configuração do servidor
+ * @return Ponteiro para o cache, ou NULL se desabilitado ou em caso de erro
+ */
+response_cache_t* response_cache_create(const server_config_t *config);
+
+/**
+ * @brief Libera o cache e todas as entradas
+ * @param cache Ponteiro para o cache
+ * @note Nenhuma thread pode estar usando o cache durante a destruição
+ */
+void response_cache_destroy(response_cache_t *cache);
+
+/**
+ * @brief Verifica se a requisição pode ser atendida pelo cache
+ * @details Apenas GET e HEAD sem Authorization ou Cookie são cacheáveis.
+ *
+ * @param cache Ponteiro para o cache (pode ser NULL)
+ * @param request Requisição parseada
+ * @return 1 se cacheável, 0 caso contrário
+ */
+int response_cache_accepts(const response_cache_t *cache, const http_request_t *request);
+
+/**
+ * @brief Verifica se a resposta pode ser armazenada e compartilhada
+ * @details Respostas com Set-Cookie ou Cache-Control private, no-store ou
+ *          no-cache pertencem a um único cliente e nunca são armazenadas.
+ *
+ * @param response Resposta gerada pelo handler
+ * @return 1 se armazenável, 0 caso contrário
+ */
+int response_cache_storable(const http_response_t *response);
+
+/**
+ * @brief Obtém a entrada da requisição, aguardando um preenchimento em andamento
+ * @details Se houver uma resposta válida, retorna a entrada com *is_filler = 0.
+ *          Caso contrário a chamada se torna responsável por preencher a
+ *          entrada (*is_filler = 1) e deve chamar response_cache_complete().
+ *          Em ambos os casos a referência deve ser liberada com
+ *          response_cache_release(). Se o preenchimento aguardado não gerou
+ *          uma resposta cacheável, retorna NULL e o chamador gera a sua
+ *          resposta sem passar pelo cache.
+ *
+ * @param cache Ponteiro para o cache
+ * @param request Requisição parseada
+ * @param is_filler Recebe 1 se o chamador deve gerar a resposta
+ * @return Entrada do cache, ou NULL se a resposta deve ser gerada sem o
+ *         cache (preenchimento não cacheável ou erro de alocação)
+ */
+cache_entry_t* response_cache_acquire(response_cache_t *cache, const http_request_t *request, int *is_filler);
+
+/**
+ * @brief Conclui o preenchimento de uma entrada e acorda as threads em espera
+ * @param cache Ponteiro para o cache
+ * @param entry Entrada obtida com *is_filler = 1
+ * @param data Resposta serializada, ou NULL se não cacheável
+ * @param length Tamanho da resposta
+ * @return 1 se o cache assumiu a posse de data, 0 se o chamador continua
+ *         responsável por liberá-lo (resposta maior que o limite do shard)
+ */
+int response_cache_complete(response_cache_t *cache, cache_entry_t *entry, char *data, size_t length);
+
+/**
+ * @brief Retorna a resposta serializada de uma entrada preenchida
+ * @param entry Entrada do cache
+ * @param length Recebe o tamanho da resposta
+ * @return Ponteiro para a resposta, ou NULL se a entrada não possui dados
+ */
+const char* response_cache_data(const cache_entry_t *entry, size_t *length);
+
+/**
+ * @brief Libera a referência obtida em response_cache_acquire()
+ * @param cache Ponteiro para o cache
+ * @param entry Entrada do cache
+ */
+void response_cache_release(response_cache_t *cache, cache_entry_t *entry);
+
+#endif // RESPONSE_CACHE_H
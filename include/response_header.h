@@ -0,0 +1,68 @@
+#ifndef RESPONSE_HEADER_H
+#define RESPONSE_HEADER_H
+
+#include <stddef.h>
+
+/**
+ * @file response_header.h
+ * @brief Blocos pré-formatados para montar headers de resposta sem snprintf
+ * @details Montar o header de uma resposta comum se reduz a alguns memcpy:
+ *          - linhas de status "HTTP/1.1 <código> <texto>\r\n" de todos os
+ *            códigos conhecidos, geradas em tempo de compilação;
+ *          - bloco "Date: ...\r\nServer: ...\r\n" mantido por thread e
+ *            refeito apenas quando o segundo do relógio muda (o relógio é
+ *            lido com CLOCK_REALTIME_COARSE, sem chamada de sistema);
+ *          - linhas "Content-Type: ...\r\n" internadas para os tipos mais
+ *            usados;
+ *          - Content-Length convertido com uma conversão inteiro-texto própria.
+ */
+
+/** @brief Valor do header Server */
+#define RESPONSE_HEADER_SERVER "libhttpserver"
+
+/**
+ * @brief Retorna o texto padrão de um código de status
+ * @param status_code Código de status
+ * @return Texto do status, ou NULL se o código não é conhecido
+ */
+const char* response_header_status_text(int status_code);
+
+/**
+ * @brief Retorna a linha de status pré-formatada
+ * @details Só é usada quando status_text é o texto padrão do código; textos
+ *          personalizados precisam ser formatados pelo chamador.
+ *
+ * @param status_code Código de status
+ * @param status_text Texto do status da resposta
+ * @param length Recebe o tamanho da linha (com o CRLF)
+ * @return Linha de status, ou NULL se não há linha pré-formatada
+ */
+const char* response_header_status_line(int status_code, const char *status_text, size_t *length);
+
+/**
+ * @brief Retorna o bloco com os headers Date e Server da thread atual
+ * @param length Recebe o tamanho do bloco (com o CRLF de cada header)
+ * @return Bloco válido até a próxima chamada na mesma thread
+ */
+const char* response_header_date(size_t *length);
+
+/**
+ * @brief Retorna a linha "Content-Type: ...\r\n" internada de um tipo
+ * @param content_type Tipo do conteúdo
+ * @param length Recebe o tamanho da linha
+ * @return Linha pré-formatada, ou NULL se o tipo não está na tabela
+ */
+const char* response_header_content_type(const char *content_type, size_t *length);
+
+/**
+ * @brief Escreve um número em decimal terminando em end
+ * @details Os dígitos são escritos de trás para frente; o buffer precisa de
+ *          pelo menos 20 bytes antes de end.
+ *
+ * @param end Posição logo após o último dígito
+ * @param value Número a converter
+ * @return Ponteiro para o primeiro dígito
+ */
+char* response_header_format_size(char *end, size_t value);
+
+#endif // RESPONSE_HEADER_H
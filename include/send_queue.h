@@ -0,0 +1,178 @@
+#ifndef SEND_QUEUE_H
+#define SEND_QUEUE_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+/**
+ * @file send_queue.h
+ * @brief Fila de envio compartilhada por WebSocket e respostas em streaming
+ * @details Qualquer thread enfileira buffers já serializados; a thread (ou
+ *          corrotina) da conexão é a única que escreve no socket e junta os
+ *          buffers pendentes em poucos sendmsg. Cada buffer tem contagem de
+ *          referências, de modo que o mesmo conteúdo pode ser enfileirado em
+ *          muitas conexões (send_group_broadcast) sem cópia.
+ *
+ *          queued_bytes conta o que ainda não foi escrito no socket, inclusive
+ *          o que a conexão já retirou da fila e está enviando: um cliente lento
+ *          nunca retém mais que max_bytes.
+ */
+
+/** @brief Ignora max_bytes: o buffer nunca descarta a conexão */
+#define SEND_QUEUE_UNLIMITED 0x1
+/** @brief Aguarda espaço na fila em vez de descartar a conexão */
+#define SEND_QUEUE_WAIT 0x2
+/** @brief O buffer encerra a fila (close do WebSocket) */
+#define SEND_QUEUE_FINAL 0x4
+
+/**
+ * @brief Buffer serializado com contagem de referências
+ * @details header_length e trailer_length delimitam o enquadramento ao redor
+ *          do conteúdo; filas com strip_framing enviam apenas o conteúdo.
+ */
+typedef struct send_buffer {
+    int refcount;
+    size_t length;            // Tamanho total de data
+    size_t header_length;     // Enquadramento antes do conteúdo
+    size_t trailer_length;    // Enquadramento depois do conteúdo
+    unsigned char data[];
+} send_buffer_t;
+
+/** @brief Nó interno da fila */
+typedef struct send_queue_node send_queue_node_t;
+
+/**
+ * @brief Fila de envio de uma conexão
+ * @details Os campos são protegidos por lock, que o dono também usa para o
+ *          próprio estado.
+ */
+typedef struct {
+    int socket;
+    int wake_fd;              // eventfd que acorda a conexão para enviar
+    int space_fd;             // eventfd legível enquanto a fila está abaixo da metade (-1 sem SEND_QUEUE_WAIT)
+    int strip_framing;        // Envia só o conteúdo dos buffers
+    size_t max_bytes;
+
+    pthread_mutex_t lock;
+    send_queue_node_t *head;
+    send_queue_node_t *tail;
+    size_t queued_bytes;      // Enfileirados ou em envio, ainda não escritos
+    unsigned long enqueued;   // Total de buffers enfileirados
+    int space_ready;          // Estado atual de space_fd
+    int shut;                 // Não aceita novos buffers
+    int dropped;              // Fila excedeu o limite (cliente lento)
+} send_queue_t;
+
+/** @brief Conjunto de filas que recebem os mesmos buffers */
+typedef struct send_group send_group_t;
+
+/**
+ * @brief Aloca um buffer com uma referência e sem enquadramento
+ * @param length Tamanho de data
+ * @return Ponteiro para o buffer, ou NULL em caso de erro
+ */
+send_buffer_t* send_buffer_create(size_t length);
+
+/**
+ * @brief Adiciona uma referência ao buffer
+ * @param buffer Ponteiro para o buffer
+ */
+void send_buffer_retain(send_buffer_t *buffer);
+
+/**
+ * @brief Remove uma referência e libera o buffer na última
+ * @param buffer Ponteiro para o buffer
+ */
+void send_buffer_release(send_buffer_t *buffer);
+
+/**
+ * @brief Inicializa a fila de uma conexão
+ * @param queue Fila a inicializar
+ * @param socket Socket da conexão
+ * @param max_bytes Limite de bytes pendentes
+ * @param blocking_writers Cria space_fd para produtores com SEND_QUEUE_WAIT
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ */
+int send_queue_init(send_queue_t *queue, int socket, size_t max_bytes, int blocking_writers);
+
+/**
+ * @brief Descarta o pendente e libera os recursos da fila
+ * @param queue Fila
+ */
+void send_queue_destroy(send_queue_t *queue);
+
+/**
+ * @brief Enfileira um buffer
+ * @details A fila adiciona sua própria referência. Sem SEND_QUEUE_UNLIMITED
+ *          nem SEND_QUEUE_WAIT, um buffer que ultrapassa max_bytes marca a
+ *          conexão como descartada. Com SEND_QUEUE_WAIT, suspende a corrotina
+ *          (ou a thread) até a fila cair à metade do limite; a própria conexão
+ *          nunca deve aguardar e usa SEND_QUEUE_UNLIMITED.
+ *
+ * @param queue Fila de destino
+ * @param buffer Buffer serializado
+ * @param flags Combinação de SEND_QUEUE_UNLIMITED, SEND_QUEUE_WAIT e SEND_QUEUE_FINAL
+ * @return 0 em caso de sucesso, -1 se a fila foi encerrada ou descartada
+ *
+ * @note Pode ser chamada de qualquer thread
+ */
+int send_queue_push(send_queue_t *queue, send_buffer_t *buffer, int flags);
+
+/**
+ * @brief Encerra a fila para novos buffers e acorda a conexão e os produtores
+ * @param queue Fila
+ * @return 0 se a fila estava aberta, -1 se já estava encerrada
+ */
+int send_queue_shut(send_queue_t *queue);
+
+/**
+ * @brief Escreve no socket tudo o que está na fila
+ * @details Chamada apenas pela conexão. Agrupa vários buffers por sendmsg e
+ *          desconta os bytes de queued_bytes à medida que são escritos.
+ *
+ * @param queue Fila
+ * @return 0 em caso de sucesso, -1 em caso de erro de escrita
+ */
+int send_queue_flush(send_queue_t *queue);
+
+/**
+ * @brief Consome os avisos pendentes em wake_fd
+ * @param queue Fila
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ */
+int send_queue_clear_wake(send_queue_t *queue);
+
+/**
+ * @brief Cria um grupo vazio
+ * @return Ponteiro para o grupo, ou NULL em caso de erro
+ */
+send_group_t* send_group_create(void);
+
+/**
+ * @brief Libera o grupo (as filas não são afetadas)
+ * @param group Ponteiro para o grupo
+ */
+void send_group_destroy(send_group_t *group);
+
+/**
+ * @brief Adiciona uma fila ao grupo
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ */
+int send_group_add(send_group_t *group, send_queue_t *queue);
+
+/**
+ * @brief Remove uma fila do grupo
+ */
+void send_group_remove(send_group_t *group, send_queue_t *queue);
+
+/**
+ * @brief Enfileira o mesmo buffer em todas as filas do grupo
+ * @details Nunca aguarda: filas cheias são descartadas.
+ *
+ * @param group Ponteiro para o grupo
+ * @param buffer Buffer serializado
+ * @return Quantidade de filas que receberam o buffer, -1 em caso de erro
+ */
+int send_group_broadcast(send_group_t *group, send_buffer_t *buffer);
+
+#endif // SEND_QUEUE_H
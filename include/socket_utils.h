@@ -1,6 +1,9 @@
 #ifndef SOCKET_UTILS_H
 #define SOCKET_UTILS_H
 
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <poll.h>
 #include "config.h"
 
 /**
@@ -25,6 +28,8 @@
  *         Em caso de erro, retorna um valor negativo
  *
  * @note O socket é configurado para reutilizar endereços (SO_REUSEADDR)
+ * @note Aplica TCP_DEFER_ACCEPT, TCP_FASTOPEN, SO_SNDBUF e SO_RCVBUF quando
+ *       habilitados na configuração
  * @note O backlog (número máximo de conexões pendentes) é definido na configuração
  *
  * Exemplo de uso:
@@ -39,6 +44,21 @@
  */
 int create_server_socket(int port, server_config_t *config);
 
+/**
+ * @brief Cria o socket de escuta de um listener configurado
+ * @details Aceita "ipv4:porta", "[ipv6]:porta" (dual-stack, exceto com
+ *          ipv6_only) e "unix:/caminho". Um socket Unix deixado por uma
+ *          execução anterior é removido antes do bind e o arquivo recebe as
+ *          permissões de listener->mode.
+ *
+ * @param listener Endereço e opções do listener
+ * @param config Ponteiro para a estrutura de configuração do servidor
+ * @return Descritor do socket (>= 0), ou -1 em caso de erro
+ *
+ * @note As opções de TCP da configuração são ignoradas em sockets Unix
+ */
+int create_listener_socket(const listener_config_t *listener, server_config_t *config);
+
 /**
  * @brief Configura um socket para modo não-bloqueante
  * @details Modifica as flags do socket usando fcntl para habilitar 
@@ -67,4 +87,148 @@ int set_socket_non_blocking(int socket_fd);
  */
 int set_socket_timeout(int socket_fd, int seconds, int microseconds);
 
+/**
+ * @brief Aplica os ajustes de TCP configurados a um socket aceito
+ * @details Habilita TCP_NODELAY quando configurado, evitando que respostas
+ *          pequenas fiquem retidas pelo algoritmo de Nagle.
+ *
+ * @param client_fd Descritor do socket do cliente
+ * @param config Ponteiro para a configuração do servidor
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ */
+int configure_client_socket(int client_fd, const server_config_t *config);
+
+/**
+ * @brief Define os tamanhos dos buffers de envio e recepção do socket
+ * @details Configura SO_SNDBUF e SO_RCVBUF. Valores menores ou iguais a zero
+ *          mantêm o padrão do kernel.
+ *
+ * @param socket_fd Descritor do socket
+ * @param send_size Tamanho do buffer de envio em bytes
+ * @param recv_size Tamanho do buffer de recepção em bytes
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ *
+ * @note O kernel dobra o valor informado para contabilizar overhead interno
+ */
+int set_socket_buffers(int socket_fd, int send_size, int recv_size);
+
+/**
+ * @brief Lê dados de um socket de cliente
+ * @details Conexões HTTPS são lidas pela sessão TLS associada ao descritor;
+ *          as demais usam recv diretamente.
+ *
+ * @param fd Descritor do socket
+ * @param buffer Buffer de destino
+ * @param length Tamanho do buffer
+ * @param flags Flags de recv (ignoradas em conexões TLS)
+ * @return Bytes lidos, 0 no fim da conexão, -1 em caso de erro
+ */
+ssize_t socket_recv(int fd, void *buffer, size_t length, int flags);
+
+/**
+ * @brief Retorna quantos bytes podem ser lidos sem consultar o socket
+ * @details Em conexões TLS o OpenSSL pode já ter decifrado dados que poll não
+ *          enxerga; laços baseados em poll devem verificar esta função antes.
+ *
+ * @param fd Descritor do socket
+ * @return Bytes já disponíveis em espaço de usuário (0 sem TLS)
+ */
+size_t socket_pending(int fd);
+
+/**
+ * @brief Envia dados por um socket de cliente
+ * @details Com kTLS de transmissão ativo (ou sem TLS) o envio é feito com send;
+ *          caso contrário os dados são cifrados pelo OpenSSL.
+ *
+ * @param fd Descritor do socket
+ * @param data Dados a enviar
+ * @param length Quantidade de bytes
+ * @param flags Flags de send (ex: MSG_MORE); MSG_NOSIGNAL é sempre aplicada
+ * @return Bytes enviados, -1 em caso de erro
+ */
+ssize_t socket_send(int fd, const void *data, size_t length, int flags);
+
+/**
+ * @brief Envia um conjunto de buffers por um socket de cliente
+ * @param fd Descritor do socket
+ * @param msg Mensagem com os buffers (msg_iov)
+ * @param flags Flags de sendmsg; MSG_NOSIGNAL é sempre aplicada
+ * @return Bytes enviados, -1 em caso de erro
+ */
+ssize_t socket_sendmsg(int fd, const struct msghdr *msg, int flags);
+
+/**
+ * @brief Envia o conteúdo de um arquivo por um socket de cliente
+ * @details Usa sendfile sem TLS ou com kTLS de transmissão ativo; nos demais
+ *          casos lê o arquivo e envia pela sessão TLS.
+ *
+ * @param out_fd Descritor do socket
+ * @param in_fd Descritor do arquivo
+ * @param offset Posição inicial no arquivo, atualizada com os bytes enviados
+ * @param count Quantidade de bytes
+ * @return Bytes enviados, -1 em caso de erro
+ */
+ssize_t socket_sendfile(int out_fd, int in_fd, off_t *offset, size_t count);
+
+/**
+ * @brief Verifica se o kernel entrega texto claro ao ler o socket
+ * @param fd Descritor do socket
+ * @return 1 sem TLS ou com kTLS de recepção ativo (splice permitido), 0 caso contrário
+ */
+int socket_kernel_recv(int fd);
+
+/**
+ * @brief Verifica se o kernel aceita texto claro ao escrever no socket
+ * @param fd Descritor do socket
+ * @return 1 sem TLS ou com kTLS de transmissão ativo (splice e sendfile permitidos), 0 caso contrário
+ */
+int socket_kernel_send(int fd);
+
+/**
+ * @brief Aguarda descritores como poll(), suspendendo apenas a corrotina atual
+ * @details Dentro de uma corrotina (coroutine_workers > 0) a espera é feita
+ *          pelo epoll do worker; em threads comuns chama poll().
+ *
+ * @param fds Descritores e eventos aguardados
+ * @param nfds Quantidade de descritores
+ * @param timeout_ms Timeout em milissegundos (-1 aguarda indefinidamente)
+ * @return Quantidade de descritores prontos, 0 no timeout, -1 em caso de erro
+ */
+int socket_poll(struct pollfd *fds, nfds_t nfds, int timeout_ms);
+
+/**
+ * @brief Aguarda um socket não-bloqueante ficar pronto após EAGAIN
+ * @details Usa o timeout configurado no socket (SO_RCVTIMEO para POLLIN,
+ *          SO_SNDTIMEO para POLLOUT). Em sockets bloqueantes o EAGAIN já
+ *          indica que o timeout expirou, e a função retorna -1 imediatamente.
+ *
+ * @param fd Descritor do socket
+ * @param events POLLIN ou POLLOUT
+ * @return 0 se o socket está pronto, -1 no timeout (errno = EAGAIN) ou em caso de erro
+ *
+ * @note Os wrappers socket_recv, socket_send, socket_sendmsg e socket_sendfile
+ *       já repetem a operação após esta espera, exceto com MSG_DONTWAIT
+ */
+int socket_wait(int fd, short events);
+
+/**
+ * @brief Aguarda um socket ficar pronto, bloqueante ou não, pelo timeout configurado
+ * @details Como socket_wait, mas também espera em sockets bloqueantes; usada
+ *          antes de leituras que não podem bloquear segurando um lock (TLS).
+ *
+ * @param fd Descritor do socket
+ * @param events POLLIN ou POLLOUT
+ * @return 0 se o socket está pronto, -1 no timeout (errno = EAGAIN) ou em caso de erro
+ */
+int socket_wait_timeout(int fd, short events);
+
+/**
+ * @brief Conecta um socket, aguardando a conclusão se ele for não-bloqueante
+ * @param fd Descritor do socket
+ * @param addr Endereço de destino
+ * @param length Tamanho do endereço
+ * @return 0 em caso de sucesso, -1 em caso de erro (errno indica a causa)
+ */
+int socket_connect(int fd, const struct sockaddr *addr, socklen_t length);
+
 #endif // SOCKET_UTILS_H
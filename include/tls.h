@@ -0,0 +1,132 @@
+#ifndef TLS_H
+#define TLS_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include "config.h"
+
+/**
+ * @file tls.h
+ * @brief Terminação TLS (OpenSSL) para os listeners HTTPS
+ * @details O contexto TLS é compartilhado por todas as conexões de um servidor,
+ *          mantendo um único cache de sessões e as chaves de session tickets,
+ *          de modo que handshakes retomados evitem a troca de chaves completa.
+ *
+ *          Cada conexão aceita em um listener HTTPS tem uma sessão associada ao
+ *          seu descritor. As funções socket_recv()/socket_send() de
+ *          socket_utils.h consultam essa associação e só passam pelo OpenSSL
+ *          quando necessário: com kernel TLS (kTLS) ativo o kernel cifra e
+ *          decifra os registros, e o socket volta a aceitar send, splice e
+ *          sendfile diretamente.
+ *
+ * @note Sem OpenSSL no momento da compilação (HAVE_OPENSSL indefinido) as
+ *       funções existem, mas tls_context_create() sempre falha
+ */
+
+/** @brief Contexto TLS compartilhado (certificado, cache de sessões, tickets) */
+typedef struct tls_context tls_context_t;
+
+/** @brief Sessão TLS de uma conexão */
+typedef struct tls_session tls_session_t;
+
+/**
+ * @brief Cria o contexto TLS a partir da configuração
+ * @details Carrega tls_certificate e tls_private_key, configura o cache de
+ *          sessões, os session tickets, o kTLS e o ALPN (h2 e http/1.1).
+ *
+ * @param config Ponteiro para a configuração do servidor
+ * @return Ponteiro para o contexto, ou NULL em caso de erro
+ */
+tls_context_t* tls_context_create(const server_config_t *config);
+
+/**
+ * @brief Libera o contexto TLS
+ * @param context Ponteiro para o contexto
+ * @note Todas as sessões criadas a partir do contexto devem estar fechadas
+ */
+void tls_context_destroy(tls_context_t *context);
+
+/**
+ * @brief Realiza o handshake TLS em um socket aceito
+ * @details Em caso de sucesso a sessão fica associada ao descritor até
+ *          tls_session_close().
+ *
+ * @param context Ponteiro para o contexto
+ * @param fd Descritor do socket do cliente
+ * @return Ponteiro para a sessão, ou NULL se o handshake falhar
+ */
+tls_session_t* tls_session_accept(tls_context_t *context, int fd);
+
+/**
+ * @brief Envia close_notify, desfaz a associação com o descritor e libera a sessão
+ * @param fd Descritor do socket do cliente (não é fechado)
+ */
+void tls_session_close(int fd);
+
+/**
+ * @brief Obtém a sessão associada a um descritor
+ * @param fd Descritor do socket
+ * @return Ponteiro para a sessão, ou NULL se o socket não usa TLS
+ */
+tls_session_t* tls_session_get(int fd);
+
+/**
+ * @brief Verifica se o cliente negociou HTTP/2 via ALPN
+ * @param session Ponteiro para a sessão
+ * @return 1 se o protocolo negociado é h2, 0 caso contrário
+ */
+int tls_session_is_h2(const tls_session_t *session);
+
+/**
+ * @brief Verifica se o kernel cifra os dados enviados (kTLS de transmissão)
+ * @param session Ponteiro para a sessão
+ * @return 1 se send, splice e sendfile podem escrever diretamente no socket
+ */
+int tls_session_kernel_send(const tls_session_t *session);
+
+/**
+ * @brief Verifica se o kernel decifra os dados recebidos (kTLS de recepção)
+ * @param session Ponteiro para a sessão
+ * @return 1 se recv e splice podem ler diretamente do socket
+ */
+int tls_session_kernel_recv(const tls_session_t *session);
+
+/**
+ * @brief Retorna quantos bytes já decifrados aguardam leitura na sessão
+ * @details Esses bytes não aparecem no socket, portanto poll não os sinaliza.
+ * @param session Ponteiro para a sessão
+ * @return Quantidade de bytes disponíveis sem ler o socket
+ */
+size_t tls_session_pending(tls_session_t *session);
+
+/**
+ * @brief Lê dados decifrados da conexão
+ * @param session Ponteiro para a sessão
+ * @param buffer Buffer de destino
+ * @param length Tamanho do buffer
+ * @return Bytes lidos, 0 quando o cliente encerra a conexão, -1 em caso de erro
+ *
+ * @note Pode ser chamada concorrentemente com tls_session_send() (HTTP/2)
+ */
+ssize_t tls_session_recv(tls_session_t *session, void *buffer, size_t length);
+
+/**
+ * @brief Envia dados pela conexão
+ * @param session Ponteiro para a sessão
+ * @param data Dados a enviar
+ * @param length Quantidade de bytes
+ * @return Bytes enviados (sempre length em caso de sucesso), -1 em caso de erro
+ */
+ssize_t tls_session_send(tls_session_t *session, const void *data, size_t length);
+
+/**
+ * @brief Envia os buffers de um iovec agrupando-os em registros TLS cheios
+ * @param session Ponteiro para a sessão
+ * @param iov Buffers a enviar
+ * @param iov_count Quantidade de buffers
+ * @return Bytes enviados, -1 em caso de erro
+ */
+ssize_t tls_session_sendv(tls_session_t *session, const struct iovec *iov, size_t iov_count);
+
+#endif // TLS_H
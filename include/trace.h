@@ -0,0 +1,122 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <time.h>
+#include "config.h"
+#include "http_parser.h"
+
+/**
+ * @file trace.h
+ * @brief Tracepoints estáticos (USDT) e rastreamento de requisições lentas
+ * @details Os probes TRACE_PROBE* usam sys/sdt.h quando disponível
+ *          (HAVE_SDT): cada probe é uma única instrução nop no código e uma
+ *          nota ELF que bpftrace, perf e SystemTap usam para instrumentá-lo em
+ *          tempo de execução. Sem ferramenta anexada o custo é nulo; sem
+ *          sys/sdt.h os probes desaparecem na compilação.
+ *
+ *          Probes do provider httpserver:
+ *          - conn__accept(fd, client_ip)
+ *          - parse__start(length)
+ *          - request__parsed(method, path, header_count)
+ *          - parse__error(code)
+ *          - handler__start(method, path)
+ *          - handler__end(method, path, status)
+ *          - response__sent(fd, status)
+ *          - conn__close(fd)
+ *
+ *          Exemplo: bpftrace -e 'usdt:./http_server:httpserver:handler__end { @[arg2] = count(); }'
+ *
+ *          O tracer em processo é independente dos probes: com trace_slow_ms
+ *          configurado, uma amostra das requisições registra o instante de
+ *          cada etapa, e as que excedem o limite são gravadas em trace_file
+ *          (uma linha JSON por requisição com a duração de cada etapa).
+ */
+
+#ifdef HAVE_SDT
+#include <sys/sdt.h>
+#define TRACE_PROBE1(name, a) DTRACE_PROBE1(httpserver, name, a)
+#define TRACE_PROBE2(name, a, b) DTRACE_PROBE2(httpserver, name, a, b)
+#define TRACE_PROBE3(name, a, b, c) DTRACE_PROBE3(httpserver, name, a, b, c)
+#else
+#define TRACE_PROBE1(name, a) do { } while (0)
+#define TRACE_PROBE2(name, a, b) do { } while (0)
+#define TRACE_PROBE3(name, a, b, c) do { } while (0)
+#endif
+
+// Etapas de uma requisição, na ordem em que ocorrem
+typedef enum {
+    TRACE_ACCEPTED = 0,      // Conexão aceita
+    TRACE_RECEIVED,          // Requisição recebida (inclui criação da thread e handshake TLS)
+    TRACE_PARSED,            // Parse concluído
+    TRACE_HANDLER_START,     // Roteamento, limite de taxa e cache concluídos
+    TRACE_HANDLER_END,       // Handler retornou
+    TRACE_SENT,              // Resposta enviada
+    TRACE_POINT_COUNT
+} trace_point_t;
+
+/** @brief Estrutura opaca do tracer */
+typedef struct tracer tracer_t;
+
+// Instantes registrados para uma requisição (0 = etapa não ocorreu)
+typedef struct {
+    int active;              // Requisição escolhida pela amostragem
+    uint64_t points[TRACE_POINT_COUNT];
+} request_trace_t;
+
+/**
+ * @brief Relógio usado pelo tracer
+ * @return Instante monotônico em microssegundos
+ */
+static inline uint64_t trace_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Registra o instante de uma etapa se a requisição está sendo rastreada
+ * @param trace Ponteiro para o rastreamento (pode ser NULL)
+ * @param point Etapa concluída
+ */
+static inline void trace_mark(request_trace_t *trace, trace_point_t point)
+{
+    if (trace && trace->active) {
+        trace->points[point] = trace_now_us();
+    }
+}
+
+/**
+ * @brief Cria o tracer a partir da configuração
+ * @param config Ponteiro para a configuração do servidor
+ * @return Ponteiro para o tracer, ou NULL se desabilitado ou em caso de erro
+ */
+tracer_t* tracer_create(const server_config_t *config);
+
+/**
+ * @brief Libera o tracer e fecha o arquivo
+ * @param tracer Ponteiro para o tracer
+ */
+void tracer_destroy(tracer_t *tracer);
+
+/**
+ * @brief Inicia o rastreamento de uma requisição, conforme a amostragem
+ * @param tracer Ponteiro para o tracer (pode ser NULL)
+ * @param trace Estrutura a inicializar
+ * @param accepted_us Instante do accept (trace_now_us), ou 0 se desconhecido
+ */
+void tracer_begin(tracer_t *tracer, request_trace_t *trace, uint64_t accepted_us);
+
+/**
+ * @brief Conclui o rastreamento e grava a requisição se ela excedeu trace_slow_ms
+ * @param tracer Ponteiro para o tracer (pode ser NULL)
+ * @param trace Rastreamento iniciado com tracer_begin()
+ * @param request Requisição parseada (pode ser NULL se o parse falhou)
+ * @param status Código de status enviado, ou 0 se desconhecido
+ * @param client_ip Endereço do cliente
+ */
+void tracer_finish(tracer_t *tracer, request_trace_t *trace, const http_request_t *request,
+                   int status, const char *client_ip);
+
+#endif // TRACE_H
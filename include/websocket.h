@@ -0,0 +1,199 @@
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "http_parser.h"
+#include "send_queue.h"
+
+/**
+ * @file websocket.h
+ * @brief Conexões WebSocket (RFC 6455)
+ * @details Trata o handshake de upgrade (Sec-WebSocket-Key) e o codec de
+ *          frames: mensagens fragmentadas, ping/pong e fechamento. A remoção
+ *          da máscara dos payloads do cliente é feita com SIMD, 16 ou 32 bytes
+ *          por instrução.
+ *
+ *          Os envios são enfileirados (send_queue.h) e escritos pela thread
+ *          da conexão. Um
+ *          frame é serializado uma única vez em um websocket_frame_t com
+ *          contagem de referências, e o mesmo buffer pode ser enfileirado em
+ *          muitas conexões (websocket_group_broadcast).
+ */
+
+// Opcodes de frame
+typedef enum {
+    WS_OPCODE_CONTINUATION = 0x0,
+    WS_OPCODE_TEXT = 0x1,
+    WS_OPCODE_BINARY = 0x2,
+    WS_OPCODE_CLOSE = 0x8,
+    WS_OPCODE_PING = 0x9,
+    WS_OPCODE_PONG = 0xA
+} websocket_opcode_t;
+
+// Códigos de fechamento
+typedef enum {
+    WS_CLOSE_NORMAL = 1000,
+    WS_CLOSE_GOING_AWAY = 1001,
+    WS_CLOSE_PROTOCOL_ERROR = 1002,
+    WS_CLOSE_UNSUPPORTED = 1003,
+    WS_CLOSE_NO_STATUS = 1005,
+    WS_CLOSE_ABNORMAL = 1006,
+    WS_CLOSE_INVALID_DATA = 1007,
+    WS_CLOSE_POLICY_VIOLATION = 1008,
+    WS_CLOSE_TOO_BIG = 1009
+} websocket_close_code_t;
+
+/** @brief Conexão WebSocket */
+typedef struct websocket websocket_t;
+
+/** @brief Frame serializado e compartilhável (referência contada) */
+typedef send_buffer_t websocket_frame_t;
+
+/** @brief Conjunto de conexões que recebem os mesmos frames */
+typedef send_group_t websocket_group_t;
+
+/**
+ * @brief Funções de uma aplicação WebSocket
+ * @details Todas são opcionais e executam na thread da conexão.
+ */
+typedef struct {
+    /**
+     * @brief Chamada após o handshake, antes de qualquer mensagem
+     * @return 0 para aceitar a conexão; valor negativo a encerra com 1008
+     */
+    int (*on_open)(websocket_t *ws, const http_request_view_t *request, void *user_data);
+
+    /**
+     * @brief Chamada para cada mensagem completa (já remontada e sem máscara)
+     * @param opcode WS_OPCODE_TEXT ou WS_OPCODE_BINARY
+     */
+    void (*on_message)(websocket_t *ws, websocket_opcode_t opcode, const char *data, size_t length,
+                       void *user_data);
+
+    /**
+     * @brief Chamada uma única vez quando a conexão termina
+     * @param code Código recebido do cliente, ou WS_CLOSE_ABNORMAL se a conexão caiu
+     * @note Após o retorno o websocket_t é liberado; a aplicação deve removê-lo
+     *       dos grupos aqui
+     */
+    void (*on_close)(websocket_t *ws, int code, void *user_data);
+} websocket_handler_t;
+
+/**
+ * @brief Verifica se a requisição é um pedido de upgrade para WebSocket
+ * @param request Requisição parseada
+ * @return 1 se contém Upgrade: websocket e Connection: Upgrade, 0 caso contrário
+ */
+int websocket_is_upgrade_request(const http_request_t *request);
+
+/**
+ * @brief Realiza o handshake e atende a conexão até o fechamento
+ * @details Responde 400 quando o handshake é inválido (método, versão HTTP ou
+ *          Sec-WebSocket-Key) e 426 quando Sec-WebSocket-Version não é 13.
+ *
+ * @param client_socket Socket do cliente
+ * @param config Ponteiro para a configuração do servidor
+ * @param request Requisição de upgrade
+ * @param initial Bytes recebidos após a requisição (frames antecipados)
+ * @param initial_length Quantidade de bytes em initial
+ * @param handler Funções da aplicação
+ * @param user_data Ponteiro repassado às funções da aplicação
+ * @return 0 em fechamento normal, -1 em caso de erro
+ */
+int websocket_serve(int client_socket, const server_config_t *config, const http_request_t *request,
+                    const char *initial, size_t initial_length,
+                    const websocket_handler_t *handler, void *user_data);
+
+/**
+ * @brief Serializa um frame de servidor (FIN, sem máscara)
+ * @param opcode Opcode do frame
+ * @param data Payload
+ * @param length Tamanho do payload
+ * @return Frame com uma referência, ou NULL em caso de erro
+ */
+websocket_frame_t* websocket_frame_create(websocket_opcode_t opcode, const void *data, size_t length);
+
+/**
+ * @brief Adiciona uma referência ao frame
+ * @param frame Ponteiro para o frame
+ */
+void websocket_frame_retain(websocket_frame_t *frame);
+
+/**
+ * @brief Remove uma referência e libera o frame na última
+ * @param frame Ponteiro para o frame
+ */
+void websocket_frame_release(websocket_frame_t *frame);
+
+/**
+ * @brief Enfileira um frame já serializado
+ * @details A fila adiciona sua própria referência. Se a fila da conexão
+ *          ultrapassar websocket_max_queue_bytes o cliente é considerado lento
+ *          e a conexão é encerrada.
+ *
+ * @param ws Conexão de destino
+ * @param frame Frame serializado
+ * @return 0 em caso de sucesso, -1 se a conexão está fechando ou foi descartada
+ *
+ * @note Pode ser chamada de qualquer thread
+ */
+int websocket_send_frame(websocket_t *ws, websocket_frame_t *frame);
+
+/**
+ * @brief Serializa e enfileira uma mensagem
+ * @param ws Conexão de destino
+ * @param opcode WS_OPCODE_TEXT, WS_OPCODE_BINARY, WS_OPCODE_PING ou WS_OPCODE_PONG
+ * @param data Payload
+ * @param length Tamanho do payload
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ */
+int websocket_send(websocket_t *ws, websocket_opcode_t opcode, const void *data, size_t length);
+
+/**
+ * @brief Inicia o fechamento da conexão
+ * @param ws Conexão
+ * @param code Código de fechamento
+ * @param reason Motivo (pode ser NULL, até 123 bytes)
+ * @return 0 em caso de sucesso, -1 se o fechamento já foi iniciado
+ */
+int websocket_close(websocket_t *ws, uint16_t code, const char *reason);
+
+/**
+ * @brief Cria um grupo vazio
+ * @return Ponteiro para o grupo, ou NULL em caso de erro
+ */
+websocket_group_t* websocket_group_create(void);
+
+/**
+ * @brief Libera o grupo (as conexões não são afetadas)
+ * @param group Ponteiro para o grupo
+ */
+void websocket_group_destroy(websocket_group_t *group);
+
+/**
+ * @brief Adiciona uma conexão ao grupo
+ * @return 0 em caso de sucesso, -1 em caso de erro
+ */
+int websocket_group_add(websocket_group_t *group, websocket_t *ws);
+
+/**
+ * @brief Remove uma conexão do grupo
+ */
+void websocket_group_remove(websocket_group_t *group, websocket_t *ws);
+
+/**
+ * @brief Envia a mesma mensagem a todas as conexões do grupo
+ * @details O frame é serializado uma vez e compartilhado pelas filas.
+ *
+ * @param group Ponteiro para o grupo
+ * @param opcode Opcode da mensagem
+ * @param data Payload
+ * @param length Tamanho do payload
+ * @return Quantidade de conexões que receberam o frame, -1 em caso de erro
+ */
+int websocket_group_broadcast(websocket_group_t *group, websocket_opcode_t opcode,
+                              const void *data, size_t length);
+
+#endif // WEBSOCKET_H
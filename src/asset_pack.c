@@ -0,0 +1,369 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "asset_pack.h"
+#include "http_response.h"
+#include "socket_utils.h"
+#include "response_header.h"
+
+struct asset_pack {
+    int fd;                              // Usado pelo sendfile
+    const char *data;                    // Arquivo inteiro mapeado
+    size_t size;
+    const asset_pack_header_t *header;
+    const asset_pack_entry_t *entries;
+    const uint32_t *buckets;
+    const uint32_t *slots;
+};
+
+static const char *encoding_names[ASSET_ENCODING_COUNT] = { NULL, "gzip", "br" };
+
+// Funções auxiliares internas
+static int validate_pack(asset_pack_t *pack);
+static int string_in_pack(const asset_pack_t *pack, uint64_t offset);
+static int accepts_encoding(const char *accept, const char *name);
+static asset_encoding_t choose_encoding(const asset_pack_entry_t *entry, const http_request_t *request);
+static int etag_matches(const http_request_t *request, const char *etag);
+static int has_variants(const asset_pack_entry_t *entry);
+
+uint64_t asset_pack_hash(const char *data, size_t length, uint32_t seed)
+{
+    // FNV-1a seguido do finalizador do MurmurHash3 para espalhar os bits
+    uint64_t hash = 14695981039346656037ULL ^ seed;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+uint32_t asset_pack_slot(uint64_t hash, uint32_t displacement)
+{
+    uint32_t value = (uint32_t)(hash >> 32) ^ (displacement * 0x9e3779b9u);
+    value ^= value >> 16;
+    value *= 0x85ebca6bu;
+    value ^= value >> 13;
+    value *= 0xc2b2ae35u;
+    value ^= value >> 16;
+    return value;
+}
+
+asset_pack_t* asset_pack_open(const char *path)
+{
+    if (!path) {
+        return NULL;
+    }
+
+    asset_pack_t *pack = calloc(1, sizeof(asset_pack_t));
+    if (!pack) {
+        perror("Erro ao alocar o pacote de arquivos");
+        return NULL;
+    }
+
+    pack->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (pack->fd < 0) {
+        perror("Erro ao abrir o pacote de arquivos");
+        free(pack);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(pack->fd, &st) < 0 || (size_t)st.st_size < sizeof(asset_pack_header_t)) {
+        fprintf(stderr, "Pacote de arquivos inválido: %s\n", path);
+        close(pack->fd);
+        free(pack);
+        return NULL;
+    }
+
+    pack->size = st.st_size;
+    void *data = mmap(NULL, pack->size, PROT_READ, MAP_SHARED, pack->fd, 0);
+    if (data == MAP_FAILED) {
+        perror("Erro ao mapear o pacote de arquivos");
+        close(pack->fd);
+        free(pack);
+        return NULL;
+    }
+    pack->data = data;
+    pack->header = (const asset_pack_header_t*)pack->data;
+
+    if (validate_pack(pack) < 0) {
+        fprintf(stderr, "Pacote de arquivos inválido: %s\n", path);
+        asset_pack_close(pack);
+        return NULL;
+    }
+
+    // O índice é lido a cada requisição: carrega suas páginas antecipadamente
+    madvise((void*)pack->data, pack->header->slots_offset + pack->header->entry_count * sizeof(uint32_t),
+            MADV_WILLNEED);
+
+    return pack;
+}
+
+void asset_pack_close(asset_pack_t *pack)
+{
+    if (!pack) {
+        return;
+    }
+
+    munmap((void*)pack->data, pack->size);
+    close(pack->fd);
+    free(pack);
+}
+
+const asset_pack_entry_t* asset_pack_find(const asset_pack_t *pack, const char *path)
+{
+    if (!pack || !path || pack->header->entry_count == 0) {
+        return NULL;
+    }
+
+    size_t length = strlen(path);
+    uint64_t hash = asset_pack_hash(path, length, pack->header->seed);
+    uint32_t displacement = pack->buckets[(uint32_t)hash % pack->header->bucket_count];
+    const asset_pack_entry_t *entry =
+        &pack->entries[pack->slots[asset_pack_slot(hash, displacement) % pack->header->entry_count]];
+
+    if (entry->path_length != length || memcmp(pack->data + entry->path_offset, path, length) != 0) {
+        return NULL;
+    }
+    return entry;
+}
+
+int asset_pack_serve(int client_socket, const asset_pack_t *pack, const asset_pack_entry_t *entry,
+                     const http_request_t *request)
+{
+    const asset_pack_variant_t *variant = &entry->variants[choose_encoding(entry, request)];
+    const char *etag = pack->data + variant->etag_offset;
+
+    if (etag_matches(request, etag)) {
+        size_t date_length;
+        const char *date = response_header_date(&date_length);
+        char header[384];
+        int length = snprintf(header, sizeof(header),
+                              "HTTP/1.1 304 Not Modified\r\n"
+                              "%.*s"
+                              "ETag: %s\r\n"
+                              "%s"
+                              "\r\n", (int)date_length, date, etag,
+                              has_variants(entry) ? "Vary: Accept-Encoding\r\n" : "");
+        if (length <= 0 || (size_t)length >= sizeof(header)) {
+            return -1;
+        }
+        return http_send_all(client_socket, header, length) < 0 ? -1 : 304;
+    }
+
+    // O bloco do pacote termina com a linha em branco (conferida em validate_pack); o
+    // bloco de response_header_date, com Date e Server, entra antes dela
+    size_t date_length;
+    const char *date = response_header_date(&date_length);
+    struct iovec iov[3];
+    iov[0].iov_base = (void*)(pack->data + variant->header_offset);
+    iov[0].iov_len = variant->header_length - 2;
+    iov[1].iov_base = (void*)date;
+    iov[1].iov_len = date_length;
+    iov[2].iov_base = "\r\n";
+    iov[2].iov_len = 2;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 3;
+
+    if (strcmp(request->method, "HEAD") == 0 || variant->length == 0) {
+        return socket_sendmsg(client_socket, &msg, 0) < 0 ? -1 : 200;
+    }
+
+    // MSG_MORE junta o header ao início do corpo no mesmo segmento
+    if (socket_sendmsg(client_socket, &msg, MSG_MORE) < 0) {
+        return -1;
+    }
+
+    off_t offset = variant->offset;
+    size_t remaining = variant->length;
+    while (remaining > 0) {
+        ssize_t sent = socket_sendfile(client_socket, pack->fd, &offset, remaining);
+        if (sent <= 0) {
+            return -1;
+        }
+        remaining -= sent;
+    }
+
+    return 200;
+}
+
+void asset_pack_response(const asset_pack_t *pack, const asset_pack_entry_t *entry,
+                         const http_request_t *request, http_response_t *response)
+{
+    asset_encoding_t encoding = choose_encoding(entry, request);
+    const asset_pack_variant_t *variant = &entry->variants[encoding];
+    const char *etag = pack->data + variant->etag_offset;
+
+    http_response_set_status(response, 200, NULL);
+    response->content_type = pack->data + entry->content_type_offset;
+    http_response_add_header(response, "ETag", etag);
+    if (has_variants(entry)) {
+        http_response_add_header(response, "Vary", "Accept-Encoding");
+    }
+
+    if (etag_matches(request, etag)) {
+        http_response_set_status(response, 304, NULL);
+        return;
+    }
+
+    if (encoding_names[encoding]) {
+        http_response_add_header(response, "Content-Encoding", encoding_names[encoding]);
+    }
+    http_response_set_body(response, pack->data + variant->offset, variant->length);
+}
+
+// Implementação das funções auxiliares internas
+
+// Confere que todas as tabelas, strings e conteúdos estão dentro do arquivo
+static int validate_pack(asset_pack_t *pack)
+{
+    const asset_pack_header_t *header = pack->header;
+
+    if (memcmp(header->magic, ASSET_PACK_MAGIC, ASSET_PACK_MAGIC_LENGTH) != 0 ||
+        header->version != ASSET_PACK_VERSION || header->file_size != pack->size ||
+        (header->entry_count > 0 && header->bucket_count == 0)) {
+        return -1;
+    }
+
+    uint64_t count = header->entry_count;
+    if (header->entries_offset % sizeof(uint64_t) != 0 || header->buckets_offset % sizeof(uint32_t) != 0 ||
+        header->slots_offset % sizeof(uint32_t) != 0 ||
+        header->entries_offset > pack->size ||
+        count > (pack->size - header->entries_offset) / sizeof(asset_pack_entry_t) ||
+        header->buckets_offset > pack->size ||
+        header->bucket_count > (pack->size - header->buckets_offset) / sizeof(uint32_t) ||
+        header->slots_offset > pack->size ||
+        count > (pack->size - header->slots_offset) / sizeof(uint32_t)) {
+        return -1;
+    }
+
+    pack->entries = (const asset_pack_entry_t*)(pack->data + header->entries_offset);
+    pack->buckets = (const uint32_t*)(pack->data + header->buckets_offset);
+    pack->slots = (const uint32_t*)(pack->data + header->slots_offset);
+
+    for (uint64_t i = 0; i < count; i++) {
+        if (pack->slots[i] >= count) {
+            return -1;
+        }
+
+        const asset_pack_entry_t *entry = &pack->entries[i];
+        if (!string_in_pack(pack, entry->path_offset) || !string_in_pack(pack, entry->content_type_offset) ||
+            strlen(pack->data + entry->path_offset) != entry->path_length ||
+            entry->variants[ASSET_ENCODING_IDENTITY].header_length == 0) {
+            return -1;
+        }
+
+        for (int e = 0; e < ASSET_ENCODING_COUNT; e++) {
+            const asset_pack_variant_t *variant = &entry->variants[e];
+            if (variant->header_length == 0) {
+                continue;
+            }
+            if (variant->header_offset > pack->size || variant->header_length > pack->size - variant->header_offset ||
+                variant->offset > pack->size || variant->length > pack->size - variant->offset ||
+                !string_in_pack(pack, variant->etag_offset)) {
+                return -1;
+            }
+            // asset_pack_serve insere headers antes da linha em branco final
+            if (variant->header_length < 4 ||
+                memcmp(pack->data + variant->header_offset + variant->header_length - 4, "\r\n\r\n", 4) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+// Verifica se há uma string terminada em nulo a partir de offset
+static int string_in_pack(const asset_pack_t *pack, uint64_t offset)
+{
+    return offset < pack->size && memchr(pack->data + offset, '\0', pack->size - offset) != NULL;
+}
+
+// Procura a codificação na lista do Accept-Encoding, ignorando as marcadas com q=0
+static int accepts_encoding(const char *accept, const char *name)
+{
+    size_t name_length = strlen(name);
+    const char *p = accept;
+
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') {
+            p++;
+        }
+        const char *token = p;
+        while (*p && *p != ',' && *p != ';' && *p != ' ' && *p != '\t') {
+            p++;
+        }
+        size_t token_length = p - token;
+
+        double quality = 1;
+        const char *end = strchr(p, ',');
+        const char *q = strstr(p, "q=");
+        if (q && (!end || q < end)) {
+            quality = strtod(q + 2, NULL);
+        }
+
+        if (token_length == name_length && strncasecmp(token, name, name_length) == 0) {
+            return quality > 0;
+        }
+        if (!end) {
+            break;
+        }
+        p = end + 1;
+    }
+
+    return 0;
+}
+
+// Brotli tem preferência sobre gzip quando o cliente aceita os dois
+static asset_encoding_t choose_encoding(const asset_pack_entry_t *entry, const http_request_t *request)
+{
+    if (!has_variants(entry)) {
+        return ASSET_ENCODING_IDENTITY;
+    }
+
+    const http_header_t *accept = http_request_get_header(request, "Accept-Encoding");
+    if (!accept) {
+        return ASSET_ENCODING_IDENTITY;
+    }
+
+    if (entry->variants[ASSET_ENCODING_BROTLI].header_length > 0 && accepts_encoding(accept->value, "br")) {
+        return ASSET_ENCODING_BROTLI;
+    }
+    if (entry->variants[ASSET_ENCODING_GZIP].header_length > 0 && accepts_encoding(accept->value, "gzip")) {
+        return ASSET_ENCODING_GZIP;
+    }
+    return ASSET_ENCODING_IDENTITY;
+}
+
+// If-None-Match com "*" ou contendo a ETag (com aspas, portanto sem falsos prefixos)
+static int etag_matches(const http_request_t *request, const char *etag)
+{
+    const http_header_t *header = http_request_get_header(request, "If-None-Match");
+    if (!header) {
+        return 0;
+    }
+    return strcmp(header->value, "*") == 0 || strstr(header->value, etag) != NULL;
+}
+
+static int has_variants(const asset_pack_entry_t *entry)
+{
+    return entry->variants[ASSET_ENCODING_GZIP].header_length > 0 ||
+           entry->variants[ASSET_ENCODING_BROTLI].header_length > 0;
+}
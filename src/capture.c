@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "capture.h"
+
+struct capture {
+    int fd;
+    uint64_t start_us;
+    size_t max_bytes;
+    size_t bytes;             // Bytes reservados no arquivo (atômico)
+    int full;                 // Limite atingido (atômico)
+};
+
+// Funções auxiliares internas
+static uint64_t now_us(void);
+static void put_le(unsigned char *out, uint64_t value, int bytes);
+static uint64_t get_le(const unsigned char *in, int bytes);
+static int compare_records(const void *a, const void *b);
+
+capture_t* capture_open(const server_config_t *config)
+{
+    if (!config || config->capture_file[0] == '\0') {
+        return NULL;
+    }
+
+    capture_t *capture = calloc(1, sizeof(capture_t));
+    if (!capture) {
+        perror("Erro ao alocar captura");
+        return NULL;
+    }
+
+    // As requisições são gravadas inteiras, com Authorization e Cookie: só o dono lê.
+    // fchmod cobre um arquivo pré-existente, que O_CREAT não altera
+    capture->fd = open(config->capture_file, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+    if (capture->fd < 0) {
+        perror("Erro ao abrir arquivo de captura");
+        free(capture);
+        return NULL;
+    }
+    if (fchmod(capture->fd, 0600) < 0) {
+        perror("Erro ao restringir permissões do arquivo de captura");
+        close(capture->fd);
+        free(capture);
+        return NULL;
+    }
+
+    if (write(capture->fd, CAPTURE_MAGIC, CAPTURE_MAGIC_LENGTH) != CAPTURE_MAGIC_LENGTH) {
+        perror("Erro ao gravar arquivo de captura");
+        close(capture->fd);
+        free(capture);
+        return NULL;
+    }
+
+    capture->start_us = now_us();
+    capture->max_bytes = config->capture_max_bytes;
+    capture->bytes = CAPTURE_MAGIC_LENGTH;
+
+    printf("Capturando requisições em %s\n", config->capture_file);
+    return capture;
+}
+
+void capture_close(capture_t *capture)
+{
+    if (!capture) {
+        return;
+    }
+
+    close(capture->fd);
+    free(capture);
+}
+
+void capture_record(capture_t *capture, const char *data, size_t length)
+{
+    if (!capture || !data || length == 0 || length > UINT32_MAX ||
+        __atomic_load_n(&capture->full, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    // Reserva o espaço antes de gravar para que o limite valha entre threads
+    size_t need = CAPTURE_RECORD_HEADER + length;
+    size_t used = __atomic_fetch_add(&capture->bytes, need, __ATOMIC_RELAXED);
+    if (used + need > capture->max_bytes) {
+        if (!__atomic_exchange_n(&capture->full, 1, __ATOMIC_RELAXED)) {
+            fprintf(stderr, "Captura atingiu capture_max_bytes; novas requisições não serão gravadas\n");
+        }
+        return;
+    }
+
+    unsigned char header[CAPTURE_RECORD_HEADER];
+    put_le(header, now_us() - capture->start_us, 8);
+    put_le(header + 8, length, 4);
+
+    struct iovec iov[2] = {
+        { .iov_base = header, .iov_len = sizeof(header) },
+        { .iov_base = (void*)data, .iov_len = length }
+    };
+
+    if (writev(capture->fd, iov, 2) != (ssize_t)need) {
+        perror("Erro ao gravar arquivo de captura");
+        __atomic_store_n(&capture->full, 1, __ATOMIC_RELAXED);
+    }
+}
+
+int capture_trace_load(const char *filename, capture_trace_t *trace)
+{
+    if (!filename || !trace) {
+        return -1;
+    }
+    memset(trace, 0, sizeof(*trace));
+
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror("Erro ao abrir arquivo de captura");
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < CAPTURE_MAGIC_LENGTH) {
+        fprintf(stderr, "Arquivo de captura inválido: %s\n", filename);
+        close(fd);
+        return -1;
+    }
+
+    size_t size = st.st_size;
+    trace->blob = malloc(size);
+    if (!trace->blob) {
+        perror("Erro ao alocar trace");
+        close(fd);
+        return -1;
+    }
+
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = read(fd, trace->blob + done, size - done);
+        if (n <= 0) {
+            perror("Erro ao ler arquivo de captura");
+            close(fd);
+            capture_trace_free(trace);
+            return -1;
+        }
+        done += n;
+    }
+    close(fd);
+
+    if (memcmp(trace->blob, CAPTURE_MAGIC, CAPTURE_MAGIC_LENGTH) != 0) {
+        fprintf(stderr, "Arquivo de captura inválido: %s\n", filename);
+        capture_trace_free(trace);
+        return -1;
+    }
+
+    // Primeira passada conta os registros; a segunda preenche o array
+    for (int pass = 0; pass < 2; pass++) {
+        size_t offset = CAPTURE_MAGIC_LENGTH;
+        size_t count = 0;
+
+        while (size - offset >= CAPTURE_RECORD_HEADER) {
+            const unsigned char *header = (const unsigned char*)trace->blob + offset;
+            uint64_t length = get_le(header + 8, 4);
+            if (length > size - offset - CAPTURE_RECORD_HEADER) {
+                break;  // Registro truncado (servidor encerrado durante a gravação)
+            }
+
+            if (pass == 1) {
+                trace->records[count].timestamp_us = get_le(header, 8);
+                trace->records[count].data = trace->blob + offset + CAPTURE_RECORD_HEADER;
+                trace->records[count].length = length;
+            }
+            count++;
+            offset += CAPTURE_RECORD_HEADER + length;
+        }
+
+        if (pass == 0) {
+            trace->records = malloc((count ? count : 1) * sizeof(capture_record_t));
+            if (!trace->records) {
+                perror("Erro ao alocar trace");
+                capture_trace_free(trace);
+                return -1;
+            }
+        }
+        trace->count = count;
+    }
+
+    // Registros gravados por threads diferentes podem estar fora de ordem;
+    // o desempate pela posição no arquivo mantém a ordenação determinística
+    qsort(trace->records, trace->count, sizeof(capture_record_t), compare_records);
+    return 0;
+}
+
+void capture_trace_free(capture_trace_t *trace)
+{
+    if (!trace) {
+        return;
+    }
+
+    free(trace->records);
+    free(trace->blob);
+    memset(trace, 0, sizeof(*trace));
+}
+
+// Implementação das funções auxiliares internas
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void put_le(unsigned char *out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        out[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+static uint64_t get_le(const unsigned char *in, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+static int compare_records(const void *a, const void *b)
+{
+    const capture_record_t *ra = (const capture_record_t*)a;
+    const capture_record_t *rb = (const capture_record_t*)b;
+
+    if (ra->timestamp_us != rb->timestamp_us) {
+        return ra->timestamp_us < rb->timestamp_us ? -1 : 1;
+    }
+    return ra->data < rb->data ? -1 : (ra->data > rb->data);
+}
@@ -1,9 +1,99 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/un.h>
 #include "config.h"
 
-#define MAX_LINE 256
+#define MAX_LINE 1024
+
+// Lê uma rota no formato "prefixo upstream1 upstream2 ..."
+static int parse_proxy_route(server_config_t *config, char *value) {
+    if (config->proxy_route_count >= MAX_PROXY_ROUTES) {
+        fprintf(stderr, "Número máximo de rotas de proxy excedido\n");
+        return -1;
+    }
+
+    proxy_route_config_t *route = &config->proxy_routes[config->proxy_route_count];
+    memset(route, 0, sizeof(*route));
+
+    char *saveptr = NULL;
+    char *token = strtok_r(value, " \t", &saveptr);
+    if (!token) {
+        fprintf(stderr, "Rota de proxy sem prefixo\n");
+        return -1;
+    }
+    strncpy(route->prefix, token, sizeof(route->prefix) - 1);
+
+    while ((token = strtok_r(NULL, " \t", &saveptr)) != NULL) {
+        if (route->upstream_count >= MAX_PROXY_UPSTREAMS) {
+            fprintf(stderr, "Número máximo de upstreams excedido na rota %s\n", route->prefix);
+            return -1;
+        }
+        strncpy(route->upstreams[route->upstream_count], token,
+                sizeof(route->upstreams[0]) - 1);
+        route->upstream_count++;
+    }
+
+    config->proxy_route_count++;
+    return 0;
+}
+
+// Lê um listener no formato "endereço [tls] [ipv6only] [mode=0660]"
+static int parse_listener(server_config_t *config, char *value) {
+    if (config->listener_count >= MAX_LISTENERS) {
+        fprintf(stderr, "Número máximo de listeners excedido\n");
+        return -1;
+    }
+
+    listener_config_t *listener = &config->listeners[config->listener_count];
+    memset(listener, 0, sizeof(*listener));
+    listener->mode = 0660;
+
+    char *saveptr = NULL;
+    char *token = strtok_r(value, " \t", &saveptr);
+    if (!token || strlen(token) >= sizeof(listener->address)) return -1;
+    strncpy(listener->address, token, sizeof(listener->address) - 1);
+
+    // Unix: caminho não vazio que caiba em sun_path; TCP: porta após o último ':'
+    if (strncmp(token, "unix:", 5) == 0) {
+        size_t path_length = strlen(token + 5);
+        if (path_length == 0 || path_length >= sizeof(((struct sockaddr_un*)0)->sun_path)) {
+            fprintf(stderr, "Caminho de socket Unix inválido: %s\n", token);
+            return -1;
+        }
+    } else {
+        char *colon = strrchr(token, ':');
+        char *end = NULL;
+        long port = colon ? strtol(colon + 1, &end, 10) : 0;
+        if (!colon || colon == token || *end != '\0' || port < 1 || port > 65535 ||
+            (token[0] == '[' && colon[-1] != ']')) {
+            fprintf(stderr, "Endereço de escuta inválido: %s\n", token);
+            return -1;
+        }
+    }
+
+    while ((token = strtok_r(NULL, " \t", &saveptr)) != NULL) {
+        if (strcmp(token, "tls") == 0) {
+            listener->tls = 1;
+        } else if (strcmp(token, "ipv6only") == 0) {
+            listener->ipv6_only = 1;
+        } else if (strncmp(token, "mode=", 5) == 0) {
+            char *end = NULL;
+            long mode = strtol(token + 5, &end, 8);
+            if (end == token + 5 || *end != '\0' || mode < 0 || mode > 0777) {
+                fprintf(stderr, "Permissão de listener inválida (0 a 0777): %s\n", token);
+                return -1;
+            }
+            listener->mode = (int)mode;
+        } else {
+            fprintf(stderr, "Opção de listener desconhecida: %s\n", token);
+            return -1;
+        }
+    }
+
+    config->listener_count++;
+    return 0;
+}
 
 static int parse_line(char *line, char **key, char **value) {
     char *equals = strchr(line, '=');
@@ -38,6 +128,7 @@ void init_default_config(server_config_t *config) {
 
     // Valores padrão básicos do servidor
     config->port = 8080;
+    config->listener_count = 0;
     config->max_connections = 10;
     config->buffer_size = 8192;
     
@@ -49,8 +140,78 @@ void init_default_config(server_config_t *config) {
     
     // Diretório e logging
     strncpy(config->root_directory, "./www", sizeof(config->root_directory) - 1);
+    config->asset_pack[0] = '\0';
     config->logging_enabled = 1;
     strncpy(config->log_file, "http-server.log", sizeof(config->log_file) - 1);
+
+    // Ajustes de TCP
+    config->tcp_nodelay = 1;
+    config->tcp_cork = 0;
+    config->tcp_defer_accept = 0;
+    config->tcp_fastopen = 0;
+    config->send_buffer_size = 0;
+    config->recv_buffer_size = 0;
+
+    // Proxy reverso
+    config->proxy_route_count = 0;
+    strncpy(config->proxy_balance, "round_robin", sizeof(config->proxy_balance) - 1);
+    config->proxy_pool_size = 16;
+    config->proxy_health_interval = 5;
+
+    // Microcache
+    config->cache_enabled = 0;
+    config->cache_ttl_ms = 1000;
+    config->cache_max_bytes = 64 * 1024 * 1024;
+    strncpy(config->cache_vary_headers, "Accept-Encoding", sizeof(config->cache_vary_headers) - 1);
+
+    // HTTP/2
+    config->http2_enabled = 1;
+    config->http2_max_concurrent_streams = 256;
+    config->http2_initial_window_size = 65535;
+
+    // TLS
+    config->tls_port = 0;
+    strncpy(config->tls_certificate, "config/cert.pem", sizeof(config->tls_certificate) - 1);
+    strncpy(config->tls_private_key, "config/key.pem", sizeof(config->tls_private_key) - 1);
+    config->tls_session_cache_size = 20480;
+    config->tls_session_timeout = 300;
+    config->tls_session_tickets = 1;
+    config->tls_ktls = 1;
+
+    // WebSocket
+    config->websocket_max_message_size = 1024 * 1024;
+    config->websocket_max_queue_bytes = 4 * 1024 * 1024;
+
+    // Limite de taxa por cliente
+    config->rate_limit_requests = 0;
+    config->rate_limit_request_burst = 100;
+    config->rate_limit_connections = 0;
+    config->rate_limit_connection_burst = 50;
+    config->rate_limit_ipv4_prefix = 32;
+    config->rate_limit_ipv6_prefix = 64;
+    config->rate_limit_table_size = 65536;
+
+    // Captura de tráfego
+    config->capture_file[0] = '\0';
+    config->capture_max_bytes = 1024UL * 1024 * 1024;
+
+    // Rastreamento de requisições lentas
+    config->trace_slow_ms = 0;
+    config->trace_sample_rate = 1;
+    strncpy(config->trace_file, "slow-requests.log", sizeof(config->trace_file) - 1);
+
+    // Corrotinas
+    config->coroutine_workers = 0;
+    config->coroutine_stack_size = 256 * 1024;
+
+    // Uploads multipart
+    strncpy(config->upload_directory, "/tmp", sizeof(config->upload_directory) - 1);
+    config->upload_max_size = 100UL * 1024 * 1024;
+    config->upload_max_part_size = 50UL * 1024 * 1024;
+
+    // Respostas em streaming
+    config->stream_max_queue_bytes = 1024 * 1024;
+    config->stream_coalesce_ms = 0;
 }
 
 int load_config(server_config_t *config, const char *filename) {
@@ -68,6 +229,7 @@ int load_config(server_config_t *config, const char *filename) {
     }
     
     char line[MAX_LINE];
+    int invalid = 0;
     while (fgets(line, sizeof(line), f)) {
         // Ignora linhas vazias e comentários
         if (line[0] == '\n' || line[0] == '#') continue;
@@ -76,6 +238,10 @@ int load_config(server_config_t *config, const char *filename) {
         if (parse_line(line, &key, &value) == 0) {
             if (strcmp(key, "port") == 0) {
                 config->port = atoi(value);
+            } else if (strcmp(key, "listen") == 0) {
+                if (parse_listener(config, value) < 0) {
+                    invalid = 1;
+                }
             } else if (strcmp(key, "max_connections") == 0) {
                 config->max_connections = atoi(value);
             } else if (strcmp(key, "buffer_size") == 0) {
@@ -90,15 +256,112 @@ int load_config(server_config_t *config, const char *filename) {
                 config->non_blocking = atoi(value);
             } else if (strcmp(key, "root_directory") == 0) {
                 strncpy(config->root_directory, value, sizeof(config->root_directory) - 1);
+            } else if (strcmp(key, "asset_pack") == 0) {
+                strncpy(config->asset_pack, value, sizeof(config->asset_pack) - 1);
             } else if (strcmp(key, "logging_enabled") == 0) {
                 config->logging_enabled = atoi(value);
             } else if (strcmp(key, "log_file") == 0) {
                 strncpy(config->log_file, value, sizeof(config->log_file) - 1);
+            } else if (strcmp(key, "tcp_nodelay") == 0) {
+                config->tcp_nodelay = atoi(value);
+            } else if (strcmp(key, "tcp_cork") == 0) {
+                config->tcp_cork = atoi(value);
+            } else if (strcmp(key, "tcp_defer_accept") == 0) {
+                config->tcp_defer_accept = atoi(value);
+            } else if (strcmp(key, "tcp_fastopen") == 0) {
+                config->tcp_fastopen = atoi(value);
+            } else if (strcmp(key, "send_buffer_size") == 0) {
+                config->send_buffer_size = atoi(value);
+            } else if (strcmp(key, "recv_buffer_size") == 0) {
+                config->recv_buffer_size = atoi(value);
+            } else if (strcmp(key, "proxy_route") == 0) {
+                if (parse_proxy_route(config, value) < 0) {
+                    invalid = 1;
+                }
+            } else if (strcmp(key, "proxy_balance") == 0) {
+                strncpy(config->proxy_balance, value, sizeof(config->proxy_balance) - 1);
+            } else if (strcmp(key, "proxy_pool_size") == 0) {
+                config->proxy_pool_size = atoi(value);
+            } else if (strcmp(key, "proxy_health_interval") == 0) {
+                config->proxy_health_interval = atoi(value);
+            } else if (strcmp(key, "cache_enabled") == 0) {
+                config->cache_enabled = atoi(value);
+            } else if (strcmp(key, "cache_ttl_ms") == 0) {
+                config->cache_ttl_ms = atoi(value);
+            } else if (strcmp(key, "cache_max_bytes") == 0) {
+                config->cache_max_bytes = strtoull(value, NULL, 10);
+            } else if (strcmp(key, "cache_vary_headers") == 0) {
+                strncpy(config->cache_vary_headers, value, sizeof(config->cache_vary_headers) - 1);
+            } else if (strcmp(key, "http2_enabled") == 0) {
+                config->http2_enabled = atoi(value);
+            } else if (strcmp(key, "http2_max_concurrent_streams") == 0) {
+                config->http2_max_concurrent_streams = atoi(value);
+            } else if (strcmp(key, "http2_initial_window_size") == 0) {
+                config->http2_initial_window_size = atoi(value);
+            } else if (strcmp(key, "tls_port") == 0) {
+                config->tls_port = atoi(value);
+            } else if (strcmp(key, "tls_certificate") == 0) {
+                strncpy(config->tls_certificate, value, sizeof(config->tls_certificate) - 1);
+            } else if (strcmp(key, "tls_private_key") == 0) {
+                strncpy(config->tls_private_key, value, sizeof(config->tls_private_key) - 1);
+            } else if (strcmp(key, "tls_session_cache_size") == 0) {
+                config->tls_session_cache_size = atoi(value);
+            } else if (strcmp(key, "tls_session_timeout") == 0) {
+                config->tls_session_timeout = atoi(value);
+            } else if (strcmp(key, "tls_session_tickets") == 0) {
+                config->tls_session_tickets = atoi(value);
+            } else if (strcmp(key, "tls_ktls") == 0) {
+                config->tls_ktls = atoi(value);
+            } else if (strcmp(key, "websocket_max_message_size") == 0) {
+                config->websocket_max_message_size = strtoull(value, NULL, 10);
+            } else if (strcmp(key, "websocket_max_queue_bytes") == 0) {
+                config->websocket_max_queue_bytes = strtoull(value, NULL, 10);
+            } else if (strcmp(key, "rate_limit_requests") == 0) {
+                config->rate_limit_requests = atoi(value);
+            } else if (strcmp(key, "rate_limit_request_burst") == 0) {
+                config->rate_limit_request_burst = atoi(value);
+            } else if (strcmp(key, "rate_limit_connections") == 0) {
+                config->rate_limit_connections = atoi(value);
+            } else if (strcmp(key, "rate_limit_connection_burst") == 0) {
+                config->rate_limit_connection_burst = atoi(value);
+            } else if (strcmp(key, "rate_limit_ipv4_prefix") == 0) {
+                config->rate_limit_ipv4_prefix = atoi(value);
+            } else if (strcmp(key, "rate_limit_ipv6_prefix") == 0) {
+                config->rate_limit_ipv6_prefix = atoi(value);
+            } else if (strcmp(key, "rate_limit_table_size") == 0) {
+                config->rate_limit_table_size = atoi(value);
+            } else if (strcmp(key, "capture_file") == 0) {
+                strncpy(config->capture_file, value, sizeof(config->capture_file) - 1);
+            } else if (strcmp(key, "capture_max_bytes") == 0) {
+                config->capture_max_bytes = strtoull(value, NULL, 10);
+            } else if (strcmp(key, "trace_slow_ms") == 0) {
+                config->trace_slow_ms = atoi(value);
+            } else if (strcmp(key, "trace_sample_rate") == 0) {
+                config->trace_sample_rate = atoi(value);
+            } else if (strcmp(key, "trace_file") == 0) {
+                strncpy(config->trace_file, value, sizeof(config->trace_file) - 1);
+            } else if (strcmp(key, "coroutine_workers") == 0) {
+                config->coroutine_workers = atoi(value);
+            } else if (strcmp(key, "coroutine_stack_size") == 0) {
+                config->coroutine_stack_size = strtoull(value, NULL, 10);
+            } else if (strcmp(key, "upload_directory") == 0) {
+                strncpy(config->upload_directory, value, sizeof(config->upload_directory) - 1);
+            } else if (strcmp(key, "upload_max_size") == 0) {
+                config->upload_max_size = strtoull(value, NULL, 10);
+            } else if (strcmp(key, "upload_max_part_size") == 0) {
+                config->upload_max_part_size = strtoull(value, NULL, 10);
+            } else if (strcmp(key, "stream_max_queue_bytes") == 0) {
+                config->stream_max_queue_bytes = strtoull(value, NULL, 10);
+            } else if (strcmp(key, "stream_coalesce_ms") == 0) {
+                config->stream_coalesce_ms = atoi(value);
             }
         }
     }
     
     fclose(f);
+    if (invalid) {
+        return -1;
+    }
     return validate_config(config);
 }
 
@@ -123,9 +386,9 @@ int validate_config(const server_config_t *config) {
         return -1;
     }
 
-    // Validação do backlog
-    if (config->backlog < 1 || config->backlog > 128) {
-        fprintf(stderr, "backlog deve estar entre 1 e 128\n");
+    // Validação do backlog (o kernel ainda limita ao valor de net.core.somaxconn)
+    if (config->backlog < 1 || config->backlog > 65535) {
+        fprintf(stderr, "backlog deve estar entre 1 e 65535\n");
         return -1;
     }
 
@@ -135,6 +398,138 @@ int validate_config(const server_config_t *config) {
         return -1;
     }
 
+    // Validação dos ajustes de TCP
+    if (config->tcp_defer_accept < 0 || config->tcp_fastopen < 0) {
+        fprintf(stderr, "tcp_defer_accept e tcp_fastopen não podem ser negativos\n");
+        return -1;
+    }
+
+    if (config->send_buffer_size < 0 || config->recv_buffer_size < 0) {
+        fprintf(stderr, "send_buffer_size e recv_buffer_size não podem ser negativos\n");
+        return -1;
+    }
+
+    // Validação do proxy reverso
+    for (int i = 0; i < config->proxy_route_count; i++) {
+        if (config->proxy_routes[i].upstream_count == 0) {
+            fprintf(stderr, "rota de proxy %s não possui upstreams\n", config->proxy_routes[i].prefix);
+            return -1;
+        }
+    }
+
+    if (strcmp(config->proxy_balance, "round_robin") != 0 &&
+        strcmp(config->proxy_balance, "least_conn") != 0) {
+        fprintf(stderr, "proxy_balance deve ser round_robin ou least_conn\n");
+        return -1;
+    }
+
+    if (config->proxy_pool_size < 0 || config->proxy_health_interval < 0) {
+        fprintf(stderr, "proxy_pool_size e proxy_health_interval não podem ser negativos\n");
+        return -1;
+    }
+
+    // Validação do microcache
+    if (config->cache_enabled && (config->cache_ttl_ms <= 0 || config->cache_max_bytes < 65536)) {
+        fprintf(stderr, "cache_ttl_ms deve ser positivo e cache_max_bytes no mínimo 65536\n");
+        return -1;
+    }
+
+    // Validação do HTTP/2
+    if (config->http2_enabled && config->http2_max_concurrent_streams < 1) {
+        fprintf(stderr, "http2_max_concurrent_streams deve ser positivo\n");
+        return -1;
+    }
+
+    if (config->http2_enabled && config->http2_initial_window_size < 65535) {
+        fprintf(stderr, "http2_initial_window_size deve ser no mínimo 65535\n");
+        return -1;
+    }
+
+    // Validação do TLS
+    if (config->tls_port < 0 || config->tls_port > 65535 || (config->tls_port > 0 && config->tls_port == config->port)) {
+        fprintf(stderr, "tls_port deve estar entre 0 e 65535 e ser diferente de port\n");
+        return -1;
+    }
+
+    int tls_enabled = config_tls_enabled(config);
+    if (tls_enabled && (strlen(config->tls_certificate) == 0 || strlen(config->tls_private_key) == 0)) {
+        fprintf(stderr, "tls_certificate e tls_private_key são obrigatórios quando há listener TLS\n");
+        return -1;
+    }
+
+    if (tls_enabled && (config->tls_session_cache_size < 0 || config->tls_session_timeout <= 0)) {
+        fprintf(stderr, "tls_session_cache_size não pode ser negativo e tls_session_timeout deve ser positivo\n");
+        return -1;
+    }
+
+    if (config->websocket_max_message_size < 125 ||
+        config->websocket_max_queue_bytes < config->websocket_max_message_size) {
+        fprintf(stderr, "websocket_max_message_size deve ser no mínimo 125 e websocket_max_queue_bytes não pode ser menor\n");
+        return -1;
+    }
+
+    if (config->rate_limit_requests < 0 || config->rate_limit_requests > 1000000 ||
+        config->rate_limit_connections < 0 || config->rate_limit_connections > 1000000) {
+        fprintf(stderr, "rate_limit_requests e rate_limit_connections devem estar entre 0 e 1000000\n");
+        return -1;
+    }
+
+    // Os buckets guardam milésimos de token em 32 bits
+    if (config->rate_limit_request_burst < 1 || config->rate_limit_request_burst > 4000000 ||
+        config->rate_limit_connection_burst < 1 || config->rate_limit_connection_burst > 4000000) {
+        fprintf(stderr, "rate_limit_request_burst e rate_limit_connection_burst devem estar entre 1 e 4000000\n");
+        return -1;
+    }
+
+    if (config->rate_limit_ipv4_prefix < 0 || config->rate_limit_ipv4_prefix > 32 ||
+        config->rate_limit_ipv6_prefix < 0 || config->rate_limit_ipv6_prefix > 128) {
+        fprintf(stderr, "rate_limit_ipv4_prefix deve estar entre 0 e 32 e rate_limit_ipv6_prefix entre 0 e 128\n");
+        return -1;
+    }
+
+    if (config->rate_limit_table_size < 1024) {
+        fprintf(stderr, "rate_limit_table_size deve ser no mínimo 1024\n");
+        return -1;
+    }
+
+    if (config->capture_file[0] && config->capture_max_bytes < 65536) {
+        fprintf(stderr, "capture_max_bytes deve ser no mínimo 65536\n");
+        return -1;
+    }
+
+    if (config->trace_slow_ms < 0 || config->trace_sample_rate < 1) {
+        fprintf(stderr, "trace_slow_ms não pode ser negativo e trace_sample_rate deve ser no mínimo 1\n");
+        return -1;
+    }
+
+    if (config->trace_slow_ms > 0 && strlen(config->trace_file) == 0) {
+        fprintf(stderr, "trace_file é obrigatório quando trace_slow_ms está definido\n");
+        return -1;
+    }
+
+    if (config->coroutine_workers < 0 || config->coroutine_workers > 1024) {
+        fprintf(stderr, "coroutine_workers deve estar entre 0 e 1024\n");
+        return -1;
+    }
+
+    // Abaixo de 64 KB os buffers locais do HTTP/2 e do TLS podem estourar a pilha
+    if (config->coroutine_workers > 0 && config->coroutine_stack_size < 64 * 1024) {
+        fprintf(stderr, "coroutine_stack_size deve ser no mínimo 65536\n");
+        return -1;
+    }
+
+    if (strlen(config->upload_directory) == 0 || config->upload_max_size == 0 ||
+        config->upload_max_part_size == 0) {
+        fprintf(stderr, "upload_directory não pode estar vazio e os limites de upload devem ser positivos\n");
+        return -1;
+    }
+
+    if (config->stream_max_queue_bytes < 4096 || config->stream_coalesce_ms < 0 ||
+        config->stream_coalesce_ms > 1000) {
+        fprintf(stderr, "stream_max_queue_bytes deve ser no mínimo 4096 e stream_coalesce_ms estar entre 0 e 1000\n");
+        return -1;
+    }
+
     // Validação do diretório raiz
     if (strlen(config->root_directory) == 0) {
         fprintf(stderr, "root_directory não pode estar vazio\n");
@@ -148,4 +543,18 @@ int validate_config(const server_config_t *config) {
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+int config_tls_enabled(const server_config_t *config) {
+    if (!config) return 0;
+
+    if (config->listener_count == 0) {
+        return config->tls_port > 0;
+    }
+    for (int i = 0; i < config->listener_count; i++) {
+        if (config->listeners[i].tls) {
+            return 1;
+        }
+    }
+    return 0;
+}
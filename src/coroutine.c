@@ -0,0 +1,724 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "coroutine.h"
+
+#define WORKER_EVENTS 256
+#define STACK_POOL_MAX 256      // Pilhas livres mantidas por worker
+#define COROUTINE_MAX_WAIT_FDS 8
+
+typedef struct coroutine coroutine_t;
+typedef struct worker worker_t;
+
+struct coroutine {
+    ucontext_t context;
+    void *stack;              // Início do mapeamento (página de guarda)
+    coroutine_fn fn;
+    void *arg;
+    int done;
+    int waiting;              // Suspensa em coroutine_poll
+    uint64_t deadline_ms;
+    size_t timer_index;       // Posição no heap de temporizadores (SIZE_MAX = nenhum)
+    coroutine_t *next;        // Fila de prontas ou caixa de entrada
+};
+
+// Espera de uma corrotina em coroutine_cond_wait; vive na pilha da corrotina
+struct coroutine_waiter {
+    int fd;                   // eventfd sinalizado pelo broadcast
+    coroutine_waiter_t *next;
+};
+
+// Descritor aguardado por coroutine_poll; vive na pilha da corrotina
+typedef struct {
+    coroutine_t *co;
+    int registered;           // Armado no epoll do worker
+    int fired;
+    uint32_t revents;
+} wait_entry_t;
+
+struct worker {
+    coroutine_scheduler_t *scheduler;
+    pthread_t thread;
+    int thread_started;
+    int epoll_fd;
+    int wake_fd;              // eventfd sinalizado quando a caixa de entrada recebe corrotinas
+    ucontext_t main_context;
+    coroutine_t *current;
+
+    coroutine_t *ready_head;
+    coroutine_t *ready_tail;
+    size_t live;              // Corrotinas criadas e não concluídas
+
+    // Min-heap por deadline_ms
+    coroutine_t **timers;
+    size_t timer_count;
+    size_t timer_capacity;
+
+    void *stack_pool[STACK_POOL_MAX];
+    size_t pool_count;
+
+    pthread_mutex_t inbox_lock;
+    coroutine_t *inbox_head;
+    coroutine_t *inbox_tail;
+    int stopping;
+};
+
+struct coroutine_scheduler {
+    worker_t *workers;
+    int worker_count;
+    unsigned int next;        // Próximo worker da distribuição circular (atômico)
+    size_t stack_size;
+    size_t page_size;
+};
+
+static __thread worker_t *current_worker;
+
+// Funções auxiliares internas
+static void* worker_main(void *arg);
+static int start_coroutine(worker_t *worker, coroutine_t *co);
+static void run_ready(worker_t *worker);
+static void finish_coroutine(worker_t *worker, coroutine_t *co);
+static void switch_to_worker(worker_t *worker, coroutine_t *co);
+static void coroutine_entry(void);
+static void ready_push(worker_t *worker, coroutine_t *co);
+static void* stack_acquire(worker_t *worker);
+static void stack_release(worker_t *worker, void *stack);
+static int timer_push(worker_t *worker, coroutine_t *co);
+static void timer_remove(worker_t *worker, coroutine_t *co);
+static void timer_swap(worker_t *worker, size_t a, size_t b);
+static void timer_sift_up(worker_t *worker, size_t index);
+static void timer_sift_down(worker_t *worker, size_t index);
+static void expire_timers(worker_t *worker);
+static int next_timeout(worker_t *worker);
+static uint64_t now_ms(void);
+
+coroutine_scheduler_t* coroutine_scheduler_create(int workers, size_t stack_size)
+{
+    if (workers <= 0 || stack_size == 0) {
+        return NULL;
+    }
+
+    coroutine_scheduler_t *scheduler = calloc(1, sizeof(coroutine_scheduler_t));
+    if (!scheduler) {
+        perror("Erro ao alocar escalonador de corrotinas");
+        return NULL;
+    }
+
+    scheduler->page_size = sysconf(_SC_PAGESIZE);
+    scheduler->stack_size = (stack_size + scheduler->page_size - 1) & ~(scheduler->page_size - 1);
+    scheduler->workers = calloc(workers, sizeof(worker_t));
+    if (!scheduler->workers) {
+        perror("Erro ao alocar workers de corrotinas");
+        free(scheduler);
+        return NULL;
+    }
+
+    for (int i = 0; i < workers; i++) {
+        worker_t *worker = &scheduler->workers[i];
+        worker->scheduler = scheduler;
+        worker->wake_fd = -1;
+        pthread_mutex_init(&worker->inbox_lock, NULL);
+        scheduler->worker_count++;
+
+        worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        worker->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (worker->epoll_fd < 0 || worker->wake_fd < 0) {
+            perror("Erro ao criar epoll do worker");
+            coroutine_scheduler_destroy(scheduler);
+            return NULL;
+        }
+
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = NULL };
+        if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, worker->wake_fd, &event) < 0 ||
+            pthread_create(&worker->thread, NULL, worker_main, worker) != 0) {
+            perror("Erro ao iniciar worker de corrotinas");
+            coroutine_scheduler_destroy(scheduler);
+            return NULL;
+        }
+        worker->thread_started = 1;
+    }
+
+    printf("Conexões atendidas por corrotinas em %d threads (pilha de %zu KB)\n",
+           workers, scheduler->stack_size / 1024);
+    return scheduler;
+}
+
+void coroutine_scheduler_destroy(coroutine_scheduler_t *scheduler)
+{
+    if (!scheduler) {
+        return;
+    }
+
+    for (int i = 0; i < scheduler->worker_count; i++) {
+        worker_t *worker = &scheduler->workers[i];
+
+        if (worker->thread_started) {
+            pthread_mutex_lock(&worker->inbox_lock);
+            worker->stopping = 1;
+            pthread_mutex_unlock(&worker->inbox_lock);
+
+            uint64_t one = 1;
+            if (write(worker->wake_fd, &one, sizeof(one)) < 0) {
+                perror("Erro ao acordar worker de corrotinas");
+            }
+            pthread_join(worker->thread, NULL);
+        }
+
+        for (size_t j = 0; j < worker->pool_count; j++) {
+            munmap(worker->stack_pool[j], scheduler->stack_size + scheduler->page_size);
+        }
+        free(worker->timers);
+        if (worker->epoll_fd >= 0) {
+            close(worker->epoll_fd);
+        }
+        if (worker->wake_fd >= 0) {
+            close(worker->wake_fd);
+        }
+        pthread_mutex_destroy(&worker->inbox_lock);
+    }
+
+    free(scheduler->workers);
+    free(scheduler);
+}
+
+int coroutine_spawn(coroutine_scheduler_t *scheduler, coroutine_fn fn, void *arg)
+{
+    if (!scheduler || !fn) {
+        return -1;
+    }
+
+    coroutine_t *co = calloc(1, sizeof(coroutine_t));
+    if (!co) {
+        perror("Erro ao alocar corrotina");
+        return -1;
+    }
+    co->fn = fn;
+    co->arg = arg;
+    co->timer_index = SIZE_MAX;
+
+    unsigned int index = __atomic_fetch_add(&scheduler->next, 1, __ATOMIC_RELAXED);
+    worker_t *worker = &scheduler->workers[index % scheduler->worker_count];
+
+    // Só a primeira corrotina de uma caixa vazia precisa acordar o worker
+    pthread_mutex_lock(&worker->inbox_lock);
+    int was_empty = worker->inbox_head == NULL;
+    if (worker->inbox_tail) {
+        worker->inbox_tail->next = co;
+    } else {
+        worker->inbox_head = co;
+    }
+    worker->inbox_tail = co;
+    pthread_mutex_unlock(&worker->inbox_lock);
+
+    if (was_empty) {
+        uint64_t one = 1;
+        if (write(worker->wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            perror("Erro ao acordar worker de corrotinas");
+        }
+    }
+
+    return 0;
+}
+
+int coroutine_spawn_local(coroutine_fn fn, void *arg)
+{
+    worker_t *worker = current_worker;
+    if (!worker || !worker->current || !fn) {
+        return -1;
+    }
+
+    coroutine_t *co = calloc(1, sizeof(coroutine_t));
+    if (!co) {
+        perror("Erro ao alocar corrotina");
+        return -1;
+    }
+    co->fn = fn;
+    co->arg = arg;
+    co->timer_index = SIZE_MAX;
+
+    // Executando no próprio worker, a corrotina entra direto na fila de prontas
+    if (start_coroutine(worker, co) < 0) {
+        free(co);
+        return -1;
+    }
+    return 0;
+}
+
+int coroutine_active(void)
+{
+    return current_worker && current_worker->current;
+}
+
+void* coroutine_self(void)
+{
+    return current_worker ? current_worker->current : NULL;
+}
+
+int coroutine_poll(struct pollfd *fds, nfds_t nfds, int timeout_ms)
+{
+    worker_t *worker = current_worker;
+    if (!worker || !worker->current) {
+        return poll(fds, nfds, timeout_ms);
+    }
+    if (nfds > COROUTINE_MAX_WAIT_FDS) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    coroutine_t *co = worker->current;
+    wait_entry_t entries[COROUTINE_MAX_WAIT_FDS];
+    int ready = 0;
+
+    // EPOLLONESHOT desarma o descritor ao disparar: basta um MOD por espera
+    // e nenhum evento tardio acorda a corrotina depois que ela seguiu adiante
+    for (nfds_t i = 0; i < nfds; i++) {
+        entries[i] = (wait_entry_t){ .co = co };
+        fds[i].revents = 0;
+        if (fds[i].fd < 0) {
+            continue;
+        }
+
+        struct epoll_event event = {
+            .events = (fds[i].events & (POLLIN | POLLOUT | POLLPRI)) | EPOLLONESHOT,
+            .data.ptr = &entries[i]
+        };
+        if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_MOD, fds[i].fd, &event) == 0 ||
+            (errno == ENOENT && epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, fds[i].fd, &event) == 0)) {
+            entries[i].registered = 1;
+        } else if (errno == EPERM) {
+            // Arquivos regulares não entram no epoll e, como no poll, estão sempre prontos
+            entries[i].fired = 1;
+            entries[i].revents = fds[i].events & (POLLIN | POLLOUT);
+            ready = 1;
+        } else {
+            fds[i].revents = POLLNVAL;
+            ready = 1;
+        }
+    }
+
+    if (!ready) {
+        if (timeout_ms >= 0) {
+            co->deadline_ms = now_ms() + timeout_ms;
+            if (timer_push(worker, co) < 0) {
+                timeout_ms = 0;  // Sem memória para o temporizador: não suspende
+            }
+        }
+        if (timeout_ms != 0) {
+            co->waiting = 1;
+            switch_to_worker(worker, co);
+        }
+        timer_remove(worker, co);
+    }
+
+    int count = 0;
+    for (nfds_t i = 0; i < nfds; i++) {
+        if (entries[i].registered && !entries[i].fired) {
+            epoll_ctl(worker->epoll_fd, EPOLL_CTL_DEL, fds[i].fd, NULL);
+        }
+        if (entries[i].fired) {
+            fds[i].revents = entries[i].revents & (fds[i].events | POLLERR | POLLHUP);
+        }
+        if (fds[i].revents) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+void coroutine_sleep(int ms)
+{
+    if (!coroutine_active()) {
+        struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000 };
+        while (nanosleep(&ts, &ts) < 0 && errno == EINTR) {
+        }
+        return;
+    }
+
+    coroutine_poll(NULL, 0, ms);
+}
+
+void coroutine_cond_init(coroutine_cond_t *cond)
+{
+    pthread_cond_init(&cond->cond, NULL);
+    cond->waiters = NULL;
+}
+
+void coroutine_cond_destroy(coroutine_cond_t *cond)
+{
+    pthread_cond_destroy(&cond->cond);
+}
+
+void coroutine_cond_wait(coroutine_cond_t *cond, pthread_mutex_t *mutex)
+{
+    if (!coroutine_active()) {
+        pthread_cond_wait(&cond->cond, mutex);
+        return;
+    }
+
+    coroutine_waiter_t waiter;
+    waiter.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (waiter.fd < 0) {
+        // Sem descritor: degrada para a espera que bloqueia o worker
+        perror("Erro ao criar eventfd da espera");
+        pthread_cond_wait(&cond->cond, mutex);
+        return;
+    }
+    waiter.next = cond->waiters;
+    cond->waiters = &waiter;
+
+    pthread_mutex_unlock(mutex);
+    struct pollfd pfd = { .fd = waiter.fd, .events = POLLIN };
+    coroutine_poll(&pfd, 1, -1);
+    pthread_mutex_lock(mutex);
+
+    // O broadcast esvazia a lista; em um retorno antecipado a espera ainda está nela.
+    // O descritor só é fechado com o mutex travado, portanto nenhum broadcast
+    // escreve nele depois de fechado.
+    for (coroutine_waiter_t **link = &cond->waiters; *link; link = &(*link)->next) {
+        if (*link == &waiter) {
+            *link = waiter.next;
+            break;
+        }
+    }
+    close(waiter.fd);
+}
+
+void coroutine_cond_broadcast(coroutine_cond_t *cond)
+{
+    pthread_cond_broadcast(&cond->cond);
+
+    coroutine_waiter_t *waiter = cond->waiters;
+    cond->waiters = NULL;
+    while (waiter) {
+        coroutine_waiter_t *next = waiter->next;
+        uint64_t one = 1;
+        if (write(waiter->fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            perror("Erro ao acordar corrotina em espera");
+        }
+        waiter = next;
+    }
+}
+
+void coroutine_yield(void)
+{
+    worker_t *worker = current_worker;
+    if (!worker || !worker->current) {
+        sched_yield();
+        return;
+    }
+
+    coroutine_t *co = worker->current;
+    ready_push(worker, co);
+    switch_to_worker(worker, co);
+}
+
+// Implementação das funções auxiliares internas
+
+static void* worker_main(void *arg)
+{
+    worker_t *worker = (worker_t*)arg;
+    current_worker = worker;
+    struct epoll_event events[WORKER_EVENTS];
+
+    while (1) {
+        pthread_mutex_lock(&worker->inbox_lock);
+        coroutine_t *inbox = worker->inbox_head;
+        worker->inbox_head = worker->inbox_tail = NULL;
+        int stopping = worker->stopping;
+        pthread_mutex_unlock(&worker->inbox_lock);
+
+        while (inbox) {
+            coroutine_t *co = inbox;
+            inbox = co->next;
+            co->next = NULL;
+            if (start_coroutine(worker, co) < 0) {
+                // Sem pilha disponível: executa na própria thread do worker,
+                // onde as esperas recaem em poll() e bloqueiam o worker
+                co->fn(co->arg);
+                free(co);
+            }
+        }
+
+        run_ready(worker);
+
+        if (stopping && worker->live == 0) {
+            break;
+        }
+
+        int n = epoll_wait(worker->epoll_fd, events, WORKER_EVENTS, next_timeout(worker));
+        if (n < 0 && errno != EINTR) {
+            perror("Erro no epoll do worker");
+        }
+
+        for (int i = 0; i < n; i++) {
+            wait_entry_t *entry = (wait_entry_t*)events[i].data.ptr;
+            if (!entry) {
+                uint64_t value;
+                if (read(worker->wake_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+                    perror("Erro ao ler eventfd do worker");
+                }
+                continue;
+            }
+
+            // Vários descritores da mesma espera podem disparar no mesmo lote
+            entry->fired = 1;
+            entry->revents = events[i].events;
+            if (entry->co->waiting) {
+                entry->co->waiting = 0;
+                ready_push(worker, entry->co);
+            }
+        }
+
+        expire_timers(worker);
+    }
+
+    return NULL;
+}
+
+static int start_coroutine(worker_t *worker, coroutine_t *co)
+{
+    coroutine_scheduler_t *scheduler = worker->scheduler;
+
+    co->stack = stack_acquire(worker);
+    if (!co->stack) {
+        return -1;
+    }
+
+    if (getcontext(&co->context) < 0) {
+        perror("Erro ao criar contexto da corrotina");
+        stack_release(worker, co->stack);
+        return -1;
+    }
+    co->context.uc_stack.ss_sp = (char*)co->stack + scheduler->page_size;
+    co->context.uc_stack.ss_size = scheduler->stack_size;
+    co->context.uc_link = &worker->main_context;
+    makecontext(&co->context, coroutine_entry, 0);
+
+    worker->live++;
+    ready_push(worker, co);
+    return 0;
+}
+
+static void run_ready(worker_t *worker)
+{
+    // Corrotinas que cedem a vez entram na próxima rodada, não nesta
+    coroutine_t *co = worker->ready_head;
+    worker->ready_head = worker->ready_tail = NULL;
+
+    while (co) {
+        coroutine_t *next = co->next;
+        co->next = NULL;
+
+        worker->current = co;
+        swapcontext(&worker->main_context, &co->context);
+        worker->current = NULL;
+
+        if (co->done) {
+            finish_coroutine(worker, co);
+        }
+        co = next;
+    }
+}
+
+static void finish_coroutine(worker_t *worker, coroutine_t *co)
+{
+    stack_release(worker, co->stack);
+    free(co);
+    worker->live--;
+}
+
+static void switch_to_worker(worker_t *worker, coroutine_t *co)
+{
+    swapcontext(&co->context, &worker->main_context);
+}
+
+static void coroutine_entry(void)
+{
+    // Ao retornar, uc_link devolve o controle ao loop do worker
+    coroutine_t *co = current_worker->current;
+    co->fn(co->arg);
+    co->done = 1;
+}
+
+static void ready_push(worker_t *worker, coroutine_t *co)
+{
+    co->next = NULL;
+    if (worker->ready_tail) {
+        worker->ready_tail->next = co;
+    } else {
+        worker->ready_head = co;
+    }
+    worker->ready_tail = co;
+}
+
+static void* stack_acquire(worker_t *worker)
+{
+    if (worker->pool_count > 0) {
+        return worker->stack_pool[--worker->pool_count];
+    }
+
+    coroutine_scheduler_t *scheduler = worker->scheduler;
+    size_t length = scheduler->stack_size + scheduler->page_size;
+
+    // MAP_NORESERVE: só as páginas tocadas pela corrotina consomem memória
+    void *stack = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED) {
+        perror("Erro ao alocar pilha da corrotina");
+        return NULL;
+    }
+
+    // A pilha cresce para baixo: a página de guarda fica no início do mapeamento
+    if (mprotect(stack, scheduler->page_size, PROT_NONE) < 0) {
+        perror("Erro ao proteger pilha da corrotina");
+        munmap(stack, length);
+        return NULL;
+    }
+
+    return stack;
+}
+
+static void stack_release(worker_t *worker, void *stack)
+{
+    if (worker->pool_count < STACK_POOL_MAX) {
+        worker->stack_pool[worker->pool_count++] = stack;
+        return;
+    }
+
+    coroutine_scheduler_t *scheduler = worker->scheduler;
+    munmap(stack, scheduler->stack_size + scheduler->page_size);
+}
+
+static int timer_push(worker_t *worker, coroutine_t *co)
+{
+    if (worker->timer_count == worker->timer_capacity) {
+        size_t capacity = worker->timer_capacity ? worker->timer_capacity * 2 : 64;
+        coroutine_t **timers = realloc(worker->timers, capacity * sizeof(coroutine_t*));
+        if (!timers) {
+            perror("Erro ao alocar temporizadores");
+            return -1;
+        }
+        worker->timers = timers;
+        worker->timer_capacity = capacity;
+    }
+
+    co->timer_index = worker->timer_count;
+    worker->timers[worker->timer_count++] = co;
+    timer_sift_up(worker, co->timer_index);
+    return 0;
+}
+
+static void timer_remove(worker_t *worker, coroutine_t *co)
+{
+    size_t index = co->timer_index;
+    if (index == SIZE_MAX) {
+        return;
+    }
+
+    co->timer_index = SIZE_MAX;
+    size_t last = --worker->timer_count;
+    if (index == last) {
+        return;
+    }
+
+    worker->timers[index] = worker->timers[last];
+    worker->timers[index]->timer_index = index;
+    timer_sift_up(worker, index);
+    timer_sift_down(worker, index);
+}
+
+static void timer_swap(worker_t *worker, size_t a, size_t b)
+{
+    coroutine_t *tmp = worker->timers[a];
+    worker->timers[a] = worker->timers[b];
+    worker->timers[b] = tmp;
+    worker->timers[a]->timer_index = a;
+    worker->timers[b]->timer_index = b;
+}
+
+static void timer_sift_up(worker_t *worker, size_t index)
+{
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (worker->timers[parent]->deadline_ms <= worker->timers[index]->deadline_ms) {
+            break;
+        }
+        timer_swap(worker, parent, index);
+        index = parent;
+    }
+}
+
+static void timer_sift_down(worker_t *worker, size_t index)
+{
+    while (1) {
+        size_t smallest = index;
+        size_t left = 2 * index + 1;
+        size_t right = left + 1;
+
+        if (left < worker->timer_count &&
+            worker->timers[left]->deadline_ms < worker->timers[smallest]->deadline_ms) {
+            smallest = left;
+        }
+        if (right < worker->timer_count &&
+            worker->timers[right]->deadline_ms < worker->timers[smallest]->deadline_ms) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            break;
+        }
+        timer_swap(worker, index, smallest);
+        index = smallest;
+    }
+}
+
+static void expire_timers(worker_t *worker)
+{
+    if (worker->timer_count == 0) {
+        return;
+    }
+
+    uint64_t now = now_ms();
+    while (worker->timer_count > 0 && worker->timers[0]->deadline_ms <= now) {
+        coroutine_t *co = worker->timers[0];
+        timer_remove(worker, co);
+        if (co->waiting) {
+            co->waiting = 0;
+            ready_push(worker, co);
+        }
+    }
+}
+
+static int next_timeout(worker_t *worker)
+{
+    if (worker->ready_head) {
+        return 0;
+    }
+    if (worker->timer_count == 0) {
+        return -1;
+    }
+
+    uint64_t now = now_ms();
+    uint64_t deadline = worker->timers[0]->deadline_ms;
+    if (deadline <= now) {
+        return 0;
+    }
+    return deadline - now > INT32_MAX ? INT32_MAX : (int)(deadline - now);
+}
+
+static uint64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
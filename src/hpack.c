@@ -0,0 +1,675 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "hpack.h"
+
+#define HPACK_STATIC_TABLE_SIZE 61
+#define HPACK_ENTRY_OVERHEAD 32
+#define HUFFMAN_EOS 256
+
+typedef struct {
+    const char *name;
+    const char *value;
+} hpack_static_entry_t;
+
+typedef struct {
+    uint32_t code;
+    uint8_t bits;
+} huffman_code_t;
+
+// Tabela estática do HPACK (RFC 7541, Apêndice A); o índice 1 é a primeira entrada
+static const hpack_static_entry_t static_table[HPACK_STATIC_TABLE_SIZE] = {
+    {":authority", ""}, {":method", "GET"}, {":method", "POST"}, {":path", "/"},
+    {":path", "/index.html"}, {":scheme", "http"}, {":scheme", "https"}, {":status", "200"},
+    {":status", "204"}, {":status", "206"}, {":status", "304"}, {":status", "400"},
+    {":status", "404"}, {":status", "500"}, {"accept-charset", ""}, {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""}, {"accept-ranges", ""}, {"accept", ""}, {"access-control-allow-origin", ""},
+    {"age", ""}, {"allow", ""}, {"authorization", ""}, {"cache-control", ""},
+    {"content-disposition", ""}, {"content-encoding", ""}, {"content-language", ""}, {"content-length", ""},
+    {"content-location", ""}, {"content-range", ""}, {"content-type", ""}, {"cookie", ""},
+    {"date", ""}, {"etag", ""}, {"expect", ""}, {"expires", ""},
+    {"from", ""}, {"host", ""}, {"if-match", ""}, {"if-modified-since", ""},
+    {"if-none-match", ""}, {"if-range", ""}, {"if-unmodified-since", ""}, {"last-modified", ""},
+    {"link", ""}, {"location", ""}, {"max-forwards", ""}, {"proxy-authenticate", ""},
+    {"proxy-authorization", ""}, {"range", ""}, {"referer", ""}, {"refresh", ""},
+    {"retry-after", ""}, {"server", ""}, {"set-cookie", ""}, {"strict-transport-security", ""},
+    {"transfer-encoding", ""}, {"user-agent", ""}, {"vary", ""}, {"via", ""},
+    {"www-authenticate", ""}
+};
+
+// Tabela de códigos Huffman do HPACK (RFC 7541, Apêndice B): código e tamanho em bits
+static const huffman_code_t huffman_table[257] = {
+    {0x00001ff8, 13}, {0x007fffd8, 23}, {0x0fffffe2, 28}, {0x0fffffe3, 28},
+    {0x0fffffe4, 28}, {0x0fffffe5, 28}, {0x0fffffe6, 28}, {0x0fffffe7, 28},
+    {0x0fffffe8, 28}, {0x00ffffea, 24}, {0x3ffffffc, 30}, {0x0fffffe9, 28},
+    {0x0fffffea, 28}, {0x3ffffffd, 30}, {0x0fffffeb, 28}, {0x0fffffec, 28},
+    {0x0fffffed, 28}, {0x0fffffee, 28}, {0x0fffffef, 28}, {0x0ffffff0, 28},
+    {0x0ffffff1, 28}, {0x0ffffff2, 28}, {0x3ffffffe, 30}, {0x0ffffff3, 28},
+    {0x0ffffff4, 28}, {0x0ffffff5, 28}, {0x0ffffff6, 28}, {0x0ffffff7, 28},
+    {0x0ffffff8, 28}, {0x0ffffff9, 28}, {0x0ffffffa, 28}, {0x0ffffffb, 28},
+    {0x00000014,  6}, {0x000003f8, 10}, {0x000003f9, 10}, {0x00000ffa, 12},
+    {0x00001ff9, 13}, {0x00000015,  6}, {0x000000f8,  8}, {0x000007fa, 11},
+    {0x000003fa, 10}, {0x000003fb, 10}, {0x000000f9,  8}, {0x000007fb, 11},
+    {0x000000fa,  8}, {0x00000016,  6}, {0x00000017,  6}, {0x00000018,  6},
+    {0x00000000,  5}, {0x00000001,  5}, {0x00000002,  5}, {0x00000019,  6},
+    {0x0000001a,  6}, {0x0000001b,  6}, {0x0000001c,  6}, {0x0000001d,  6},
+    {0x0000001e,  6}, {0x0000001f,  6}, {0x0000005c,  7}, {0x000000fb,  8},
+    {0x00007ffc, 15}, {0x00000020,  6}, {0x00000ffb, 12}, {0x000003fc, 10},
+    {0x00001ffa, 13}, {0x00000021,  6}, {0x0000005d,  7}, {0x0000005e,  7},
+    {0x0000005f,  7}, {0x00000060,  7}, {0x00000061,  7}, {0x00000062,  7},
+    {0x00000063,  7}, {0x00000064,  7}, {0x00000065,  7}, {0x00000066,  7},
+    {0x00000067,  7}, {0x00000068,  7}, {0x00000069,  7}, {0x0000006a,  7},
+    {0x0000006b,  7}, {0x0000006c,  7}, {0x0000006d,  7}, {0x0000006e,  7},
+    {0x0000006f,  7}, {0x00000070,  7}, {0x00000071,  7}, {0x00000072,  7},
+    {0x000000fc,  8}, {0x00000073,  7}, {0x000000fd,  8}, {0x00001ffb, 13},
+    {0x0007fff0, 19}, {0x00001ffc, 13}, {0x00003ffc, 14}, {0x00000022,  6},
+    {0x00007ffd, 15}, {0x00000003,  5}, {0x00000023,  6}, {0x00000004,  5},
+    {0x00000024,  6}, {0x00000005,  5}, {0x00000025,  6}, {0x00000026,  6},
+    {0x00000027,  6}, {0x00000006,  5}, {0x00000074,  7}, {0x00000075,  7},
+    {0x00000028,  6}, {0x00000029,  6}, {0x0000002a,  6}, {0x00000007,  5},
+    {0x0000002b,  6}, {0x00000076,  7}, {0x0000002c,  6}, {0x00000008,  5},
+    {0x00000009,  5}, {0x0000002d,  6}, {0x00000077,  7}, {0x00000078,  7},
+    {0x00000079,  7}, {0x0000007a,  7}, {0x0000007b,  7}, {0x00007ffe, 15},
+    {0x000007fc, 11}, {0x00003ffd, 14}, {0x00001ffd, 13}, {0x0ffffffc, 28},
+    {0x000fffe6, 20}, {0x003fffd2, 22}, {0x000fffe7, 20}, {0x000fffe8, 20},
+    {0x003fffd3, 22}, {0x003fffd4, 22}, {0x003fffd5, 22}, {0x007fffd9, 23},
+    {0x003fffd6, 22}, {0x007fffda, 23}, {0x007fffdb, 23}, {0x007fffdc, 23},
+    {0x007fffdd, 23}, {0x007fffde, 23}, {0x00ffffeb, 24}, {0x007fffdf, 23},
+    {0x00ffffec, 24}, {0x00ffffed, 24}, {0x003fffd7, 22}, {0x007fffe0, 23},
+    {0x00ffffee, 24}, {0x007fffe1, 23}, {0x007fffe2, 23}, {0x007fffe3, 23},
+    {0x007fffe4, 23}, {0x001fffdc, 21}, {0x003fffd8, 22}, {0x007fffe5, 23},
+    {0x003fffd9, 22}, {0x007fffe6, 23}, {0x007fffe7, 23}, {0x00ffffef, 24},
+    {0x003fffda, 22}, {0x001fffdd, 21}, {0x000fffe9, 20}, {0x003fffdb, 22},
+    {0x003fffdc, 22}, {0x007fffe8, 23}, {0x007fffe9, 23}, {0x001fffde, 21},
+    {0x007fffea, 23}, {0x003fffdd, 22}, {0x003fffde, 22}, {0x00fffff0, 24},
+    {0x001fffdf, 21}, {0x003fffdf, 22}, {0x007fffeb, 23}, {0x007fffec, 23},
+    {0x001fffe0, 21}, {0x001fffe1, 21}, {0x003fffe0, 22}, {0x001fffe2, 21},
+    {0x007fffed, 23}, {0x003fffe1, 22}, {0x007fffee, 23}, {0x007fffef, 23},
+    {0x000fffea, 20}, {0x003fffe2, 22}, {0x003fffe3, 22}, {0x003fffe4, 22},
+    {0x007ffff0, 23}, {0x003fffe5, 22}, {0x003fffe6, 22}, {0x007ffff1, 23},
+    {0x03ffffe0, 26}, {0x03ffffe1, 26}, {0x000fffeb, 20}, {0x0007fff1, 19},
+    {0x003fffe7, 22}, {0x007ffff2, 23}, {0x003fffe8, 22}, {0x01ffffec, 25},
+    {0x03ffffe2, 26}, {0x03ffffe3, 26}, {0x03ffffe4, 26}, {0x07ffffde, 27},
+    {0x07ffffdf, 27}, {0x03ffffe5, 26}, {0x00fffff1, 24}, {0x01ffffed, 25},
+    {0x0007fff2, 19}, {0x001fffe3, 21}, {0x03ffffe6, 26}, {0x07ffffe0, 27},
+    {0x07ffffe1, 27}, {0x03ffffe7, 26}, {0x07ffffe2, 27}, {0x00fffff2, 24},
+    {0x001fffe4, 21}, {0x001fffe5, 21}, {0x03ffffe8, 26}, {0x03ffffe9, 26},
+    {0x0ffffffd, 28}, {0x07ffffe3, 27}, {0x07ffffe4, 27}, {0x07ffffe5, 27},
+    {0x000fffec, 20}, {0x00fffff3, 24}, {0x000fffed, 20}, {0x001fffe6, 21},
+    {0x003fffe9, 22}, {0x001fffe7, 21}, {0x001fffe8, 21}, {0x007ffff3, 23},
+    {0x003fffea, 22}, {0x003fffeb, 22}, {0x01ffffee, 25}, {0x01ffffef, 25},
+    {0x00fffff4, 24}, {0x00fffff5, 24}, {0x03ffffea, 26}, {0x007ffff4, 23},
+    {0x03ffffeb, 26}, {0x07ffffe6, 27}, {0x03ffffec, 26}, {0x03ffffed, 26},
+    {0x07ffffe7, 27}, {0x07ffffe8, 27}, {0x07ffffe9, 27}, {0x07ffffea, 27},
+    {0x07ffffeb, 27}, {0x0ffffffe, 28}, {0x07ffffec, 27}, {0x07ffffed, 27},
+    {0x07ffffee, 27}, {0x07ffffef, 27}, {0x07fffff0, 27}, {0x03ffffee, 26},
+    {0x3fffffff, 30}
+};
+
+// Árvore de decodificação Huffman: filhos >= 0 são nós, negativos são folhas (-(símbolo + 1))
+static int16_t huffman_tree[512][2];
+static int huffman_tree_nodes;
+static pthread_once_t huffman_once = PTHREAD_ONCE_INIT;
+
+// Funções auxiliares internas
+static void build_huffman_tree(void);
+static int huffman_decode(const uint8_t *src, size_t length, char *dst, size_t *dst_length);
+static size_t huffman_encoded_length(const char *src, size_t length);
+static size_t huffman_encode(const char *src, size_t length, uint8_t *dst);
+static int decode_integer(const uint8_t **pos, const uint8_t *end, int prefix_bits, size_t *value);
+static int encode_integer(uint8_t *out, size_t capacity, uint8_t first_byte, int prefix_bits, size_t value);
+static int decode_string(hpack_decoder_t *decoder, int slot, const uint8_t **pos, const uint8_t *end,
+                         const char **str, size_t *length);
+static int encode_string(uint8_t *out, size_t capacity, const char *str, size_t length);
+static void table_init(hpack_table_t *table, size_t max_size);
+static void table_cleanup(hpack_table_t *table);
+static int table_add(hpack_table_t *table, const char *name, size_t name_length,
+                     const char *value, size_t value_length);
+static void table_set_max_size(hpack_table_t *table, size_t max_size);
+static int table_lookup(const hpack_table_t *table, size_t index, const char **name, size_t *name_length,
+                        const char **value, size_t *value_length);
+
+void hpack_decoder_init(hpack_decoder_t *decoder, size_t max_size)
+{
+    memset(decoder, 0, sizeof(hpack_decoder_t));
+    table_init(&decoder->table, max_size);
+    decoder->settings_max_size = max_size;
+    pthread_once(&huffman_once, build_huffman_tree);
+}
+
+void hpack_decoder_cleanup(hpack_decoder_t *decoder)
+{
+    table_cleanup(&decoder->table);
+    free(decoder->scratch[0]);
+    free(decoder->scratch[1]);
+    memset(decoder, 0, sizeof(hpack_decoder_t));
+}
+
+int hpack_decode(hpack_decoder_t *decoder, const uint8_t *block, size_t length,
+                 hpack_header_cb callback, void *ctx)
+{
+    const uint8_t *pos = block;
+    const uint8_t *end = block + length;
+    int headers_seen = 0;
+
+    while (pos < end) {
+        uint8_t byte = *pos;
+        const char *name, *value;
+        size_t name_length, value_length, index;
+        char *name_copy = NULL;
+
+        if (byte & 0x80) {
+            // Header indexado
+            if (decode_integer(&pos, end, 7, &index) < 0 ||
+                table_lookup(&decoder->table, index, &name, &name_length, &value, &value_length) < 0) {
+                return HPACK_ERROR;
+            }
+        } else if ((byte & 0xE0) == 0x20) {
+            // Atualização do tamanho da tabela: só é permitida no início do bloco
+            size_t max_size;
+            if (headers_seen || decode_integer(&pos, end, 5, &max_size) < 0 ||
+                max_size > decoder->settings_max_size) {
+                return HPACK_ERROR;
+            }
+            table_set_max_size(&decoder->table, max_size);
+            continue;
+        } else {
+            // Literal com indexação incremental (01), sem indexação (0000) ou nunca indexado (0001)
+            int incremental = (byte & 0xC0) == 0x40;
+            int prefix_bits = incremental ? 6 : 4;
+
+            if (decode_integer(&pos, end, prefix_bits, &index) < 0) {
+                return HPACK_ERROR;
+            }
+
+            if (index > 0) {
+                const char *unused;
+                size_t unused_length;
+                if (table_lookup(&decoder->table, index, &name, &name_length, &unused, &unused_length) < 0) {
+                    return HPACK_ERROR;
+                }
+            } else if (decode_string(decoder, 0, &pos, end, &name, &name_length) < 0) {
+                return HPACK_ERROR;
+            }
+
+            if (decode_string(decoder, 1, &pos, end, &value, &value_length) < 0) {
+                return HPACK_ERROR;
+            }
+
+            if (incremental) {
+                // Copia antes de inserir: o nome pode apontar para uma entrada que será
+                // removida, inclusive quando a nova entrada não cabe e esvazia a tabela.
+                // A cópia é entregue ao callback; o valor aponta para o bloco ou para o
+                // buffer de decodificação, que a inserção não altera.
+                name_copy = malloc(name_length + 1);
+                if (!name_copy) {
+                    return HPACK_MEMORY_ERROR;
+                }
+                memcpy(name_copy, name, name_length);
+                name_copy[name_length] = '\0';
+
+                int result = table_add(&decoder->table, name_copy, name_length, value, value_length);
+                if (result != HPACK_OK) {
+                    free(name_copy);
+                    return result;
+                }
+                name = name_copy;
+            }
+        }
+
+        headers_seen = 1;
+        int result = callback ? callback(ctx, name, name_length, value, value_length) : 0;
+        free(name_copy);
+        if (result < 0) {
+            return HPACK_ERROR;
+        }
+    }
+
+    return HPACK_OK;
+}
+
+void hpack_encoder_init(hpack_encoder_t *encoder, size_t max_size)
+{
+    memset(encoder, 0, sizeof(hpack_encoder_t));
+    table_init(&encoder->table, max_size);
+    pthread_once(&huffman_once, build_huffman_tree);
+}
+
+void hpack_encoder_cleanup(hpack_encoder_t *encoder)
+{
+    table_cleanup(&encoder->table);
+    memset(encoder, 0, sizeof(hpack_encoder_t));
+}
+
+void hpack_encoder_set_max_size(hpack_encoder_t *encoder, size_t max_size)
+{
+    encoder->pending_max_size = max_size;
+    encoder->size_update_pending = 1;
+}
+
+int hpack_encode_begin(hpack_encoder_t *encoder, uint8_t *out, size_t capacity)
+{
+    if (!encoder->size_update_pending) {
+        return 0;
+    }
+
+    int written = encode_integer(out, capacity, 0x20, 5, encoder->pending_max_size);
+    if (written < 0) {
+        return written;
+    }
+
+    table_set_max_size(&encoder->table, encoder->pending_max_size);
+    encoder->size_update_pending = 0;
+    return written;
+}
+
+int hpack_encode_header(hpack_encoder_t *encoder, uint8_t *out, size_t capacity,
+                        const char *name, const char *value, hpack_index_mode_t mode)
+{
+    size_t name_length = strlen(name);
+    size_t value_length = strlen(value);
+    size_t name_index = 0;
+
+    // Procura o par completo (representação indexada) ou apenas o nome
+    for (size_t i = 0; i < HPACK_STATIC_TABLE_SIZE; i++) {
+        if (strcmp(static_table[i].name, name) != 0) {
+            continue;
+        }
+        if (mode == HPACK_INDEX && strcmp(static_table[i].value, value) == 0) {
+            return encode_integer(out, capacity, 0x80, 7, i + 1);
+        }
+        if (!name_index) {
+            name_index = i + 1;
+        }
+    }
+
+    for (size_t i = 0; i < encoder->table.count; i++) {
+        const hpack_entry_t *entry = &encoder->table.entries[(encoder->table.head + i) % encoder->table.capacity];
+        if (entry->name_length != name_length || memcmp(entry->name, name, name_length) != 0) {
+            continue;
+        }
+        if (mode == HPACK_INDEX && entry->value_length == value_length &&
+            memcmp(entry->value, value, value_length) == 0) {
+            return encode_integer(out, capacity, 0x80, 7, HPACK_STATIC_TABLE_SIZE + 1 + i);
+        }
+        if (!name_index) {
+            name_index = HPACK_STATIC_TABLE_SIZE + 1 + i;
+        }
+    }
+
+    uint8_t first_byte;
+    int prefix_bits;
+    switch (mode) {
+        case HPACK_INDEX:       first_byte = 0x40; prefix_bits = 6; break;
+        case HPACK_NEVER_INDEX: first_byte = 0x10; prefix_bits = 4; break;
+        default:                first_byte = 0x00; prefix_bits = 4; break;
+    }
+
+    int used = encode_integer(out, capacity, first_byte, prefix_bits, name_index);
+    if (used < 0) {
+        return used;
+    }
+
+    if (!name_index) {
+        int written = encode_string(out + used, capacity - used, name, name_length);
+        if (written < 0) {
+            return written;
+        }
+        used += written;
+    }
+
+    int written = encode_string(out + used, capacity - used, value, value_length);
+    if (written < 0) {
+        return written;
+    }
+    used += written;
+
+    if (mode == HPACK_INDEX) {
+        int result = table_add(&encoder->table, name, name_length, value, value_length);
+        if (result != HPACK_OK) {
+            return result;
+        }
+    }
+
+    return used;
+}
+
+// Implementação das funções auxiliares internas
+
+static void build_huffman_tree(void)
+{
+    memset(huffman_tree, 0, sizeof(huffman_tree));
+    huffman_tree_nodes = 1;
+
+    for (int symbol = 0; symbol <= HUFFMAN_EOS; symbol++) {
+        uint32_t code = huffman_table[symbol].code;
+        int bits = huffman_table[symbol].bits;
+        int node = 0;
+
+        for (int i = bits - 1; i > 0; i--) {
+            int bit = (code >> i) & 1;
+            if (huffman_tree[node][bit] == 0) {
+                huffman_tree[node][bit] = huffman_tree_nodes++;
+            }
+            node = huffman_tree[node][bit];
+        }
+        huffman_tree[node][code & 1] = -(symbol + 1);
+    }
+}
+
+static int huffman_decode(const uint8_t *src, size_t length, char *dst, size_t *dst_length)
+{
+    size_t out = 0;
+    int node = 0;
+    int pending_bits = 0;    // Bits lidos desde o último símbolo completo
+    int pending_all_ones = 1;
+
+    for (size_t i = 0; i < length; i++) {
+        for (int shift = 7; shift >= 0; shift--) {
+            int bit = (src[i] >> shift) & 1;
+            int next = huffman_tree[node][bit];
+
+            pending_bits++;
+            pending_all_ones &= bit;
+
+            if (next < 0) {
+                int symbol = -next - 1;
+                if (symbol == HUFFMAN_EOS) {
+                    return HPACK_ERROR;
+                }
+                dst[out++] = (char)symbol;
+                node = 0;
+                pending_bits = 0;
+                pending_all_ones = 1;
+            } else if (next == 0) {
+                return HPACK_ERROR;
+            } else {
+                node = next;
+            }
+        }
+    }
+
+    // O preenchimento final deve ser um prefixo do EOS (apenas bits 1) com menos de 8 bits
+    if (pending_bits > 7 || !pending_all_ones) {
+        return HPACK_ERROR;
+    }
+
+    *dst_length = out;
+    return HPACK_OK;
+}
+
+static size_t huffman_encoded_length(const char *src, size_t length)
+{
+    size_t bits = 0;
+    for (size_t i = 0; i < length; i++) {
+        bits += huffman_table[(uint8_t)src[i]].bits;
+    }
+    return (bits + 7) / 8;
+}
+
+static size_t huffman_encode(const char *src, size_t length, uint8_t *dst)
+{
+    uint64_t accumulator = 0;
+    int bits = 0;
+    size_t out = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        const huffman_code_t *code = &huffman_table[(uint8_t)src[i]];
+        accumulator = (accumulator << code->bits) | code->code;
+        bits += code->bits;
+
+        while (bits >= 8) {
+            bits -= 8;
+            dst[out++] = (uint8_t)(accumulator >> bits);
+        }
+    }
+
+    // Completa o último byte com o prefixo do EOS
+    if (bits > 0) {
+        accumulator = (accumulator << (8 - bits)) | (0xFF >> bits);
+        dst[out++] = (uint8_t)accumulator;
+    }
+
+    return out;
+}
+
+static int decode_integer(const uint8_t **pos, const uint8_t *end, int prefix_bits, size_t *value)
+{
+    if (*pos >= end) {
+        return HPACK_ERROR;
+    }
+
+    size_t max_prefix = (1u << prefix_bits) - 1;
+    size_t result = **pos & max_prefix;
+    (*pos)++;
+
+    if (result == max_prefix) {
+        int shift = 0;
+        uint8_t byte;
+        do {
+            // Limita a 4 bytes de continuação (valores até 2^28), suficiente para qualquer campo válido
+            if (*pos >= end || shift > 21) {
+                return HPACK_ERROR;
+            }
+            byte = **pos;
+            (*pos)++;
+            result += (size_t)(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+    }
+
+    *value = result;
+    return HPACK_OK;
+}
+
+static int encode_integer(uint8_t *out, size_t capacity, uint8_t first_byte, int prefix_bits, size_t value)
+{
+    size_t max_prefix = (1u << prefix_bits) - 1;
+    size_t used = 0;
+
+    if (capacity < 1) {
+        return HPACK_BUFFER_FULL;
+    }
+
+    if (value < max_prefix) {
+        out[used++] = first_byte | (uint8_t)value;
+        return used;
+    }
+
+    out[used++] = first_byte | (uint8_t)max_prefix;
+    value -= max_prefix;
+
+    while (value >= 0x80) {
+        if (used >= capacity) {
+            return HPACK_BUFFER_FULL;
+        }
+        out[used++] = (uint8_t)((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+
+    if (used >= capacity) {
+        return HPACK_BUFFER_FULL;
+    }
+    out[used++] = (uint8_t)value;
+    return used;
+}
+
+static int decode_string(hpack_decoder_t *decoder, int slot, const uint8_t **pos, const uint8_t *end,
+                         const char **str, size_t *length)
+{
+    if (*pos >= end) {
+        return HPACK_ERROR;
+    }
+
+    int huffman = (**pos & 0x80) != 0;
+    size_t encoded_length;
+
+    if (decode_integer(pos, end, 7, &encoded_length) < 0 || encoded_length > (size_t)(end - *pos)) {
+        return HPACK_ERROR;
+    }
+
+    if (!huffman) {
+        *str = (const char*)*pos;
+        *length = encoded_length;
+        *pos += encoded_length;
+        return HPACK_OK;
+    }
+
+    // Cada byte Huffman gera no máximo 8/5 símbolos (códigos têm ao menos 5 bits)
+    size_t needed = encoded_length * 8 / 5 + 1;
+    if (decoder->scratch_size[slot] < needed) {
+        char *scratch = realloc(decoder->scratch[slot], needed);
+        if (!scratch) {
+            return HPACK_MEMORY_ERROR;
+        }
+        decoder->scratch[slot] = scratch;
+        decoder->scratch_size[slot] = needed;
+    }
+
+    if (huffman_decode(*pos, encoded_length, decoder->scratch[slot], length) < 0) {
+        return HPACK_ERROR;
+    }
+
+    *str = decoder->scratch[slot];
+    *pos += encoded_length;
+    return HPACK_OK;
+}
+
+static int encode_string(uint8_t *out, size_t capacity, const char *str, size_t length)
+{
+    size_t huffman_length = huffman_encoded_length(str, length);
+    int huffman = huffman_length < length;
+    size_t data_length = huffman ? huffman_length : length;
+
+    int used = encode_integer(out, capacity, huffman ? 0x80 : 0x00, 7, data_length);
+    if (used < 0) {
+        return used;
+    }
+
+    if (data_length > capacity - used) {
+        return HPACK_BUFFER_FULL;
+    }
+
+    if (huffman) {
+        huffman_encode(str, length, out + used);
+    } else {
+        memcpy(out + used, str, length);
+    }
+
+    return used + data_length;
+}
+
+static void table_init(hpack_table_t *table, size_t max_size)
+{
+    memset(table, 0, sizeof(hpack_table_t));
+    table->max_size = max_size;
+}
+
+static void table_cleanup(hpack_table_t *table)
+{
+    for (size_t i = 0; i < table->count; i++) {
+        hpack_entry_t *entry = &table->entries[(table->head + i) % table->capacity];
+        free(entry->name);
+        free(entry->value);
+    }
+    free(table->entries);
+    memset(table, 0, sizeof(hpack_table_t));
+}
+
+// Remove as entradas mais antigas até que o tamanho caiba no limite
+static void table_evict(hpack_table_t *table, size_t limit)
+{
+    while (table->count > 0 && table->size > limit) {
+        hpack_entry_t *oldest = &table->entries[(table->head + table->count - 1) % table->capacity];
+        table->size -= oldest->name_length + oldest->value_length + HPACK_ENTRY_OVERHEAD;
+        free(oldest->name);
+        free(oldest->value);
+        table->count--;
+    }
+}
+
+static int table_add(hpack_table_t *table, const char *name, size_t name_length,
+                     const char *value, size_t value_length)
+{
+    size_t entry_size = name_length + value_length + HPACK_ENTRY_OVERHEAD;
+
+    // Uma entrada maior que a tabela esvazia a tabela e não é inserida
+    if (entry_size > table->max_size) {
+        table_evict(table, 0);
+        return HPACK_OK;
+    }
+
+    table_evict(table, table->max_size - entry_size);
+
+    if (table->count == table->capacity) {
+        size_t capacity = table->capacity ? table->capacity * 2 : 16;
+        hpack_entry_t *entries = malloc(capacity * sizeof(hpack_entry_t));
+        if (!entries) {
+            return HPACK_MEMORY_ERROR;
+        }
+        for (size_t i = 0; i < table->count; i++) {
+            entries[i] = table->entries[(table->head + i) % table->capacity];
+        }
+        free(table->entries);
+        table->entries = entries;
+        table->capacity = capacity;
+        table->head = 0;
+    }
+
+    hpack_entry_t entry;
+    entry.name = malloc(name_length + 1);
+    entry.value = malloc(value_length + 1);
+    if (!entry.name || !entry.value) {
+        free(entry.name);
+        free(entry.value);
+        return HPACK_MEMORY_ERROR;
+    }
+    memcpy(entry.name, name, name_length);
+    entry.name[name_length] = '\0';
+    memcpy(entry.value, value, value_length);
+    entry.value[value_length] = '\0';
+    entry.name_length = name_length;
+    entry.value_length = value_length;
+
+    table->head = (table->head + table->capacity - 1) % table->capacity;
+    table->entries[table->head] = entry;
+    table->count++;
+    table->size += entry_size;
+    return HPACK_OK;
+}
+
+static void table_set_max_size(hpack_table_t *table, size_t max_size)
+{
+    table->max_size = max_size;
+    table_evict(table, max_size);
+}
+
+static int table_lookup(const hpack_table_t *table, size_t index, const char **name, size_t *name_length,
+                        const char **value, size_t *value_length)
+{
+    if (index == 0) {
+        return HPACK_ERROR;
+    }
+
+    if (index <= HPACK_STATIC_TABLE_SIZE) {
+        const hpack_static_entry_t *entry = &static_table[index - 1];
+        *name = entry->name;
+        *name_length = strlen(entry->name);
+        *value = entry->value;
+        *value_length = strlen(entry->value);
+        return HPACK_OK;
+    }
+
+    index -= HPACK_STATIC_TABLE_SIZE + 1;
+    if (index >= table->count) {
+        return HPACK_ERROR;
+    }
+
+    const hpack_entry_t *entry = &table->entries[(table->head + index) % table->capacity];
+    *name = entry->name;
+    *name_length = entry->name_length;
+    *value = entry->value;
+    *value_length = entry->value_length;
+    return HPACK_OK;
+}
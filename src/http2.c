@@ -0,0 +1,1437 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include "http2.h"
+#include "hpack.h"
+#include "send_queue.h"
+#include "socket_utils.h"
+#include "coroutine.h"
+
+#define H2_PREFACE "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+#define H2_PREFACE_LENGTH 24
+#define H2_FRAME_HEADER_SIZE 9
+#define H2_DEFAULT_WINDOW 65535
+#define H2_MAX_WINDOW 0x7FFFFFFF
+#define H2_MAX_FRAME_SIZE 16384
+#define H2_HEADER_TABLE_SIZE 4096
+#define H2_MAX_HEADER_BLOCK (64 * 1024)
+#define H2_MAX_REQUEST_BODY (16 * 1024 * 1024)
+#define H2_MAX_BUFFERED_BODY (32 * 1024 * 1024)  // Corpos retidos por conexão
+#define H2_STREAM_BUCKETS 64
+#define H2_SEND_QUEUE_BYTES (1024 * 1024)  // Frames pendentes antes de suspender os streams
+#define MAX_HEADERS 50
+
+// Tipos de frame
+enum {
+    H2_DATA = 0x0,
+    H2_HEADERS = 0x1,
+    H2_PRIORITY = 0x2,
+    H2_RST_STREAM = 0x3,
+    H2_SETTINGS = 0x4,
+    H2_PUSH_PROMISE = 0x5,
+    H2_PING = 0x6,
+    H2_GOAWAY = 0x7,
+    H2_WINDOW_UPDATE = 0x8,
+    H2_CONTINUATION = 0x9
+};
+
+// Flags de frame
+enum {
+    H2_FLAG_END_STREAM = 0x1,
+    H2_FLAG_ACK = 0x1,
+    H2_FLAG_END_HEADERS = 0x4,
+    H2_FLAG_PADDED = 0x8,
+    H2_FLAG_PRIORITY = 0x20
+};
+
+// Parâmetros de SETTINGS
+enum {
+    H2_SETTINGS_HEADER_TABLE_SIZE = 0x1,
+    H2_SETTINGS_ENABLE_PUSH = 0x2,
+    H2_SETTINGS_MAX_CONCURRENT_STREAMS = 0x3,
+    H2_SETTINGS_INITIAL_WINDOW_SIZE = 0x4,
+    H2_SETTINGS_MAX_FRAME_SIZE = 0x5,
+    H2_SETTINGS_MAX_HEADER_LIST_SIZE = 0x6
+};
+
+// Códigos de erro
+enum {
+    H2_NO_ERROR = 0x0,
+    H2_PROTOCOL_ERROR = 0x1,
+    H2_INTERNAL_ERROR = 0x2,
+    H2_FLOW_CONTROL_ERROR = 0x3,
+    H2_STREAM_CLOSED = 0x5,
+    H2_FRAME_SIZE_ERROR = 0x6,
+    H2_REFUSED_STREAM = 0x7,
+    H2_CANCEL = 0x8,
+    H2_COMPRESSION_ERROR = 0x9
+};
+
+typedef struct h2_connection h2_connection_t;
+
+typedef struct h2_stream {
+    uint32_t id;
+    h2_connection_t *conn;
+    int dispatched;           // Requisição completa, handler em execução
+    int cancelled;            // RST_STREAM recebido
+    int64_t send_window;      // Janela de envio do stream
+    int64_t recv_window;      // Janela de recebimento anunciada ao cliente
+    uint32_t recv_pending;    // Bytes consumidos ainda não devolvidos com WINDOW_UPDATE
+    size_t buffered;          // Memória do corpo contabilizada em buffered_body
+    http_request_t request;
+    int has_method;
+    int has_path;
+    int has_scheme;
+    int regular_seen;         // Um header regular já foi visto (pseudo-headers devem vir antes)
+    int malformed;            // Pseudo-headers inválidos
+    int too_many_headers;
+    char *body;
+    size_t body_length;
+    size_t body_capacity;
+    int body_too_large;
+    struct h2_stream *next;
+} h2_stream_t;
+
+struct h2_connection {
+    int socket;
+    const server_config_t *config;
+    http2_dispatch_fn dispatch;
+    void *ctx;
+
+    pthread_mutex_t lock;        // Streams e janelas de envio
+    coroutine_cond_t cond;       // Sinaliza mudanças de janela, da fila e término de streams
+    pthread_mutex_t write_lock;  // Ordem dos frames na fila e codificador HPACK (nunca mantido em esperas)
+    send_queue_t queue;          // Frames escritos no socket apenas pelo laço da conexão
+    int encoder_failed;          // Tabela HPACK dessincronizada do cliente (protegido por write_lock)
+    int queue_blocked;           // Um stream aguarda a fila esvaziar
+
+    hpack_decoder_t decoder;
+    hpack_encoder_t encoder;
+
+    h2_stream_t *streams[H2_STREAM_BUCKETS];
+    int open_streams;
+    int active_workers;
+    uint32_t last_stream_id;
+    int64_t send_window;         // Janela de envio da conexão
+    int64_t recv_window;         // Janela de recebimento da conexão
+    uint32_t recv_pending;       // Bytes consumidos ainda não devolvidos
+    size_t buffered_body;        // Memória dos corpos de todos os streams
+    int64_t peer_initial_window;
+    uint32_t peer_max_frame;
+    int closing;
+
+    uint32_t max_concurrent_streams;
+    uint32_t local_initial_window;
+
+    // Montagem de blocos de headers divididos em CONTINUATION
+    uint8_t *header_block;
+    size_t header_block_length;
+    uint32_t header_stream;
+    uint8_t header_flags;
+    int expecting_continuation;
+};
+
+// Funções auxiliares internas
+static int queue_frame(h2_connection_t *conn, uint8_t type, uint8_t flags, uint32_t stream_id,
+                       const void *payload, size_t length);
+static int send_frame(h2_connection_t *conn, uint8_t type, uint8_t flags, uint32_t stream_id,
+                      const void *payload, size_t length);
+static int send_rst_stream(h2_connection_t *conn, uint32_t stream_id, uint32_t error_code);
+static int send_window_update(h2_connection_t *conn, uint32_t stream_id, uint32_t increment);
+static int send_goaway(h2_connection_t *conn, uint32_t error_code);
+static int flush_queue(h2_connection_t *conn);
+static int queue_full(h2_connection_t *conn);
+static void consume_window(h2_connection_t *conn, h2_stream_t *stream, uint32_t length);
+static int buffer_body(h2_connection_t *conn, h2_stream_t *stream, const uint8_t *data, size_t length);
+static int process_frame(h2_connection_t *conn, uint8_t type, uint8_t flags, uint32_t stream_id,
+                         const uint8_t *payload, size_t length);
+static int apply_settings(h2_connection_t *conn, const uint8_t *payload, size_t length);
+static h2_stream_t* stream_find(h2_connection_t *conn, uint32_t stream_id);
+static h2_stream_t* stream_create(h2_connection_t *conn, uint32_t stream_id);
+static void stream_remove(h2_connection_t *conn, h2_stream_t *stream);
+static void stream_detach(h2_connection_t *conn, h2_stream_t *stream);
+static void stream_cancel(h2_connection_t *conn, h2_stream_t *stream);
+static void stream_free(h2_stream_t *stream);
+static void stream_start(h2_connection_t *conn, h2_stream_t *stream);
+static int finish_header_block(h2_connection_t *conn);
+static void* stream_worker(void *arg);
+static void stream_coroutine(void *arg);
+static int base64url_decode(const char *src, uint8_t *dst, size_t capacity, size_t *length);
+
+static uint32_t read_u32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void write_u32(uint8_t *p, uint32_t value)
+{
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+int http2_is_preface(const char *data, size_t length)
+{
+    if (!data || length < 3) {
+        return 0;
+    }
+
+    size_t compare = length < H2_PREFACE_LENGTH ? length : H2_PREFACE_LENGTH;
+    return memcmp(data, H2_PREFACE, compare) == 0;
+}
+
+int http2_is_upgrade_request(const http_request_t *request)
+{
+    if (!request || strcmp(request->version, "HTTP/1.1") != 0) {
+        return 0;
+    }
+
+    const http_header_t *upgrade = http_request_get_header(request, "Upgrade");
+    const http_header_t *settings = http_request_get_header(request, "HTTP2-Settings");
+    const http_header_t *content_length = http_request_get_header(request, "Content-Length");
+
+    // Requisições com corpo seguem em HTTP/1.1, o que a RFC 7540 permite
+    if (content_length && atol(content_length->value) > 0) {
+        return 0;
+    }
+
+    return upgrade && settings && strcasecmp(upgrade->value, "h2c") == 0;
+}
+
+int http2_serve_connection(int client_socket, const server_config_t *config,
+                           const char *initial, size_t initial_length,
+                           const http_request_t *upgrade_request,
+                           http2_dispatch_fn dispatch, void *ctx)
+{
+    h2_connection_t conn;
+    memset(&conn, 0, sizeof(conn));
+    conn.socket = client_socket;
+    conn.config = config;
+    conn.dispatch = dispatch;
+    conn.ctx = ctx;
+    conn.send_window = H2_DEFAULT_WINDOW;
+    conn.recv_window = config->http2_initial_window_size;
+    conn.peer_initial_window = H2_DEFAULT_WINDOW;
+    conn.peer_max_frame = H2_MAX_FRAME_SIZE;
+    conn.max_concurrent_streams = config->http2_max_concurrent_streams;
+    conn.local_initial_window = config->http2_initial_window_size;
+    pthread_mutex_init(&conn.lock, NULL);
+    coroutine_cond_init(&conn.cond);
+    pthread_mutex_init(&conn.write_lock, NULL);
+    if (send_queue_init(&conn.queue, client_socket, H2_SEND_QUEUE_BYTES, 0) < 0) {
+        perror("Erro ao criar fila de envio HTTP/2");
+        pthread_mutex_destroy(&conn.write_lock);
+        coroutine_cond_destroy(&conn.cond);
+        pthread_mutex_destroy(&conn.lock);
+        return -1;
+    }
+    hpack_decoder_init(&conn.decoder, H2_HEADER_TABLE_SIZE);
+    hpack_encoder_init(&conn.encoder, H2_HEADER_TABLE_SIZE);
+
+    size_t capacity = H2_FRAME_HEADER_SIZE + H2_MAX_FRAME_SIZE + initial_length;
+    uint8_t *buffer = malloc(capacity);
+    conn.header_block = malloc(H2_MAX_HEADER_BLOCK);
+    int error_code = H2_NO_ERROR;
+    int io_error = 0;
+
+    if (!buffer || !conn.header_block) {
+        free(buffer);
+        free(conn.header_block);
+        hpack_decoder_cleanup(&conn.decoder);
+        hpack_encoder_cleanup(&conn.encoder);
+        send_queue_destroy(&conn.queue);
+        pthread_mutex_destroy(&conn.write_lock);
+        coroutine_cond_destroy(&conn.cond);
+        pthread_mutex_destroy(&conn.lock);
+        return -1;
+    }
+
+    if (initial_length > 0) {
+        memcpy(buffer, initial, initial_length);
+    }
+    size_t have = initial_length;
+
+    if (upgrade_request) {
+        static const char switching[] =
+            "HTTP/1.1 101 Switching Protocols\r\n"
+            "Connection: Upgrade\r\n"
+            "Upgrade: h2c\r\n"
+            "\r\n";
+        if (socket_send(client_socket, switching, sizeof(switching) - 1, 0) < 0) {
+            io_error = 1;
+        }
+
+        // HTTP2-Settings carrega o payload de um frame SETTINGS, reconhecido implicitamente pelo 101
+        const http_header_t *settings = http_request_get_header(upgrade_request, "HTTP2-Settings");
+        uint8_t payload[256];
+        size_t payload_length;
+        if (base64url_decode(settings->value, payload, sizeof(payload), &payload_length) < 0 ||
+            payload_length % 6 != 0) {
+            io_error = 1;
+        } else {
+            apply_settings(&conn, payload, payload_length);
+        }
+    }
+
+    // Prefácio do servidor: SETTINGS com os limites locais
+    uint8_t settings[18];
+    size_t settings_length = 0;
+    settings[settings_length++] = 0;
+    settings[settings_length++] = H2_SETTINGS_MAX_CONCURRENT_STREAMS;
+    write_u32(settings + settings_length, conn.max_concurrent_streams);
+    settings_length += 4;
+    settings[settings_length++] = 0;
+    settings[settings_length++] = H2_SETTINGS_INITIAL_WINDOW_SIZE;
+    write_u32(settings + settings_length, conn.local_initial_window);
+    settings_length += 4;
+    settings[settings_length++] = 0;
+    settings[settings_length++] = H2_SETTINGS_HEADER_TABLE_SIZE;
+    write_u32(settings + settings_length, H2_HEADER_TABLE_SIZE);
+    settings_length += 4;
+
+    if (!io_error && send_frame(&conn, H2_SETTINGS, 0, 0, settings, settings_length) < 0) {
+        io_error = 1;
+    }
+
+    // A janela da conexão não é afetada por SETTINGS e precisa de WINDOW_UPDATE
+    if (!io_error && conn.local_initial_window > H2_DEFAULT_WINDOW) {
+        send_window_update(&conn, 0, conn.local_initial_window - H2_DEFAULT_WINDOW);
+    }
+
+    // Com upgrade, a requisição original vira o stream 1 (meio fechado pelo cliente)
+    if (!io_error && upgrade_request) {
+        h2_stream_t *stream = stream_create(&conn, 1);
+        if (stream) {
+            strcpy(stream->request.method, upgrade_request->method);
+            strcpy(stream->request.path, upgrade_request->path);
+            http_request_normalize_path(&stream->request);
+            for (size_t i = 0; i < upgrade_request->header_count; i++) {
+                const http_header_t *header = &upgrade_request->headers[i];
+                if (strcasecmp(header->name, "Connection") != 0 && strcasecmp(header->name, "Upgrade") != 0 &&
+                    strcasecmp(header->name, "HTTP2-Settings") != 0) {
+                    http_request_add_header(&stream->request, header->name, header->value);
+                }
+            }
+            conn.last_stream_id = 1;
+            pthread_mutex_lock(&conn.lock);
+            conn.open_streams++;
+            pthread_mutex_unlock(&conn.lock);
+            stream_start(&conn, stream);
+        }
+    }
+
+    int preface_checked = 0;
+    int settings_received = 0;
+
+    while (!io_error && error_code == H2_NO_ERROR) {
+        if (!preface_checked && have >= H2_PREFACE_LENGTH) {
+            if (memcmp(buffer, H2_PREFACE, H2_PREFACE_LENGTH) != 0) {
+                error_code = H2_PROTOCOL_ERROR;
+                break;
+            }
+            memmove(buffer, buffer + H2_PREFACE_LENGTH, have - H2_PREFACE_LENGTH);
+            have -= H2_PREFACE_LENGTH;
+            preface_checked = 1;
+        }
+
+        // Processa todos os frames completos do buffer
+        size_t offset = 0;
+        int graceful_end = 0;
+        while (preface_checked && have - offset >= H2_FRAME_HEADER_SIZE) {
+            const uint8_t *header = buffer + offset;
+            uint32_t length = ((uint32_t)header[0] << 16) | ((uint32_t)header[1] << 8) | header[2];
+            uint8_t type = header[3];
+            uint8_t flags = header[4];
+            uint32_t stream_id = read_u32(header + 5) & 0x7FFFFFFF;
+
+            if (length > H2_MAX_FRAME_SIZE) {
+                error_code = H2_FRAME_SIZE_ERROR;
+                break;
+            }
+            if (have - offset < H2_FRAME_HEADER_SIZE + length) {
+                break;
+            }
+
+            // O primeiro frame do cliente deve ser SETTINGS
+            if (!settings_received && (type != H2_SETTINGS || (flags & H2_FLAG_ACK))) {
+                error_code = H2_PROTOCOL_ERROR;
+                break;
+            }
+            settings_received = 1;
+
+            int result = process_frame(&conn, type, flags, stream_id, header + H2_FRAME_HEADER_SIZE, length);
+            offset += H2_FRAME_HEADER_SIZE + length;
+
+            if (result > 0) {
+                graceful_end = 1;
+                break;
+            }
+            if (result < 0) {
+                error_code = -result;
+                break;
+            }
+        }
+
+        if (graceful_end || error_code != H2_NO_ERROR) {
+            break;
+        }
+
+        if (offset > 0) {
+            memmove(buffer, buffer + offset, have - offset);
+            have -= offset;
+        }
+
+        // Uma falha do codificador HPACK deixa a tabela do cliente dessincronizada
+        pthread_mutex_lock(&conn.write_lock);
+        int encoder_failed = conn.encoder_failed;
+        pthread_mutex_unlock(&conn.write_lock);
+        if (encoder_failed) {
+            error_code = H2_COMPRESSION_ERROR;
+            break;
+        }
+
+        // Escreve o que foi enfileirado pelo laço e pelos streams
+        if (flush_queue(&conn) < 0) {
+            io_error = 1;
+            break;
+        }
+
+        // Aguarda dados do cliente ou novos frames na fila
+        if (socket_pending(client_socket) == 0) {
+            struct pollfd fds[2] = {
+                { .fd = client_socket, .events = POLLIN },
+                { .fd = conn.queue.wake_fd, .events = POLLIN }
+            };
+            int ready = socket_poll(fds, 2, -1);
+            if (ready < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ready <= 0) {
+                break;
+            }
+            if ((fds[1].revents & POLLIN) && send_queue_clear_wake(&conn.queue) < 0) {
+                break;
+            }
+            if (!(fds[0].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+        }
+
+        ssize_t n = socket_recv(client_socket, buffer + have, capacity - have, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        have += n;
+    }
+
+    if (error_code != H2_NO_ERROR) {
+        send_goaway(&conn, error_code);
+    }
+    if (!io_error) {
+        send_queue_flush(&conn.queue);
+    }
+
+    // Aguarda os streams em andamento antes de liberar a conexão; com a fila
+    // encerrada, os frames que ainda enviariam são descartados
+    pthread_mutex_lock(&conn.lock);
+    conn.closing = 1;
+    coroutine_cond_broadcast(&conn.cond);
+    pthread_mutex_unlock(&conn.lock);
+    send_queue_shut(&conn.queue);
+
+    pthread_mutex_lock(&conn.lock);
+    while (conn.active_workers > 0) {
+        coroutine_cond_wait(&conn.cond, &conn.lock);
+    }
+    for (int i = 0; i < H2_STREAM_BUCKETS; i++) {
+        h2_stream_t *stream = conn.streams[i];
+        while (stream) {
+            h2_stream_t *next = stream->next;
+            stream->conn = NULL;
+            stream_free(stream);
+            stream = next;
+        }
+    }
+    pthread_mutex_unlock(&conn.lock);
+
+    hpack_decoder_cleanup(&conn.decoder);
+    hpack_encoder_cleanup(&conn.encoder);
+    send_queue_destroy(&conn.queue);
+    pthread_mutex_destroy(&conn.write_lock);
+    coroutine_cond_destroy(&conn.cond);
+    pthread_mutex_destroy(&conn.lock);
+    free(conn.header_block);
+    free(buffer);
+
+    return (io_error || error_code != H2_NO_ERROR) ? -1 : 0;
+}
+
+// Implementação das funções auxiliares internas
+
+// Enfileira um frame para o laço da conexão escrever; o chamador deve possuir
+// write_lock, que mantém a ordem da fila igual à do codificador HPACK
+static int queue_frame(h2_connection_t *conn, uint8_t type, uint8_t flags, uint32_t stream_id,
+                       const void *payload, size_t length)
+{
+    send_buffer_t *frame = send_buffer_create(H2_FRAME_HEADER_SIZE + length);
+    if (!frame) {
+        return -1;
+    }
+
+    uint8_t *header = frame->data;
+    header[0] = length >> 16;
+    header[1] = length >> 8;
+    header[2] = length;
+    header[3] = type;
+    header[4] = flags;
+    write_u32(header + 5, stream_id & 0x7FFFFFFF);
+    if (length > 0) {
+        memcpy(frame->data + H2_FRAME_HEADER_SIZE, payload, length);
+    }
+
+    // O limite da fila é aplicado pelos streams antes de enfileirar DATA
+    int result = send_queue_push(&conn->queue, frame, SEND_QUEUE_UNLIMITED);
+    send_buffer_release(frame);
+    return result;
+}
+
+static int send_frame(h2_connection_t *conn, uint8_t type, uint8_t flags, uint32_t stream_id,
+                      const void *payload, size_t length)
+{
+    pthread_mutex_lock(&conn->write_lock);
+    int result = queue_frame(conn, type, flags, stream_id, payload, length);
+    pthread_mutex_unlock(&conn->write_lock);
+    return result;
+}
+
+static int send_rst_stream(h2_connection_t *conn, uint32_t stream_id, uint32_t error_code)
+{
+    uint8_t payload[4];
+    write_u32(payload, error_code);
+    return send_frame(conn, H2_RST_STREAM, 0, stream_id, payload, sizeof(payload));
+}
+
+static int send_window_update(h2_connection_t *conn, uint32_t stream_id, uint32_t increment)
+{
+    uint8_t payload[4];
+    write_u32(payload, increment & 0x7FFFFFFF);
+    return send_frame(conn, H2_WINDOW_UPDATE, 0, stream_id, payload, sizeof(payload));
+}
+
+static int send_goaway(h2_connection_t *conn, uint32_t error_code)
+{
+    uint8_t payload[8];
+    write_u32(payload, conn->last_stream_id);
+    write_u32(payload + 4, error_code);
+    return send_frame(conn, H2_GOAWAY, 0, 0, payload, sizeof(payload));
+}
+
+// Escreve a fila no socket e libera os streams que aguardavam espaço
+static int flush_queue(h2_connection_t *conn)
+{
+    int result = send_queue_flush(&conn->queue);
+
+    pthread_mutex_lock(&conn->lock);
+    if (conn->queue_blocked) {
+        conn->queue_blocked = 0;
+        coroutine_cond_broadcast(&conn->cond);
+    }
+    pthread_mutex_unlock(&conn->lock);
+
+    return result;
+}
+
+// Verifica se a fila passou do limite; chamada com conn->lock
+static int queue_full(h2_connection_t *conn)
+{
+    pthread_mutex_lock(&conn->queue.lock);
+    int full = conn->queue.queued_bytes >= conn->queue.max_bytes;
+    pthread_mutex_unlock(&conn->queue.lock);
+
+    if (full) {
+        conn->queue_blocked = 1;
+    }
+    return full;
+}
+
+// Devolve ao cliente a janela de dados já consumidos; os WINDOW_UPDATE são agrupados
+// até metade da janela inicial, em vez de um por frame DATA
+static void consume_window(h2_connection_t *conn, h2_stream_t *stream, uint32_t length)
+{
+    uint32_t threshold = conn->local_initial_window / 2;
+
+    conn->recv_pending += length;
+    if (conn->recv_pending >= threshold) {
+        conn->recv_window += conn->recv_pending;
+        send_window_update(conn, 0, conn->recv_pending);
+        conn->recv_pending = 0;
+    }
+
+    if (stream) {
+        stream->recv_pending += length;
+        if (stream->recv_pending >= threshold) {
+            stream->recv_window += stream->recv_pending;
+            send_window_update(conn, stream->id, stream->recv_pending);
+            stream->recv_pending = 0;
+        }
+    }
+}
+
+// Acrescenta dados ao corpo do stream. Acima do limite do stream ou da memória de
+// corpos da conexão o corpo é descartado e a requisição recebe 413
+static int buffer_body(h2_connection_t *conn, h2_stream_t *stream, const uint8_t *data, size_t length)
+{
+    size_t needed = stream->body_length + length;
+    size_t new_capacity = stream->body_capacity;
+    if (needed > new_capacity) {
+        new_capacity = new_capacity ? new_capacity * 2 : 16384;
+        while (new_capacity < needed) {
+            new_capacity *= 2;
+        }
+    }
+    size_t growth = new_capacity - stream->body_capacity;
+
+    pthread_mutex_lock(&conn->lock);
+    int too_large = needed > H2_MAX_REQUEST_BODY || conn->buffered_body + growth > H2_MAX_BUFFERED_BODY;
+    if (too_large) {
+        conn->buffered_body -= stream->buffered;
+        stream->buffered = 0;
+    } else {
+        conn->buffered_body += growth;
+        stream->buffered += growth;
+    }
+    pthread_mutex_unlock(&conn->lock);
+
+    if (too_large) {
+        stream->body_too_large = 1;
+        free(stream->body);
+        stream->body = NULL;
+        stream->body_length = 0;
+        stream->body_capacity = 0;
+        return 0;
+    }
+
+    if (growth > 0) {
+        char *body = realloc(stream->body, new_capacity);
+        if (!body) {
+            return -1;
+        }
+        stream->body = body;
+        stream->body_capacity = new_capacity;
+    }
+
+    memcpy(stream->body + stream->body_length, data, length);
+    stream->body_length = needed;
+    return 0;
+}
+
+// Retorna 0 para continuar, 1 para encerrar normalmente (GOAWAY) ou -código de erro
+static int process_frame(h2_connection_t *conn, uint8_t type, uint8_t flags, uint32_t stream_id,
+                         const uint8_t *payload, size_t length)
+{
+    // Um bloco de headers aberto só pode ser seguido por CONTINUATION do mesmo stream
+    if (conn->expecting_continuation && (type != H2_CONTINUATION || stream_id != conn->header_stream)) {
+        return -H2_PROTOCOL_ERROR;
+    }
+
+    switch (type) {
+        case H2_DATA: {
+            if (stream_id == 0) {
+                return -H2_PROTOCOL_ERROR;
+            }
+
+            size_t data_length = length;
+            const uint8_t *data = payload;
+            if (flags & H2_FLAG_PADDED) {
+                if (length < 1 || payload[0] >= length) {
+                    return -H2_PROTOCOL_ERROR;
+                }
+                data_length = length - 1 - payload[0];
+                data = payload + 1;
+            }
+
+            // Todo o frame, inclusive o preenchimento, conta para o controle de fluxo
+            if ((int64_t)length > conn->recv_window) {
+                return -H2_FLOW_CONTROL_ERROR;
+            }
+            conn->recv_window -= length;
+
+            pthread_mutex_lock(&conn->lock);
+            h2_stream_t *stream = stream_find(conn, stream_id);
+            int receiving = stream && !stream->dispatched;
+            int overflow = receiving && (int64_t)length > stream->recv_window;
+            if (overflow) {
+                stream_cancel(conn, stream);
+            }
+            pthread_mutex_unlock(&conn->lock);
+
+            if (!receiving || overflow) {
+                if (stream_id > conn->last_stream_id) {
+                    return -H2_PROTOCOL_ERROR;
+                }
+                // Dados descartados devolvem apenas a janela da conexão
+                consume_window(conn, NULL, length);
+                send_rst_stream(conn, stream_id, overflow ? H2_FLOW_CONTROL_ERROR : H2_STREAM_CLOSED);
+                return 0;
+            }
+            stream->recv_window -= length;
+
+            if (!stream->body_too_large && data_length > 0 &&
+                buffer_body(conn, stream, data, data_length) < 0) {
+                return -H2_INTERNAL_ERROR;
+            }
+
+            // A janela só é devolvida depois que os dados foram copiados ou descartados
+            if (flags & H2_FLAG_END_STREAM) {
+                consume_window(conn, NULL, length);
+                stream_start(conn, stream);
+            } else {
+                consume_window(conn, stream, length);
+            }
+            return 0;
+        }
+
+        case H2_HEADERS: {
+            if (stream_id == 0) {
+                return -H2_PROTOCOL_ERROR;
+            }
+
+            size_t skip = 0;
+            size_t padding = 0;
+            if (flags & H2_FLAG_PADDED) {
+                if (length < 1) {
+                    return -H2_PROTOCOL_ERROR;
+                }
+                padding = payload[0];
+                skip = 1;
+            }
+            if (flags & H2_FLAG_PRIORITY) {
+                skip += 5;
+            }
+            if (skip + padding > length) {
+                return -H2_PROTOCOL_ERROR;
+            }
+
+            size_t fragment_length = length - skip - padding;
+            if (fragment_length > H2_MAX_HEADER_BLOCK) {
+                return -H2_PROTOCOL_ERROR;
+            }
+
+            memcpy(conn->header_block, payload + skip, fragment_length);
+            conn->header_block_length = fragment_length;
+            conn->header_stream = stream_id;
+            conn->header_flags = flags;
+
+            if (flags & H2_FLAG_END_HEADERS) {
+                return finish_header_block(conn);
+            }
+            conn->expecting_continuation = 1;
+            return 0;
+        }
+
+        case H2_CONTINUATION: {
+            if (!conn->expecting_continuation) {
+                return -H2_PROTOCOL_ERROR;
+            }
+            if (conn->header_block_length + length > H2_MAX_HEADER_BLOCK) {
+                return -H2_PROTOCOL_ERROR;
+            }
+
+            memcpy(conn->header_block + conn->header_block_length, payload, length);
+            conn->header_block_length += length;
+
+            if (flags & H2_FLAG_END_HEADERS) {
+                conn->expecting_continuation = 0;
+                return finish_header_block(conn);
+            }
+            return 0;
+        }
+
+        case H2_PRIORITY:
+            if (length != 5) {
+                return -H2_FRAME_SIZE_ERROR;
+            }
+            return 0;
+
+        case H2_RST_STREAM: {
+            if (stream_id == 0) {
+                return -H2_PROTOCOL_ERROR;
+            }
+            if (length != 4) {
+                return -H2_FRAME_SIZE_ERROR;
+            }
+
+            pthread_mutex_lock(&conn->lock);
+            h2_stream_t *stream = stream_find(conn, stream_id);
+            if (stream) {
+                stream_cancel(conn, stream);
+            }
+            pthread_mutex_unlock(&conn->lock);
+            return 0;
+        }
+
+        case H2_SETTINGS: {
+            if (stream_id != 0) {
+                return -H2_PROTOCOL_ERROR;
+            }
+            if (flags & H2_FLAG_ACK) {
+                return length == 0 ? 0 : -H2_FRAME_SIZE_ERROR;
+            }
+            if (length % 6 != 0) {
+                return -H2_FRAME_SIZE_ERROR;
+            }
+
+            int result = apply_settings(conn, payload, length);
+            if (result < 0) {
+                return result;
+            }
+            send_frame(conn, H2_SETTINGS, H2_FLAG_ACK, 0, NULL, 0);
+            return 0;
+        }
+
+        case H2_PUSH_PROMISE:
+            // Clientes não podem enviar PUSH_PROMISE
+            return -H2_PROTOCOL_ERROR;
+
+        case H2_PING:
+            if (stream_id != 0) {
+                return -H2_PROTOCOL_ERROR;
+            }
+            if (length != 8) {
+                return -H2_FRAME_SIZE_ERROR;
+            }
+            if (!(flags & H2_FLAG_ACK)) {
+                send_frame(conn, H2_PING, H2_FLAG_ACK, 0, payload, length);
+            }
+            return 0;
+
+        case H2_GOAWAY:
+            if (stream_id != 0) {
+                return -H2_PROTOCOL_ERROR;
+            }
+            return 1;
+
+        case H2_WINDOW_UPDATE: {
+            if (length != 4) {
+                return -H2_FRAME_SIZE_ERROR;
+            }
+
+            uint32_t increment = read_u32(payload) & 0x7FFFFFFF;
+            if (increment == 0) {
+                if (stream_id == 0) {
+                    return -H2_PROTOCOL_ERROR;
+                }
+                send_rst_stream(conn, stream_id, H2_PROTOCOL_ERROR);
+                return 0;
+            }
+
+            int overflow = 0;
+            pthread_mutex_lock(&conn->lock);
+            if (stream_id == 0) {
+                conn->send_window += increment;
+                if (conn->send_window > H2_MAX_WINDOW) {
+                    pthread_mutex_unlock(&conn->lock);
+                    return -H2_FLOW_CONTROL_ERROR;
+                }
+            } else {
+                h2_stream_t *stream = stream_find(conn, stream_id);
+                if (stream) {
+                    stream->send_window += increment;
+                    overflow = stream->send_window > H2_MAX_WINDOW;
+                    if (overflow) {
+                        stream_cancel(conn, stream);
+                    }
+                }
+            }
+            coroutine_cond_broadcast(&conn->cond);
+            pthread_mutex_unlock(&conn->lock);
+
+            // Janela do stream acima de 2^31-1 é erro apenas do stream
+            if (overflow) {
+                send_rst_stream(conn, stream_id, H2_FLOW_CONTROL_ERROR);
+            }
+            return 0;
+        }
+
+        default:
+            // Tipos desconhecidos são ignorados
+            return 0;
+    }
+}
+
+static int apply_settings(h2_connection_t *conn, const uint8_t *payload, size_t length)
+{
+    for (size_t i = 0; i + 6 <= length; i += 6) {
+        uint16_t id = ((uint16_t)payload[i] << 8) | payload[i + 1];
+        uint32_t value = read_u32(payload + i + 2);
+
+        switch (id) {
+            case H2_SETTINGS_HEADER_TABLE_SIZE:
+                pthread_mutex_lock(&conn->write_lock);
+                hpack_encoder_set_max_size(&conn->encoder,
+                                           value < H2_HEADER_TABLE_SIZE ? value : H2_HEADER_TABLE_SIZE);
+                pthread_mutex_unlock(&conn->write_lock);
+                break;
+
+            case H2_SETTINGS_ENABLE_PUSH:
+                if (value > 1) {
+                    return -H2_PROTOCOL_ERROR;
+                }
+                break;
+
+            case H2_SETTINGS_INITIAL_WINDOW_SIZE: {
+                if (value > H2_MAX_WINDOW) {
+                    return -H2_FLOW_CONTROL_ERROR;
+                }
+
+                // A diferença é aplicada às janelas de todos os streams abertos
+                pthread_mutex_lock(&conn->lock);
+                int64_t delta = (int64_t)value - conn->peer_initial_window;
+                int overflow = 0;
+                conn->peer_initial_window = value;
+                for (int b = 0; b < H2_STREAM_BUCKETS; b++) {
+                    for (h2_stream_t *stream = conn->streams[b]; stream; stream = stream->next) {
+                        stream->send_window += delta;
+                        overflow |= stream->send_window > H2_MAX_WINDOW;
+                    }
+                }
+                coroutine_cond_broadcast(&conn->cond);
+                pthread_mutex_unlock(&conn->lock);
+                if (overflow) {
+                    return -H2_FLOW_CONTROL_ERROR;
+                }
+                break;
+            }
+
+            case H2_SETTINGS_MAX_FRAME_SIZE:
+                if (value < 16384 || value > 16777215) {
+                    return -H2_PROTOCOL_ERROR;
+                }
+                pthread_mutex_lock(&conn->lock);
+                conn->peer_max_frame = value;
+                pthread_mutex_unlock(&conn->lock);
+                break;
+
+            default:
+                // MAX_CONCURRENT_STREAMS e MAX_HEADER_LIST_SIZE não afetam um servidor sem push
+                break;
+        }
+    }
+
+    return 0;
+}
+
+// Recebe cada header decodificado de um stream
+static int stream_header_cb(void *ctx, const char *name, size_t name_length,
+                            const char *value, size_t value_length)
+{
+    h2_stream_t *stream = (h2_stream_t*)ctx;
+    http_request_t *request = &stream->request;
+
+    if (name_length > 0 && name[0] == ':') {
+        if (stream->regular_seen) {
+            stream->malformed = 1;
+            return 0;
+        }
+
+        if (name_length == 7 && memcmp(name, ":method", 7) == 0) {
+            if (value_length >= sizeof(request->method)) {
+                stream->malformed = 1;
+                return 0;
+            }
+            memcpy(request->method, value, value_length);
+            request->method[value_length] = '\0';
+            stream->has_method = 1;
+        } else if (name_length == 5 && memcmp(name, ":path", 5) == 0) {
+            if (value_length == 0 || value_length >= sizeof(request->path)) {
+                stream->malformed = 1;
+                return 0;
+            }
+            memcpy(request->path, value, value_length);
+            request->path[value_length] = '\0';
+            if (http_request_normalize_path(request) != HTTP_PARSE_OK) {
+                stream->malformed = 1;
+                return 0;
+            }
+            stream->has_path = 1;
+        } else if (name_length == 7 && memcmp(name, ":scheme", 7) == 0) {
+            stream->has_scheme = 1;
+        } else if (name_length == 10 && memcmp(name, ":authority", 10) == 0) {
+            // :authority substitui o header Host do HTTP/1.1
+            char *host = strndup(value, value_length);
+            if (host && !http_request_get_header(request, "host") &&
+                http_request_add_header(request, "host", host) == HTTP_PARSE_TOO_MANY_HEADERS) {
+                stream->too_many_headers = 1;
+            }
+            free(host);
+        } else {
+            stream->malformed = 1;
+        }
+        return 0;
+    }
+
+    stream->regular_seen = 1;
+
+    // Headers específicos de conexão são proibidos em HTTP/2
+    for (size_t i = 0; i < name_length; i++) {
+        if (isupper((unsigned char)name[i])) {
+            stream->malformed = 1;
+            return 0;
+        }
+    }
+    if ((name_length == 10 && memcmp(name, "connection", 10) == 0) ||
+        (name_length == 17 && memcmp(name, "transfer-encoding", 17) == 0)) {
+        stream->malformed = 1;
+        return 0;
+    }
+
+    char *name_copy = strndup(name, name_length);
+    char *value_copy = strndup(value, value_length);
+    if (!name_copy || !value_copy) {
+        free(name_copy);
+        free(value_copy);
+        return -1;
+    }
+
+    int result = http_request_add_header(request, name_copy, value_copy);
+    if (result == HTTP_PARSE_TOO_MANY_HEADERS) {
+        stream->too_many_headers = 1;
+    }
+
+    free(name_copy);
+    free(value_copy);
+    return result == HTTP_PARSE_MEMORY_ERROR ? -1 : 0;
+}
+
+static int finish_header_block(h2_connection_t *conn)
+{
+    uint32_t stream_id = conn->header_stream;
+    int end_stream = (conn->header_flags & H2_FLAG_END_STREAM) != 0;
+    conn->expecting_continuation = 0;
+
+    pthread_mutex_lock(&conn->lock);
+    h2_stream_t *stream = stream_find(conn, stream_id);
+    pthread_mutex_unlock(&conn->lock);
+
+    if (stream) {
+        // Trailers de um stream que ainda recebe dados
+        if (stream->dispatched || !end_stream) {
+            return -H2_PROTOCOL_ERROR;
+        }
+        if (hpack_decode(&conn->decoder, conn->header_block, conn->header_block_length, NULL, NULL) != HPACK_OK) {
+            return -H2_COMPRESSION_ERROR;
+        }
+        stream_start(conn, stream);
+        return 0;
+    }
+
+    // Streams iniciados pelo cliente são ímpares e crescentes
+    if ((stream_id & 1) == 0 || stream_id <= conn->last_stream_id) {
+        return -H2_PROTOCOL_ERROR;
+    }
+    conn->last_stream_id = stream_id;
+
+    pthread_mutex_lock(&conn->lock);
+    int refuse = conn->open_streams >= (int)conn->max_concurrent_streams;
+    pthread_mutex_unlock(&conn->lock);
+
+    if (refuse) {
+        // O bloco ainda precisa ser decodificado para manter a tabela dinâmica em sincronia
+        if (hpack_decode(&conn->decoder, conn->header_block, conn->header_block_length, NULL, NULL) != HPACK_OK) {
+            return -H2_COMPRESSION_ERROR;
+        }
+        send_rst_stream(conn, stream_id, H2_REFUSED_STREAM);
+        return 0;
+    }
+
+    stream = stream_create(conn, stream_id);
+    if (!stream) {
+        return -H2_INTERNAL_ERROR;
+    }
+
+    if (hpack_decode(&conn->decoder, conn->header_block, conn->header_block_length,
+                     stream_header_cb, stream) != HPACK_OK) {
+        stream_free(stream);
+        return -H2_COMPRESSION_ERROR;
+    }
+
+    int is_connect = strcmp(stream->request.method, "CONNECT") == 0;
+    if (stream->malformed || !stream->has_method ||
+        (!is_connect && (!stream->has_path || !stream->has_scheme))) {
+        stream_free(stream);
+        send_rst_stream(conn, stream_id, H2_PROTOCOL_ERROR);
+        return 0;
+    }
+
+    pthread_mutex_lock(&conn->lock);
+    conn->open_streams++;
+    pthread_mutex_unlock(&conn->lock);
+
+    if (end_stream) {
+        stream_start(conn, stream);
+    }
+    return 0;
+}
+
+static h2_stream_t* stream_find(h2_connection_t *conn, uint32_t stream_id)
+{
+    h2_stream_t *stream = conn->streams[stream_id % H2_STREAM_BUCKETS];
+    while (stream && stream->id != stream_id) {
+        stream = stream->next;
+    }
+    return stream;
+}
+
+static h2_stream_t* stream_create(h2_connection_t *conn, uint32_t stream_id)
+{
+    h2_stream_t *stream = calloc(1, sizeof(h2_stream_t));
+    if (!stream) {
+        return NULL;
+    }
+
+    if (http_request_init(&stream->request, MAX_HEADERS) != HTTP_PARSE_OK) {
+        free(stream);
+        return NULL;
+    }
+
+    stream->id = stream_id;
+    stream->conn = conn;
+    strcpy(stream->request.version, "HTTP/2.0");
+
+    pthread_mutex_lock(&conn->lock);
+    stream->send_window = conn->peer_initial_window;
+    stream->recv_window = conn->local_initial_window;
+    stream->next = conn->streams[stream_id % H2_STREAM_BUCKETS];
+    conn->streams[stream_id % H2_STREAM_BUCKETS] = stream;
+    pthread_mutex_unlock(&conn->lock);
+
+    return stream;
+}
+
+// Remove o stream da tabela; o chamador deve possuir conn->lock
+static void stream_remove(h2_connection_t *conn, h2_stream_t *stream)
+{
+    h2_stream_t **link = &conn->streams[stream->id % H2_STREAM_BUCKETS];
+    while (*link && *link != stream) {
+        link = &(*link)->next;
+    }
+    if (*link) {
+        *link = stream->next;
+    }
+}
+
+// Remove o stream da conexão e devolve a memória do corpo; o chamador deve possuir conn->lock
+static void stream_detach(h2_connection_t *conn, h2_stream_t *stream)
+{
+    stream_remove(conn, stream);
+    conn->open_streams--;
+    conn->buffered_body -= stream->buffered;
+    stream->buffered = 0;
+    stream->conn = NULL;
+}
+
+// Encerra um stream a pedido do cliente ou por erro; o chamador deve possuir conn->lock
+static void stream_cancel(h2_connection_t *conn, h2_stream_t *stream)
+{
+    if (stream->dispatched) {
+        // A thread do stream interrompe o envio e libera o stream
+        stream->cancelled = 1;
+        coroutine_cond_broadcast(&conn->cond);
+        return;
+    }
+
+    stream_detach(conn, stream);
+    stream_free(stream);
+}
+
+static void stream_free(h2_stream_t *stream)
+{
+    if (!stream) {
+        return;
+    }
+
+    if (stream->conn) {
+        pthread_mutex_lock(&stream->conn->lock);
+        stream_remove(stream->conn, stream);
+        pthread_mutex_unlock(&stream->conn->lock);
+        stream->conn = NULL;
+    }
+
+    http_request_cleanup(&stream->request);
+    free(stream->body);
+    free(stream);
+}
+
+// Inicia o processamento de um stream cuja requisição está completa
+static void stream_start(h2_connection_t *conn, h2_stream_t *stream)
+{
+    // O corpo acumulado passa a pertencer à requisição
+    stream->request.body = stream->body;
+    stream->request.body_length = stream->body_length;
+    stream->body = NULL;
+
+    pthread_mutex_lock(&conn->lock);
+    stream->dispatched = 1;
+    conn->active_workers++;
+    pthread_mutex_unlock(&conn->lock);
+
+    // Em uma corrotina, o stream roda no mesmo worker da conexão
+    int started;
+    if (coroutine_active()) {
+        started = coroutine_spawn_local(stream_coroutine, stream) == 0;
+    } else {
+        pthread_t thread_id;
+        started = pthread_create(&thread_id, NULL, stream_worker, stream) == 0;
+        if (started) {
+            pthread_detach(thread_id);
+        }
+    }
+    if (started) {
+        return;
+    }
+
+    // Executado no laço da conexão, o stream a travaria aguardando as janelas: é recusado
+    uint32_t stream_id = stream->id;
+    pthread_mutex_lock(&conn->lock);
+    stream->dispatched = 0;
+    conn->active_workers--;
+    stream_detach(conn, stream);
+    pthread_mutex_unlock(&conn->lock);
+    stream_free(stream);
+
+    send_rst_stream(conn, stream_id, H2_REFUSED_STREAM);
+}
+
+// Codifica o bloco de headers da resposta; uma falha no meio pode já ter alterado a tabela dinâmica
+static int encode_response_headers(h2_connection_t *conn, const http_response_t *response,
+                                   uint8_t *block, size_t capacity, size_t *length)
+{
+    size_t used = 0;
+    char status[8];
+    char content_length[24];
+    char lowercase[HTTP_RESPONSE_MAX_HEADERS][64];
+    int written;
+
+    snprintf(status, sizeof(status), "%03d", response->status_code % 1000);
+    snprintf(content_length, sizeof(content_length), "%zu", response->body_length);
+
+    written = hpack_encode_begin(&conn->encoder, block, capacity);
+    if (written < 0) {
+        return -1;
+    }
+    used += written;
+
+    written = hpack_encode_header(&conn->encoder, block + used, capacity - used, ":status", status, HPACK_INDEX);
+    if (written < 0) {
+        return -1;
+    }
+    used += written;
+
+    if (response->content_type) {
+        written = hpack_encode_header(&conn->encoder, block + used, capacity - used,
+                                      "content-type", response->content_type, HPACK_INDEX);
+        if (written < 0) {
+            return -1;
+        }
+        used += written;
+    }
+
+    written = hpack_encode_header(&conn->encoder, block + used, capacity - used,
+                                  "content-length", content_length, HPACK_NO_INDEX);
+    if (written < 0) {
+        return -1;
+    }
+    used += written;
+
+    for (size_t i = 0; i < response->header_count; i++) {
+        const char *name = response->headers[i].name;
+        size_t name_length = strlen(name);
+        if (name_length >= sizeof(lowercase[0]) || strcasecmp(name, "Connection") == 0 ||
+            strcasecmp(name, "Keep-Alive") == 0 || strcasecmp(name, "Transfer-Encoding") == 0) {
+            continue;
+        }
+        for (size_t j = 0; j <= name_length; j++) {
+            lowercase[i][j] = tolower((unsigned char)name[j]);
+        }
+
+        written = hpack_encode_header(&conn->encoder, block + used, capacity - used,
+                                      lowercase[i], response->headers[i].value, HPACK_INDEX);
+        if (written < 0) {
+            return -1;
+        }
+        used += written;
+    }
+
+    *length = used;
+    return 0;
+}
+
+// Codifica e envia HEADERS (e CONTINUATION) com a resposta; o chamador possui write_lock
+static int send_response_headers(h2_connection_t *conn, h2_stream_t *stream,
+                                 const http_response_t *response, int end_stream)
+{
+    uint8_t block[H2_MAX_FRAME_SIZE];
+    size_t used;
+
+    // Depois de uma falha o cliente não decodificaria mais nenhum bloco
+    if (conn->encoder_failed) {
+        return -1;
+    }
+    if (encode_response_headers(conn, response, block, sizeof(block), &used) < 0) {
+        conn->encoder_failed = 1;
+        return -1;
+    }
+
+    // Blocos maiores que o frame máximo do cliente seguem em CONTINUATION
+    uint32_t max_frame = conn->peer_max_frame;
+    size_t offset = 0;
+    int first = 1;
+    do {
+        size_t chunk = used - offset < max_frame ? used - offset : max_frame;
+        int last = offset + chunk == used;
+        uint8_t flags = last ? H2_FLAG_END_HEADERS : 0;
+        if (first && end_stream) {
+            flags |= H2_FLAG_END_STREAM;
+        }
+        if (queue_frame(conn, first ? H2_HEADERS : H2_CONTINUATION, flags, stream->id,
+                        block + offset, chunk) < 0) {
+            return -1;
+        }
+        offset += chunk;
+        first = 0;
+    } while (offset < used);
+
+    return 0;
+}
+
+static void* stream_worker(void *arg)
+{
+    h2_stream_t *stream = (h2_stream_t*)arg;
+    h2_connection_t *conn = stream->conn;
+
+    http_response_t response;
+    http_response_init(&response);
+
+    if (stream->body_too_large) {
+        http_response_set(&response, 413, "Payload Too Large", "text/plain", "Corpo da requisição muito grande");
+    } else if (stream->too_many_headers) {
+        http_response_set(&response, 431, "Request Header Fields Too Large", "text/plain", NULL);
+    } else {
+        conn->dispatch(conn->ctx, &stream->request, &response);
+    }
+
+    int is_head = strcmp(stream->request.method, "HEAD") == 0;
+    size_t remaining = is_head ? 0 : response.body_length;
+    const char *data = response.body;
+
+    pthread_mutex_lock(&conn->lock);
+    int aborted = stream->cancelled || conn->closing;
+    pthread_mutex_unlock(&conn->lock);
+
+    if (!aborted) {
+        pthread_mutex_lock(&conn->write_lock);
+        aborted = send_response_headers(conn, stream, &response, remaining == 0) < 0;
+        int encoder_failed = conn->encoder_failed;
+        pthread_mutex_unlock(&conn->write_lock);
+
+        // Sem HEADERS, o RST_STREAM encerra o stream e acorda o laço da conexão, que envia GOAWAY
+        if (aborted && encoder_failed) {
+            send_rst_stream(conn, stream->id, H2_INTERNAL_ERROR);
+        }
+    }
+
+    // Envia o corpo em frames DATA respeitando as janelas do stream e da conexão
+    // e o limite da fila de envio
+    while (!aborted && remaining > 0) {
+        pthread_mutex_lock(&conn->lock);
+        while (!stream->cancelled && !conn->closing &&
+               (conn->send_window <= 0 || stream->send_window <= 0 || queue_full(conn))) {
+            coroutine_cond_wait(&conn->cond, &conn->lock);
+        }
+        if (stream->cancelled || conn->closing) {
+            pthread_mutex_unlock(&conn->lock);
+            break;
+        }
+
+        size_t chunk = remaining;
+        if ((int64_t)chunk > conn->send_window) {
+            chunk = conn->send_window;
+        }
+        if ((int64_t)chunk > stream->send_window) {
+            chunk = stream->send_window;
+        }
+        if (chunk > conn->peer_max_frame) {
+            chunk = conn->peer_max_frame;
+        }
+        conn->send_window -= chunk;
+        stream->send_window -= chunk;
+        pthread_mutex_unlock(&conn->lock);
+
+        remaining -= chunk;
+        pthread_mutex_lock(&conn->write_lock);
+        aborted = queue_frame(conn, H2_DATA, remaining == 0 ? H2_FLAG_END_STREAM : 0,
+                              stream->id, data, chunk) < 0;
+        pthread_mutex_unlock(&conn->write_lock);
+        data += chunk;
+    }
+
+    http_response_cleanup(&response);
+
+    pthread_mutex_lock(&conn->lock);
+    stream_detach(conn, stream);
+    conn->active_workers--;
+    coroutine_cond_broadcast(&conn->cond);
+    pthread_mutex_unlock(&conn->lock);
+
+    stream_free(stream);
+    return NULL;
+}
+
+static void stream_coroutine(void *arg)
+{
+    stream_worker(arg);
+}
+
+static int base64url_decode(const char *src, uint8_t *dst, size_t capacity, size_t *length)
+{
+    uint32_t accumulator = 0;
+    int bits = 0;
+    size_t out = 0;
+
+    for (; *src && *src != '='; src++) {
+        int value;
+        char c = *src;
+        if (c >= 'A' && c <= 'Z') value = c - 'A';
+        else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') value = c - '0' + 52;
+        else if (c == '-' || c == '+') value = 62;
+        else if (c == '_' || c == '/') value = 63;
+        else return -1;
+
+        accumulator = (accumulator << 6) | value;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            if (out >= capacity) {
+                return -1;
+            }
+            dst[out++] = (uint8_t)(accumulator >> bits);
+        }
+    }
+
+    *length = out;
+    return 0;
+}
@@ -3,13 +3,17 @@
 #include <string.h>
 #include <ctype.h>
 #include "http_parser.h"
+#include "trace.h"
 
 // Funções auxiliares internas
+static int parse_request(http_request_t *request, const char *raw_data, size_t length);
 static int parse_request_line(http_request_t *request, const char *data, size_t length, size_t *offset);
 static int parse_headers(http_request_t *request, const char *data, size_t length, size_t *offset);
 static int is_valid_method(const char *method);
 static int is_valid_path_char(char c);
 static void skip_whitespace(const char *data, size_t length, size_t *offset);
+static int hex_value(char c);
+static int remove_dot_segments(char *path);
 
 int http_request_init(http_request_t *request, size_t max_headers) {
     if (!request || max_headers == 0) {
@@ -47,8 +51,8 @@ void http_request_cleanup(http_request_t *request) {
         free(request->headers);
     }
 
-    // Libera corpo se existir
-    if (request->body) {
+    // Libera corpo se existir (corpos emprestados pertencem ao buffer de recepção)
+    if (request->body && !request->borrow_body) {
         free(request->body);
     }
 
@@ -57,36 +61,17 @@ void http_request_cleanup(http_request_t *request) {
 }
 
 int parse_http_request(http_request_t *request, const char *raw_data, size_t length) {
-    if (!request || !raw_data || length == 0) {
-        return HTTP_PARSE_INVALID_REQUEST;
-    }
-
-    size_t offset = 0;
-    int result;
-
-    // Parse da linha de requisição
-    result = parse_request_line(request, raw_data, length, &offset);
-    if (result != HTTP_PARSE_OK) {
-        return result;
-    }
-
-    // Parse dos headers
-    result = parse_headers(request, raw_data, length, &offset);
-    if (result != HTTP_PARSE_OK) {
-        return result;
-    }
-
-    // Verifica se há corpo na requisição
-    const http_header_t *content_length_header = http_request_get_header(request, "Content-Length");
-    if (content_length_header) {
-        size_t content_length = atol(content_length_header->value);
-        if (content_length > 0 && offset + content_length <= length) {
-            // Copia o corpo
-            return http_request_set_body(request, raw_data + offset, content_length);
-        }
+    TRACE_PROBE1(parse__start, length);
+
+    int result = parse_request(request, raw_data, length);
+    if (result == HTTP_PARSE_OK) {
+        TRACE_PROBE3(request__parsed, (const char*)request->method, (const char*)request->path,
+                     request->header_count);
+    } else {
+        TRACE_PROBE1(parse__error, result);
     }
 
-    return HTTP_PARSE_OK;
+    return result;
 }
 
 int http_request_add_header(http_request_t *request, const char *name, const char *value) {
@@ -136,10 +121,13 @@ int http_request_set_body(http_request_t *request, const char *body, size_t leng
 
     // Libera corpo anterior se existir
     if (request->body) {
-        free(request->body);
+        if (!request->borrow_body) {
+            free(request->body);
+        }
         request->body = NULL;
         request->body_length = 0;
     }
+    request->borrow_body = 0;
 
     if (length > 0) {
         request->body = malloc(length);
@@ -154,8 +142,226 @@ int http_request_set_body(http_request_t *request, const char *body, size_t leng
     return HTTP_PARSE_OK;
 }
 
+void http_request_view_init(http_request_view_t *view, const http_request_t *request)
+{
+    if (!view || !request) {
+        return;
+    }
+
+    view->method.data = request->method;
+    view->method.length = strlen(request->method);
+    view->path.data = request->path;
+    view->path.length = strlen(request->path);
+    view->normalized_path.data = request->normalized_path;
+    view->normalized_path.length = strlen(request->normalized_path);
+    view->query.data = request->path + request->query_offset;
+    view->query.length = request->query_length;
+    view->version.data = request->version;
+    view->version.length = strlen(request->version);
+    view->headers = request->headers;
+    view->header_count = request->header_count;
+    view->body.data = request->body;
+    view->body.length = request->body_length;
+    view->request = request;
+}
+
+int http_request_view_header(const http_request_view_t *view, const char *name, http_string_view_t *value)
+{
+    if (!view || !name || !value) {
+        return 0;
+    }
+
+    const http_header_t *header = http_request_get_header(view->request, name);
+    if (!header) {
+        return 0;
+    }
+
+    value->data = header->value;
+    value->length = strlen(header->value);
+    return 1;
+}
+
+int http_request_normalize_path(http_request_t *request)
+{
+    if (!request) {
+        return HTTP_PARSE_INVALID_REQUEST;
+    }
+
+    const char *path = request->path;
+    size_t length = strcspn(path, "?#");
+
+    request->query_offset = 0;
+    request->query_length = 0;
+    if (path[length] == '?') {
+        request->query_offset = length + 1;
+        request->query_length = strcspn(path + length + 1, "#");
+    }
+
+    // OPTIONS * não tem caminho
+    if (length == 1 && path[0] == '*') {
+        strcpy(request->normalized_path, "*");
+        return HTTP_PARSE_OK;
+    }
+
+    if (path[0] != '/' ||
+        http_url_decode(path, length, request->normalized_path, sizeof(request->normalized_path), 0) < 0 ||
+        remove_dot_segments(request->normalized_path) < 0) {
+        request->normalized_path[0] = '\0';
+        return HTTP_PARSE_INVALID_PATH;
+    }
+
+    return HTTP_PARSE_OK;
+}
+
+ssize_t http_url_decode(const char *src, size_t length, char *dst, size_t dst_size, int plus_as_space)
+{
+    if (!src || !dst || length >= dst_size) {
+        return -1;
+    }
+
+    // Caminho rápido: nada a decodificar
+    if (!memchr(src, '%', length) && (!plus_as_space || !memchr(src, '+', length))) {
+        memmove(dst, src, length);
+        dst[length] = '\0';
+        return (ssize_t)length;
+    }
+
+    // A saída nunca é maior que a entrada, portanto dst pode ser igual a src
+    size_t used = 0;
+    for (size_t i = 0; i < length; i++) {
+        char c = src[i];
+        if (c == '%') {
+            if (i + 2 >= length) {
+                return -1;
+            }
+            int high = hex_value(src[i + 1]);
+            int low = hex_value(src[i + 2]);
+            if (high < 0 || low < 0 || (high | low) == 0) {
+                return -1;
+            }
+            c = (char)(high << 4 | low);
+            i += 2;
+        } else if (c == '+' && plus_as_space) {
+            c = ' ';
+        }
+        dst[used++] = c;
+    }
+    dst[used] = '\0';
+
+    return (ssize_t)used;
+}
+
+void http_query_iterator_init(http_query_iterator_t *iterator, http_string_view_t query)
+{
+    if (!iterator) {
+        return;
+    }
+
+    iterator->next = query.data;
+    iterator->end = query.data ? query.data + query.length : NULL;
+}
+
+int http_query_next(http_query_iterator_t *iterator, http_query_param_t *param)
+{
+    if (!iterator || !param) {
+        return 0;
+    }
+
+    while (iterator->next && iterator->next < iterator->end) {
+        const char *start = iterator->next;
+        const char *stop = memchr(start, '&', (size_t)(iterator->end - start));
+        if (!stop) {
+            stop = iterator->end;
+        }
+        iterator->next = stop + 1;
+
+        if (stop == start) {
+            continue;
+        }
+
+        const char *equals = memchr(start, '=', (size_t)(stop - start));
+        param->name.data = start;
+        param->name.length = (size_t)((equals ? equals : stop) - start);
+        param->value.data = equals ? equals + 1 : stop;
+        param->value.length = equals ? (size_t)(stop - equals - 1) : 0;
+        param->encoded = memchr(start, '%', (size_t)(stop - start)) != NULL ||
+                         memchr(start, '+', (size_t)(stop - start)) != NULL;
+        return 1;
+    }
+
+    return 0;
+}
+
+int http_request_view_query(const http_request_view_t *view, const char *name, http_string_view_t *value)
+{
+    if (!view || !name || !value) {
+        return 0;
+    }
+
+    size_t name_length = strlen(name);
+    http_query_iterator_t iterator;
+    http_query_param_t param;
+
+    http_query_iterator_init(&iterator, view->query);
+    while (http_query_next(&iterator, &param)) {
+        if (param.name.length == name_length && memcmp(param.name.data, name, name_length) == 0) {
+            *value = param.value;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
 // Implementação das funções auxiliares internas
 
+static int parse_request(http_request_t *request, const char *raw_data, size_t length) {
+    if (!request || !raw_data || length == 0) {
+        return HTTP_PARSE_INVALID_REQUEST;
+    }
+
+    size_t offset = 0;
+    int result;
+
+    // Parse da linha de requisição
+    result = parse_request_line(request, raw_data, length, &offset);
+    if (result != HTTP_PARSE_OK) {
+        return result;
+    }
+
+    // Parse dos headers
+    result = parse_headers(request, raw_data, length, &offset);
+    if (result != HTTP_PARSE_OK) {
+        return result;
+    }
+
+    request->header_length = offset;
+
+    result = http_request_normalize_path(request);
+    if (result != HTTP_PARSE_OK) {
+        return result;
+    }
+
+    // Verifica se há corpo na requisição
+    const http_header_t *content_length_header = http_request_get_header(request, "Content-Length");
+    if (content_length_header) {
+        size_t content_length = atol(content_length_header->value);
+        if (content_length > 0 && offset + content_length <= length) {
+            if (request->borrow_body) {
+                // Aponta para os dados brutos, que devem sobreviver à requisição
+                request->body = (char*)raw_data + offset;
+                request->body_length = content_length;
+                return HTTP_PARSE_OK;
+            }
+
+            // Copia o corpo
+            return http_request_set_body(request, raw_data + offset, content_length);
+        }
+    }
+
+    return HTTP_PARSE_OK;
+}
+
 static int parse_request_line(http_request_t *request, const char *data, size_t length, size_t *offset) {
     char buffer[1024];
     size_t i = 0;
@@ -284,4 +490,66 @@ static void skip_whitespace(const char *data, size_t length, size_t *offset) {
     while (*offset < length && isspace(data[*offset])) {
         (*offset)++;
     }
-}
\ No newline at end of file
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static int remove_dot_segments(char *path) {
+    // Reescreve o caminho no próprio buffer: a saída nunca passa da leitura
+    char *out = path;
+    const char *in = path;
+    int trailing_slash = 0;
+
+    while (*in) {
+        while (*in == '/') {
+            in++;
+        }
+        if (!*in) {
+            trailing_slash = 1;
+            break;
+        }
+
+        const char *segment = in;
+        while (*in && *in != '/') {
+            in++;
+        }
+        size_t length = (size_t)(in - segment);
+
+        if (length == 1 && segment[0] == '.') {
+            trailing_slash = 1;
+            continue;
+        }
+        if (length == 2 && segment[0] == '.' && segment[1] == '.') {
+            if (out == path) {
+                return -1; // Acima da raiz
+            }
+            while (out > path && *--out != '/') {
+            }
+            trailing_slash = 1;
+            continue;
+        }
+
+        *out++ = '/';
+        memmove(out, segment, length);
+        out += length;
+        trailing_slash = 0;
+    }
+
+    if (trailing_slash || out == path) {
+        *out++ = '/';
+    }
+    *out = '\0';
+
+    return 0;
+}
@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include "http_response.h"
+#include "socket_utils.h"
+#include "response_header.h"
+
+// Tamanho máximo da linha de status somada aos headers
+#define HTTP_RESPONSE_HEADER_MAX 4096
+
+// Funções auxiliares internas
+static int send_header_and_body(int client_socket, const char *header, size_t header_length,
+                                const char *body, size_t body_length);
+static void set_cork(int client_socket, int enabled);
+
+void http_response_init(http_response_t *response)
+{
+    if (!response) {
+        return;
+    }
+
+    memset(response, 0, sizeof(http_response_t));
+    response->status_code = 200;
+    response->status_text = "OK";
+    response->content_type = "text/plain";
+}
+
+void http_response_cleanup(http_response_t *response)
+{
+    if (!response) {
+        return;
+    }
+
+    if (response->body_free) {
+        response->body_free((void*)response->body);
+    }
+
+    memset(response, 0, sizeof(http_response_t));
+}
+
+void http_response_set(http_response_t *response, int status_code, const char *status_text,
+                       const char *content_type, const char *body)
+{
+    http_response_set_status(response, status_code, status_text);
+    response->content_type = content_type;
+    http_response_set_body(response, body, body ? strlen(body) : 0);
+}
+
+void http_response_set_status(http_response_t *response, int status_code, const char *status_text)
+{
+    response->status_code = status_code;
+    response->status_text = status_text ? status_text : http_status_text(status_code);
+}
+
+void http_response_set_body(http_response_t *response, const void *body, size_t length)
+{
+    if (response->body_free) {
+        response->body_free((void*)response->body);
+        response->body_free = NULL;
+    }
+
+    response->body = body;
+    response->body_length = body ? length : 0;
+}
+
+void http_response_take_body(http_response_t *response, void *body, size_t length, http_body_free_fn free_fn)
+{
+    http_response_set_body(response, body, length);
+    response->body_free = free_fn;
+}
+
+int http_response_add_header(http_response_t *response, const char *name, const char *value)
+{
+    if (!response || !name || !value || response->header_count >= HTTP_RESPONSE_MAX_HEADERS) {
+        return -1;
+    }
+
+    response->headers[response->header_count].name = name;
+    response->headers[response->header_count].value = value;
+    response->header_count++;
+    return 0;
+}
+
+const char* http_status_text(int status_code)
+{
+    const char *text = response_header_status_text(status_code);
+    return text ? text : "Unknown";
+}
+
+size_t http_response_format_header(const http_response_t *response, char *buffer, size_t size)
+{
+    // Linha de status: pré-formatada, exceto para textos personalizados
+    char custom_status[128];
+    size_t status_length;
+    const char *status = response_header_status_line(response->status_code, response->status_text,
+                                                     &status_length);
+    if (!status) {
+        int written = snprintf(custom_status, sizeof(custom_status), "HTTP/1.1 %d %s\r\n",
+                               response->status_code,
+                               response->status_text ? response->status_text : http_status_text(response->status_code));
+        if (written <= 0 || (size_t)written >= sizeof(custom_status)) {
+            return 0;
+        }
+        status = custom_status;
+        status_length = written;
+    }
+
+    size_t date_length;
+    const char *date = response_header_date(&date_length);
+
+    const char *content_type = response->content_type ? response->content_type : "application/octet-stream";
+    size_t type_length;
+    const char *type_line = response_header_content_type(content_type, &type_length);
+    size_t type_value_length = type_line ? 0 : strlen(content_type);
+    if (!type_line) {
+        type_length = sizeof("Content-Type: \r\n") - 1 + type_value_length;
+    }
+
+    char digits[24];
+    char *body_length = response_header_format_size(digits + sizeof(digits), response->body_length);
+    size_t body_length_size = digits + sizeof(digits) - body_length;
+
+    size_t total = status_length + date_length + type_length +
+                   sizeof("Content-Length: \r\n") - 1 + body_length_size + 2;
+    for (size_t i = 0; i < response->header_count; i++) {
+        total += strlen(response->headers[i].name) + strlen(response->headers[i].value) + 4;
+    }
+    if (total + 1 > size) {
+        return 0;
+    }
+
+    char *p = buffer;
+    memcpy(p, status, status_length);
+    p += status_length;
+    memcpy(p, date, date_length);
+    p += date_length;
+    if (type_line) {
+        memcpy(p, type_line, type_length);
+        p += type_length;
+    } else {
+        memcpy(p, "Content-Type: ", 14);
+        memcpy(p + 14, content_type, type_value_length);
+        memcpy(p + 14 + type_value_length, "\r\n", 2);
+        p += type_length;
+    }
+    memcpy(p, "Content-Length: ", 16);
+    p += 16;
+    memcpy(p, body_length, body_length_size);
+    p += body_length_size;
+    memcpy(p, "\r\n", 2);
+    p += 2;
+
+    // Headers adicionais antes da linha em branco final
+    for (size_t i = 0; i < response->header_count; i++) {
+        size_t name_length = strlen(response->headers[i].name);
+        size_t value_length = strlen(response->headers[i].value);
+        memcpy(p, response->headers[i].name, name_length);
+        p += name_length;
+        memcpy(p, ": ", 2);
+        p += 2;
+        memcpy(p, response->headers[i].value, value_length);
+        p += value_length;
+        memcpy(p, "\r\n", 2);
+        p += 2;
+    }
+
+    memcpy(p, "\r\n", 3);
+    return p + 2 - buffer;
+}
+
+char* http_response_serialize(const http_response_t *response, size_t *length)
+{
+    char header[HTTP_RESPONSE_HEADER_MAX];
+    size_t header_length = http_response_format_header(response, header, sizeof(header));
+    if (header_length == 0) {
+        return NULL;
+    }
+
+    size_t body_length = response->omit_body ? 0 : response->body_length;
+    char *data = malloc(header_length + body_length);
+    if (!data) {
+        return NULL;
+    }
+
+    memcpy(data, header, header_length);
+    if (body_length > 0) {
+        memcpy(data + header_length, response->body, body_length);
+    }
+
+    *length = header_length + body_length;
+    return data;
+}
+
+int http_response_send(int client_socket, const server_config_t *config, const http_response_t *response)
+{
+    char header[HTTP_RESPONSE_HEADER_MAX];
+    size_t header_length = http_response_format_header(response, header, sizeof(header));
+    if (header_length == 0) {
+        return -1;
+    }
+
+    size_t body_length = response->omit_body ? 0 : response->body_length;  // HEAD: o header já traz o Content-Length
+
+    // Com o cork o kernel só emite segmentos cheios, inclusive quando o corpo não cabe
+    // em um sendmsg e o restante segue em outras chamadas; retirá-lo envia a sobra
+    int cork = config->tcp_cork && body_length > 0;
+    if (cork) {
+        set_cork(client_socket, 1);
+    }
+    int result = send_header_and_body(client_socket, header, header_length, response->body, body_length);
+    if (cork) {
+        set_cork(client_socket, 0);
+    }
+    return result;
+}
+
+int http_send_all(int client_socket, const char *data, size_t length)
+{
+    while (length > 0) {
+        ssize_t sent = socket_send(client_socket, data, length, 0);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += sent;
+        length -= sent;
+    }
+    return 0;
+}
+
+// Implementação das funções auxiliares internas
+
+// Header e corpo em uma única chamada de sistema, completando envios parciais
+static int send_header_and_body(int client_socket, const char *header, size_t header_length,
+                                const char *body, size_t body_length)
+{
+    struct iovec iov[2];
+    iov[0].iov_base = (void*)header;
+    iov[0].iov_len = header_length;
+    iov[1].iov_base = (void*)body;
+    iov[1].iov_len = body_length;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = body_length > 0 ? 2 : 1;
+
+    ssize_t sent = socket_sendmsg(client_socket, &msg, 0);
+    if (sent < 0) {
+        return -1;
+    }
+
+    if ((size_t)sent < header_length) {
+        if (http_send_all(client_socket, header + sent, header_length - sent) < 0) {
+            return -1;
+        }
+        sent = header_length;
+    }
+    size_t body_sent = sent - header_length;
+    return http_send_all(client_socket, body + body_sent, body_length - body_sent);
+}
+
+// Sockets Unix não têm TCP_CORK; nesse caso o envio segue sem ele
+static void set_cork(int client_socket, int enabled)
+{
+    // Sem cork o resultado é o mesmo, apenas com mais segmentos
+    (void)setsockopt(client_socket, IPPROTO_TCP, TCP_CORK, &enabled, sizeof(enabled));
+}
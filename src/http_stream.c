@@ -0,0 +1,433 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include "http_stream.h"
+#include "http_response.h"
+#include "socket_utils.h"
+#include "coroutine.h"
+
+#define STREAM_CHUNK_HEADER_MAX 18     // "%zx\r\n" com 16 dígitos
+#define STREAM_COALESCE_BYTES 16384    // Acima disso a fila é escrita sem esperar stream_coalesce_ms
+
+struct http_stream {
+    send_queue_t queue;       // Pedaços pendentes; shut após http_stream_end ou o fim da conexão
+    int chunked;              // Enquadramento chunked (HTTP/1.1)
+    int in_callback;          // Funções do handler executando na própria conexão
+    pthread_t owner_thread;   // Thread e corrotina que atendem a conexão
+    void *owner_coroutine;
+};
+
+// Funções auxiliares internas
+static http_stream_chunk_t* chunk_alloc(size_t payload_length);
+static int called_by_connection(const http_stream_t *stream);
+static int has_newline(const char *value);
+static size_t next_line(const char *data, size_t length, size_t start, size_t *line_length);
+
+int http_stream_serve(int client_socket, const server_config_t *config, const http_request_t *request,
+                      const char *content_type, const http_stream_handler_t *handler, void *user_data)
+{
+    http_stream_t *stream = calloc(1, sizeof(http_stream_t));
+    if (!stream) {
+        perror("Erro ao alocar resposta em streaming");
+        return -1;
+    }
+
+    if (send_queue_init(&stream->queue, client_socket, config->stream_max_queue_bytes, 1) < 0) {
+        perror("Erro ao inicializar resposta em streaming");
+        free(stream);
+        return -1;
+    }
+
+    // Sem enquadramento só os dados são enviados
+    stream->chunked = strcmp(request->version, "HTTP/1.1") == 0;
+    stream->queue.strip_framing = !stream->chunked;
+    stream->owner_thread = pthread_self();
+    stream->owner_coroutine = coroutine_self();
+
+    int failed = 0;
+    int opened = 1;
+    int status = 200;
+
+    if (handler->on_open) {
+        http_request_view_t view;
+        http_request_view_init(&view, request);
+
+        stream->in_callback = 1;
+        opened = handler->on_open(stream, &view, user_data) >= 0;
+        stream->in_callback = 0;
+    }
+
+    if (!opened) {
+        http_response_t response;
+        http_response_init(&response);
+        http_response_set(&response, 500, "Internal Server Error", "text/plain", "Erro interno do servidor");
+        http_response_send(client_socket, config, &response);
+        http_response_cleanup(&response);
+        status = 500;
+        failed = 1;
+    } else {
+        int is_event_stream = strncmp(content_type, "text/event-stream", 17) == 0;
+        char header[512];
+        int header_length = snprintf(header, sizeof(header),
+                                     "HTTP/1.1 200 OK\r\n"
+                                     "Content-Type: %s\r\n"
+                                     "%s"
+                                     "%s"
+                                     "Connection: close\r\n"
+                                     "\r\n", content_type,
+                                     stream->chunked ? "Transfer-Encoding: chunked\r\n" : "",
+                                     is_event_stream ? "Cache-Control: no-cache\r\n" : "");
+        if (header_length <= 0 || (size_t)header_length >= sizeof(header) ||
+            http_send_all(client_socket, header, header_length) < 0) {
+            status = -1;
+            failed = 1;
+        }
+    }
+
+    char discard[256];
+
+    while (!failed) {
+        // Gera o próximo pedaço sob demanda enquanto a fila está baixa
+        int produced = 0;
+        pthread_mutex_lock(&stream->queue.lock);
+        int writable = !stream->queue.shut && stream->queue.queued_bytes <= stream->queue.max_bytes / 4;
+        unsigned long enqueued = stream->queue.enqueued;
+        pthread_mutex_unlock(&stream->queue.lock);
+
+        if (opened && handler->on_writable && writable) {
+            stream->in_callback = 1;
+            int result = handler->on_writable(stream, user_data);
+            stream->in_callback = 0;
+
+            if (result < 0) {
+                failed = 1;
+                break;
+            }
+            if (result > 0) {
+                http_stream_end(stream);
+            }
+
+            pthread_mutex_lock(&stream->queue.lock);
+            produced = stream->queue.enqueued != enqueued;
+            pthread_mutex_unlock(&stream->queue.lock);
+        }
+
+        if (send_queue_flush(&stream->queue) < 0) {
+            failed = 1;
+            break;
+        }
+
+        pthread_mutex_lock(&stream->queue.lock);
+        int ending = stream->queue.shut;
+        int ended = ending && !stream->queue.head;
+        int dropped = stream->queue.dropped;
+        pthread_mutex_unlock(&stream->queue.lock);
+
+        if (dropped) {
+            failed = 1;
+            break;
+        }
+        if (ended) {
+            // Último pedaço de tamanho zero encerra o corpo chunked
+            if (stream->chunked && http_send_all(client_socket, "0\r\n\r\n", 5) < 0) {
+                failed = 1;
+            }
+            break;
+        }
+        // Aguarda novos pedaços ou o fechamento pelo cliente; enquanto on_writable
+        // produz, apenas verifica sem esperar se o cliente fechou
+        int pulling = produced && !ending;
+        struct pollfd fds[2] = {
+            { .fd = client_socket, .events = POLLIN },
+            { .fd = stream->queue.wake_fd, .events = POLLIN }
+        };
+        int ready = socket_pending(client_socket) > 0 ? 1 : pulling ? poll(fds, 2, 0) : socket_poll(fds, 2, -1);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready == 0 && pulling) {
+            continue;
+        }
+        if (ready <= 0) {
+            failed = 1;
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            if (send_queue_clear_wake(&stream->queue) < 0) {
+                failed = 1;
+                break;
+            }
+
+            // Dá tempo para outros eventos chegarem e saírem na mesma escrita
+            if (config->stream_coalesce_ms > 0 && !pulling &&
+                http_stream_queued_bytes(stream) < STREAM_COALESCE_BYTES) {
+                coroutine_sleep(config->stream_coalesce_ms);
+            }
+        }
+
+        if (socket_pending(client_socket) > 0 || (fds[0].revents & (POLLIN | POLLHUP | POLLERR))) {
+            // O cliente não envia nada numa resposta em streaming: leitura vazia é o fechamento
+            ssize_t n = socket_recv(client_socket, discard, sizeof(discard), 0);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                failed = 1;
+                break;
+            }
+        }
+    }
+
+    // Acorda produtores presos em http_stream_write antes de avisar a aplicação
+    send_queue_shut(&stream->queue);
+
+    if (opened && handler->on_close) {
+        handler->on_close(stream, user_data);
+    }
+
+    send_queue_destroy(&stream->queue);
+    free(stream);
+
+    return status;
+}
+
+http_stream_chunk_t* http_stream_chunk_create(const void *data, size_t length)
+{
+    if (!data || length == 0) {
+        return NULL;
+    }
+
+    http_stream_chunk_t *chunk = chunk_alloc(length);
+    if (chunk) {
+        memcpy(chunk->data + chunk->header_length, data, length);
+    }
+    return chunk;
+}
+
+http_stream_chunk_t* http_stream_event_create(const char *event, const char *id, const char *data, size_t length)
+{
+    if ((!data && length > 0) || has_newline(event) || has_newline(id)) {
+        return NULL;
+    }
+    if (!data) {
+        data = "";
+    }
+
+    // Cada linha dos dados vira um campo "data: "; a linha em branco final despacha o evento
+    size_t payload_length = (event ? strlen(event) + 8 : 0) + (id ? strlen(id) + 5 : 0) + 1;
+    size_t line_length;
+    size_t start = 0;
+    do {
+        start = next_line(data, length, start, &line_length);
+        payload_length += 7 + line_length;
+    } while (start <= length);
+
+    http_stream_chunk_t *chunk = chunk_alloc(payload_length);
+    if (!chunk) {
+        return NULL;
+    }
+
+    char *p = (char*)chunk->data + chunk->header_length;
+    if (event) {
+        p += sprintf(p, "event: %s\n", event);
+    }
+    if (id) {
+        p += sprintf(p, "id: %s\n", id);
+    }
+
+    start = 0;
+    do {
+        size_t line_start = start;
+        start = next_line(data, length, start, &line_length);
+
+        memcpy(p, "data: ", 6);
+        p += 6;
+        memcpy(p, data + line_start, line_length);
+        p += line_length;
+        *p++ = '\n';
+    } while (start <= length);
+    *p = '\n';
+
+    return chunk;
+}
+
+void http_stream_chunk_retain(http_stream_chunk_t *chunk)
+{
+    send_buffer_retain(chunk);
+}
+
+void http_stream_chunk_release(http_stream_chunk_t *chunk)
+{
+    send_buffer_release(chunk);
+}
+
+int http_stream_send_chunk(http_stream_t *stream, http_stream_chunk_t *chunk)
+{
+    if (!stream || !chunk) {
+        return -1;
+    }
+    return send_queue_push(&stream->queue, chunk, 0);
+}
+
+int http_stream_send(http_stream_t *stream, const void *data, size_t length)
+{
+    if (!stream) {
+        return -1;
+    }
+    if (length == 0) {
+        return 0;
+    }
+
+    http_stream_chunk_t *chunk = http_stream_chunk_create(data, length);
+    if (!chunk) {
+        return -1;
+    }
+
+    int result = send_queue_push(&stream->queue, chunk, 0);
+    http_stream_chunk_release(chunk);
+    return result;
+}
+
+int http_stream_send_event(http_stream_t *stream, const char *event, const char *id,
+                           const char *data, size_t length)
+{
+    if (!stream) {
+        return -1;
+    }
+
+    http_stream_chunk_t *chunk = http_stream_event_create(event, id, data, length);
+    if (!chunk) {
+        return -1;
+    }
+
+    int result = send_queue_push(&stream->queue, chunk, 0);
+    http_stream_chunk_release(chunk);
+    return result;
+}
+
+int http_stream_write(http_stream_t *stream, const void *data, size_t length)
+{
+    if (!stream) {
+        return -1;
+    }
+    if (length == 0) {
+        return 0;
+    }
+
+    http_stream_chunk_t *chunk = http_stream_chunk_create(data, length);
+    if (!chunk) {
+        return -1;
+    }
+
+    // A própria conexão não pode esperar por si mesma
+    int flags = called_by_connection(stream) ? SEND_QUEUE_UNLIMITED : SEND_QUEUE_WAIT;
+    int result = send_queue_push(&stream->queue, chunk, flags);
+    http_stream_chunk_release(chunk);
+    return result;
+}
+
+size_t http_stream_queued_bytes(http_stream_t *stream)
+{
+    if (!stream) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&stream->queue.lock);
+    size_t queued = stream->queue.queued_bytes;
+    pthread_mutex_unlock(&stream->queue.lock);
+    return queued;
+}
+
+int http_stream_end(http_stream_t *stream)
+{
+    if (!stream) {
+        return -1;
+    }
+
+    return send_queue_shut(&stream->queue);
+}
+
+http_stream_group_t* http_stream_group_create(void)
+{
+    return send_group_create();
+}
+
+void http_stream_group_destroy(http_stream_group_t *group)
+{
+    send_group_destroy(group);
+}
+
+int http_stream_group_add(http_stream_group_t *group, http_stream_t *stream)
+{
+    return stream ? send_group_add(group, &stream->queue) : -1;
+}
+
+void http_stream_group_remove(http_stream_group_t *group, http_stream_t *stream)
+{
+    if (stream) {
+        send_group_remove(group, &stream->queue);
+    }
+}
+
+int http_stream_group_broadcast(http_stream_group_t *group, http_stream_chunk_t *chunk)
+{
+    return send_group_broadcast(group, chunk);
+}
+
+// Implementação das funções auxiliares internas
+
+// Aloca um pedaço com o enquadramento chunked já escrito ao redor dos dados
+static http_stream_chunk_t* chunk_alloc(size_t payload_length)
+{
+    char header[STREAM_CHUNK_HEADER_MAX + 1];
+    int header_length = snprintf(header, sizeof(header), "%zx\r\n", payload_length);
+
+    http_stream_chunk_t *chunk = send_buffer_create(header_length + payload_length + 2);
+    if (!chunk) {
+        return NULL;
+    }
+
+    chunk->header_length = header_length;
+    chunk->trailer_length = 2;
+    memcpy(chunk->data, header, header_length);
+    memcpy(chunk->data + header_length + payload_length, "\r\n", 2);
+    return chunk;
+}
+
+// Verifica se quem enfileira é a própria conexão, dentro de uma função do handler.
+// O estado fica na resposta, e não em uma variável da thread, porque o handler pode
+// ceder a corrotina e outras conexões do mesmo worker executam seus handlers
+static int called_by_connection(const http_stream_t *stream)
+{
+    // A identidade vem primeiro: só o dono lê in_callback, que ele mesmo escreve
+    return stream->owner_coroutine == coroutine_self() &&
+           pthread_equal(stream->owner_thread, pthread_self()) && stream->in_callback;
+}
+
+static int has_newline(const char *value)
+{
+    return value && strpbrk(value, "\r\n") != NULL;
+}
+
+// Mede a linha que começa em start e retorna o início da seguinte (length + 1 após a última).
+// CR, LF e CRLF terminam linhas no cliente, portanto todos são tratados como quebra.
+static size_t next_line(const char *data, size_t length, size_t start, size_t *line_length)
+{
+    size_t end = start;
+    while (end < length && data[end] != '\n' && data[end] != '\r') {
+        end++;
+    }
+    *line_length = end - start;
+
+    if (end == length) {
+        return length + 1;
+    }
+    if (data[end] == '\r' && end + 1 < length && data[end + 1] == '\n') {
+        end++;
+    }
+    return end + 1;
+}
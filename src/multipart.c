@@ -0,0 +1,630 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include "multipart.h"
+#include "socket_utils.h"
+
+#define BOUNDARY_MAX 70              // RFC 2046
+#define DELIMITER_MAX (BOUNDARY_MAX + 4)
+
+typedef enum {
+    STATE_PREAMBLE,           // Antes do primeiro delimitador
+    STATE_BOUNDARY_END,       // Após um delimitador: CRLF inicia uma parte, "--" encerra o corpo
+    STATE_HEADERS,
+    STATE_BODY,
+    STATE_DONE                // Epílogo, ignorado
+} parser_state_t;
+
+struct multipart_parser {
+    multipart_callbacks_t callbacks;
+    void *user_data;
+    parser_state_t state;
+
+    // CRLF "--" boundary e a tabela de saltos do Boyer-Moore-Horspool
+    char delimiter[DELIMITER_MAX];
+    size_t delimiter_length;
+    size_t skip[256];
+
+    // Bytes pendentes em window[start, end)
+    size_t start;
+    size_t end;
+    char window[MULTIPART_WINDOW_SIZE];
+};
+
+// Estado de multipart_upload_receive repassado às funções do parser
+typedef struct {
+    const server_config_t *config;
+    multipart_upload_t *upload;
+    multipart_part_t *part;   // Parte em andamento
+    int fd;                   // Arquivo da parte em andamento (-1 em campos)
+    size_t field_capacity;
+    int status;               // Código HTTP do erro que interrompeu o parse
+} upload_state_t;
+
+// Funções auxiliares internas
+static int process(multipart_parser_t *parser);
+static const char* find_delimiter(const multipart_parser_t *parser, const char *data, size_t length);
+static int parse_part_headers(const char *data, size_t length, multipart_part_info_t *info);
+static int get_param(const char *value, size_t length, const char *param, char *out, size_t out_size);
+static int copy_trimmed(const char *value, size_t length, char *out, size_t out_size);
+static int upload_part_begin(const multipart_part_info_t *part, void *user_data);
+static int upload_part_data(const char *data, size_t length, void *user_data);
+static int upload_part_end(void *user_data);
+static int write_all(int fd, const char *data, size_t length);
+static int parse_content_length(const char *value, size_t *length);
+
+multipart_parser_t* multipart_parser_create(const char *content_type, const multipart_callbacks_t *callbacks,
+                                            void *user_data)
+{
+    if (!content_type || !callbacks || strncasecmp(content_type, "multipart/form-data", 19) != 0) {
+        return NULL;
+    }
+
+    char boundary[BOUNDARY_MAX + 1];
+    size_t params_length = strlen(content_type + 19);
+    if (get_param(content_type + 19, params_length, "boundary", boundary, sizeof(boundary)) != 1 ||
+        boundary[0] == '\0') {
+        return NULL;
+    }
+
+    multipart_parser_t *parser = malloc(sizeof(multipart_parser_t));
+    if (!parser) {
+        perror("Erro ao alocar parser multipart");
+        return NULL;
+    }
+
+    parser->callbacks = *callbacks;
+    parser->user_data = user_data;
+    parser->state = STATE_PREAMBLE;
+    parser->delimiter_length = (size_t)snprintf(parser->delimiter, sizeof(parser->delimiter), "\r\n--%s", boundary);
+
+    size_t m = parser->delimiter_length;
+    for (int i = 0; i < 256; i++) {
+        parser->skip[i] = m;
+    }
+    for (size_t i = 0; i + 1 < m; i++) {
+        parser->skip[(unsigned char)parser->delimiter[i]] = m - 1 - i;
+    }
+
+    // O primeiro delimitador pode estar no início do corpo, sem o CRLF que o
+    // precede: um CRLF artificial permite tratá-lo como os demais
+    memcpy(parser->window, "\r\n", 2);
+    parser->start = 0;
+    parser->end = 2;
+
+    return parser;
+}
+
+void multipart_parser_destroy(multipart_parser_t *parser)
+{
+    free(parser);
+}
+
+int multipart_parser_feed(multipart_parser_t *parser, const char *data, size_t length)
+{
+    while (length > 0) {
+        size_t available;
+        char *space = multipart_parser_space(parser, &available);
+        size_t chunk = length < available ? length : available;
+
+        memcpy(space, data, chunk);
+        int result = multipart_parser_commit(parser, chunk);
+        if (result != MULTIPART_OK) {
+            return result;
+        }
+        data += chunk;
+        length -= chunk;
+    }
+
+    return MULTIPART_OK;
+}
+
+char* multipart_parser_space(multipart_parser_t *parser, size_t *available)
+{
+    *available = sizeof(parser->window) - parser->end;
+    return parser->window + parser->end;
+}
+
+int multipart_parser_commit(multipart_parser_t *parser, size_t length)
+{
+    parser->end += length;
+    return process(parser);
+}
+
+int multipart_parser_done(const multipart_parser_t *parser)
+{
+    return parser && parser->state == STATE_DONE;
+}
+
+int multipart_upload_receive(int client_socket, const server_config_t *config, const http_request_t *request,
+                             const char *initial, size_t initial_length, multipart_upload_t *upload,
+                             int *status)
+{
+    memset(upload, 0, sizeof(*upload));
+
+    const http_header_t *type = http_request_get_header(request, "Content-Type");
+    const http_header_t *length_header = http_request_get_header(request, "Content-Length");
+    size_t content_length = 0;
+
+    if (!type || strncasecmp(type->value, "multipart/form-data", 19) != 0) {
+        *status = 415;
+        return -1;
+    }
+    if (!length_header || http_request_get_header(request, "Transfer-Encoding")) {
+        *status = 411;
+        return -1;
+    }
+    if (parse_content_length(length_header->value, &content_length) < 0) {
+        *status = 400;
+        return -1;
+    }
+    if (content_length > config->upload_max_size) {
+        *status = 413;
+        return -1;
+    }
+
+    upload_state_t state = { .config = config, .upload = upload, .fd = -1, .status = 400 };
+    multipart_callbacks_t callbacks = { upload_part_begin, upload_part_data, upload_part_end };
+    multipart_parser_t *parser = multipart_parser_create(type->value, &callbacks, &state);
+    if (!parser) {
+        *status = 400;
+        return -1;
+    }
+
+    // Clientes como o curl aguardam a confirmação antes de enviar corpos grandes
+    const http_header_t *expect = http_request_get_header(request, "Expect");
+    if (expect && strcasecmp(expect->value, "100-continue") == 0 && initial_length < content_length) {
+        static const char continue_response[] = "HTTP/1.1 100 Continue\r\n\r\n";
+        socket_send(client_socket, continue_response, sizeof(continue_response) - 1, 0);
+    }
+
+    if (initial_length > content_length) {
+        initial_length = content_length;
+    }
+    size_t remaining = content_length - initial_length;
+    int result = multipart_parser_feed(parser, initial, initial_length);
+
+    // O corpo é lido direto para a janela do parser
+    while (result == MULTIPART_OK && remaining > 0) {
+        size_t available;
+        char *space = multipart_parser_space(parser, &available);
+        ssize_t n = socket_recv(client_socket, space, remaining < available ? remaining : available, 0);
+        if (n <= 0) {
+            result = MULTIPART_INVALID;  // Cliente desconectou ou excedeu o timeout
+            break;
+        }
+        remaining -= n;
+        result = multipart_parser_commit(parser, n);
+    }
+
+    if (result == MULTIPART_OK && !multipart_parser_done(parser)) {
+        result = MULTIPART_INVALID;
+    }
+    multipart_parser_destroy(parser);
+
+    if (result != MULTIPART_OK) {
+        if (state.fd >= 0) {
+            close(state.fd);
+        }
+        *status = result == MULTIPART_ABORTED ? state.status : 400;
+        multipart_upload_cleanup(upload);
+        return -1;
+    }
+
+    return 0;
+}
+
+void multipart_upload_cleanup(multipart_upload_t *upload)
+{
+    if (!upload) {
+        return;
+    }
+
+    for (size_t i = 0; i < upload->part_count; i++) {
+        multipart_part_t *part = &upload->parts[i];
+        if (part->path[0] && unlink(part->path) < 0 && errno != ENOENT) {
+            perror("Erro ao remover arquivo de upload");
+        }
+        free(part->value);
+    }
+
+    upload->part_count = 0;
+    upload->total_size = 0;
+}
+
+// Implementação das funções auxiliares internas
+
+static int process(multipart_parser_t *parser)
+{
+    while (parser->start < parser->end || parser->state == STATE_DONE) {
+        const char *data = parser->window + parser->start;
+        size_t length = parser->end - parser->start;
+
+        if (parser->state == STATE_DONE) {
+            parser->start = parser->end;
+            break;
+        }
+
+        if (parser->state == STATE_PREAMBLE || parser->state == STATE_BODY) {
+            const char *match = find_delimiter(parser, data, length);
+            size_t emit = match ? (size_t)(match - data) : 0;
+
+            // Sem delimitador, os últimos bytes ainda podem ser o início de um
+            if (!match) {
+                size_t keep = parser->delimiter_length - 1;
+                emit = length > keep ? length - keep : 0;
+            }
+
+            if (parser->state == STATE_BODY && emit > 0 && parser->callbacks.on_part_data &&
+                parser->callbacks.on_part_data(data, emit, parser->user_data) < 0) {
+                return MULTIPART_ABORTED;
+            }
+
+            if (!match) {
+                parser->start += emit;
+                break;
+            }
+
+            if (parser->state == STATE_BODY && parser->callbacks.on_part_end &&
+                parser->callbacks.on_part_end(parser->user_data) < 0) {
+                return MULTIPART_ABORTED;
+            }
+            parser->start += emit + parser->delimiter_length;
+            parser->state = STATE_BOUNDARY_END;
+
+        } else if (parser->state == STATE_BOUNDARY_END) {
+            // Espaços após o delimitador são permitidos (transport padding)
+            while (length > 0 && (*data == ' ' || *data == '\t')) {
+                data++;
+                length--;
+                parser->start++;
+            }
+            if (length < 2) {
+                break;
+            }
+
+            if (data[0] == '-' && data[1] == '-') {
+                parser->state = STATE_DONE;
+            } else if (data[0] == '\r' && data[1] == '\n') {
+                parser->start += 2;
+                parser->state = STATE_HEADERS;
+            } else {
+                return MULTIPART_INVALID;
+            }
+
+        } else {
+            // Headers da parte terminam em uma linha vazia
+            size_t header_length;
+            size_t consumed;
+            if (length >= 2 && data[0] == '\r' && data[1] == '\n') {
+                header_length = 0;
+                consumed = 2;
+            } else {
+                const char *blank = memmem(data, length, "\r\n\r\n", 4);
+                if (!blank) {
+                    break;
+                }
+                header_length = blank - data + 2;
+                consumed = header_length + 2;
+            }
+
+            multipart_part_info_t info;
+            if (parse_part_headers(data, header_length, &info) < 0) {
+                return MULTIPART_INVALID;
+            }
+            if (parser->callbacks.on_part_begin &&
+                parser->callbacks.on_part_begin(&info, parser->user_data) < 0) {
+                return MULTIPART_ABORTED;
+            }
+            parser->start += consumed;
+            parser->state = STATE_BODY;
+        }
+    }
+
+    // Move os bytes pendentes para o início da janela
+    if (parser->start > 0) {
+        memmove(parser->window, parser->window + parser->start, parser->end - parser->start);
+        parser->end -= parser->start;
+        parser->start = 0;
+    }
+
+    // Janela cheia sem progresso: headers de uma parte maiores que a janela
+    if (parser->end == sizeof(parser->window)) {
+        return MULTIPART_INVALID;
+    }
+
+    return MULTIPART_OK;
+}
+
+static const char* find_delimiter(const multipart_parser_t *parser, const char *data, size_t length)
+{
+    size_t m = parser->delimiter_length;
+    if (length < m) {
+        return NULL;
+    }
+
+    // Boyer-Moore-Horspool: o último byte da janela de comparação decide o salto
+    const unsigned char *text = (const unsigned char*)data;
+    const unsigned char *pattern = (const unsigned char*)parser->delimiter;
+    unsigned char last = pattern[m - 1];
+
+    for (size_t pos = 0; pos <= length - m; pos += parser->skip[text[pos + m - 1]]) {
+        if (text[pos + m - 1] == last && memcmp(text + pos, pattern, m - 1) == 0) {
+            return data + pos;
+        }
+    }
+
+    return NULL;
+}
+
+static int parse_part_headers(const char *data, size_t length, multipart_part_info_t *info)
+{
+    memset(info, 0, sizeof(*info));
+    int has_disposition = 0;
+
+    while (length > 0) {
+        const char *line_end = memmem(data, length, "\r\n", 2);
+        size_t line_length = line_end ? (size_t)(line_end - data) : length;
+        const char *colon = memchr(data, ':', line_length);
+
+        if (colon) {
+            size_t name_length = colon - data;
+            const char *value = colon + 1;
+            size_t value_length = line_length - name_length - 1;
+
+            if (name_length == 19 && strncasecmp(data, "Content-Disposition", 19) == 0) {
+                while (value_length > 0 && (*value == ' ' || *value == '\t')) {
+                    value++;
+                    value_length--;
+                }
+                if (value_length < 9 || strncasecmp(value, "form-data", 9) != 0 ||
+                    get_param(value + 9, value_length - 9, "name", info->name, sizeof(info->name)) != 1) {
+                    return -1;
+                }
+
+                int found = get_param(value + 9, value_length - 9, "filename", info->filename,
+                                      sizeof(info->filename));
+                if (found < 0) {
+                    return -1;
+                }
+                info->has_filename = found;
+                has_disposition = 1;
+            } else if (name_length == 12 && strncasecmp(data, "Content-Type", 12) == 0) {
+                if (copy_trimmed(value, value_length, info->content_type, sizeof(info->content_type)) < 0) {
+                    return -1;
+                }
+            }
+        }
+
+        if (!line_end) {
+            break;
+        }
+        length -= line_length + 2;
+        data = line_end + 2;
+    }
+
+    return has_disposition ? 0 : -1;
+}
+
+// Busca um parâmetro em uma lista "; nome=valor; nome="valor"".
+// Retorna 1 se encontrado, 0 se ausente e -1 se o valor não cabe em out
+static int get_param(const char *value, size_t length, const char *param, char *out, size_t out_size)
+{
+    size_t param_length = strlen(param);
+    const char *p = value;
+    const char *end = value + length;
+
+    while (p < end) {
+        // Próximo parâmetro após ';'
+        const char *semicolon = memchr(p, ';', end - p);
+        if (!semicolon) {
+            return 0;
+        }
+        p = semicolon + 1;
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+
+        if ((size_t)(end - p) <= param_length || strncasecmp(p, param, param_length) != 0 ||
+            p[param_length] != '=') {
+            continue;
+        }
+        p += param_length + 1;
+
+        size_t n = 0;
+        if (p < end && *p == '"') {
+            for (p++; p < end && *p != '"'; p++) {
+                if (*p == '\\' && p + 1 < end) {
+                    p++;
+                }
+                if (n + 1 >= out_size) {
+                    return -1;
+                }
+                out[n++] = *p;
+            }
+        } else {
+            for (; p < end && *p != ';' && *p != ' ' && *p != '\t' && *p != '\r'; p++) {
+                if (n + 1 >= out_size) {
+                    return -1;
+                }
+                out[n++] = *p;
+            }
+        }
+        out[n] = '\0';
+        return 1;
+    }
+
+    return 0;
+}
+
+static int copy_trimmed(const char *value, size_t length, char *out, size_t out_size)
+{
+    while (length > 0 && (*value == ' ' || *value == '\t')) {
+        value++;
+        length--;
+    }
+    while (length > 0 && (value[length - 1] == ' ' || value[length - 1] == '\t')) {
+        length--;
+    }
+    if (length >= out_size) {
+        return -1;
+    }
+
+    memcpy(out, value, length);
+    out[length] = '\0';
+    return 0;
+}
+
+static int upload_part_begin(const multipart_part_info_t *info, void *user_data)
+{
+    upload_state_t *state = (upload_state_t*)user_data;
+    multipart_upload_t *upload = state->upload;
+
+    if (upload->part_count == MULTIPART_MAX_PARTS) {
+        state->status = 413;
+        return -1;
+    }
+
+    multipart_part_t *part = &upload->parts[upload->part_count++];
+    memset(part, 0, sizeof(*part));
+    part->info = *info;
+    state->part = part;
+    state->field_capacity = 0;
+
+    if (!info->has_filename) {
+        return 0;
+    }
+
+    // O nome do arquivo enviado pelo cliente não é usado no caminho
+    int written = snprintf(part->path, sizeof(part->path), "%s/upload-XXXXXX", state->config->upload_directory);
+    if (written < 0 || (size_t)written >= sizeof(part->path)) {
+        part->path[0] = '\0';
+        state->status = 500;
+        return -1;
+    }
+
+    state->fd = mkostemp(part->path, O_CLOEXEC);
+    if (state->fd < 0) {
+        perror("Erro ao criar arquivo de upload");
+        part->path[0] = '\0';
+        state->status = 500;
+        return -1;
+    }
+
+    return 0;
+}
+
+static int upload_part_data(const char *data, size_t length, void *user_data)
+{
+    upload_state_t *state = (upload_state_t*)user_data;
+    multipart_part_t *part = state->part;
+
+    if (part->size + length > state->config->upload_max_part_size) {
+        state->status = 413;
+        return -1;
+    }
+
+    if (state->fd >= 0) {
+        if (write_all(state->fd, data, length) < 0) {
+            perror("Erro ao gravar arquivo de upload");
+            state->status = 500;
+            return -1;
+        }
+    } else {
+        if (part->size + length > MULTIPART_FIELD_MAX) {
+            state->status = 413;
+            return -1;
+        }
+        if (part->size + length + 1 > state->field_capacity) {
+            size_t capacity = state->field_capacity ? state->field_capacity : 256;
+            while (capacity < part->size + length + 1) {
+                capacity *= 2;
+            }
+            char *value = realloc(part->value, capacity);
+            if (!value) {
+                state->status = 500;
+                return -1;
+            }
+            part->value = value;
+            state->field_capacity = capacity;
+        }
+        memcpy(part->value + part->size, data, length);
+        part->value[part->size + length] = '\0';
+    }
+
+    part->size += length;
+    state->upload->total_size += length;
+    return 0;
+}
+
+static int upload_part_end(void *user_data)
+{
+    upload_state_t *state = (upload_state_t*)user_data;
+    multipart_part_t *part = state->part;
+
+    if (state->fd >= 0) {
+        if (close(state->fd) < 0) {
+            perror("Erro ao fechar arquivo de upload");
+            state->fd = -1;
+            state->status = 500;
+            return -1;
+        }
+        state->fd = -1;
+    } else if (!part->value) {
+        part->value = calloc(1, 1);  // Campo vazio
+        if (!part->value) {
+            state->status = 500;
+            return -1;
+        }
+    }
+
+    state->part = NULL;
+    return 0;
+}
+
+static int write_all(int fd, const char *data, size_t length)
+{
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        data += n;
+        length -= n;
+    }
+    return 0;
+}
+
+static int parse_content_length(const char *value, size_t *length)
+{
+    size_t result = 0;
+    const char *p = value;
+
+    if (*p < '0' || *p > '9') {
+        return -1;
+    }
+    for (; *p >= '0' && *p <= '9'; p++) {
+        if (result > (SIZE_MAX - 9) / 10) {
+            return -1;
+        }
+        result = result * 10 + (*p - '0');
+    }
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    if (*p != '\0') {
+        return -1;
+    }
+
+    *length = result;
+    return 0;
+}
@@ -0,0 +1,1025 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "proxy.h"
+#include "socket_utils.h"
+#include "coroutine.h"
+
+#define HEALTH_CHECK_TIMEOUT_MS 1000
+
+// Forma como o fim do corpo da resposta do upstream é determinado
+typedef enum {
+    BODY_NONE,
+    BODY_LENGTH,
+    BODY_CHUNKED,
+    BODY_UNTIL_CLOSE
+} body_mode_t;
+
+// Estados do rastreador de corpo chunked
+typedef enum {
+    CHUNK_SIZE,
+    CHUNK_EXTENSION,
+    CHUNK_SIZE_LF,
+    CHUNK_DATA,
+    CHUNK_DATA_CR,
+    CHUNK_DATA_LF,
+    CHUNK_TRAILER,
+    CHUNK_TRAILER_LF,
+    CHUNK_DONE
+} chunk_state_t;
+
+typedef struct {
+    chunk_state_t state;
+    size_t remaining;
+    size_t line_length;
+} chunk_tracker_t;
+
+typedef struct {
+    char name[256];
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    int healthy;
+    int active;
+    int *idle_fds;
+    int idle_count;
+} upstream_t;
+
+typedef struct {
+    char prefix[256];
+    size_t prefix_len;
+    upstream_t upstreams[MAX_PROXY_UPSTREAMS];
+    int upstream_count;
+    unsigned int next;
+    pthread_mutex_t lock;
+} proxy_route_t;
+
+struct proxy {
+    proxy_route_t routes[MAX_PROXY_ROUTES];
+    int route_count;
+    int least_conn;
+    int pool_size;
+    int health_interval;
+    int timeout_seconds;
+    int timeout_microseconds;
+    size_t buffer_size;
+
+    pthread_t health_thread;
+    int health_running;
+    pthread_mutex_t health_lock;
+    pthread_cond_t health_cond;
+};
+
+// Funções auxiliares internas
+static int resolve_upstream(upstream_t *upstream, const char *spec);
+static int connect_upstream(const proxy_t *proxy, const upstream_t *upstream);
+static int select_upstream(proxy_route_t *route, int least_conn, int exclude_mask);
+static int acquire_connection(proxy_t *proxy, proxy_route_t *route, int index, int *reused);
+static void release_connection(proxy_t *proxy, proxy_route_t *route, int index, int fd, int reusable);
+static void mark_unhealthy(proxy_route_t *route, int index);
+static int parse_content_length(const char *value, size_t value_length, size_t *length);
+static int request_content_length(const http_request_t *request, size_t *length, int *present);
+static char* build_request_head(const http_request_t *request, const char *client_ip, int has_length,
+                                size_t content_length, size_t *length);
+static int send_all(int fd, const char *data, size_t length);
+static int relay_body(int from, int to, size_t length, char *buffer, size_t buffer_size);
+static size_t chunk_tracker_feed(chunk_tracker_t *tracker, const char *data, size_t length);
+static void send_error_response(int client_socket, int status_code, const char *status_text);
+static void* health_check_thread(void *arg);
+
+proxy_t* proxy_create(const server_config_t *config)
+{
+    if (!config || config->proxy_route_count == 0) {
+        return NULL;
+    }
+
+    proxy_t *proxy = calloc(1, sizeof(proxy_t));
+    if (!proxy) {
+        perror("Erro ao alocar proxy");
+        return NULL;
+    }
+
+    proxy->least_conn = strcmp(config->proxy_balance, "least_conn") == 0;
+    proxy->pool_size = config->proxy_pool_size;
+    proxy->health_interval = config->proxy_health_interval;
+    proxy->timeout_seconds = config->timeout_seconds;
+    proxy->timeout_microseconds = config->timeout_microseconds;
+    proxy->buffer_size = config->buffer_size;
+    pthread_mutex_init(&proxy->health_lock, NULL);
+    pthread_cond_init(&proxy->health_cond, NULL);
+
+    for (int i = 0; i < config->proxy_route_count; i++) {
+        const proxy_route_config_t *route_config = &config->proxy_routes[i];
+        proxy_route_t *route = &proxy->routes[i];
+
+        strncpy(route->prefix, route_config->prefix, sizeof(route->prefix) - 1);
+        route->prefix_len = strlen(route->prefix);
+        pthread_mutex_init(&route->lock, NULL);
+        proxy->route_count++;
+
+        for (int j = 0; j < route_config->upstream_count; j++) {
+            upstream_t *upstream = &route->upstreams[j];
+            if (resolve_upstream(upstream, route_config->upstreams[j]) < 0) {
+                fprintf(stderr, "Upstream inválido: %s\n", route_config->upstreams[j]);
+                proxy_destroy(proxy);
+                return NULL;
+            }
+
+            upstream->healthy = 1;
+            upstream->idle_fds = calloc(proxy->pool_size > 0 ? proxy->pool_size : 1, sizeof(int));
+            if (!upstream->idle_fds) {
+                perror("Erro ao alocar pool de conexões");
+                proxy_destroy(proxy);
+                return NULL;
+            }
+            route->upstream_count++;
+        }
+    }
+
+    if (proxy->health_interval > 0) {
+        proxy->health_running = 1;
+        if (pthread_create(&proxy->health_thread, NULL, health_check_thread, proxy) != 0) {
+            perror("Erro ao criar a thread de health check");
+            proxy->health_running = 0;
+        }
+    }
+
+    return proxy;
+}
+
+void proxy_destroy(proxy_t *proxy)
+{
+    if (!proxy) {
+        return;
+    }
+
+    if (proxy->health_running) {
+        pthread_mutex_lock(&proxy->health_lock);
+        proxy->health_running = 0;
+        pthread_cond_signal(&proxy->health_cond);
+        pthread_mutex_unlock(&proxy->health_lock);
+        pthread_join(proxy->health_thread, NULL);
+    }
+
+    for (int i = 0; i < proxy->route_count; i++) {
+        proxy_route_t *route = &proxy->routes[i];
+        for (int j = 0; j < route->upstream_count; j++) {
+            upstream_t *upstream = &route->upstreams[j];
+            for (int k = 0; k < upstream->idle_count; k++) {
+                close(upstream->idle_fds[k]);
+            }
+            free(upstream->idle_fds);
+        }
+        pthread_mutex_destroy(&route->lock);
+    }
+
+    pthread_cond_destroy(&proxy->health_cond);
+    pthread_mutex_destroy(&proxy->health_lock);
+    free(proxy);
+}
+
+int proxy_match(const proxy_t *proxy, const char *path)
+{
+    if (!proxy || !path) {
+        return -1;
+    }
+
+    int best = -1;
+    size_t best_len = 0;
+
+    for (int i = 0; i < proxy->route_count; i++) {
+        const proxy_route_t *route = &proxy->routes[i];
+        if (route->prefix_len >= best_len && strncmp(path, route->prefix, route->prefix_len) == 0) {
+            best = i;
+            best_len = route->prefix_len;
+        }
+    }
+
+    return best;
+}
+
+int proxy_handle_request(proxy_t *proxy, int route_index, int client_socket, const char *client_ip,
+                         const http_request_t *request, const char *raw, size_t raw_length)
+{
+    if (!proxy || route_index < 0 || route_index >= proxy->route_count || !request || !raw) {
+        return -1;
+    }
+
+    proxy_route_t *route = &proxy->routes[route_index];
+
+    // Corpos chunked da requisição não são suportados pelo proxy
+    if (http_request_get_header(request, "Transfer-Encoding")) {
+        send_error_response(client_socket, 411, "Length Required");
+        return -1;
+    }
+
+    // O upstream precisa enquadrar o corpo exatamente como o proxy: um tamanho ambíguo
+    // dessincronizaria a conexão reaproveitada por outros clientes
+    size_t content_length = 0;
+    int has_length = 0;
+    if (request_content_length(request, &content_length, &has_length) < 0) {
+        send_error_response(client_socket, 400, "Bad Request");
+        return -1;
+    }
+
+    size_t buffered_body = raw_length > request->header_length ? raw_length - request->header_length : 0;
+    if (buffered_body > content_length) {
+        buffered_body = content_length;
+    }
+    const char *body_start = raw + request->header_length;
+
+    const http_header_t *expect_header = http_request_get_header(request, "Expect");
+    int expect_continue = expect_header && strcasecmp(expect_header->value, "100-continue") == 0;
+
+    size_t head_length;
+    char *head = build_request_head(request, client_ip, has_length, content_length, &head_length);
+    if (!head) {
+        send_error_response(client_socket, 500, "Internal Server Error");
+        return -1;
+    }
+
+    // Um byte extra mantém o cabeçalho da resposta terminado em nulo
+    char *buffer = malloc(proxy->buffer_size + 1);
+    if (!buffer) {
+        free(head);
+        send_error_response(client_socket, 500, "Internal Server Error");
+        return -1;
+    }
+
+    int upstream_fd = -1;
+    int upstream_index = -1;
+    int exclude_mask = 0;
+    size_t received = 0;
+    char *head_end = NULL;
+
+    // Tenta os upstreams até obter o início de uma resposta. Conexões reaproveitadas
+    // podem ter sido fechadas pelo upstream; nesse caso repete com uma conexão nova
+    // enquanto o corpo ainda não tiver sido consumido do cliente.
+    for (int attempt = 0; attempt < route->upstream_count * 2 && !head_end; attempt++) {
+        int reused = 0;
+
+        if (upstream_fd < 0) {
+            upstream_index = select_upstream(route, proxy->least_conn, exclude_mask);
+            if (upstream_index < 0) {
+                break;
+            }
+
+            upstream_fd = acquire_connection(proxy, route, upstream_index, &reused);
+            if (upstream_fd < 0) {
+                mark_unhealthy(route, upstream_index);
+                exclude_mask |= 1 << upstream_index;
+                continue;
+            }
+        }
+
+        int failed = send_all(upstream_fd, head, head_length) < 0 ||
+                     send_all(upstream_fd, body_start, buffered_body) < 0;
+
+        if (!failed && content_length > buffered_body) {
+            // O cliente aguarda o 100 Continue antes de enviar o restante do corpo
+            if (expect_continue) {
+                send_all(client_socket, "HTTP/1.1 100 Continue\r\n\r\n", 25);
+                expect_continue = 0;
+            }
+
+            // O corpo restante é transmitido direto do cliente; a partir daqui não há repetição
+            if (relay_body(client_socket, upstream_fd, content_length - buffered_body,
+                           buffer, proxy->buffer_size) < 0) {
+                release_connection(proxy, route, upstream_index, upstream_fd, 0);
+                free(buffer);
+                free(head);
+                return -1;
+            }
+            reused = 0;
+        }
+
+        // Lê o cabeçalho da resposta
+        received = 0;
+        while (!failed && !head_end && received < proxy->buffer_size) {
+            ssize_t n = socket_recv(upstream_fd, buffer + received, proxy->buffer_size - received, 0);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                failed = 1;
+                break;
+            }
+            received += n;
+            buffer[received] = '\0';
+            head_end = memmem(buffer, received, "\r\n\r\n", 4);
+
+            // Respostas intermediárias 1xx (exceto 101) são descartadas
+            while (head_end && received > 12 && buffer[9] == '1' && strncmp(buffer + 9, "101", 3) != 0) {
+                size_t interim = (head_end - buffer) + 4;
+                memmove(buffer, buffer + interim, received - interim);
+                received -= interim;
+                buffer[received] = '\0';
+                head_end = memmem(buffer, received, "\r\n\r\n", 4);
+            }
+        }
+
+        if (head_end) {
+            break;
+        }
+
+        release_connection(proxy, route, upstream_index, upstream_fd, 0);
+        upstream_fd = -1;
+
+        // Só repete quando a falha veio de uma conexão reaproveitada que o upstream
+        // fechou; em conexões novas a requisição pode já ter sido processada
+        if (!failed || !reused) {
+            break;
+        }
+    }
+
+    free(head);
+
+    if (!head_end) {
+        if (upstream_fd >= 0) {
+            release_connection(proxy, route, upstream_index, upstream_fd, 0);
+        }
+        free(buffer);
+        send_error_response(client_socket, 502, "Bad Gateway");
+        return -1;
+    }
+
+    // Analisa a linha de status e os headers relevantes da resposta
+    size_t response_head_length = (head_end - buffer) + 4;
+    int status_code = 0;
+    int http11 = strncmp(buffer, "HTTP/1.1", 8) == 0;
+    int connection_close = !http11;
+    size_t response_length = 0;
+    int has_response_length = 0;
+    body_mode_t mode = BODY_UNTIL_CLOSE;
+
+    if (response_head_length > 12) {
+        status_code = atoi(buffer + 9);
+    }
+
+    // Reescreve o cabeçalho sem os headers hop-by-hop
+    char *client_head = malloc(response_head_length + 32);
+    if (!client_head) {
+        release_connection(proxy, route, upstream_index, upstream_fd, 0);
+        free(buffer);
+        return -1;
+    }
+
+    const char *line = buffer;
+    const char *line_end = memmem(line, response_head_length, "\r\n", 2);
+    size_t client_head_length = (line_end - line) + 2;
+    memcpy(client_head, line, client_head_length);
+
+    for (line = line_end + 2; line < head_end; line = line_end + 2) {
+        line_end = memmem(line, head_end + 2 - line, "\r\n", 2);
+        size_t line_length = line_end - line;
+
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            // Tamanho inválido ou repetido: o fim do corpo não pode ser determinado
+            if (has_response_length ||
+                parse_content_length(line + 15, line_end - (line + 15), &response_length) < 0) {
+                free(client_head);
+                release_connection(proxy, route, upstream_index, upstream_fd, 0);
+                free(buffer);
+                send_error_response(client_socket, 502, "Bad Gateway");
+                return -1;
+            }
+            has_response_length = 1;
+            if (mode != BODY_CHUNKED) {
+                mode = BODY_LENGTH;
+            }
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+            const char *token = strcasestr(line + 18, "chunked");
+            if (token && token < line_end) {
+                mode = BODY_CHUNKED;
+            }
+        } else if (strncasecmp(line, "Connection:", 11) == 0) {
+            const char *token = strcasestr(line + 11, "close");
+            if (token && token < line_end) {
+                connection_close = 1;
+            }
+            token = strcasestr(line + 11, "keep-alive");
+            if (token && token < line_end) {
+                connection_close = 0;
+            }
+            continue;
+        } else if (strncasecmp(line, "Keep-Alive:", 11) == 0) {
+            continue;
+        }
+
+        memcpy(client_head + client_head_length, line, line_length + 2);
+        client_head_length += line_length + 2;
+    }
+
+    memcpy(client_head + client_head_length, "Connection: close\r\n\r\n", 21);
+    client_head_length += 21;
+
+    if (strcmp(request->method, "HEAD") == 0 || (status_code >= 100 && status_code < 200) ||
+        status_code == 204 || status_code == 304) {
+        mode = BODY_NONE;
+    }
+
+    int ok = send_all(client_socket, client_head, client_head_length) == 0;
+    free(client_head);
+
+    // Transmite o corpo da resposta
+    const char *leftover = buffer + response_head_length;
+    size_t leftover_length = received - response_head_length;
+    int reusable = !connection_close;
+
+    switch (mode) {
+        case BODY_NONE:
+            reusable = reusable && leftover_length == 0;
+            break;
+
+        case BODY_LENGTH: {
+            size_t first = leftover_length < response_length ? leftover_length : response_length;
+            reusable = reusable && leftover_length <= response_length;
+            ok = ok && send_all(client_socket, leftover, first) == 0;
+            if (ok && response_length > first) {
+                ok = relay_body(upstream_fd, client_socket, response_length - first,
+                                buffer, proxy->buffer_size) == 0;
+            }
+            break;
+        }
+
+        case BODY_CHUNKED: {
+            chunk_tracker_t tracker = { CHUNK_SIZE, 0, 0 };
+            size_t used = chunk_tracker_feed(&tracker, leftover, leftover_length);
+            ok = ok && send_all(client_socket, leftover, used) == 0;
+            reusable = reusable && used == leftover_length;
+
+            while (ok && tracker.state != CHUNK_DONE) {
+                ssize_t n = socket_recv(upstream_fd, buffer, proxy->buffer_size, 0);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    ok = 0;
+                    break;
+                }
+                used = chunk_tracker_feed(&tracker, buffer, n);
+                reusable = reusable && used == (size_t)n;
+                ok = send_all(client_socket, buffer, used) == 0;
+            }
+            break;
+        }
+
+        case BODY_UNTIL_CLOSE:
+            reusable = 0;
+            ok = ok && send_all(client_socket, leftover, leftover_length) == 0;
+            while (ok) {
+                ssize_t n = socket_recv(upstream_fd, buffer, proxy->buffer_size, 0);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    break;
+                }
+                ok = send_all(client_socket, buffer, n) == 0;
+            }
+            break;
+    }
+
+    release_connection(proxy, route, upstream_index, upstream_fd, ok && reusable);
+    free(buffer);
+    return ok ? 0 : -1;
+}
+
+// Implementação das funções auxiliares internas
+
+static int resolve_upstream(upstream_t *upstream, const char *spec)
+{
+    memset(upstream, 0, sizeof(*upstream));
+    strncpy(upstream->name, spec, sizeof(upstream->name) - 1);
+
+    if (strncmp(spec, "unix:", 5) == 0) {
+        struct sockaddr_un *addr = (struct sockaddr_un*)&upstream->addr;
+        const char *path = spec + 5;
+        if (strlen(path) == 0 || strlen(path) >= sizeof(addr->sun_path)) {
+            return -1;
+        }
+        addr->sun_family = AF_UNIX;
+        strcpy(addr->sun_path, path);
+        upstream->addr_len = sizeof(struct sockaddr_un);
+        return 0;
+    }
+
+    // host:porta, com suporte a IPv6 entre colchetes ([::1]:8080)
+    char host[256];
+    const char *port;
+    if (spec[0] == '[') {
+        const char *close_bracket = strchr(spec, ']');
+        if (!close_bracket || close_bracket[1] != ':') {
+            return -1;
+        }
+        size_t host_len = close_bracket - spec - 1;
+        if (host_len >= sizeof(host)) {
+            return -1;
+        }
+        memcpy(host, spec + 1, host_len);
+        host[host_len] = '\0';
+        port = close_bracket + 2;
+    } else {
+        const char *colon = strrchr(spec, ':');
+        if (!colon || (size_t)(colon - spec) >= sizeof(host)) {
+            return -1;
+        }
+        memcpy(host, spec, colon - spec);
+        host[colon - spec] = '\0';
+        port = colon + 1;
+    }
+
+    struct addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (getaddrinfo(host, port, &hints, &result) != 0) {
+        return -1;
+    }
+
+    memcpy(&upstream->addr, result->ai_addr, result->ai_addrlen);
+    upstream->addr_len = result->ai_addrlen;
+    freeaddrinfo(result);
+    return 0;
+}
+
+static int connect_upstream(const proxy_t *proxy, const upstream_t *upstream)
+{
+    // Em uma corrotina o socket é não-bloqueante e as esperas suspendem só a corrotina
+    int type = SOCK_STREAM | SOCK_CLOEXEC | (coroutine_active() ? SOCK_NONBLOCK : 0);
+    int fd = socket(upstream->addr.ss_family, type, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (proxy->timeout_seconds > 0 || proxy->timeout_microseconds > 0) {
+        set_socket_timeout(fd, proxy->timeout_seconds, proxy->timeout_microseconds);
+    }
+
+    if (upstream->addr.ss_family != AF_UNIX) {
+        int opt = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    }
+
+    if (socket_connect(fd, (const struct sockaddr*)&upstream->addr, upstream->addr_len) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static int select_upstream(proxy_route_t *route, int least_conn, int exclude_mask)
+{
+    int selected = -1;
+
+    pthread_mutex_lock(&route->lock);
+
+    unsigned int start = route->next++;
+    for (int pass = 0; pass < 2 && selected < 0; pass++) {
+        // Na segunda passada ignora o estado de saúde: o health check pode estar atrasado
+        for (int i = 0; i < route->upstream_count; i++) {
+            int index = (start + i) % route->upstream_count;
+            upstream_t *upstream = &route->upstreams[index];
+
+            if ((exclude_mask & (1 << index)) || (pass == 0 && !upstream->healthy)) {
+                continue;
+            }
+            if (!least_conn) {
+                selected = index;
+                break;
+            }
+            if (selected < 0 || upstream->active < route->upstreams[selected].active) {
+                selected = index;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&route->lock);
+    return selected;
+}
+
+static int acquire_connection(proxy_t *proxy, proxy_route_t *route, int index, int *reused)
+{
+    upstream_t *upstream = &route->upstreams[index];
+    int fd = -1;
+
+    pthread_mutex_lock(&route->lock);
+    upstream->active++;
+    while (upstream->idle_count > 0) {
+        int candidate = upstream->idle_fds[--upstream->idle_count];
+        char probe;
+
+        // Uma conexão ociosa saudável não tem nada para ler; EOF ou dados
+        // inesperados indicam que o upstream a fechou ou está fora de sincronia
+        ssize_t n = recv(candidate, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            fd = candidate;
+            break;
+        }
+        close(candidate);
+    }
+    pthread_mutex_unlock(&route->lock);
+
+    if (fd >= 0) {
+        *reused = 1;
+        return fd;
+    }
+
+    *reused = 0;
+    fd = connect_upstream(proxy, upstream);
+    if (fd < 0) {
+        pthread_mutex_lock(&route->lock);
+        upstream->active--;
+        pthread_mutex_unlock(&route->lock);
+    }
+
+    return fd;
+}
+
+static void release_connection(proxy_t *proxy, proxy_route_t *route, int index, int fd, int reusable)
+{
+    upstream_t *upstream = &route->upstreams[index];
+
+    pthread_mutex_lock(&route->lock);
+    upstream->active--;
+    if (reusable && upstream->idle_count < proxy->pool_size) {
+        upstream->idle_fds[upstream->idle_count++] = fd;
+        fd = -1;
+    }
+    pthread_mutex_unlock(&route->lock);
+
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+static void mark_unhealthy(proxy_route_t *route, int index)
+{
+    pthread_mutex_lock(&route->lock);
+    if (route->upstreams[index].healthy) {
+        route->upstreams[index].healthy = 0;
+        printf("Upstream %s marcado como indisponível\n", route->upstreams[index].name);
+    }
+    pthread_mutex_unlock(&route->lock);
+}
+
+static int is_hop_by_hop_header(const char *name)
+{
+    static const char *hop_by_hop[] = {
+        "Connection", "Keep-Alive", "Proxy-Connection", "TE", "Trailer",
+        "Transfer-Encoding", "Upgrade", "Expect", NULL
+    };
+
+    for (const char **h = hop_by_hop; *h; h++) {
+        if (strcasecmp(name, *h) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Apenas dígitos, com espaços opcionais ao redor; rejeita sinais, sufixos e estouro
+static int parse_content_length(const char *value, size_t value_length, size_t *length)
+{
+    const char *p = value;
+    const char *end = value + value_length;
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t')) {
+        end--;
+    }
+    if (p == end) {
+        return -1;
+    }
+
+    size_t result = 0;
+    for (; p < end; p++) {
+        if (*p < '0' || *p > '9' || result > (SIZE_MAX - (*p - '0')) / 10) {
+            return -1;
+        }
+        result = result * 10 + (*p - '0');
+    }
+
+    *length = result;
+    return 0;
+}
+
+// Content-Length da requisição: mais de um header, mesmo com valores iguais, é recusado
+static int request_content_length(const http_request_t *request, size_t *length, int *present)
+{
+    *length = 0;
+    *present = 0;
+
+    for (size_t i = 0; i < request->header_count; i++) {
+        const http_header_t *header = &request->headers[i];
+        if (strcasecmp(header->name, "Content-Length") != 0) {
+            continue;
+        }
+        if (*present || parse_content_length(header->value, strlen(header->value), length) < 0) {
+            return -1;
+        }
+        *present = 1;
+    }
+    return 0;
+}
+
+// O Content-Length do cliente é substituído pelo valor validado
+static char* build_request_head(const http_request_t *request, const char *client_ip, int has_length,
+                                size_t content_length, size_t *length)
+{
+    const http_header_t *forwarded = http_request_get_header(request, "X-Forwarded-For");
+    size_t capacity = strlen(request->method) + strlen(request->path) + 96 + strlen(client_ip);
+
+    for (size_t i = 0; i < request->header_count; i++) {
+        capacity += strlen(request->headers[i].name) + strlen(request->headers[i].value) + 4;
+    }
+
+    char *head = malloc(capacity);
+    if (!head) {
+        return NULL;
+    }
+
+    size_t used = sprintf(head, "%s %s HTTP/1.1\r\n", request->method, request->path);
+
+    for (size_t i = 0; i < request->header_count; i++) {
+        const http_header_t *header = &request->headers[i];
+        if (is_hop_by_hop_header(header->name) || header == forwarded ||
+            strcasecmp(header->name, "Content-Length") == 0) {
+            continue;
+        }
+        used += sprintf(head + used, "%s: %s\r\n", header->name, header->value);
+    }
+
+    if (has_length) {
+        used += sprintf(head + used, "Content-Length: %zu\r\n", content_length);
+    }
+
+    if (forwarded) {
+        used += sprintf(head + used, "X-Forwarded-For: %s, %s\r\n", forwarded->value, client_ip);
+    } else {
+        used += sprintf(head + used, "X-Forwarded-For: %s\r\n", client_ip);
+    }
+    used += sprintf(head + used, "Connection: keep-alive\r\n\r\n");
+
+    *length = used;
+    return head;
+}
+
+static int send_all(int fd, const char *data, size_t length)
+{
+    while (length > 0) {
+        ssize_t sent = socket_send(fd, data, length, 0);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += sent;
+        length -= sent;
+    }
+    return 0;
+}
+
+static int relay_body(int from, int to, size_t length, char *buffer, size_t buffer_size)
+{
+    int pipefd[2];
+
+    // splice move os dados entre os sockets pelo kernel, sem passar pelo espaço de usuário;
+    // em conexões TLS só é possível quando o kTLS cifra/decifra no kernel
+    if (socket_kernel_recv(from) && socket_kernel_send(to) && pipe2(pipefd, O_CLOEXEC) == 0) {
+        int spliced = 0;
+
+        while (length > 0) {
+            ssize_t n = splice(from, NULL, pipefd[1], NULL, length, SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (n < 0 && (errno == EINTR || (errno == EAGAIN && socket_wait(from, POLLIN) == 0))) {
+                continue;
+            }
+            if (n < 0 && errno == EINVAL && !spliced) {
+                break; // splice não suportado por estes descritores
+            }
+            if (n <= 0) {
+                close(pipefd[0]);
+                close(pipefd[1]);
+                return -1;
+            }
+            spliced = 1;
+            length -= n;
+
+            while (n > 0) {
+                ssize_t written = splice(pipefd[0], NULL, to, NULL, n, SPLICE_F_MOVE | SPLICE_F_MORE);
+                if (written < 0 && (errno == EINTR || (errno == EAGAIN && socket_wait(to, POLLOUT) == 0))) {
+                    continue;
+                }
+                if (written <= 0) {
+                    close(pipefd[0]);
+                    close(pipefd[1]);
+                    return -1;
+                }
+                n -= written;
+            }
+        }
+
+        close(pipefd[0]);
+        close(pipefd[1]);
+        if (length == 0) {
+            return 0;
+        }
+    }
+
+    // Cópia tradicional quando splice não está disponível
+    while (length > 0) {
+        size_t chunk = length < buffer_size ? length : buffer_size;
+        ssize_t n = socket_recv(from, buffer, chunk, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0 || send_all(to, buffer, n) < 0) {
+            return -1;
+        }
+        length -= n;
+    }
+
+    return 0;
+}
+
+static size_t chunk_tracker_feed(chunk_tracker_t *tracker, const char *data, size_t length)
+{
+    size_t i = 0;
+
+    while (i < length && tracker->state != CHUNK_DONE) {
+        char c = data[i];
+
+        switch (tracker->state) {
+            case CHUNK_SIZE:
+                if (c >= '0' && c <= '9') {
+                    tracker->remaining = tracker->remaining * 16 + (c - '0');
+                } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+                    tracker->remaining = tracker->remaining * 16 + ((c | 0x20) - 'a' + 10);
+                } else if (c == '\r') {
+                    tracker->state = CHUNK_SIZE_LF;
+                } else {
+                    tracker->state = CHUNK_EXTENSION;
+                }
+                i++;
+                break;
+
+            case CHUNK_EXTENSION:
+                if (c == '\r') {
+                    tracker->state = CHUNK_SIZE_LF;
+                }
+                i++;
+                break;
+
+            case CHUNK_SIZE_LF:
+                i++;
+                if (tracker->remaining == 0) {
+                    tracker->line_length = 0;
+                    tracker->state = CHUNK_TRAILER;
+                } else {
+                    tracker->state = CHUNK_DATA;
+                }
+                break;
+
+            case CHUNK_DATA: {
+                size_t available = length - i;
+                size_t take = available < tracker->remaining ? available : tracker->remaining;
+                i += take;
+                tracker->remaining -= take;
+                if (tracker->remaining == 0) {
+                    tracker->state = CHUNK_DATA_CR;
+                }
+                break;
+            }
+
+            case CHUNK_DATA_CR:
+                tracker->state = CHUNK_DATA_LF;
+                i++;
+                break;
+
+            case CHUNK_DATA_LF:
+                tracker->state = CHUNK_SIZE;
+                tracker->remaining = 0;
+                i++;
+                break;
+
+            case CHUNK_TRAILER:
+                if (c == '\r') {
+                    tracker->state = CHUNK_TRAILER_LF;
+                } else {
+                    tracker->line_length++;
+                }
+                i++;
+                break;
+
+            case CHUNK_TRAILER_LF:
+                i++;
+                // Uma linha vazia encerra os trailers
+                if (tracker->line_length == 0) {
+                    tracker->state = CHUNK_DONE;
+                } else {
+                    tracker->line_length = 0;
+                    tracker->state = CHUNK_TRAILER;
+                }
+                break;
+
+            case CHUNK_DONE:
+                break;
+        }
+    }
+
+    return i;
+}
+
+static void send_error_response(int client_socket, int status_code, const char *status_text)
+{
+    char response[256];
+    int length = snprintf(response, sizeof(response),
+        "HTTP/1.1 %d %s\r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Length: %zu\r\n"
+        "Connection: close\r\n"
+        "\r\n"
+        "%s", status_code, status_text, strlen(status_text), status_text);
+
+    if (length > 0) {
+        send_all(client_socket, response, length);
+    }
+}
+
+static int probe_upstream(const upstream_t *upstream)
+{
+    int fd = socket(upstream->addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        return 0;
+    }
+
+    int healthy = 0;
+    if (connect(fd, (const struct sockaddr*)&upstream->addr, upstream->addr_len) == 0) {
+        healthy = 1;
+    } else if (errno == EINPROGRESS) {
+        struct pollfd pfd = { fd, POLLOUT, 0 };
+        if (poll(&pfd, 1, HEALTH_CHECK_TIMEOUT_MS) == 1) {
+            int error = 0;
+            socklen_t len = sizeof(error);
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+            healthy = error == 0;
+        }
+    }
+
+    close(fd);
+    return healthy;
+}
+
+static void* health_check_thread(void *arg)
+{
+    proxy_t *proxy = (proxy_t*)arg;
+
+    pthread_mutex_lock(&proxy->health_lock);
+    while (proxy->health_running) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += proxy->health_interval;
+        pthread_cond_timedwait(&proxy->health_cond, &proxy->health_lock, &deadline);
+        if (!proxy->health_running) {
+            break;
+        }
+        pthread_mutex_unlock(&proxy->health_lock);
+
+        for (int i = 0; i < proxy->route_count; i++) {
+            proxy_route_t *route = &proxy->routes[i];
+            for (int j = 0; j < route->upstream_count; j++) {
+                int healthy = probe_upstream(&route->upstreams[j]);
+
+                pthread_mutex_lock(&route->lock);
+                if (healthy != route->upstreams[j].healthy) {
+                    printf("Upstream %s %s\n", route->upstreams[j].name,
+                           healthy ? "disponível novamente" : "marcado como indisponível");
+                }
+                route->upstreams[j].healthy = healthy;
+                pthread_mutex_unlock(&route->lock);
+            }
+        }
+
+        pthread_mutex_lock(&proxy->health_lock);
+    }
+    pthread_mutex_unlock(&proxy->health_lock);
+
+    return NULL;
+}
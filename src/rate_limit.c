@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <netinet/in.h>
+#include "rate_limit.h"
+
+#define RATE_LIMIT_MAX_PROBE 16    // Slots examinados por endereço antes de desistir
+#define RATE_LIMIT_TOKEN 1000      // Tokens são contados em milésimos
+#define RATE_LIMIT_TICK_MS 10      // Resolução do instante gravado no bucket
+#define RATE_LIMIT_TICK_MASK 0x7FFFFFFFU  // Instante em 31 bits: dá a volta a cada ~248 dias
+#define RATE_LIMIT_SKEW_TICKS 100  // Instantes à frente do nosso tolerados (gravados por outra thread)
+#define RATE_STATE_VALID (1ULL << 63)  // Bucket já gravado (estado 0: novo e cheio)
+
+// Parâmetros de um tipo de evento
+typedef struct {
+    uint64_t rate;                 // Milésimos de token repostos por milissegundo (= tokens por segundo)
+    uint32_t capacity;             // Rajada em milésimos de token
+} rate_params_t;
+
+// Slot da tabela: chave 0 indica slot livre. O estado guarda RATE_STATE_VALID
+// (sem ele o bucket é novo e está cheio), o instante da última atualização
+// (bits 32 a 62, em ticks de RATE_LIMIT_TICK_MS) e os tokens restantes
+// (32 bits baixos, em milésimos).
+typedef struct {
+    uint64_t key;
+    uint64_t state;
+} rate_slot_t;
+
+struct rate_limiter {
+    rate_slot_t *slots;
+    size_t mask;                   // Capacidade - 1 (potência de dois)
+    rate_params_t params[2];       // Indexado por rate_limit_kind_t
+    int ipv4_prefix;
+    int ipv6_prefix;
+    uint64_t seed;
+    uint64_t epoch_ms;             // Origem do relógio dos buckets
+};
+
+// Funções auxiliares internas
+static uint64_t now_ms(void);
+static uint64_t mix64(uint64_t value);
+static uint64_t address_key(const rate_limiter_t *limiter, rate_limit_kind_t kind, const struct sockaddr *address);
+static uint32_t refill(const rate_params_t *params, uint64_t state, uint32_t now);
+static rate_slot_t* find_slot(rate_limiter_t *limiter, uint64_t key, uint32_t now);
+static void mask_prefix(unsigned char *bytes, size_t length, int prefix);
+
+rate_limiter_t* rate_limiter_create(const server_config_t *config)
+{
+    if (!config || (config->rate_limit_requests <= 0 && config->rate_limit_connections <= 0)) {
+        return NULL;
+    }
+
+    rate_limiter_t *limiter = calloc(1, sizeof(rate_limiter_t));
+    if (!limiter) {
+        perror("Erro ao alocar limitador de taxa");
+        return NULL;
+    }
+
+    size_t capacity = 1024;
+    while (capacity < (size_t)config->rate_limit_table_size) {
+        capacity <<= 1;
+    }
+
+    limiter->slots = calloc(capacity, sizeof(rate_slot_t));
+    if (!limiter->slots) {
+        perror("Erro ao alocar tabela do limitador de taxa");
+        free(limiter);
+        return NULL;
+    }
+
+    limiter->mask = capacity - 1;
+    limiter->params[RATE_LIMIT_REQUEST].rate = config->rate_limit_requests;
+    limiter->params[RATE_LIMIT_REQUEST].capacity = config->rate_limit_request_burst * RATE_LIMIT_TOKEN;
+    limiter->params[RATE_LIMIT_CONNECTION].rate = config->rate_limit_connections;
+    limiter->params[RATE_LIMIT_CONNECTION].capacity = config->rate_limit_connection_burst * RATE_LIMIT_TOKEN;
+    limiter->ipv4_prefix = config->rate_limit_ipv4_prefix;
+    limiter->ipv6_prefix = config->rate_limit_ipv6_prefix;
+
+    // A semente impede que clientes escolham endereços que colidam na tabela
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    limiter->seed = mix64((uint64_t)ts.tv_nsec ^ ((uint64_t)ts.tv_sec << 32) ^ (uintptr_t)limiter);
+    limiter->epoch_ms = now_ms() - 1;
+
+    return limiter;
+}
+
+void rate_limiter_destroy(rate_limiter_t *limiter)
+{
+    if (!limiter) {
+        return;
+    }
+
+    free(limiter->slots);
+    free(limiter);
+}
+
+int rate_limiter_check(rate_limiter_t *limiter, rate_limit_kind_t kind, const struct sockaddr *address)
+{
+    if (!limiter || !address) {
+        return 0;
+    }
+
+    const rate_params_t *params = &limiter->params[kind];
+    if (params->rate == 0) {
+        return 0;
+    }
+
+    uint64_t key = address_key(limiter, kind, address);
+    if (key == 0) {
+        return 0;
+    }
+
+    uint32_t now = (uint32_t)((now_ms() - limiter->epoch_ms) / RATE_LIMIT_TICK_MS) & RATE_LIMIT_TICK_MASK;
+    rate_slot_t *slot = find_slot(limiter, key, now);
+    if (!slot) {
+        // Tabela saturada na vizinhança do endereço: o cliente não é limitado
+        return 0;
+    }
+
+    uint64_t state = __atomic_load_n(&slot->state, __ATOMIC_RELAXED);
+    while (1) {
+        uint32_t tokens = refill(params, state, now);
+        if (tokens < RATE_LIMIT_TOKEN) {
+            // Rejeições não alteram o bucket: a reposição continua contando do último consumo
+            uint64_t wait_ms = (RATE_LIMIT_TOKEN - tokens + params->rate - 1) / params->rate;
+            return (int)((wait_ms + 999) / 1000);
+        }
+
+        uint64_t next = RATE_STATE_VALID | ((uint64_t)now << 32) | (tokens - RATE_LIMIT_TOKEN);
+        if (__atomic_compare_exchange_n(&slot->state, &state, next, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return 0;
+        }
+    }
+}
+
+// Implementação das funções auxiliares internas
+
+static uint64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Finalizador do splitmix64
+static uint64_t mix64(uint64_t value)
+{
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ULL;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBULL;
+    value ^= value >> 31;
+    return value;
+}
+
+static void mask_prefix(unsigned char *bytes, size_t length, int prefix)
+{
+    for (size_t i = 0; i < length; i++) {
+        int bits = prefix - (int)(i * 8);
+        if (bits >= 8) {
+            continue;
+        }
+        bytes[i] &= bits <= 0 ? 0 : (unsigned char)(0xFF << (8 - bits));
+    }
+}
+
+// Chave de 64 bits do bucket: endereço truncado no prefixo, com o tipo de evento no bit mais baixo
+static uint64_t address_key(const rate_limiter_t *limiter, rate_limit_kind_t kind, const struct sockaddr *address)
+{
+    unsigned char bytes[16];
+    uint64_t family;
+
+    if (address->sa_family == AF_INET) {
+        const struct sockaddr_in *in = (const struct sockaddr_in*)address;
+        memset(bytes, 0, sizeof(bytes));
+        memcpy(bytes, &in->sin_addr, 4);
+        mask_prefix(bytes, 4, limiter->ipv4_prefix);
+        family = 4;
+    } else if (address->sa_family == AF_INET6) {
+        const struct sockaddr_in6 *in6 = (const struct sockaddr_in6*)address;
+        if (IN6_IS_ADDR_V4MAPPED(&in6->sin6_addr)) {
+            // Clientes IPv4 em sockets dual-stack compartilham o bucket do endereço IPv4
+            memset(bytes, 0, sizeof(bytes));
+            memcpy(bytes, &in6->sin6_addr.s6_addr[12], 4);
+            mask_prefix(bytes, 4, limiter->ipv4_prefix);
+            family = 4;
+        } else {
+            memcpy(bytes, &in6->sin6_addr, 16);
+            mask_prefix(bytes, 16, limiter->ipv6_prefix);
+            family = 6;
+        }
+    } else {
+        return 0;
+    }
+
+    uint64_t high, low;
+    memcpy(&high, bytes, 8);
+    memcpy(&low, bytes + 8, 8);
+    uint64_t hash = mix64(limiter->seed ^ high ^ mix64(low ^ (family << 56)));
+
+    uint64_t key = (hash & ~1ULL) | (uint64_t)kind;
+    return key ? key : 2;
+}
+
+// Tokens disponíveis agora (em milésimos), aplicando a reposição desde a última atualização
+static uint32_t refill(const rate_params_t *params, uint64_t state, uint32_t now)
+{
+    if (!(state & RATE_STATE_VALID)) {
+        return params->capacity;
+    }
+
+    uint32_t last = (uint32_t)(state >> 32) & RATE_LIMIT_TICK_MASK;
+    uint64_t tokens = (uint32_t)state;
+
+    // A diferença sem sinal continua correta quando o relógio dá a volta; só um
+    // instante um pouco à frente do nosso, gravado por outra thread, não repõe nada
+    uint32_t elapsed = (now - last) & RATE_LIMIT_TICK_MASK;
+    if (elapsed <= RATE_LIMIT_TICK_MASK - RATE_LIMIT_SKEW_TICKS) {
+        tokens += (uint64_t)elapsed * RATE_LIMIT_TICK_MS * params->rate;
+    }
+
+    return tokens > params->capacity ? params->capacity : (uint32_t)tokens;
+}
+
+// Localiza o slot da chave, ocupando um slot livre ou reaproveitando um bucket
+// já cheio (equivalente a um cliente que não é visto há tempo suficiente)
+static rate_slot_t* find_slot(rate_limiter_t *limiter, uint64_t key, uint32_t now)
+{
+    size_t index = (size_t)(key >> 1) & limiter->mask;
+    rate_slot_t *reusable = NULL;
+    uint64_t reusable_key = 0;
+
+    for (int probe = 0; probe < RATE_LIMIT_MAX_PROBE; probe++) {
+        rate_slot_t *slot = &limiter->slots[(index + probe) & limiter->mask];
+        uint64_t current = __atomic_load_n(&slot->key, __ATOMIC_ACQUIRE);
+
+        if (current == key) {
+            return slot;
+        }
+
+        // Slots nunca voltam a ficar livres, então a chave não aparece depois de um slot livre
+        if (current == 0) {
+            if (__atomic_compare_exchange_n(&slot->key, &current, key, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ||
+                current == key) {
+                return slot;
+            }
+            continue;
+        }
+
+        if (!reusable) {
+            const rate_params_t *params = &limiter->params[current & 1];
+            uint64_t state = __atomic_load_n(&slot->state, __ATOMIC_RELAXED);
+            if (refill(params, state, now) >= params->capacity) {
+                reusable = slot;
+                reusable_key = current;
+            }
+        }
+    }
+
+    if (!reusable) {
+        return NULL;
+    }
+
+    // Duas threads podem reaproveitar slots diferentes para o mesmo endereço;
+    // o efeito é apenas uma rajada extra para esse cliente
+    uint64_t expected = reusable_key;
+    if (__atomic_compare_exchange_n(&reusable->key, &expected, key, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&reusable->state, 0, __ATOMIC_RELAXED);
+        return reusable;
+    }
+    return expected == key ? reusable : NULL;
+}
@@ -0,0 +1,450 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include "response_cache.h"
+#include "coroutine.h"
+
+#define CACHE_SHARDS 16
+#define CACHE_BUCKETS_PER_SHARD 256
+#define MAX_VARY_HEADERS 8
+
+struct cache_entry {
+    uint64_t hash;
+    char *key;
+    size_t key_length;
+    char *data;               // Resposta serializada (NULL enquanto pendente)
+    size_t length;
+    uint64_t expires_ms;
+    size_t charge;            // Bytes contabilizados no limite de memória
+    int pending;              // Preenchimento em andamento
+    int linked;               // Presente na tabela hash
+    int refcount;             // Threads usando a entrada
+    cache_entry_t *next;      // Próxima entrada no bucket
+    cache_entry_t *lru_prev;  // Entrada usada mais recentemente
+    cache_entry_t *lru_next;  // Entrada usada menos recentemente
+};
+
+typedef struct {
+    pthread_mutex_t lock;
+    coroutine_cond_t filled;   // Esperas suspendem só a corrotina
+    cache_entry_t *buckets[CACHE_BUCKETS_PER_SHARD];
+    cache_entry_t *lru_head;  // Mais recente
+    cache_entry_t *lru_tail;  // Candidata à remoção
+    size_t bytes;
+} cache_shard_t;
+
+struct response_cache {
+    cache_shard_t shards[CACHE_SHARDS];
+    uint64_t ttl_ms;
+    size_t shard_capacity;
+    char vary_headers[MAX_VARY_HEADERS][64];
+    int vary_count;
+};
+
+// Funções auxiliares internas
+static uint64_t now_ms(void);
+static uint64_t hash_key(const char *key, size_t length);
+static char* build_key(const response_cache_t *cache, const http_request_t *request, size_t *length);
+static void lru_remove(cache_shard_t *shard, cache_entry_t *entry);
+static void lru_push_front(cache_shard_t *shard, cache_entry_t *entry);
+static void unlink_entry(cache_shard_t *shard, cache_entry_t *entry);
+static void free_entry(cache_entry_t *entry);
+static int has_directive(const char *value, const char *directive);
+
+response_cache_t* response_cache_create(const server_config_t *config)
+{
+    if (!config || !config->cache_enabled) {
+        return NULL;
+    }
+
+    response_cache_t *cache = calloc(1, sizeof(response_cache_t));
+    if (!cache) {
+        perror("Erro ao alocar cache de respostas");
+        return NULL;
+    }
+
+    cache->ttl_ms = config->cache_ttl_ms;
+    cache->shard_capacity = config->cache_max_bytes / CACHE_SHARDS;
+
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        pthread_mutex_init(&cache->shards[i].lock, NULL);
+        coroutine_cond_init(&cache->shards[i].filled);
+    }
+
+    // Lista de headers separados por vírgula que diferenciam as respostas
+    char vary[sizeof(config->cache_vary_headers)];
+    strncpy(vary, config->cache_vary_headers, sizeof(vary) - 1);
+    vary[sizeof(vary) - 1] = '\0';
+
+    char *saveptr = NULL;
+    for (char *token = strtok_r(vary, ", ", &saveptr);
+         token && cache->vary_count < MAX_VARY_HEADERS;
+         token = strtok_r(NULL, ", ", &saveptr)) {
+        strncpy(cache->vary_headers[cache->vary_count], token, sizeof(cache->vary_headers[0]) - 1);
+        cache->vary_count++;
+    }
+
+    return cache;
+}
+
+void response_cache_destroy(response_cache_t *cache)
+{
+    if (!cache) {
+        return;
+    }
+
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        cache_shard_t *shard = &cache->shards[i];
+        for (int j = 0; j < CACHE_BUCKETS_PER_SHARD; j++) {
+            cache_entry_t *entry = shard->buckets[j];
+            while (entry) {
+                cache_entry_t *next = entry->next;
+                free_entry(entry);
+                entry = next;
+            }
+        }
+        coroutine_cond_destroy(&shard->filled);
+        pthread_mutex_destroy(&shard->lock);
+    }
+
+    free(cache);
+}
+
+int response_cache_accepts(const response_cache_t *cache, const http_request_t *request)
+{
+    if (!cache || !request) {
+        return 0;
+    }
+
+    if (strcmp(request->method, "GET") != 0 && strcmp(request->method, "HEAD") != 0) {
+        return 0;
+    }
+
+    // Respostas personalizadas por usuário nunca são compartilhadas
+    return !http_request_get_header(request, "Authorization") &&
+           !http_request_get_header(request, "Cookie");
+}
+
+int response_cache_storable(const http_response_t *response)
+{
+    if (!response) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < response->header_count; i++) {
+        const char *name = response->headers[i].name;
+        const char *value = response->headers[i].value;
+
+        if (strcasecmp(name, "Set-Cookie") == 0) {
+            return 0;
+        }
+        if (strcasecmp(name, "Cache-Control") == 0 &&
+            (has_directive(value, "private") || has_directive(value, "no-store") ||
+             has_directive(value, "no-cache"))) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+cache_entry_t* response_cache_acquire(response_cache_t *cache, const http_request_t *request, int *is_filler)
+{
+    size_t key_length;
+    char *key = build_key(cache, request, &key_length);
+    if (!key) {
+        return NULL;
+    }
+
+    uint64_t hash = hash_key(key, key_length);
+    cache_shard_t *shard = &cache->shards[hash % CACHE_SHARDS];
+    size_t bucket = (hash / CACHE_SHARDS) % CACHE_BUCKETS_PER_SHARD;
+
+    pthread_mutex_lock(&shard->lock);
+
+    for (;;) {
+        cache_entry_t *entry = shard->buckets[bucket];
+        while (entry && (entry->hash != hash || entry->key_length != key_length ||
+                         memcmp(entry->key, key, key_length) != 0)) {
+            entry = entry->next;
+        }
+
+        if (!entry) {
+            break;
+        }
+
+        if (entry->pending) {
+            // Outra thread está gerando esta resposta: aguarda o resultado segurando
+            // uma referência, pois a entrada sai da tabela se não for cacheável
+            entry->refcount++;
+            while (entry->pending) {
+                coroutine_cond_wait(&shard->filled, &shard->lock);
+            }
+
+            if (entry->data) {
+                // A referência já obtida passa ao chamador, mesmo se a entrada
+                // tiver sido removida da tabela enquanto aguardava
+                pthread_mutex_unlock(&shard->lock);
+                free(key);
+                *is_filler = 0;
+                return entry;
+            }
+
+            // Resposta não cacheável: cada thread em espera gera a sua em paralelo,
+            // em vez de virarem preenchedoras uma de cada vez
+            entry->refcount--;
+            int release = !entry->linked && entry->refcount == 0;
+            pthread_mutex_unlock(&shard->lock);
+            if (release) {
+                free_entry(entry);
+            }
+            free(key);
+            return NULL;
+        }
+
+        if (entry->data && now_ms() < entry->expires_ms) {
+            lru_remove(shard, entry);
+            lru_push_front(shard, entry);
+            entry->refcount++;
+            pthread_mutex_unlock(&shard->lock);
+            free(key);
+            *is_filler = 0;
+            return entry;
+        }
+
+        // Entrada expirada: será substituída
+        unlink_entry(shard, entry);
+        break;
+    }
+
+    cache_entry_t *entry = calloc(1, sizeof(cache_entry_t));
+    if (!entry) {
+        pthread_mutex_unlock(&shard->lock);
+        free(key);
+        return NULL;
+    }
+
+    entry->hash = hash;
+    entry->key = key;
+    entry->key_length = key_length;
+    entry->pending = 1;
+    entry->linked = 1;
+    entry->refcount = 1;
+    entry->next = shard->buckets[bucket];
+    shard->buckets[bucket] = entry;
+
+    pthread_mutex_unlock(&shard->lock);
+
+    *is_filler = 1;
+    return entry;
+}
+
+int response_cache_complete(response_cache_t *cache, cache_entry_t *entry, char *data, size_t length)
+{
+    cache_shard_t *shard = &cache->shards[entry->hash % CACHE_SHARDS];
+    size_t charge = length + entry->key_length + sizeof(cache_entry_t);
+    int stored = data && charge <= cache->shard_capacity;
+
+    pthread_mutex_lock(&shard->lock);
+
+    entry->pending = 0;
+
+    if (stored) {
+        entry->data = data;
+        entry->length = length;
+        entry->charge = charge;
+        entry->expires_ms = now_ms() + cache->ttl_ms;
+        shard->bytes += charge;
+        lru_push_front(shard, entry);
+
+        // Remove as entradas menos usadas até respeitar o limite de memória
+        while (shard->bytes > cache->shard_capacity && shard->lru_tail != entry) {
+            unlink_entry(shard, shard->lru_tail);
+        }
+    } else {
+        unlink_entry(shard, entry);
+    }
+
+    coroutine_cond_broadcast(&shard->filled);
+    pthread_mutex_unlock(&shard->lock);
+    return stored;
+}
+
+const char* response_cache_data(const cache_entry_t *entry, size_t *length)
+{
+    if (!entry || !entry->data) {
+        return NULL;
+    }
+
+    *length = entry->length;
+    return entry->data;
+}
+
+void response_cache_release(response_cache_t *cache, cache_entry_t *entry)
+{
+    if (!entry) {
+        return;
+    }
+
+    cache_shard_t *shard = &cache->shards[entry->hash % CACHE_SHARDS];
+    int release = 0;
+
+    pthread_mutex_lock(&shard->lock);
+    entry->refcount--;
+    release = !entry->linked && entry->refcount == 0;
+    pthread_mutex_unlock(&shard->lock);
+
+    if (release) {
+        free_entry(entry);
+    }
+}
+
+// Implementação das funções auxiliares internas
+
+static uint64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint64_t hash_key(const char *key, size_t length)
+{
+    // FNV-1a de 64 bits
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)key[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static char* build_key(const response_cache_t *cache, const http_request_t *request, size_t *length)
+{
+    const char *values[MAX_VARY_HEADERS];
+    size_t method_length = strlen(request->method);
+    size_t path_length = strlen(request->path);
+    size_t total = method_length + path_length + 2;
+
+    for (int i = 0; i < cache->vary_count; i++) {
+        const http_header_t *header = http_request_get_header(request, cache->vary_headers[i]);
+        values[i] = header ? header->value : "";
+        total += strlen(values[i]) + 1;
+    }
+
+    // Campos separados por '\0' para que "GET" + "/a" nunca colida com "GE" + "T/a"
+    char *key = malloc(total);
+    if (!key) {
+        return NULL;
+    }
+
+    size_t used = 0;
+    memcpy(key + used, request->method, method_length + 1);
+    used += method_length + 1;
+    memcpy(key + used, request->path, path_length + 1);
+    used += path_length + 1;
+
+    for (int i = 0; i < cache->vary_count; i++) {
+        size_t value_length = strlen(values[i]);
+        memcpy(key + used, values[i], value_length + 1);
+        used += value_length + 1;
+    }
+
+    *length = used;
+    return key;
+}
+
+static void lru_remove(cache_shard_t *shard, cache_entry_t *entry)
+{
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else if (shard->lru_head == entry) {
+        shard->lru_head = entry->lru_next;
+    }
+
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else if (shard->lru_tail == entry) {
+        shard->lru_tail = entry->lru_prev;
+    }
+
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+static void lru_push_front(cache_shard_t *shard, cache_entry_t *entry)
+{
+    entry->lru_prev = NULL;
+    entry->lru_next = shard->lru_head;
+    if (shard->lru_head) {
+        shard->lru_head->lru_prev = entry;
+    }
+    shard->lru_head = entry;
+    if (!shard->lru_tail) {
+        shard->lru_tail = entry;
+    }
+}
+
+static void unlink_entry(cache_shard_t *shard, cache_entry_t *entry)
+{
+    size_t bucket = (entry->hash / CACHE_SHARDS) % CACHE_BUCKETS_PER_SHARD;
+    cache_entry_t **link = &shard->buckets[bucket];
+
+    while (*link && *link != entry) {
+        link = &(*link)->next;
+    }
+    if (*link) {
+        *link = entry->next;
+    }
+
+    if (entry->data) {
+        lru_remove(shard, entry);
+        shard->bytes -= entry->charge;
+    }
+
+    entry->linked = 0;
+    entry->next = NULL;
+
+    // Entradas em uso são liberadas pela última thread em response_cache_release
+    if (entry->refcount == 0) {
+        free_entry(entry);
+    }
+}
+
+static void free_entry(cache_entry_t *entry)
+{
+    free(entry->key);
+    free(entry->data);
+    free(entry);
+}
+
+// Procura uma diretiva (com ou sem argumento) numa lista separada por vírgulas
+static int has_directive(const char *value, const char *directive)
+{
+    size_t length = strlen(directive);
+    const char *p = value;
+
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') {
+            p++;
+        }
+
+        const char *start = p;
+        while (*p && *p != ',' && *p != '=' && *p != ' ' && *p != '\t') {
+            p++;
+        }
+        if ((size_t)(p - start) == length && strncasecmp(start, directive, length) == 0) {
+            return 1;
+        }
+
+        while (*p && *p != ',') {
+            p++;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,200 @@
+#include <string.h>
+#include <time.h>
+#include "response_header.h"
+
+#define STATUS_CODE_LIMIT 600
+
+// Códigos conhecidos; cada um gera o texto e a linha de status completa
+#define STATUS_CODES(X) \
+    X(100, "Continue") \
+    X(101, "Switching Protocols") \
+    X(200, "OK") \
+    X(201, "Created") \
+    X(202, "Accepted") \
+    X(204, "No Content") \
+    X(206, "Partial Content") \
+    X(301, "Moved Permanently") \
+    X(302, "Found") \
+    X(303, "See Other") \
+    X(304, "Not Modified") \
+    X(307, "Temporary Redirect") \
+    X(308, "Permanent Redirect") \
+    X(400, "Bad Request") \
+    X(401, "Unauthorized") \
+    X(403, "Forbidden") \
+    X(404, "Not Found") \
+    X(405, "Method Not Allowed") \
+    X(408, "Request Timeout") \
+    X(409, "Conflict") \
+    X(411, "Length Required") \
+    X(413, "Payload Too Large") \
+    X(414, "URI Too Long") \
+    X(415, "Unsupported Media Type") \
+    X(429, "Too Many Requests") \
+    X(431, "Request Header Fields Too Large") \
+    X(500, "Internal Server Error") \
+    X(501, "Not Implemented") \
+    X(502, "Bad Gateway") \
+    X(503, "Service Unavailable") \
+    X(504, "Gateway Timeout")
+
+#define STATUS_LINE(code, text) "HTTP/1.1 " #code " " text "\r\n"
+#define STATUS_ENTRY(code, text) [code] = { text, STATUS_LINE(code, text), sizeof(STATUS_LINE(code, text)) - 1 },
+
+typedef struct {
+    const char *text;
+    const char *line;
+    size_t line_length;
+} status_entry_t;
+
+static const status_entry_t status_table[STATUS_CODE_LIMIT] = {
+    STATUS_CODES(STATUS_ENTRY)
+};
+
+// Tipos internados: a linha do header é gerada em tempo de compilação
+#define CONTENT_TYPE_LINE(type) "Content-Type: " type "\r\n"
+#define CONTENT_TYPE_ENTRY(type) { type, CONTENT_TYPE_LINE(type), sizeof(CONTENT_TYPE_LINE(type)) - 1 }
+
+typedef struct {
+    const char *type;
+    const char *line;
+    size_t line_length;
+} content_type_entry_t;
+
+static const content_type_entry_t content_types[] = {
+    CONTENT_TYPE_ENTRY("text/plain"),
+    CONTENT_TYPE_ENTRY("text/html"),
+    CONTENT_TYPE_ENTRY("application/json"),
+    CONTENT_TYPE_ENTRY("text/plain; charset=utf-8"),
+    CONTENT_TYPE_ENTRY("text/html; charset=utf-8"),
+    CONTENT_TYPE_ENTRY("application/octet-stream"),
+    CONTENT_TYPE_ENTRY("text/css"),
+    CONTENT_TYPE_ENTRY("text/javascript"),
+    CONTENT_TYPE_ENTRY("application/javascript"),
+    CONTENT_TYPE_ENTRY("application/xml"),
+    CONTENT_TYPE_ENTRY("text/event-stream"),
+    CONTENT_TYPE_ENTRY("image/png"),
+    CONTENT_TYPE_ENTRY("image/jpeg"),
+    CONTENT_TYPE_ENTRY("image/svg+xml"),
+    { NULL, NULL, 0 }
+};
+
+// Bloco Date/Server da thread e o segundo a que ele corresponde
+static __thread char date_block[96];
+static __thread size_t date_length;
+static __thread time_t date_second;
+
+// Funções auxiliares internas
+static size_t format_date_block(char *buffer, time_t now);
+static char* write_two_digits(char *p, int value);
+
+const char* response_header_status_text(int status_code)
+{
+    if (status_code < 0 || status_code >= STATUS_CODE_LIMIT) {
+        return NULL;
+    }
+    return status_table[status_code].text;
+}
+
+const char* response_header_status_line(int status_code, const char *status_text, size_t *length)
+{
+    if (status_code < 0 || status_code >= STATUS_CODE_LIMIT || !status_table[status_code].line) {
+        return NULL;
+    }
+
+    const status_entry_t *entry = &status_table[status_code];
+    if (status_text && status_text != entry->text && strcmp(status_text, entry->text) != 0) {
+        return NULL;
+    }
+
+    *length = entry->line_length;
+    return entry->line;
+}
+
+const char* response_header_date(size_t *length)
+{
+    // CLOCK_REALTIME_COARSE é lido pelo vDSO, sem chamada de sistema; a
+    // resolução de alguns milissegundos basta para detectar a troca de segundo
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+
+    if (ts.tv_sec != date_second || date_length == 0) {
+        date_length = format_date_block(date_block, ts.tv_sec);
+        date_second = ts.tv_sec;
+    }
+
+    *length = date_length;
+    return date_block;
+}
+
+const char* response_header_content_type(const char *content_type, size_t *length)
+{
+    if (!content_type) {
+        return NULL;
+    }
+
+    for (const content_type_entry_t *entry = content_types; entry->type; entry++) {
+        if (content_type == entry->type || strcmp(content_type, entry->type) == 0) {
+            *length = entry->line_length;
+            return entry->line;
+        }
+    }
+    return NULL;
+}
+
+char* response_header_format_size(char *end, size_t value)
+{
+    char *p = end;
+    do {
+        *--p = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    return p;
+}
+
+// Implementação das funções auxiliares internas
+
+// Formato IMF-fixdate (RFC 9110), sem strftime para não depender do locale
+static size_t format_date_block(char *buffer, time_t now)
+{
+    static const char days[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+    static const char months[12][4] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+    struct tm tm;
+    gmtime_r(&now, &tm);
+
+    char *p = buffer;
+    memcpy(p, "Date: ", 6);
+    p += 6;
+    memcpy(p, days[tm.tm_wday], 3);
+    p += 3;
+    memcpy(p, ", ", 2);
+    p = write_two_digits(p + 2, tm.tm_mday);
+    *p++ = ' ';
+    memcpy(p, months[tm.tm_mon], 3);
+    p += 3;
+    *p++ = ' ';
+    char year[8];
+    char *digits = response_header_format_size(year + sizeof(year), tm.tm_year + 1900);
+    memcpy(p, digits, year + sizeof(year) - digits);
+    p += year + sizeof(year) - digits;
+    *p++ = ' ';
+    p = write_two_digits(p, tm.tm_hour);
+    *p++ = ':';
+    p = write_two_digits(p, tm.tm_min);
+    *p++ = ':';
+    p = write_two_digits(p, tm.tm_sec);
+
+    static const char tail[] = " GMT\r\nServer: " RESPONSE_HEADER_SERVER "\r\n";
+    memcpy(p, tail, sizeof(tail) - 1);
+    p += sizeof(tail) - 1;
+
+    return p - buffer;
+}
+
+static char* write_two_digits(char *p, int value)
+{
+    p[0] = '0' + value / 10;
+    p[1] = '0' + value % 10;
+    return p + 2;
+}
@@ -0,0 +1,390 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include "send_queue.h"
+#include "socket_utils.h"
+#include "coroutine.h"
+
+#define SEND_QUEUE_BATCH 64       // Buffers por chamada de sendmsg
+
+struct send_queue_node {
+    send_buffer_t *buffer;
+    struct send_queue_node *next;
+};
+
+struct send_group {
+    pthread_mutex_t lock;
+    send_queue_t **members;
+    size_t count;
+    size_t capacity;
+};
+
+// Funções auxiliares internas
+static size_t buffer_send_length(const send_queue_t *queue, const send_buffer_t *buffer);
+static void update_space(send_queue_t *queue);
+static void notify(int fd);
+static void release_nodes(send_queue_node_t *node, send_queue_node_t *end);
+
+send_buffer_t* send_buffer_create(size_t length)
+{
+    send_buffer_t *buffer = malloc(sizeof(send_buffer_t) + length);
+    if (!buffer) {
+        return NULL;
+    }
+
+    buffer->refcount = 1;
+    buffer->length = length;
+    buffer->header_length = 0;
+    buffer->trailer_length = 0;
+    return buffer;
+}
+
+void send_buffer_retain(send_buffer_t *buffer)
+{
+    if (buffer) {
+        __atomic_add_fetch(&buffer->refcount, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void send_buffer_release(send_buffer_t *buffer)
+{
+    if (buffer && __atomic_sub_fetch(&buffer->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(buffer);
+    }
+}
+
+int send_queue_init(send_queue_t *queue, int socket, size_t max_bytes, int blocking_writers)
+{
+    memset(queue, 0, sizeof(*queue));
+    queue->space_fd = -1;
+
+    queue->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (queue->wake_fd < 0) {
+        return -1;
+    }
+    if (blocking_writers) {
+        queue->space_fd = eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (queue->space_fd < 0) {
+            close(queue->wake_fd);
+            return -1;
+        }
+    }
+
+    queue->socket = socket;
+    queue->max_bytes = max_bytes;
+    queue->space_ready = 1;
+    pthread_mutex_init(&queue->lock, NULL);
+    return 0;
+}
+
+void send_queue_destroy(send_queue_t *queue)
+{
+    release_nodes(queue->head, NULL);
+    queue->head = NULL;
+    queue->tail = NULL;
+
+    close(queue->wake_fd);
+    if (queue->space_fd >= 0) {
+        close(queue->space_fd);
+    }
+    pthread_mutex_destroy(&queue->lock);
+}
+
+int send_queue_push(send_queue_t *queue, send_buffer_t *buffer, int flags)
+{
+    send_queue_node_t *node = malloc(sizeof(send_queue_node_t));
+    if (!node) {
+        return -1;
+    }
+
+    size_t length = buffer_send_length(queue, buffer);
+
+    pthread_mutex_lock(&queue->lock);
+    while (1) {
+        // Nada pode ser enviado depois do encerramento
+        if (queue->shut || queue->dropped) {
+            pthread_mutex_unlock(&queue->lock);
+            free(node);
+            return -1;
+        }
+
+        if ((flags & SEND_QUEUE_WAIT) && queue->space_fd >= 0) {
+            if (queue->space_ready) {
+                break;
+            }
+
+            pthread_mutex_unlock(&queue->lock);
+            struct pollfd pfd = { .fd = queue->space_fd, .events = POLLIN };
+            if (coroutine_poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+                free(node);
+                return -1;
+            }
+            pthread_mutex_lock(&queue->lock);
+            continue;
+        }
+
+        // Um cliente que não consome os buffers não pode acumular memória sem limite
+        if (!(flags & SEND_QUEUE_UNLIMITED) && queue->queued_bytes + length > queue->max_bytes) {
+            queue->dropped = 1;
+            update_space(queue);
+            pthread_mutex_unlock(&queue->lock);
+            free(node);
+            notify(queue->wake_fd);
+            return -1;
+        }
+        break;
+    }
+
+    send_buffer_retain(buffer);
+    node->buffer = buffer;
+    node->next = NULL;
+    if (queue->tail) {
+        queue->tail->next = node;
+    } else {
+        queue->head = node;
+    }
+    queue->tail = node;
+    queue->queued_bytes += length;
+    queue->enqueued++;
+    if (flags & SEND_QUEUE_FINAL) {
+        queue->shut = 1;
+    }
+    update_space(queue);
+    pthread_mutex_unlock(&queue->lock);
+
+    notify(queue->wake_fd);
+    return 0;
+}
+
+int send_queue_shut(send_queue_t *queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    int result = queue->shut ? -1 : 0;
+    queue->shut = 1;
+    update_space(queue);
+    pthread_mutex_unlock(&queue->lock);
+
+    if (result == 0) {
+        notify(queue->wake_fd);
+    }
+    return result;
+}
+
+int send_queue_flush(send_queue_t *queue)
+{
+    // A fila é esvaziada de uma vez, mas os bytes continuam contados até a escrita
+    pthread_mutex_lock(&queue->lock);
+    send_queue_node_t *node = queue->head;
+    size_t pending = queue->queued_bytes;
+    queue->head = NULL;
+    queue->tail = NULL;
+    pthread_mutex_unlock(&queue->lock);
+
+    int result = 0;
+
+    while (node && result == 0) {
+        struct iovec iov[SEND_QUEUE_BATCH];
+        send_queue_node_t *batch = node;
+        int count = 0;
+
+        while (node && count < SEND_QUEUE_BATCH) {
+            send_buffer_t *buffer = node->buffer;
+            size_t skip = queue->strip_framing ? buffer->header_length : 0;
+            iov[count].iov_base = buffer->data + skip;
+            iov[count].iov_len = buffer_send_length(queue, buffer);
+            count++;
+            node = node->next;
+        }
+
+        struct iovec *current = iov;
+        while (count > 0) {
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = current;
+            msg.msg_iovlen = count;
+
+            ssize_t sent = socket_sendmsg(queue->socket, &msg, 0);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                result = -1;
+                break;
+            }
+
+            pthread_mutex_lock(&queue->lock);
+            queue->queued_bytes -= sent;
+            update_space(queue);
+            pthread_mutex_unlock(&queue->lock);
+            pending -= sent;
+
+            while (count > 0 && (size_t)sent >= current->iov_len) {
+                sent -= current->iov_len;
+                current++;
+                count--;
+            }
+            if (count > 0) {
+                current->iov_base = (char*)current->iov_base + sent;
+                current->iov_len -= sent;
+            }
+        }
+
+        release_nodes(batch, node);
+    }
+
+    // Buffers restantes após erro de escrita
+    if (node || pending > 0) {
+        release_nodes(node, NULL);
+        pthread_mutex_lock(&queue->lock);
+        queue->queued_bytes -= pending;
+        update_space(queue);
+        pthread_mutex_unlock(&queue->lock);
+    }
+
+    return result;
+}
+
+int send_queue_clear_wake(send_queue_t *queue)
+{
+    uint64_t counter;
+    if (read(queue->wake_fd, &counter, sizeof(counter)) < 0 && errno != EAGAIN) {
+        return -1;
+    }
+    return 0;
+}
+
+send_group_t* send_group_create(void)
+{
+    send_group_t *group = calloc(1, sizeof(send_group_t));
+    if (!group) {
+        return NULL;
+    }
+
+    pthread_mutex_init(&group->lock, NULL);
+    return group;
+}
+
+void send_group_destroy(send_group_t *group)
+{
+    if (!group) {
+        return;
+    }
+
+    pthread_mutex_destroy(&group->lock);
+    free(group->members);
+    free(group);
+}
+
+int send_group_add(send_group_t *group, send_queue_t *queue)
+{
+    if (!group || !queue) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&group->lock);
+    if (group->count == group->capacity) {
+        size_t capacity = group->capacity ? group->capacity * 2 : 16;
+        send_queue_t **members = realloc(group->members, capacity * sizeof(send_queue_t*));
+        if (!members) {
+            pthread_mutex_unlock(&group->lock);
+            return -1;
+        }
+        group->members = members;
+        group->capacity = capacity;
+    }
+    group->members[group->count++] = queue;
+    pthread_mutex_unlock(&group->lock);
+
+    return 0;
+}
+
+void send_group_remove(send_group_t *group, send_queue_t *queue)
+{
+    if (!group || !queue) {
+        return;
+    }
+
+    pthread_mutex_lock(&group->lock);
+    for (size_t i = 0; i < group->count; i++) {
+        if (group->members[i] == queue) {
+            group->members[i] = group->members[--group->count];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&group->lock);
+}
+
+int send_group_broadcast(send_group_t *group, send_buffer_t *buffer)
+{
+    if (!group || !buffer) {
+        return -1;
+    }
+
+    int delivered = 0;
+    pthread_mutex_lock(&group->lock);
+    for (size_t i = 0; i < group->count; i++) {
+        if (send_queue_push(group->members[i], buffer, 0) == 0) {
+            delivered++;
+        }
+    }
+    pthread_mutex_unlock(&group->lock);
+
+    return delivered;
+}
+
+// Implementação das funções auxiliares internas
+
+static size_t buffer_send_length(const send_queue_t *queue, const send_buffer_t *buffer)
+{
+    if (queue->strip_framing) {
+        return buffer->length - buffer->header_length - buffer->trailer_length;
+    }
+    return buffer->length;
+}
+
+// Mantém space_fd legível enquanto produtores bloqueantes podem enfileirar (chamada com o lock)
+static void update_space(send_queue_t *queue)
+{
+    if (queue->space_fd < 0) {
+        return;
+    }
+
+    int ready = queue->shut || queue->dropped || queue->queued_bytes <= queue->max_bytes / 2;
+    if (ready == queue->space_ready) {
+        return;
+    }
+
+    if (ready) {
+        notify(queue->space_fd);
+    } else {
+        uint64_t counter;
+        if (read(queue->space_fd, &counter, sizeof(counter)) < 0) {
+            // Já estava zerado
+        }
+    }
+    queue->space_ready = ready;
+}
+
+static void notify(int fd)
+{
+    uint64_t one = 1;
+    if (write(fd, &one, sizeof(one)) < 0) {
+        // Contador saturado: o aviso já está pendente
+    }
+}
+
+// Libera os nós de node até end (exclusivo)
+static void release_nodes(send_queue_node_t *node, send_queue_node_t *end)
+{
+    while (node != end) {
+        send_queue_node_t *next = node->next;
+        send_buffer_release(node->buffer);
+        free(node);
+        node = next;
+    }
+}
@@ -6,156 +6,707 @@
 #include <errno.h>
 #include <arpa/inet.h>
 #include "server.h"
+#include "httpserver.h"
 #include "socket_utils.h"
 #include "http_parser.h"
+#include "http_response.h"
+#include "response_cache.h"
+#include "proxy.h"
+#include "http2.h"
+#include "tls.h"
+#include "websocket.h"
+#include "http_stream.h"
+#include "asset_pack.h"
+#include "rate_limit.h"
+#include "capture.h"
+#include "trace.h"
+#include "coroutine.h"
 #include "config.h"
 
 #define MAX_HEADERS 50
+#define MAX_HANDLERS 64
+#define MAX_WEBSOCKET_ENDPOINTS 16
+#define MAX_UPLOAD_ENDPOINTS 16
+#define MAX_STREAM_ENDPOINTS 16
 
-// Definir a estrutura para passar dados para a thread
+// Handler registrado para um método e prefixo de caminho
+typedef struct {
+    char method[16];          // Método atendido (vazio atende qualquer método)
+    char prefix[256];         // Prefixo do caminho
+    size_t prefix_len;
+    http_handler_fn handler;
+    void *user_data;
+} handler_entry_t;
+
+// Aplicação WebSocket registrada para um prefixo de caminho
+typedef struct {
+    char prefix[256];
+    size_t prefix_len;
+    websocket_handler_t handler;
+    void *user_data;
+} websocket_entry_t;
+
+// Recebimento de uploads registrado para um prefixo de caminho
+typedef struct {
+    char prefix[256];
+    size_t prefix_len;
+    http_upload_fn handler;
+    void *user_data;
+} upload_entry_t;
+
+// Resposta em streaming registrada para um prefixo de caminho
+typedef struct {
+    char prefix[256];
+    size_t prefix_len;
+    char content_type[128];
+    http_stream_handler_t handler;
+    void *user_data;
+} stream_entry_t;
+
+// Socket de escuta e a thread que aceita suas conexões
 typedef struct {
+    http_server_t *server;
+    int socket;
+    char address[256];        // Endereço configurado (ipv4:porta, [ipv6]:porta ou unix:/caminho)
+    int unix_socket;          // O arquivo do socket é removido ao fechar
+    int tls;                  // Conexões passam pelo handshake TLS
+    int thread_started;
+    pthread_t thread;
+} listener_t;
+
+struct http_server {
+    server_config_t config;
+    proxy_t *proxy;
+    response_cache_t *cache;
+    tls_context_t *tls;
+    rate_limiter_t *limiter;
+    capture_t *capture;
+    tracer_t *tracer;
+    asset_pack_t *pack;                // Arquivos estáticos pré-compilados (asset_pack)
+    coroutine_scheduler_t *scheduler;  // NULL: uma thread por conexão
+
+    handler_entry_t handlers[MAX_HANDLERS];
+    int handler_count;
+
+    websocket_entry_t websockets[MAX_WEBSOCKET_ENDPOINTS];
+    int websocket_count;
+
+    upload_entry_t uploads[MAX_UPLOAD_ENDPOINTS];
+    int upload_count;
+
+    stream_entry_t streams[MAX_STREAM_ENDPOINTS];
+    int stream_count;
+
+    listener_t listeners[MAX_LISTENERS];
+    int listener_count;
+    int running;
+
+    // Conexões em andamento, aguardadas em http_server_stop
+    int active_connections;
+    struct client_data *clients;
+    pthread_mutex_t lock;
+    pthread_cond_t idle;
+};
+
+// Definir a estrutura para passar dados para a thread
+typedef struct client_data {
     int client_socket;
-    server_config_t *config;
+    http_server_t *server;
+    int tls;
+    char client_ip[INET6_ADDRSTRLEN];
+    struct sockaddr_storage client_addr;
+    uint64_t accepted_us;      // Instante do accept, apenas com o tracer habilitado
+    struct client_data *prev;  // Lista de conexões em andamento (server->clients)
+    struct client_data *next;
 } client_data_t;
 
+// Contexto dos streams HTTP/2 de uma conexão
+typedef struct {
+    http_server_t *server;
+    const struct sockaddr *client_addr;
+    int upgrade_counted;       // A requisição do upgrade h2c já consumiu seu token
+} h2_context_t;
+
 // Função auxiliar para enviar resposta HTTP
-static void send_http_response(int client_socket, int status_code, const char* status_text,
+static void send_http_response(int client_socket, const server_config_t *config,
+                             int status_code, const char* status_text,
                              const char* content_type, const char* body) {
-    char response[4096];
-    int response_len;
-
-    if (body) {
-        response_len = snprintf(response, sizeof(response),
-            "HTTP/1.1 %d %s\r\n"
-            "Content-Type: %s\r\n"
-            "Content-Length: %zu\r\n"
-            "\r\n"
-            "%s", status_code, status_text, content_type, strlen(body), body);
-    } else {
-        response_len = snprintf(response, sizeof(response),
-            "HTTP/1.1 %d %s\r\n"
-            "Content-Type: %s\r\n"
-            "Content-Length: 0\r\n"
-            "\r\n", status_code, status_text, content_type);
+    http_response_t response;
+    http_response_init(&response);
+    http_response_set(&response, status_code, status_text, content_type, body);
+    http_response_send(client_socket, config, &response);
+    http_response_cleanup(&response);
+}
+
+// Gera a resposta para uma requisição local (fora das rotas de proxy)
+static void dispatch_request(http_server_t *server, const http_request_t *request, http_response_t *response,
+                             request_trace_t *trace)
+{
+    const handler_entry_t *best = NULL;
+    int path_matched = 0;
+
+    for (int i = 0; i < server->handler_count; i++) {
+        const handler_entry_t *entry = &server->handlers[i];
+        if (strncmp(request->normalized_path, entry->prefix, entry->prefix_len) != 0) {
+            continue;
+        }
+        path_matched = 1;
+
+        if (entry->method[0] && strcmp(entry->method, request->method) != 0) {
+            continue;
+        }
+        if (!best || entry->prefix_len > best->prefix_len) {
+            best = entry;
+        }
+    }
+
+    if (!best) {
+        if (path_matched) {
+            http_response_set(response, 405, "Method Not Allowed", "text/plain", NULL);
+        } else {
+            http_response_set(response, 404, "Not Found", "text/plain", "Recurso não encontrado");
+        }
+        return;
     }
 
-    if (response_len > 0) {
-        send(client_socket, response, response_len, 0);
+    http_request_view_t view;
+    http_request_view_init(&view, request);
+
+    TRACE_PROBE2(handler__start, (const char*)request->method, (const char*)request->path);
+    trace_mark(trace, TRACE_HANDLER_START);
+
+    if (best->handler(&view, response, best->user_data) < 0) {
+        http_response_cleanup(response);
+        http_response_init(response);
+        http_response_set(response, 500, "Internal Server Error", "text/plain", "Erro interno do servidor");
     }
+
+    trace_mark(trace, TRACE_HANDLER_END);
+    TRACE_PROBE3(handler__end, (const char*)request->method, (const char*)request->path, response->status_code);
 }
 
-void* handle_client(void* arg)
+// Arquivo do pacote para GET e HEAD; os demais métodos seguem para os handlers
+static const asset_pack_entry_t* match_asset(const http_server_t *server, const http_request_t *request)
+{
+    if (!server->pack || (strcmp(request->method, "GET") != 0 && strcmp(request->method, "HEAD") != 0)) {
+        return NULL;
+    }
+    return asset_pack_find(server->pack, request->normalized_path);
+}
+
+// Resposta 429 de um stream HTTP/2: os headers não são copiados e precisam
+// viver até o envio, então o valor de Retry-After segue no bloco do corpo
+static void set_h2_rate_limited(http_response_t *response, int retry_after)
+{
+    static const char body[] = "Limite de requisições excedido";
+
+    http_response_set(response, 429, "Too Many Requests", "text/plain", body);
+
+    char *block = malloc(sizeof(body) + 16);
+    if (!block) {
+        return;
+    }
+    memcpy(block, body, sizeof(body));
+    char *retry = block + sizeof(body);
+    snprintf(retry, 16, "%d", retry_after);
+
+    http_response_take_body(response, block, sizeof(body) - 1, free);
+    http_response_add_header(response, "Retry-After", retry);
+}
+
+// Gera a resposta de um stream HTTP/2
+static void h2_dispatch(void *ctx, const http_request_t *request, http_response_t *response)
+{
+    h2_context_t *context = (h2_context_t*)ctx;
+    http_server_t *server = context->server;
+
+    // Cada stream conta como uma requisição; a do upgrade h2c já foi verificada em HTTP/1.1
+    if (!__atomic_exchange_n(&context->upgrade_counted, 0, __ATOMIC_RELAXED)) {
+        int retry_after = rate_limiter_check(server->limiter, RATE_LIMIT_REQUEST, context->client_addr);
+        if (retry_after > 0) {
+            set_h2_rate_limited(response, retry_after);
+            return;
+        }
+    }
+
+    // O proxy reverso repassa bytes HTTP/1.1 diretamente ao socket do cliente
+    if (proxy_match(server->proxy, request->normalized_path) >= 0) {
+        http_response_set(response, 502, "Bad Gateway", "text/plain",
+                          "Rotas de proxy não são suportadas em HTTP/2");
+        return;
+    }
+
+    const asset_pack_entry_t *asset = match_asset(server, request);
+    if (asset) {
+        asset_pack_response(server->pack, asset, request, response);
+        return;
+    }
+
+    dispatch_request(server, request, response, NULL);
+}
+
+// Procura a aplicação WebSocket de maior prefixo que atende o caminho
+static const websocket_entry_t* match_websocket(const http_server_t *server, const char *path)
+{
+    const websocket_entry_t *best = NULL;
+
+    for (int i = 0; i < server->websocket_count; i++) {
+        const websocket_entry_t *entry = &server->websockets[i];
+        if (strncmp(path, entry->prefix, entry->prefix_len) == 0 &&
+            (!best || entry->prefix_len > best->prefix_len)) {
+            best = entry;
+        }
+    }
+    return best;
+}
+
+// Procura o recebimento de uploads de maior prefixo que atende o caminho
+static const upload_entry_t* match_upload(const http_server_t *server, const char *path)
+{
+    const upload_entry_t *best = NULL;
+
+    for (int i = 0; i < server->upload_count; i++) {
+        const upload_entry_t *entry = &server->uploads[i];
+        if (strncmp(path, entry->prefix, entry->prefix_len) == 0 &&
+            (!best || entry->prefix_len > best->prefix_len)) {
+            best = entry;
+        }
+    }
+    return best;
+}
+
+// Procura a resposta em streaming de maior prefixo que atende o caminho
+static const stream_entry_t* match_stream(const http_server_t *server, const char *path)
+{
+    const stream_entry_t *best = NULL;
+
+    for (int i = 0; i < server->stream_count; i++) {
+        const stream_entry_t *entry = &server->streams[i];
+        if (strncmp(path, entry->prefix, entry->prefix_len) == 0 &&
+            (!best || entry->prefix_len > best->prefix_len)) {
+            best = entry;
+        }
+    }
+    return best;
+}
+
+// Recebe o corpo multipart em disco e chama a aplicação. Retorna o código de status enviado.
+static int serve_upload(http_server_t *server, int client_socket, const http_request_t *request,
+                        const char *initial, size_t initial_length, const upload_entry_t *entry,
+                        request_trace_t *trace)
+{
+    http_response_t response;
+    http_response_init(&response);
+
+    int status = 500;
+    multipart_upload_t *upload = malloc(sizeof(multipart_upload_t));
+    if (!upload) {
+        perror("Erro ao alocar upload");
+    } else if (multipart_upload_receive(client_socket, &server->config, request, initial, initial_length,
+                                        upload, &status) == 0) {
+        http_request_view_t view;
+        http_request_view_init(&view, request);
+
+        TRACE_PROBE2(handler__start, (const char*)request->method, (const char*)request->path);
+        trace_mark(trace, TRACE_HANDLER_START);
+
+        status = entry->handler(&view, upload, &response, entry->user_data) < 0 ? 500 : 0;
+        multipart_upload_cleanup(upload);
+
+        trace_mark(trace, TRACE_HANDLER_END);
+        TRACE_PROBE3(handler__end, (const char*)request->method, (const char*)request->path, status);
+    }
+    free(upload);
+
+    if (status != 0) {
+        const char *message = status == 411 ? "Content-Length obrigatório" :
+                              status == 413 ? "Upload excede o limite permitido" :
+                              status == 415 ? "Esperado multipart/form-data" :
+                              status == 400 ? "Corpo multipart inválido" : "Erro ao receber o upload";
+        http_response_cleanup(&response);
+        http_response_init(&response);
+        http_response_set(&response, status, http_status_text(status), "text/plain", message);
+    }
+
+    http_response_send(client_socket, &server->config, &response);
+    status = response.status_code;
+    http_response_cleanup(&response);
+    return status;
+}
+
+// Atende a requisição pelo microcache: um hit é enviado com um único send do
+// buffer serializado; em um miss apenas uma thread executa o handler.
+// Retorna o código de status enviado.
+static int serve_cached(http_server_t *server, int client_socket, const http_request_t *request,
+                        request_trace_t *trace)
+{
+    response_cache_t *cache = server->cache;
+    int is_filler = 0;
+    cache_entry_t *entry = response_cache_acquire(cache, request, &is_filler);
+    size_t length = 0;
+
+    if (entry && !is_filler) {
+        const char *data = response_cache_data(entry, &length);
+        http_send_all(client_socket, data, length);
+        response_cache_release(cache, entry);
+        return 200;  // Apenas respostas 200 são armazenadas
+    }
+
+    http_response_t response;
+    http_response_init(&response);
+    dispatch_request(server, request, &response, trace);
+    response.omit_body = strcmp(request->method, "HEAD") == 0;
+
+    char *data = http_response_serialize(&response, &length);
+    int status = response.status_code;
+    int cacheable = data && status == 200 && response_cache_storable(&response);
+    http_response_cleanup(&response);
+
+    if (!entry) {
+        if (data) {
+            http_send_all(client_socket, data, length);
+        }
+        free(data);
+        return status;
+    }
+
+    // Se o cache assume o buffer, a referência mantém a entrada viva durante o envio
+    int stored = response_cache_complete(cache, entry, cacheable ? data : NULL, length);
+    if (data) {
+        http_send_all(client_socket, data, length);
+    }
+    if (!stored) {
+        free(data);
+    }
+
+    response_cache_release(cache, entry);
+    return status;
+}
+
+// Registra o envio da resposta nos probes e no tracer
+static void finish_request(client_data_t *client_data, request_trace_t *trace,
+                           const http_request_t *request, int status)
+{
+    trace_mark(trace, TRACE_SENT);
+    TRACE_PROBE2(response__sent, client_data->client_socket, status);
+    tracer_finish(client_data->server->tracer, trace, request, status, client_data->client_ip);
+}
+
+// Recebe, interpreta e responde a requisição de uma conexão
+static void process_connection(client_data_t *client_data)
 {
-    // Recebe a conexão do cliente
-    client_data_t* client_data = (client_data_t*)arg;
     int client_socket = client_data->client_socket;
-    server_config_t* config = client_data->config;
+    http_server_t *server = client_data->server;
+    server_config_t *config = &server->config;
+
+    request_trace_t trace;
+    tracer_begin(server->tracer, &trace, client_data->accepted_us);
 
     // Aloca buffer para receber os dados
     char* buffer = malloc(config->buffer_size);
     if (!buffer) {
         perror("Erro ao alocar buffer");
-        close(client_socket);
-        free(client_data);
-        pthread_exit(NULL);
+        return;
     }
     memset(buffer, 0, config->buffer_size);
 
     // Inicializa a estrutura da requisição HTTP
     http_request_t request;
     if (http_request_init(&request, MAX_HEADERS) != HTTP_PARSE_OK) {
-        send_http_response(client_socket, 500, "Internal Server Error", 
+        send_http_response(client_socket, config, 500, "Internal Server Error",
                          "text/plain", "Erro ao inicializar parser");
         free(buffer);
-        free(client_data);
-        close(client_socket);
-        pthread_exit(NULL);
+        return;
+    }
+
+    // O corpo aponta para o buffer de recepção, sem cópia
+    request.borrow_body = 1;
+
+    h2_context_t h2_context = { server, (const struct sockaddr*)&client_data->client_addr, 0 };
+
+    // HTTP/2 negociado via ALPN dispensa o prefácio como forma de detecção
+    if (config->http2_enabled && tls_session_is_h2(tls_session_get(client_socket))) {
+        http2_serve_connection(client_socket, config, NULL, 0, NULL, h2_dispatch, &h2_context);
+        http_request_cleanup(&request);
+        free(buffer);
+        return;
     }
 
     // Recebe a requisição do cliente
-    ssize_t bytes_received = recv(client_socket, buffer, config->buffer_size - 1, 0);
+    ssize_t bytes_received = socket_recv(client_socket, buffer, config->buffer_size - 1, 0);
 
     if (bytes_received < 0) {
         perror("Erro ao receber dados do cliente");
         http_request_cleanup(&request);
         free(buffer);
-        close(client_socket);
-        free(client_data);
-        pthread_exit(NULL);
+        return;
     }
 
+    trace_mark(&trace, TRACE_RECEIVED);
     printf("Requisição recebida de tamanho: %zd bytes\n", bytes_received);
 
+    // Conexão HTTP/2 com conhecimento prévio: o prefácio substitui a linha de requisição
+    if (config->http2_enabled && http2_is_preface(buffer, bytes_received)) {
+        http2_serve_connection(client_socket, config, buffer, bytes_received, NULL, h2_dispatch, &h2_context);
+        http_request_cleanup(&request);
+        free(buffer);
+        return;
+    }
+
+    // A captura grava exatamente os bytes entregues ao parser, inclusive requisições inválidas
+    capture_record(server->capture, buffer, bytes_received);
+
     // Parse da requisição HTTP
     int parse_result = parse_http_request(&request, buffer, bytes_received);
-    
+    trace_mark(&trace, TRACE_PARSED);
+
     if (parse_result != HTTP_PARSE_OK) {
-        send_http_response(client_socket, 400, "Bad Request", 
+        send_http_response(client_socket, config, 400, "Bad Request",
                          "text/plain", "Requisição inválida");
+        finish_request(client_data, &trace, NULL, 400);
         http_request_cleanup(&request);
         free(buffer);
-        close(client_socket);
-        free(client_data);
-        pthread_exit(NULL);
+        return;
     }
 
-    printf("Método: %s, Caminho: %s, Versão: %s\n", 
+    printf("Método: %s, Caminho: %s, Versão: %s\n",
            request.method, request.path, request.version);
 
-    // Processa a requisição
-    if (strcmp(request.method, "GET") == 0) {
-        const char* body = "<html><body><h1>Olá, Mundo!</h1></body></html>";
-        send_http_response(client_socket, 200, "OK", "text/html", body);
-    } 
-    else if (strcmp(request.method, "POST") == 0) {
-        // Verifica se há corpo na requisição
-        if (request.body && request.body_length > 0) {
-            printf("Corpo da requisição recebido: %zu bytes\n", request.body_length);
-            send_http_response(client_socket, 200, "OK", 
-                             "text/plain", "Dados recebidos com sucesso");
-        } else {
-            send_http_response(client_socket, 400, "Bad Request", 
-                             "text/plain", "Corpo da requisição vazio");
-        }
+    // Cliente acima do limite é rejeitado antes de qualquer handler, upgrade ou proxy
+    int retry_after = rate_limiter_check(server->limiter, RATE_LIMIT_REQUEST,
+                                         (const struct sockaddr*)&client_data->client_addr);
+    if (retry_after > 0) {
+        char retry[16];
+        snprintf(retry, sizeof(retry), "%d", retry_after);
+
+        http_response_t response;
+        http_response_init(&response);
+        http_response_set(&response, 429, "Too Many Requests", "text/plain", "Limite de requisições excedido");
+        http_response_add_header(&response, "Retry-After", retry);
+        response.omit_body = strcmp(request.method, "HEAD") == 0;
+        http_response_send(client_socket, config, &response);
+        http_response_cleanup(&response);
+        finish_request(client_data, &trace, &request, 429);
+        http_request_cleanup(&request);
+        free(buffer);
+        return;
     }
-    else {
-        send_http_response(client_socket, 405, "Method Not Allowed", 
-                         "text/plain", NULL);
+
+    // Upgrade para h2c: a resposta da requisição original segue no stream 1
+    if (config->http2_enabled && http2_is_upgrade_request(&request)) {
+        h2_context.upgrade_counted = 1;
+        http2_serve_connection(client_socket, config, buffer + request.header_length,
+                               bytes_received - request.header_length, &request, h2_dispatch, &h2_context);
+        http_request_cleanup(&request);
+        free(buffer);
+        return;
     }
 
+    // Upgrade para WebSocket: a conexão passa a ser atendida pela aplicação registrada
+    const websocket_entry_t *websocket = websocket_is_upgrade_request(&request) ?
+                                         match_websocket(server, request.normalized_path) : NULL;
+    if (websocket) {
+        websocket_serve(client_socket, config, &request, buffer + request.header_length,
+                        bytes_received - request.header_length, &websocket->handler, websocket->user_data);
+        http_request_cleanup(&request);
+        free(buffer);
+        return;
+    }
+
+    // Respostas em streaming ocupam a conexão até o fim ou a desconexão do cliente
+    const stream_entry_t *stream = strcmp(request.method, "GET") == 0 ?
+                                   match_stream(server, request.normalized_path) : NULL;
+    if (stream) {
+        int sent = http_stream_serve(client_socket, config, &request, stream->content_type,
+                                     &stream->handler, stream->user_data);
+        finish_request(client_data, &trace, &request, sent < 0 ? 0 : sent);
+        http_request_cleanup(&request);
+        free(buffer);
+        return;
+    }
+
+    // Rotas de proxy reverso têm precedência sobre os handlers locais
+    int status = 0;  // O status de respostas do upstream não é conhecido
+    const upload_entry_t *upload = strcmp(request.method, "POST") == 0 ?
+                                   match_upload(server, request.normalized_path) : NULL;
+    int proxy_route = upload ? -1 : proxy_match(server->proxy, request.normalized_path);
+    const asset_pack_entry_t *asset = upload || proxy_route >= 0 ? NULL : match_asset(server, &request);
+    if (upload) {
+        status = serve_upload(server, client_socket, &request, buffer + request.header_length,
+                              bytes_received - request.header_length, upload, &trace);
+    } else if (proxy_route >= 0) {
+        proxy_handle_request(server->proxy, proxy_route, client_socket, client_data->client_ip,
+                             &request, buffer, bytes_received);
+    } else if (asset) {
+        // Arquivos do pacote não passam pelo microcache: o corpo já está no page cache
+        status = asset_pack_serve(client_socket, server->pack, asset, &request);
+        status = status < 0 ? 0 : status;
+    } else if (response_cache_accepts(server->cache, &request)) {
+        status = serve_cached(server, client_socket, &request, &trace);
+    } else {
+        http_response_t response;
+        http_response_init(&response);
+        dispatch_request(server, &request, &response, &trace);
+        response.omit_body = strcmp(request.method, "HEAD") == 0;
+        http_response_send(client_socket, config, &response);
+        status = response.status_code;
+        http_response_cleanup(&response);
+    }
+
+    finish_request(client_data, &trace, &request, status);
+
     // Limpa recursos
     http_request_cleanup(&request);
     free(buffer);
-    close(client_socket);
+}
+
+void* handle_client(void* arg)
+{
+    // Recebe a conexão do cliente
+    client_data_t* client_data = (client_data_t*)arg;
+    http_server_t *server = client_data->server;
+
+    // O handshake ocorre na thread da conexão para não atrasar o accept
+    if (!client_data->tls || tls_session_accept(server->tls, client_data->client_socket)) {
+        process_connection(client_data);
+        tls_session_close(client_data->client_socket);
+    }
+
+    TRACE_PROBE1(conn__close, client_data->client_socket);
+
+    pthread_mutex_lock(&server->lock);
+    if (client_data->prev) {
+        client_data->prev->next = client_data->next;
+    } else {
+        server->clients = client_data->next;
+    }
+    if (client_data->next) {
+        client_data->next->prev = client_data->prev;
+    }
+    close(client_data->client_socket);
     free(client_data);
-    pthread_exit(NULL);
+
+    if (--server->active_connections == 0) {
+        pthread_cond_broadcast(&server->idle);
+    }
+    pthread_mutex_unlock(&server->lock);
+
+    return NULL;
 }
 
-void start_server(int port, server_config_t *config)
+static void client_coroutine(void *arg)
 {
-    int server_socket = create_server_socket(port, config);
+    handle_client(arg);
+}
 
-    if (server_socket < 0) {
-        fprintf(stderr, "Erro ao criar o socket do servidor\n");
-        exit(EXIT_FAILURE);
+// Inicia o atendimento da conexão em uma corrotina ou em uma thread própria
+static int start_client(http_server_t *server, client_data_t *client_data)
+{
+    if (server->scheduler) {
+        // Os wrappers de socket_utils suspendem a corrotina em vez de bloquear
+        if (set_socket_non_blocking(client_data->client_socket) < 0) {
+            return -1;
+        }
+        return coroutine_spawn(server->scheduler, client_coroutine, client_data);
+    }
+
+    pthread_t thread_id;
+    if (pthread_create(&thread_id, NULL, handle_client, client_data) != 0) {
+        perror("Erro ao criar a thread");
+        return -1;
+    }
+    pthread_detach(thread_id);
+    return 0;
+}
+
+// Escreve o IP do cliente e retorna a porta; IPv4 mapeado em IPv6 (listener
+// dual-stack) é convertido para AF_INET, para que o rate limit agrupe o
+// cliente pelo prefixo IPv4. Clientes de sockets Unix aparecem como "unix".
+static int format_client_address(struct sockaddr_storage *addr, char *ip, size_t size)
+{
+    if (addr->ss_family == AF_INET6) {
+        struct sockaddr_in6 *in6 = (struct sockaddr_in6*)addr;
+        if (IN6_IS_ADDR_V4MAPPED(&in6->sin6_addr)) {
+            struct sockaddr_in in;
+            memset(&in, 0, sizeof(in));
+            in.sin_family = AF_INET;
+            in.sin_port = in6->sin6_port;
+            memcpy(&in.sin_addr, &in6->sin6_addr.s6_addr[12], sizeof(in.sin_addr));
+            memset(addr, 0, sizeof(*addr));
+            memcpy(addr, &in, sizeof(in));
+        } else {
+            inet_ntop(AF_INET6, &in6->sin6_addr, ip, size);
+            return ntohs(in6->sin6_port);
+        }
+    }
+
+    if (addr->ss_family == AF_INET) {
+        struct sockaddr_in *in = (struct sockaddr_in*)addr;
+        inet_ntop(AF_INET, &in->sin_addr, ip, size);
+        return ntohs(in->sin_port);
+    }
+
+    snprintf(ip, size, "unix");
+    return 0;
+}
+
+// Recusa uma conexão acima do limite sem criar thread; a resposta cabe no
+// buffer de envio vazio, portanto o envio não bloqueia o accept
+static void reject_connection(int client_socket, int tls, int retry_after)
+{
+    if (!tls) {
+        char response[160];
+        int length = snprintf(response, sizeof(response),
+                              "HTTP/1.1 429 Too Many Requests\r\n"
+                              "Retry-After: %d\r\n"
+                              "Content-Length: 0\r\n"
+                              "Connection: close\r\n"
+                              "\r\n", retry_after);
+        socket_send(client_socket, response, length, MSG_DONTWAIT);
     }
+    close(client_socket);
+}
 
-    printf("Servidor HTTP ouvindo na porta %d\n", port);
+// Loop principal: aceita conexões e inicia o atendimento de cada cliente
+static void accept_loop(listener_t *listener)
+{
+    http_server_t *server = listener->server;
+    server_config_t *config = &server->config;
 
     while (1)
     {
-        struct sockaddr_in client_addr;
+        struct sockaddr_storage client_addr;
         socklen_t client_len = sizeof(client_addr);
-        int client_socket = accept(server_socket, (struct sockaddr*)&client_addr, &client_len);
+        int client_socket = accept(listener->socket, (struct sockaddr*)&client_addr, &client_len);
 
         if (client_socket < 0) {
+            pthread_mutex_lock(&server->lock);
+            int running = server->running;
+            pthread_mutex_unlock(&server->lock);
+            if (!running) {
+                break;
+            }
             perror("Erro ao aceitar a conexão");
             continue;
         }
+        uint64_t accepted_us = server->tracer ? trace_now_us() : 0;
+
+        char client_ip[INET6_ADDRSTRLEN];
+        int client_port = format_client_address(&client_addr, client_ip, sizeof(client_ip));
+
+        int retry_after = rate_limiter_check(server->limiter, RATE_LIMIT_CONNECTION,
+                                             (const struct sockaddr*)&client_addr);
+        if (retry_after > 0) {
+            reject_connection(client_socket, listener->tls, retry_after);
+            continue;
+        }
 
-        printf("Conexão aceita de %s:%d\n", 
-               inet_ntoa(client_addr.sin_addr), 
-               ntohs(client_addr.sin_port));
+        if (listener->unix_socket) {
+            printf("Conexão aceita em %s\n", listener->address);
+        } else {
+            configure_client_socket(client_socket, config);
+            printf("Conexão aceita de %s:%d\n", client_ip, client_port);
+        }
 
         // Aloca e inicializa a estrutura client_data
         client_data_t *client_data = malloc(sizeof(client_data_t));
@@ -164,21 +715,503 @@ void start_server(int port, server_config_t *config)
             close(client_socket);
             continue;
         }
-        
+
         client_data->client_socket = client_socket;
-        client_data->config = config;
+        client_data->server = server;
+        client_data->tls = listener->tls;
+        memcpy(client_data->client_ip, client_ip, sizeof(client_ip));
+        memcpy(&client_data->client_addr, &client_addr, sizeof(client_addr));
+        client_data->accepted_us = accepted_us;
+
+        TRACE_PROBE2(conn__accept, client_socket, (const char*)client_data->client_ip);
 
-        pthread_t thread_id;
+        pthread_mutex_lock(&server->lock);
+        server->active_connections++;
+        client_data->prev = NULL;
+        client_data->next = server->clients;
+        if (server->clients) {
+            server->clients->prev = client_data;
+        }
+        server->clients = client_data;
+        pthread_mutex_unlock(&server->lock);
 
-        if (pthread_create(&thread_id, NULL, handle_client, client_data) != 0) {
-            perror("Erro ao criar a thread");
+        if (start_client(server, client_data) < 0) {
+            pthread_mutex_lock(&server->lock);
+            server->clients = client_data->next;
+            if (client_data->next) {
+                client_data->next->prev = NULL;
+            }
+            server->active_connections--;
+            pthread_mutex_unlock(&server->lock);
             free(client_data);
             close(client_socket);
             continue;
         }
+    }
+}
+
+static void* accept_thread_main(void *arg)
+{
+    accept_loop((listener_t*)arg);
+    return NULL;
+}
+
+// Fecha os sockets de escuta abertos
+static void close_listeners(http_server_t *server)
+{
+    for (int i = 0; i < server->listener_count; i++) {
+        listener_t *listener = &server->listeners[i];
+        if (listener->socket >= 0) {
+            close(listener->socket);
+            listener->socket = -1;
+            if (listener->unix_socket) {
+                unlink(listener->address + 5);
+            }
+        }
+    }
+    server->listener_count = 0;
+}
+
+// Abre os sockets de escuta e marca o servidor como em execução; sem
+// listeners configurados, usa port e tls_port em todos os endereços IPv4
+static int open_listeners(http_server_t *server)
+{
+    listener_config_t defaults[2];
+    const listener_config_t *configured = server->config.listeners;
+    int count = server->config.listener_count;
+
+    if (count == 0) {
+        memset(defaults, 0, sizeof(defaults));
+        snprintf(defaults[0].address, sizeof(defaults[0].address), "0.0.0.0:%d", server->config.port);
+        snprintf(defaults[1].address, sizeof(defaults[1].address), "0.0.0.0:%d", server->config.tls_port);
+        defaults[1].tls = 1;
+        configured = defaults;
+        count = server->config.tls_port > 0 ? 2 : 1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        listener_t *listener = &server->listeners[i];
+        memset(listener, 0, sizeof(*listener));
+        listener->server = server;
+        strncpy(listener->address, configured[i].address, sizeof(listener->address) - 1);
+        listener->unix_socket = strncmp(listener->address, "unix:", 5) == 0;
+        listener->tls = configured[i].tls;
+        listener->socket = create_listener_socket(&configured[i], &server->config);
+
+        if (listener->socket < 0) {
+            fprintf(stderr, "Erro ao criar o socket do servidor\n");
+            close_listeners(server);
+            return -1;
+        }
+        server->listener_count++;
+
+        printf("Servidor %s ouvindo em %s\n", listener->tls ? "HTTPS" : "HTTP", listener->address);
+    }
+
+    pthread_mutex_lock(&server->lock);
+    server->running = 1;
+    pthread_mutex_unlock(&server->lock);
+
+    return 0;
+}
+
+// Cria as threads de accept dos listeners a partir de first
+static int start_listener_threads(http_server_t *server, int first)
+{
+    for (int i = first; i < server->listener_count; i++) {
+        listener_t *listener = &server->listeners[i];
+        if (pthread_create(&listener->thread, NULL, accept_thread_main, listener) != 0) {
+            perror("Erro ao criar a thread de accept");
+            return -1;
+        }
+        listener->thread_started = 1;
+    }
+    return 0;
+}
+
+http_server_t* http_server_create(const server_config_t *config)
+{
+    if (!config) {
+        return NULL;
+    }
+
+    http_server_t *server = calloc(1, sizeof(http_server_t));
+    if (!server) {
+        perror("Erro ao alocar servidor");
+        return NULL;
+    }
+
+    server->config = *config;
+    pthread_mutex_init(&server->lock, NULL);
+    pthread_cond_init(&server->idle, NULL);
+
+    // Proxy reverso é opcional; proxy_create retorna NULL se não houver rotas
+    server->proxy = proxy_create(&server->config);
+    if (server->config.proxy_route_count > 0 && !server->proxy) {
+        fprintf(stderr, "Erro ao inicializar o proxy reverso\n");
+        http_server_destroy(server);
+        return NULL;
+    }
+
+    server->cache = response_cache_create(&server->config);
+    if (server->config.cache_enabled && !server->cache) {
+        fprintf(stderr, "Erro ao inicializar o cache de respostas\n");
+        http_server_destroy(server);
+        return NULL;
+    }
+
+    server->limiter = rate_limiter_create(&server->config);
+    if ((server->config.rate_limit_requests > 0 || server->config.rate_limit_connections > 0) &&
+        !server->limiter) {
+        fprintf(stderr, "Erro ao inicializar o limite de taxa\n");
+        http_server_destroy(server);
+        return NULL;
+    }
+
+    if (server->config.asset_pack[0]) {
+        server->pack = asset_pack_open(server->config.asset_pack);
+        if (!server->pack) {
+            http_server_destroy(server);
+            return NULL;
+        }
+    }
+
+    if (server->config.capture_file[0]) {
+        server->capture = capture_open(&server->config);
+        if (!server->capture) {
+            http_server_destroy(server);
+            return NULL;
+        }
+    }
+
+    if (server->config.trace_slow_ms > 0) {
+        server->tracer = tracer_create(&server->config);
+        if (!server->tracer) {
+            http_server_destroy(server);
+            return NULL;
+        }
+    }
+
+    if (server->config.coroutine_workers > 0) {
+        server->scheduler = coroutine_scheduler_create(server->config.coroutine_workers,
+                                                       server->config.coroutine_stack_size);
+        if (!server->scheduler) {
+            fprintf(stderr, "Erro ao inicializar as corrotinas\n");
+            http_server_destroy(server);
+            return NULL;
+        }
+    }
+
+    if (config_tls_enabled(&server->config)) {
+        server->tls = tls_context_create(&server->config);
+        if (!server->tls) {
+            fprintf(stderr, "Erro ao inicializar o TLS\n");
+            http_server_destroy(server);
+            return NULL;
+        }
+    }
+
+    return server;
+}
 
-        pthread_detach(thread_id);
+int http_server_add_handler(http_server_t *server, const char *method, const char *path_prefix,
+                            http_handler_fn handler, void *user_data)
+{
+    if (!server || !path_prefix || !handler || server->handler_count >= MAX_HANDLERS) {
+        return -1;
+    }
+
+    if (strlen(path_prefix) >= sizeof(server->handlers[0].prefix) ||
+        (method && strlen(method) >= sizeof(server->handlers[0].method))) {
+        return -1;
+    }
+
+    handler_entry_t *entry = &server->handlers[server->handler_count];
+    memset(entry, 0, sizeof(*entry));
+    if (method) {
+        strcpy(entry->method, method);
+    }
+    strcpy(entry->prefix, path_prefix);
+    entry->prefix_len = strlen(path_prefix);
+    entry->handler = handler;
+    entry->user_data = user_data;
+
+    server->handler_count++;
+    return 0;
+}
+
+int http_server_add_websocket(http_server_t *server, const char *path_prefix,
+                              const websocket_handler_t *handler, void *user_data)
+{
+    if (!server || !path_prefix || !handler || server->websocket_count >= MAX_WEBSOCKET_ENDPOINTS ||
+        strlen(path_prefix) >= sizeof(server->websockets[0].prefix)) {
+        return -1;
+    }
+
+    websocket_entry_t *entry = &server->websockets[server->websocket_count];
+    strcpy(entry->prefix, path_prefix);
+    entry->prefix_len = strlen(path_prefix);
+    entry->handler = *handler;
+    entry->user_data = user_data;
+
+    server->websocket_count++;
+    return 0;
+}
+
+int http_server_add_upload(http_server_t *server, const char *path_prefix,
+                           http_upload_fn handler, void *user_data)
+{
+    if (!server || !path_prefix || !handler || server->upload_count >= MAX_UPLOAD_ENDPOINTS ||
+        strlen(path_prefix) >= sizeof(server->uploads[0].prefix)) {
+        return -1;
+    }
+
+    upload_entry_t *entry = &server->uploads[server->upload_count];
+    strcpy(entry->prefix, path_prefix);
+    entry->prefix_len = strlen(path_prefix);
+    entry->handler = handler;
+    entry->user_data = user_data;
+
+    server->upload_count++;
+    return 0;
+}
+
+int http_server_add_stream(http_server_t *server, const char *path_prefix, const char *content_type,
+                           const http_stream_handler_t *handler, void *user_data)
+{
+    if (!server || !path_prefix || !content_type || !handler || server->stream_count >= MAX_STREAM_ENDPOINTS ||
+        strlen(path_prefix) >= sizeof(server->streams[0].prefix) ||
+        strlen(content_type) >= sizeof(server->streams[0].content_type)) {
+        return -1;
     }
 
-    close(server_socket);
-}
\ No newline at end of file
+    stream_entry_t *entry = &server->streams[server->stream_count];
+    strcpy(entry->prefix, path_prefix);
+    entry->prefix_len = strlen(path_prefix);
+    strcpy(entry->content_type, content_type);
+    entry->handler = *handler;
+    entry->user_data = user_data;
+
+    server->stream_count++;
+    return 0;
+}
+
+int http_server_start(http_server_t *server)
+{
+    if (!server || open_listeners(server) < 0) {
+        return -1;
+    }
+
+    if (start_listener_threads(server, 0) < 0) {
+        http_server_stop(server);
+        return -1;
+    }
+
+    return 0;
+}
+
+int http_server_run(http_server_t *server)
+{
+    if (!server || open_listeners(server) < 0) {
+        return -1;
+    }
+
+    // O primeiro listener é atendido na thread atual
+    if (start_listener_threads(server, 1) < 0) {
+        http_server_stop(server);
+        return -1;
+    }
+
+    accept_loop(&server->listeners[0]);
+    return 0;
+}
+
+void http_server_stop(http_server_t *server)
+{
+    if (!server) {
+        return;
+    }
+
+    // shutdown desbloqueia o accept em andamento
+    pthread_mutex_lock(&server->lock);
+    server->running = 0;
+    for (int i = 0; i < server->listener_count; i++) {
+        shutdown(server->listeners[i].socket, SHUT_RDWR);
+    }
+    pthread_mutex_unlock(&server->lock);
+
+    for (int i = 0; i < server->listener_count; i++) {
+        if (server->listeners[i].thread_started) {
+            pthread_join(server->listeners[i].thread, NULL);
+            server->listeners[i].thread_started = 0;
+        }
+    }
+
+    // Conexões longas (HTTP/2, WebSocket) terminam ao ler fim de arquivo
+    pthread_mutex_lock(&server->lock);
+    for (client_data_t *client = server->clients; client; client = client->next) {
+        shutdown(client->client_socket, SHUT_RD);
+    }
+    while (server->active_connections > 0) {
+        pthread_cond_wait(&server->idle, &server->lock);
+    }
+    pthread_mutex_unlock(&server->lock);
+
+    close_listeners(server);
+}
+
+void http_server_destroy(http_server_t *server)
+{
+    if (!server) {
+        return;
+    }
+
+    // Encerra os workers antes de liberar o que as corrotinas ainda usam
+    coroutine_scheduler_destroy(server->scheduler);
+    tls_context_destroy(server->tls);
+    rate_limiter_destroy(server->limiter);
+    capture_close(server->capture);
+    tracer_destroy(server->tracer);
+    asset_pack_close(server->pack);
+    response_cache_destroy(server->cache);
+    proxy_destroy(server->proxy);
+    pthread_cond_destroy(&server->idle);
+    pthread_mutex_destroy(&server->lock);
+    free(server);
+}
+
+// Handlers padrão do executável http_server
+
+static int default_get_handler(const http_request_view_t *request, http_response_t *response, void *user_data)
+{
+    (void)request;
+    (void)user_data;
+
+    const char* body = "<html><body><h1>Olá, Mundo!</h1></body></html>";
+    http_response_set(response, 200, "OK", "text/html", body);
+    return 0;
+}
+
+static int default_post_handler(const http_request_view_t *request, http_response_t *response, void *user_data)
+{
+    (void)user_data;
+
+    // Verifica se há corpo na requisição
+    if (request->body.data && request->body.length > 0) {
+        printf("Corpo da requisição recebido: %zu bytes\n", request->body.length);
+        http_response_set(response, 200, "OK",
+                         "text/plain", "Dados recebidos com sucesso");
+    } else {
+        http_response_set(response, 400, "Bad Request",
+                         "text/plain", "Corpo da requisição vazio");
+    }
+    return 0;
+}
+
+// Upload de demonstração em /upload: lista as partes recebidas (os arquivos são descartados)
+static int upload_summary_handler(const http_request_view_t *request, const multipart_upload_t *upload,
+                                  http_response_t *response, void *user_data)
+{
+    (void)request;
+    (void)user_data;
+
+    size_t capacity = 64 + upload->part_count * (2 * MULTIPART_NAME_MAX + 64);
+    char *body = malloc(capacity);
+    if (!body) {
+        return -1;
+    }
+
+    size_t length = snprintf(body, capacity, "%zu partes, %zu bytes\n", upload->part_count, upload->total_size);
+    for (size_t i = 0; i < upload->part_count; i++) {
+        const multipart_part_t *part = &upload->parts[i];
+        length += snprintf(body + length, capacity - length, "%s%s%s: %zu bytes\n", part->info.name,
+                           part->info.has_filename ? " -> " : "", part->info.filename, part->size);
+    }
+
+    http_response_take_body(response, body, length, free);
+    return 0;
+}
+
+// Chat de demonstração em /ws: cada mensagem é retransmitida a todos os participantes
+// e, como evento Server-Sent Events, aos ouvintes de /events
+
+typedef struct {
+    websocket_group_t *members;
+    http_stream_group_t *listeners;
+} chat_room_t;
+
+static int chat_open(websocket_t *ws, const http_request_view_t *request, void *user_data)
+{
+    (void)request;
+    return websocket_group_add(((chat_room_t*)user_data)->members, ws);
+}
+
+static void chat_message(websocket_t *ws, websocket_opcode_t opcode, const char *data, size_t length,
+                         void *user_data)
+{
+    (void)ws;
+    chat_room_t *room = (chat_room_t*)user_data;
+    websocket_group_broadcast(room->members, opcode, data, length);
+
+    if (opcode == WS_OPCODE_TEXT) {
+        http_stream_chunk_t *event = http_stream_event_create("message", NULL, data, length);
+        if (event) {
+            http_stream_group_broadcast(room->listeners, event);
+            http_stream_chunk_release(event);
+        }
+    }
+}
+
+static void chat_close(websocket_t *ws, int code, void *user_data)
+{
+    (void)code;
+    websocket_group_remove(((chat_room_t*)user_data)->members, ws);
+}
+
+static int listener_open(http_stream_t *stream, const http_request_view_t *request, void *user_data)
+{
+    (void)request;
+    return http_stream_group_add(((chat_room_t*)user_data)->listeners, stream);
+}
+
+static void listener_close(http_stream_t *stream, void *user_data)
+{
+    http_stream_group_remove(((chat_room_t*)user_data)->listeners, stream);
+}
+
+void start_server(int port, server_config_t *config)
+{
+    server_config_t server_config = *config;
+    server_config.port = port;
+
+    http_server_t *server = http_server_create(&server_config);
+    if (!server) {
+        fprintf(stderr, "Erro ao criar o servidor\n");
+        exit(EXIT_FAILURE);
+    }
+
+    http_server_add_handler(server, "GET", "/", default_get_handler, NULL);
+    http_server_add_handler(server, "POST", "/", default_post_handler, NULL);
+
+    http_server_add_upload(server, "/upload", upload_summary_handler, NULL);
+
+    chat_room_t chat = { websocket_group_create(), http_stream_group_create() };
+    websocket_handler_t chat_handler = { chat_open, chat_message, chat_close };
+    http_stream_handler_t listener_handler = { listener_open, NULL, listener_close };
+    if (chat.members && chat.listeners) {
+        http_server_add_websocket(server, "/ws", &chat_handler, &chat);
+        http_server_add_stream(server, "/events", "text/event-stream", &listener_handler, &chat);
+    }
+
+    if (http_server_run(server) < 0) {
+        http_server_destroy(server);
+        websocket_group_destroy(chat.members);
+        http_stream_group_destroy(chat.listeners);
+        exit(EXIT_FAILURE);
+    }
+
+    http_server_stop(server);
+    http_server_destroy(server);
+    websocket_group_destroy(chat.members);
+    http_stream_group_destroy(chat.listeners);
+}
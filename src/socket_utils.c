@@ -4,11 +4,25 @@
 #include <unistd.h>
 #include <errno.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <fcntl.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netdb.h>
 #include <sys/time.h>
+#include <sys/sendfile.h>
 #include "socket_utils.h"
 #include "config.h"
+#include "coroutine.h"
+#include "tls.h"
+
+// Funções auxiliares internas
+static int open_listening_socket(const struct sockaddr *addr, socklen_t addr_len, int ipv6_only,
+                                 server_config_t *config);
+static int unix_socket_stale(const struct sockaddr_un *addr);
+static int wait_retry(int fd, short events, int flags);
+static ssize_t send_remaining(int fd, const struct msghdr *msg, size_t sent, int flags);
 
 int create_server_socket(int port, server_config_t *config)
 {
@@ -17,11 +31,350 @@ int create_server_socket(int port, server_config_t *config)
         return -1;
     }
 
-    int sockfd;
+    // Prepara o endereço do servidor
     struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons(port);
+
+    return open_listening_socket((struct sockaddr*)&server_addr, sizeof(server_addr), 0, config);
+}
+
+int create_listener_socket(const listener_config_t *listener, server_config_t *config)
+{
+    if (!listener || !config) {
+        fprintf(stderr, "Configuração inválida\n");
+        return -1;
+    }
+
+    struct sockaddr_storage addr;
+    memset(&addr, 0, sizeof(addr));
+
+    if (strncmp(listener->address, "unix:", 5) == 0) {
+        struct sockaddr_un *un = (struct sockaddr_un*)&addr;
+        const char *path = listener->address + 5;
+        if (strlen(path) == 0 || strlen(path) >= sizeof(un->sun_path)) {
+            fprintf(stderr, "Caminho de socket Unix inválido: %s\n", path);
+            return -1;
+        }
+        un->sun_family = AF_UNIX;
+        strcpy(un->sun_path, path);
+
+        // Remove o socket deixado por uma execução anterior, mas nunca outro tipo de arquivo
+        struct stat st;
+        if (lstat(path, &st) == 0) {
+            if (!S_ISSOCK(st.st_mode)) {
+                fprintf(stderr, "%s já existe e não é um socket\n", path);
+                return -1;
+            }
+            if (unix_socket_stale(un) < 0) {
+                return -1;
+            }
+            unlink(path);
+        }
+
+        int sockfd = open_listening_socket((struct sockaddr*)un, sizeof(*un), 0, config);
+        if (sockfd >= 0 && chmod(path, listener->mode) < 0) {
+            perror("Erro ao definir as permissões do socket Unix");
+            close(sockfd);
+            unlink(path);
+            return -1;
+        }
+        return sockfd;
+    }
+
+    // ipv4:porta ou [ipv6]:porta; o host deve ser um endereço numérico
+    char host[INET6_ADDRSTRLEN];
+    const char *port;
+    const char *address = listener->address;
+    size_t host_len;
+    if (address[0] == '[') {
+        const char *close_bracket = strchr(address, ']');
+        if (!close_bracket || close_bracket[1] != ':') {
+            fprintf(stderr, "Endereço de escuta inválido: %s\n", address);
+            return -1;
+        }
+        address++;
+        host_len = close_bracket - address;
+        port = close_bracket + 2;
+    } else {
+        const char *colon = strrchr(address, ':');
+        if (!colon) {
+            fprintf(stderr, "Endereço de escuta inválido: %s\n", address);
+            return -1;
+        }
+        host_len = colon - address;
+        port = colon + 1;
+    }
+    if (host_len == 0 || host_len >= sizeof(host)) {
+        fprintf(stderr, "Endereço de escuta inválido: %s\n", listener->address);
+        return -1;
+    }
+    memcpy(host, address, host_len);
+    host[host_len] = '\0';
+
+    struct addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST | AI_NUMERICSERV;
+
+    int error = getaddrinfo(host, port, &hints, &result);
+    if (error != 0) {
+        fprintf(stderr, "Endereço de escuta inválido: %s (%s)\n", listener->address, gai_strerror(error));
+        return -1;
+    }
+
+    memcpy(&addr, result->ai_addr, result->ai_addrlen);
+    socklen_t addr_len = result->ai_addrlen;
+    freeaddrinfo(result);
+
+    return open_listening_socket((struct sockaddr*)&addr, addr_len, listener->ipv6_only, config);
+}
+
+int configure_client_socket(int client_fd, const server_config_t *config)
+{
+    if (!config) {
+        return -1;
+    }
+
+    if (config->tcp_nodelay) {
+        int opt = 1;
+        if (setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt)) < 0) {
+            perror("Erro ao configurar TCP_NODELAY");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int set_socket_buffers(int socket_fd, int send_size, int recv_size)
+{
+    if (send_size > 0 &&
+        setsockopt(socket_fd, SOL_SOCKET, SO_SNDBUF, &send_size, sizeof(send_size)) < 0) {
+        perror("Erro ao configurar SO_SNDBUF");
+        return -1;
+    }
+
+    if (recv_size > 0 &&
+        setsockopt(socket_fd, SOL_SOCKET, SO_RCVBUF, &recv_size, sizeof(recv_size)) < 0) {
+        perror("Erro ao configurar SO_RCVBUF");
+        return -1;
+    }
+
+    return 0;
+}
+
+int set_socket_non_blocking(int socket_fd)
+{
+    int flags = fcntl(socket_fd, F_GETFL, 0);
+    if (flags == -1) {
+        perror("Erro ao obter flags do socket");
+        return -1;
+    }
+
+    if (fcntl(socket_fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+        perror("Erro ao configurar socket não-bloqueante");
+        return -1;
+    }
+
+    return 0;
+}
+
+int set_socket_timeout(int socket_fd, int seconds, int microseconds)
+{
+    struct timeval tv;
+    tv.tv_sec = seconds;
+    tv.tv_usec = microseconds;
+
+    if (setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0 ||
+        setsockopt(socket_fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) < 0) {
+        perror("Erro ao configurar timeouts do socket");
+        return -1;
+    }
+
+    return 0;
+}
+
+ssize_t socket_recv(int fd, void *buffer, size_t length, int flags)
+{
+    tls_session_t *session = tls_session_get(fd);
+    if (session) {
+        // Mesmo com kTLS de recepção o OpenSSL trata os registros de controle
+        return tls_session_recv(session, buffer, length);
+    }
+
+    ssize_t n;
+    while ((n = recv(fd, buffer, length, flags)) < 0 && wait_retry(fd, POLLIN, flags)) {
+    }
+    return n;
+}
+
+size_t socket_pending(int fd)
+{
+    tls_session_t *session = tls_session_get(fd);
+    return session ? tls_session_pending(session) : 0;
+}
+
+ssize_t socket_send(int fd, const void *data, size_t length, int flags)
+{
+    tls_session_t *session = tls_session_get(fd);
+    if (session && !tls_session_kernel_send(session)) {
+        return tls_session_send(session, data, length);
+    }
+
+    // Em sockets não-bloqueantes o envio é concluído esperando o socket,
+    // preservando a semântica de envio completo dos sockets bloqueantes
+    size_t total = 0;
+    while (total < length) {
+        ssize_t n = send(fd, (const char*)data + total, length - total, flags | MSG_NOSIGNAL);
+        if (n < 0) {
+            if (wait_retry(fd, POLLOUT, flags)) {
+                continue;
+            }
+            return total > 0 ? (ssize_t)total : -1;
+        }
+        total += n;
+        if (flags & MSG_DONTWAIT) {
+            break;
+        }
+    }
+    return total;
+}
+
+ssize_t socket_sendmsg(int fd, const struct msghdr *msg, int flags)
+{
+    tls_session_t *session = tls_session_get(fd);
+    if (session && !tls_session_kernel_send(session)) {
+        return tls_session_sendv(session, msg->msg_iov, msg->msg_iovlen);
+    }
+
+    ssize_t n;
+    while ((n = sendmsg(fd, msg, flags | MSG_NOSIGNAL)) < 0 && wait_retry(fd, POLLOUT, flags)) {
+    }
+    if (n < 0 || (flags & MSG_DONTWAIT)) {
+        return n;
+    }
+    return send_remaining(fd, msg, n, flags);
+}
+
+ssize_t socket_sendfile(int out_fd, int in_fd, off_t *offset, size_t count)
+{
+    if (socket_kernel_send(out_fd)) {
+        ssize_t n;
+        while ((n = sendfile(out_fd, in_fd, offset, count)) < 0 && wait_retry(out_fd, POLLOUT, 0)) {
+        }
+        return n;
+    }
+
+    // TLS em espaço de usuário: o arquivo precisa passar pelo OpenSSL
+    char buffer[16384];
+    size_t total = 0;
+
+    while (total < count) {
+        size_t chunk = count - total < sizeof(buffer) ? count - total : sizeof(buffer);
+        ssize_t n = pread(in_fd, buffer, chunk, *offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        if (socket_send(out_fd, buffer, n, 0) < 0) {
+            return total > 0 ? (ssize_t)total : -1;
+        }
+        *offset += n;
+        total += n;
+    }
+
+    return total;
+}
+
+int socket_kernel_recv(int fd)
+{
+    tls_session_t *session = tls_session_get(fd);
+    return !session || tls_session_kernel_recv(session);
+}
+
+int socket_kernel_send(int fd)
+{
+    tls_session_t *session = tls_session_get(fd);
+    return !session || tls_session_kernel_send(session);
+}
+
+int socket_poll(struct pollfd *fds, nfds_t nfds, int timeout_ms)
+{
+    return coroutine_poll(fds, nfds, timeout_ms);
+}
+
+int socket_wait(int fd, short events)
+{
+    // Sockets bloqueantes já esperaram no kernel pelo timeout configurado
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || !(flags & O_NONBLOCK)) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    return socket_wait_timeout(fd, events);
+}
+
+int socket_wait_timeout(int fd, short events)
+{
+    // O timeout do socket (SO_RCVTIMEO/SO_SNDTIMEO) limita a espera, como no modo bloqueante
+    int timeout_ms = -1;
+    struct timeval tv;
+    socklen_t len = sizeof(tv);
+    if (getsockopt(fd, SOL_SOCKET, (events & POLLOUT) ? SO_SNDTIMEO : SO_RCVTIMEO, &tv, &len) == 0 &&
+        (tv.tv_sec > 0 || tv.tv_usec > 0)) {
+        timeout_ms = tv.tv_sec * 1000 + tv.tv_usec / 1000;
+    }
+
+    struct pollfd pfd = { .fd = fd, .events = events };
+    int ready;
+    while ((ready = socket_poll(&pfd, 1, timeout_ms)) < 0 && errno == EINTR) {
+    }
+
+    if (ready == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    return ready < 0 ? -1 : 0;
+}
+
+int socket_connect(int fd, const struct sockaddr *addr, socklen_t length)
+{
+    if (connect(fd, addr, length) == 0) {
+        return 0;
+    }
+    if (errno != EINPROGRESS || socket_wait(fd, POLLOUT) < 0) {
+        return -1;
+    }
+
+    int error = 0;
+    socklen_t error_length = sizeof(error);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &error_length) < 0) {
+        return -1;
+    }
+    if (error) {
+        errno = error;
+        return -1;
+    }
+    return 0;
+}
+
+// Implementação das funções auxiliares internas
+
+// Cria o socket, aplica as opções da configuração, faz o bind e o listen
+static int open_listening_socket(const struct sockaddr *addr, socklen_t addr_len, int ipv6_only,
+                                 server_config_t *config)
+{
+    int sockfd;
 
     // Cria o socket do servidor
-    sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    sockfd = socket(addr->sa_family, SOCK_STREAM, 0);
     if (sockfd < 0) {
         perror("Erro ao criar o socket do servidor");
         return -1;
@@ -35,6 +388,16 @@ int create_server_socket(int port, server_config_t *config)
         return -1;
     }
 
+    // Define o dual-stack explicitamente: o padrão depende de net.ipv6.bindv6only
+    if (addr->sa_family == AF_INET6) {
+        int v6only = ipv6_only ? 1 : 0;
+        if (setsockopt(sockfd, IPPROTO_IPV6, IPV6_V6ONLY, &v6only, sizeof(v6only)) < 0) {
+            perror("Erro ao configurar IPV6_V6ONLY");
+            close(sockfd);
+            return -1;
+        }
+    }
+
     // Configura timeouts se especificados
     if (config->timeout_seconds > 0 || config->timeout_microseconds > 0) {
         struct timeval tv;
@@ -57,19 +420,39 @@ int create_server_socket(int port, server_config_t *config)
         }
     }
 
-    // Prepara o endereço do servidor
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(port);
+    // Buffers do socket de escuta são herdados pelos sockets aceitos; o
+    // SO_RCVBUF precisa ser definido antes do listen para afetar o window scaling
+    if (set_socket_buffers(sockfd, config->send_buffer_size, config->recv_buffer_size) < 0) {
+        close(sockfd);
+        return -1;
+    }
 
     // Associa o socket ao endereço
-    if (bind(sockfd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+    if (bind(sockfd, addr, addr_len) < 0) {
         perror("Erro ao associar o socket ao endereço");
         close(sockfd);
         return -1;
     }
 
+    // As opções de TCP não se aplicam a sockets Unix
+    if (addr->sa_family != AF_UNIX) {
+        // Só acorda o accept quando já houver dados da requisição disponíveis
+        if (config->tcp_defer_accept > 0) {
+            int defer = config->tcp_defer_accept;
+            if (setsockopt(sockfd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &defer, sizeof(defer)) < 0) {
+                perror("Erro ao configurar TCP_DEFER_ACCEPT");
+            }
+        }
+
+        // TCP Fast Open permite receber a requisição já no SYN
+        if (config->tcp_fastopen > 0) {
+            int qlen = config->tcp_fastopen;
+            if (setsockopt(sockfd, IPPROTO_TCP, TCP_FASTOPEN, &qlen, sizeof(qlen)) < 0) {
+                perror("Erro ao configurar TCP_FASTOPEN");
+            }
+        }
+    }
+
     // Coloca o socket em modo de escuta
     if (listen(sockfd, config->backlog) < 0) {
         perror("Erro ao escutar as conexões");
@@ -80,33 +463,67 @@ int create_server_socket(int port, server_config_t *config)
     return sockfd;
 }
 
-int set_socket_non_blocking(int socket_fd)
+// Só um socket sem ninguém escutando pode ser removido: a conexão recusada indica
+// que o processo que o criou terminou. Qualquer outro resultado mantém o arquivo
+static int unix_socket_stale(const struct sockaddr_un *addr)
 {
-    int flags = fcntl(socket_fd, F_GETFL, 0);
-    if (flags == -1) {
-        perror("Erro ao obter flags do socket");
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe < 0) {
+        perror("Erro ao verificar o socket Unix");
         return -1;
     }
 
-    if (fcntl(socket_fd, F_SETFL, flags | O_NONBLOCK) == -1) {
-        perror("Erro ao configurar socket não-bloqueante");
+    int result = connect(probe, (const struct sockaddr*)addr, sizeof(*addr));
+    int error = errno;
+    close(probe);
+
+    if (result == 0) {
+        fprintf(stderr, "%s já está em uso por outro processo\n", addr->sun_path);
+        return -1;
+    }
+    if (error != ECONNREFUSED) {
+        fprintf(stderr, "Não foi possível verificar %s: %s\n", addr->sun_path, strerror(error));
         return -1;
     }
-
     return 0;
 }
 
-int set_socket_timeout(int socket_fd, int seconds, int microseconds)
+// Decide se uma chamada que falhou deve ser repetida após aguardar o socket
+static int wait_retry(int fd, short events, int flags)
 {
-    struct timeval tv;
-    tv.tv_sec = seconds;
-    tv.tv_usec = microseconds;
+    if (errno == EINTR) {
+        return 1;
+    }
+    if (errno != EAGAIN || (flags & MSG_DONTWAIT)) {
+        return 0;
+    }
+    return socket_wait(fd, events) == 0;
+}
 
-    if (setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0 ||
-        setsockopt(socket_fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) < 0) {
-        perror("Erro ao configurar timeouts do socket");
-        return -1;
+// Conclui um sendmsg parcial enviando o restante de cada buffer
+static ssize_t send_remaining(int fd, const struct msghdr *msg, size_t sent, int flags)
+{
+    size_t skip = sent;
+    size_t total = sent;
+
+    for (size_t i = 0; i < msg->msg_iovlen; i++) {
+        const struct iovec *iov = &msg->msg_iov[i];
+        if (skip >= iov->iov_len) {
+            skip -= iov->iov_len;
+            continue;
+        }
+
+        size_t length = iov->iov_len - skip;
+        ssize_t n = socket_send(fd, (const char*)iov->iov_base + skip, length, flags);
+        if (n < 0) {
+            return total;
+        }
+        total += n;
+        if ((size_t)n < length) {
+            break;
+        }
+        skip = 0;
     }
 
-    return 0;
-}
\ No newline at end of file
+    return total;
+}
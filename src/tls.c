@@ -0,0 +1,494 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/uio.h>
+#include "tls.h"
+#include "socket_utils.h"
+
+#ifdef HAVE_OPENSSL
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+// Tamanho máximo do texto claro de um registro TLS
+#define TLS_RECORD_SIZE 16384
+// Limite da tabela descritor -> sessão
+#define TLS_MAX_DESCRIPTORS (1 << 20)
+
+struct tls_context {
+    SSL_CTX *ctx;
+    int http2;                // Anuncia h2 no ALPN
+};
+
+struct tls_session {
+    SSL *ssl;
+    int fd;
+    int h2;                   // ALPN negociou h2
+    int kernel_send;          // kTLS de transmissão ativo
+    int kernel_recv;          // kTLS de recepção ativo
+    pthread_mutex_t lock;     // Serializa SSL_read e SSL_write (streams HTTP/2)
+    unsigned char record[TLS_RECORD_SIZE];
+};
+
+// Sessões indexadas pelo descritor; cada entrada só é alterada pela thread da conexão
+static tls_session_t **sessions = NULL;
+static size_t session_slots = 0;
+static pthread_once_t sessions_once = PTHREAD_ONCE_INIT;
+
+// Funções auxiliares internas
+static void init_session_table(void);
+static int alpn_select(SSL *ssl, const unsigned char **out, unsigned char *out_length,
+                       const unsigned char *in, unsigned int in_length, void *arg);
+static void print_ssl_error(const char *message);
+
+tls_context_t* tls_context_create(const server_config_t *config)
+{
+    if (!config) {
+        return NULL;
+    }
+
+    pthread_once(&sessions_once, init_session_table);
+    if (!sessions) {
+        fprintf(stderr, "Erro ao alocar a tabela de sessões TLS\n");
+        return NULL;
+    }
+
+    // O OpenSSL escreve no socket com write(); um cliente que fecha a conexão
+    // não pode derrubar o processo com SIGPIPE
+    struct sigaction current;
+    if (sigaction(SIGPIPE, NULL, &current) == 0 && current.sa_handler == SIG_DFL) {
+        signal(SIGPIPE, SIG_IGN);
+    }
+
+    tls_context_t *context = calloc(1, sizeof(tls_context_t));
+    if (!context) {
+        perror("Erro ao alocar contexto TLS");
+        return NULL;
+    }
+
+    context->ctx = SSL_CTX_new(TLS_server_method());
+    if (!context->ctx) {
+        print_ssl_error("Erro ao criar contexto TLS");
+        free(context);
+        return NULL;
+    }
+
+    SSL_CTX *ctx = context->ctx;
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+
+    if (SSL_CTX_use_certificate_chain_file(ctx, config->tls_certificate) != 1) {
+        print_ssl_error("Erro ao carregar tls_certificate");
+        tls_context_destroy(context);
+        return NULL;
+    }
+
+    if (SSL_CTX_use_PrivateKey_file(ctx, config->tls_private_key, SSL_FILETYPE_PEM) != 1 ||
+        SSL_CTX_check_private_key(ctx) != 1) {
+        print_ssl_error("Erro ao carregar tls_private_key");
+        tls_context_destroy(context);
+        return NULL;
+    }
+
+    // Cache de sessões no servidor, compartilhado por todas as threads de conexão
+    static const unsigned char session_id_context[] = "libhttpserver";
+    SSL_CTX_set_session_id_context(ctx, session_id_context, sizeof(session_id_context) - 1);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ctx, config->tls_session_cache_size);
+    SSL_CTX_set_timeout(ctx, config->tls_session_timeout);
+
+    // Sem tickets a retomada usa apenas o cache (inclusive em TLS 1.3)
+    if (!config->tls_session_tickets) {
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+    }
+
+    // kTLS é habilitado após o handshake quando o kernel suporta a cifra negociada
+    if (config->tls_ktls) {
+        SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+    }
+
+    // Clientes que fecham sem close_notify são tratados como fim de conexão normal
+    SSL_CTX_set_options(ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+    SSL_CTX_set_mode(ctx, SSL_MODE_RELEASE_BUFFERS);
+
+    context->http2 = config->http2_enabled;
+    SSL_CTX_set_alpn_select_cb(ctx, alpn_select, context);
+
+    return context;
+}
+
+void tls_context_destroy(tls_context_t *context)
+{
+    if (!context) {
+        return;
+    }
+
+    SSL_CTX_free(context->ctx);
+    free(context);
+}
+
+tls_session_t* tls_session_accept(tls_context_t *context, int fd)
+{
+    if (!context || fd < 0 || (size_t)fd >= session_slots) {
+        return NULL;
+    }
+
+    tls_session_t *session = malloc(sizeof(tls_session_t));
+    if (!session) {
+        perror("Erro ao alocar sessão TLS");
+        return NULL;
+    }
+
+    memset(session, 0, offsetof(tls_session_t, record));
+    session->fd = fd;
+    session->ssl = SSL_new(context->ctx);
+    if (!session->ssl || SSL_set_fd(session->ssl, fd) != 1) {
+        print_ssl_error("Erro ao criar sessão TLS");
+        SSL_free(session->ssl);
+        free(session);
+        return NULL;
+    }
+
+    // Em sockets não-bloqueantes (corrotinas) o handshake aguarda o socket entre as etapas
+    int result;
+    while ((result = SSL_accept(session->ssl)) != 1) {
+        int error = SSL_get_error(session->ssl, result);
+        if ((error == SSL_ERROR_SYSCALL && errno == EINTR) ||
+            (error == SSL_ERROR_WANT_READ && socket_wait(fd, POLLIN) == 0) ||
+            (error == SSL_ERROR_WANT_WRITE && socket_wait(fd, POLLOUT) == 0)) {
+            continue;
+        }
+        break;
+    }
+
+    if (result != 1) {
+        print_ssl_error("Falha no handshake TLS");
+        SSL_free(session->ssl);
+        free(session);
+        return NULL;
+    }
+
+    const unsigned char *protocol = NULL;
+    unsigned int protocol_length = 0;
+    SSL_get0_alpn_selected(session->ssl, &protocol, &protocol_length);
+    session->h2 = protocol_length == 2 && memcmp(protocol, "h2", 2) == 0;
+    session->kernel_send = BIO_get_ktls_send(SSL_get_wbio(session->ssl));
+    session->kernel_recv = BIO_get_ktls_recv(SSL_get_rbio(session->ssl));
+    pthread_mutex_init(&session->lock, NULL);
+
+    sessions[fd] = session;
+    return session;
+}
+
+void tls_session_close(int fd)
+{
+    tls_session_t *session = tls_session_get(fd);
+    if (!session) {
+        return;
+    }
+
+    sessions[fd] = NULL;
+
+    // close_notify sem aguardar a resposta do cliente
+    SSL_shutdown(session->ssl);
+    SSL_free(session->ssl);
+    pthread_mutex_destroy(&session->lock);
+    free(session);
+}
+
+tls_session_t* tls_session_get(int fd)
+{
+    if (fd < 0 || (size_t)fd >= session_slots) {
+        return NULL;
+    }
+    return sessions[fd];
+}
+
+int tls_session_is_h2(const tls_session_t *session)
+{
+    return session && session->h2;
+}
+
+int tls_session_kernel_send(const tls_session_t *session)
+{
+    return session && session->kernel_send;
+}
+
+int tls_session_kernel_recv(const tls_session_t *session)
+{
+    return session && session->kernel_recv;
+}
+
+size_t tls_session_pending(tls_session_t *session)
+{
+    pthread_mutex_lock(&session->lock);
+    int pending = SSL_pending(session->ssl);
+    pthread_mutex_unlock(&session->lock);
+    return pending > 0 ? (size_t)pending : 0;
+}
+
+ssize_t tls_session_recv(tls_session_t *session, void *buffer, size_t length)
+{
+    if (length == 0) {
+        return 0;
+    }
+
+    // Em HTTP/2 outras threads escrevem na mesma sessão: aguarda dados sem
+    // segurar o lock, para que SSL_read não bloqueie os envios. A espera
+    // respeita o timeout do socket, como a leitura em texto puro
+    if (tls_session_pending(session) == 0 && socket_wait_timeout(session->fd, POLLIN) < 0) {
+        return -1;
+    }
+
+    int n;
+    int error;
+    while (1) {
+        pthread_mutex_lock(&session->lock);
+        errno = 0;
+        n = SSL_read(session->ssl, buffer, length > INT32_MAX ? INT32_MAX : (int)length);
+        error = n > 0 ? SSL_ERROR_NONE : SSL_get_error(session->ssl, n);
+        pthread_mutex_unlock(&session->lock);
+
+        // Socket não-bloqueante com registro incompleto: aguarda o restante sem o lock
+        if ((error == SSL_ERROR_SYSCALL && errno == EINTR) ||
+            (error == SSL_ERROR_WANT_READ && socket_wait(session->fd, POLLIN) == 0)) {
+            continue;
+        }
+        break;
+    }
+
+    if (n > 0) {
+        return n;
+    }
+    if (error == SSL_ERROR_ZERO_RETURN || (error == SSL_ERROR_SYSCALL && errno == 0)) {
+        return 0;
+    }
+    if (error != SSL_ERROR_SYSCALL) {
+        ERR_clear_error();
+        errno = EIO;
+    }
+    return -1;
+}
+
+// Escreve todos os bytes; o chamador deve possuir session->lock
+static int write_all_locked(tls_session_t *session, const void *data, size_t length)
+{
+    const char *p = data;
+
+    while (length > 0) {
+        int chunk = length > INT32_MAX ? INT32_MAX : (int)length;
+        errno = 0;
+        int n = SSL_write(session->ssl, p, chunk);
+        if (n <= 0) {
+            int error = SSL_get_error(session->ssl, n);
+            // Com socket não-bloqueante o lock continua retido durante a espera,
+            // pois SSL_write deve ser repetido com o mesmo buffer
+            if ((error == SSL_ERROR_SYSCALL && errno == EINTR) ||
+                (error == SSL_ERROR_WANT_WRITE && socket_wait(session->fd, POLLOUT) == 0) ||
+                (error == SSL_ERROR_WANT_READ && socket_wait(session->fd, POLLIN) == 0)) {
+                continue;
+            }
+            if (error != SSL_ERROR_SYSCALL) {
+                ERR_clear_error();
+                errno = EIO;
+            }
+            return -1;
+        }
+        p += n;
+        length -= n;
+    }
+
+    return 0;
+}
+
+ssize_t tls_session_send(tls_session_t *session, const void *data, size_t length)
+{
+    pthread_mutex_lock(&session->lock);
+    int result = write_all_locked(session, data, length);
+    pthread_mutex_unlock(&session->lock);
+    return result < 0 ? -1 : (ssize_t)length;
+}
+
+ssize_t tls_session_sendv(tls_session_t *session, const struct iovec *iov, size_t iov_count)
+{
+    size_t total = 0;
+    size_t staged = 0;
+    int result = 0;
+
+    pthread_mutex_lock(&session->lock);
+
+    // Buffers pequenos (header + corpo curto) são agrupados em um único registro
+    for (size_t i = 0; i < iov_count && result == 0; i++) {
+        const char *data = iov[i].iov_base;
+        size_t length = iov[i].iov_len;
+        total += length;
+
+        while (length > 0 && result == 0) {
+            if (staged == 0 && length >= TLS_RECORD_SIZE) {
+                result = write_all_locked(session, data, length);
+                break;
+            }
+
+            size_t take = TLS_RECORD_SIZE - staged;
+            if (take > length) {
+                take = length;
+            }
+            memcpy(session->record + staged, data, take);
+            staged += take;
+            data += take;
+            length -= take;
+
+            if (staged == TLS_RECORD_SIZE) {
+                result = write_all_locked(session, session->record, staged);
+                staged = 0;
+            }
+        }
+    }
+
+    if (result == 0 && staged > 0) {
+        result = write_all_locked(session, session->record, staged);
+    }
+
+    pthread_mutex_unlock(&session->lock);
+    return result < 0 ? -1 : (ssize_t)total;
+}
+
+// Implementação das funções auxiliares internas
+
+static void init_session_table(void)
+{
+    struct rlimit limit;
+    size_t slots = 1024;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur > slots) {
+        slots = limit.rlim_cur;
+    }
+    if (slots > TLS_MAX_DESCRIPTORS) {
+        slots = TLS_MAX_DESCRIPTORS;
+    }
+
+    sessions = calloc(slots, sizeof(tls_session_t*));
+    if (sessions) {
+        session_slots = slots;
+    }
+}
+
+static int alpn_select(SSL *ssl, const unsigned char **out, unsigned char *out_length,
+                       const unsigned char *in, unsigned int in_length, void *arg)
+{
+    (void)ssl;
+    tls_context_t *context = (tls_context_t*)arg;
+
+    static const unsigned char with_h2[] = "\x02h2\x08http/1.1";
+    static const unsigned char http1_only[] = "\x08http/1.1";
+    const unsigned char *server_protocols = context->http2 ? with_h2 : http1_only;
+    unsigned int server_length = context->http2 ? sizeof(with_h2) - 1 : sizeof(http1_only) - 1;
+
+    if (SSL_select_next_proto((unsigned char**)out, out_length, server_protocols, server_length,
+                              in, in_length) != OPENSSL_NPN_NEGOTIATED) {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+    return SSL_TLSEXT_ERR_OK;
+}
+
+static void print_ssl_error(const char *message)
+{
+    unsigned long error = ERR_get_error();
+    if (error) {
+        fprintf(stderr, "%s: %s\n", message, ERR_reason_error_string(error));
+    } else {
+        fprintf(stderr, "%s\n", message);
+    }
+    ERR_clear_error();
+}
+
+#else // HAVE_OPENSSL
+
+tls_context_t* tls_context_create(const server_config_t *config)
+{
+    (void)config;
+    fprintf(stderr, "Servidor compilado sem suporte a TLS (OpenSSL)\n");
+    return NULL;
+}
+
+void tls_context_destroy(tls_context_t *context)
+{
+    (void)context;
+}
+
+tls_session_t* tls_session_accept(tls_context_t *context, int fd)
+{
+    (void)context;
+    (void)fd;
+    return NULL;
+}
+
+void tls_session_close(int fd)
+{
+    (void)fd;
+}
+
+tls_session_t* tls_session_get(int fd)
+{
+    (void)fd;
+    return NULL;
+}
+
+int tls_session_is_h2(const tls_session_t *session)
+{
+    (void)session;
+    return 0;
+}
+
+int tls_session_kernel_send(const tls_session_t *session)
+{
+    (void)session;
+    return 0;
+}
+
+int tls_session_kernel_recv(const tls_session_t *session)
+{
+    (void)session;
+    return 0;
+}
+
+size_t tls_session_pending(tls_session_t *session)
+{
+    (void)session;
+    return 0;
+}
+
+ssize_t tls_session_recv(tls_session_t *session, void *buffer, size_t length)
+{
+    (void)session;
+    (void)buffer;
+    (void)length;
+    errno = ENOTSUP;
+    return -1;
+}
+
+ssize_t tls_session_send(tls_session_t *session, const void *data, size_t length)
+{
+    (void)session;
+    (void)data;
+    (void)length;
+    errno = ENOTSUP;
+    return -1;
+}
+
+ssize_t tls_session_sendv(tls_session_t *session, const struct iovec *iov, size_t iov_count)
+{
+    (void)session;
+    (void)iov;
+    (void)iov_count;
+    errno = ENOTSUP;
+    return -1;
+}
+
+#endif // HAVE_OPENSSL
@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "trace.h"
+
+struct tracer {
+    FILE *file;
+    pthread_mutex_t lock;     // Serializa as linhas gravadas no arquivo
+    uint64_t threshold_us;
+    unsigned int sample_rate; // Rastreia 1 a cada sample_rate requisições
+    unsigned int counter;     // Atômico
+};
+
+// Nome de cada etapa na saída, indexado pelo instante em que ela termina
+static const char *span_names[TRACE_POINT_COUNT] = {
+    "accept", "recv", "parse", "dispatch", "handler", "send"
+};
+
+// Funções auxiliares internas
+static void write_json_string(FILE *file, const char *value);
+
+tracer_t* tracer_create(const server_config_t *config)
+{
+    if (!config || config->trace_slow_ms <= 0) {
+        return NULL;
+    }
+
+    tracer_t *tracer = calloc(1, sizeof(tracer_t));
+    if (!tracer) {
+        perror("Erro ao alocar tracer");
+        return NULL;
+    }
+
+    tracer->file = fopen(config->trace_file, "a");
+    if (!tracer->file) {
+        perror("Erro ao abrir arquivo de trace");
+        free(tracer);
+        return NULL;
+    }
+
+    pthread_mutex_init(&tracer->lock, NULL);
+    tracer->threshold_us = (uint64_t)config->trace_slow_ms * 1000;
+    tracer->sample_rate = config->trace_sample_rate;
+
+    printf("Requisições acima de %d ms serão gravadas em %s\n", config->trace_slow_ms, config->trace_file);
+    return tracer;
+}
+
+void tracer_destroy(tracer_t *tracer)
+{
+    if (!tracer) {
+        return;
+    }
+
+    fclose(tracer->file);
+    pthread_mutex_destroy(&tracer->lock);
+    free(tracer);
+}
+
+void tracer_begin(tracer_t *tracer, request_trace_t *trace, uint64_t accepted_us)
+{
+    memset(trace, 0, sizeof(*trace));
+    if (!tracer) {
+        return;
+    }
+
+    unsigned int count = __atomic_fetch_add(&tracer->counter, 1, __ATOMIC_RELAXED);
+    if (count % tracer->sample_rate != 0) {
+        return;
+    }
+
+    trace->active = 1;
+    trace->points[TRACE_ACCEPTED] = accepted_us ? accepted_us : trace_now_us();
+}
+
+void tracer_finish(tracer_t *tracer, request_trace_t *trace, const http_request_t *request,
+                   int status, const char *client_ip)
+{
+    if (!tracer || !trace->active) {
+        return;
+    }
+
+    // A última etapa registrada encerra a requisição (ex: falha de parse)
+    uint64_t end = 0;
+    for (int i = TRACE_POINT_COUNT - 1; i > TRACE_ACCEPTED && !end; i--) {
+        end = trace->points[i];
+    }
+    uint64_t total = end ? end - trace->points[TRACE_ACCEPTED] : 0;
+    if (total < tracer->threshold_us) {
+        return;
+    }
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    pthread_mutex_lock(&tracer->lock);
+    fprintf(tracer->file, "{\"time\":%ld.%03ld,\"client\":", (long)now.tv_sec, (long)now.tv_usec / 1000);
+    write_json_string(tracer->file, client_ip);
+    fprintf(tracer->file, ",\"method\":");
+    write_json_string(tracer->file, request ? request->method : "");
+    fprintf(tracer->file, ",\"path\":");
+    write_json_string(tracer->file, request ? request->path : "");
+    fprintf(tracer->file, ",\"status\":%d,\"total_us\":%llu,\"spans_us\":{", status, (unsigned long long)total);
+
+    // Cada etapa é medida desde a anterior que ocorreu
+    uint64_t previous = trace->points[TRACE_ACCEPTED];
+    int first = 1;
+    for (int i = TRACE_ACCEPTED + 1; i < TRACE_POINT_COUNT; i++) {
+        if (!trace->points[i]) {
+            continue;
+        }
+        fprintf(tracer->file, "%s\"%s\":%llu", first ? "" : ",", span_names[i],
+                (unsigned long long)(trace->points[i] - previous));
+        previous = trace->points[i];
+        first = 0;
+    }
+
+    fprintf(tracer->file, "}}\n");
+    fflush(tracer->file);
+    pthread_mutex_unlock(&tracer->lock);
+}
+
+// Implementação das funções auxiliares internas
+
+static void write_json_string(FILE *file, const char *value)
+{
+    fputc('"', file);
+    for (const unsigned char *p = (const unsigned char*)value; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fputc('\\', file);
+            fputc(*p, file);
+        } else if (*p < 0x20) {
+            fprintf(file, "\\u%04x", *p);
+        } else {
+            fputc(*p, file);
+        }
+    }
+    fputc('"', file);
+}
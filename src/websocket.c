@@ -0,0 +1,751 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include "websocket.h"
+#include "http_response.h"
+#include "socket_utils.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_MAX_HEADER 14          // Header de frame do cliente: 2 + 8 (tamanho) + 4 (máscara)
+#define WS_MAX_CONTROL_PAYLOAD 125
+#define WS_CLOSE_TIMEOUT_MS 5000  // Espera pelo close do cliente após enviarmos o nosso
+
+struct websocket {
+    send_queue_t queue;       // Frames pendentes; shut quando o close é enfileirado
+};
+
+// Funções auxiliares internas
+static void sha1(const unsigned char *data, size_t length, unsigned char digest[20]);
+static void base64_encode(const unsigned char *data, size_t length, char *out);
+static int header_has_token(const http_request_t *request, const char *name, const char *token);
+static void unmask_payload(unsigned char *data, size_t length, const unsigned char mask[4]);
+static int utf8_valid(const unsigned char *data, size_t length);
+static int valid_close_code(int code);
+
+int websocket_is_upgrade_request(const http_request_t *request)
+{
+    if (!request) {
+        return 0;
+    }
+
+    return header_has_token(request, "Upgrade", "websocket") &&
+           header_has_token(request, "Connection", "upgrade");
+}
+
+int websocket_serve(int client_socket, const server_config_t *config, const http_request_t *request,
+                    const char *initial, size_t initial_length,
+                    const websocket_handler_t *handler, void *user_data)
+{
+    const http_header_t *key = http_request_get_header(request, "Sec-WebSocket-Key");
+    const http_header_t *version = http_request_get_header(request, "Sec-WebSocket-Version");
+
+    if (strcmp(request->method, "GET") != 0 || strcmp(request->version, "HTTP/1.1") != 0 ||
+        !key || strlen(key->value) != 24) {
+        http_response_t response;
+        http_response_init(&response);
+        http_response_set(&response, 400, "Bad Request", "text/plain", "Handshake WebSocket inválido");
+        http_response_send(client_socket, config, &response);
+        http_response_cleanup(&response);
+        return -1;
+    }
+
+    if (!version || strcmp(version->value, "13") != 0) {
+        http_response_t response;
+        http_response_init(&response);
+        http_response_set(&response, 426, "Upgrade Required", "text/plain", "Versão WebSocket não suportada");
+        http_response_add_header(&response, "Sec-WebSocket-Version", "13");
+        http_response_send(client_socket, config, &response);
+        http_response_cleanup(&response);
+        return -1;
+    }
+
+    // Sec-WebSocket-Accept = base64(SHA-1(chave + GUID))
+    char concatenated[64];
+    unsigned char digest[20];
+    char accept[32];
+    int concatenated_length = snprintf(concatenated, sizeof(concatenated), "%s%s", key->value, WS_GUID);
+    sha1((const unsigned char*)concatenated, concatenated_length, digest);
+    base64_encode(digest, sizeof(digest), accept);
+
+    char handshake[256];
+    int handshake_length = snprintf(handshake, sizeof(handshake),
+                                    "HTTP/1.1 101 Switching Protocols\r\n"
+                                    "Upgrade: websocket\r\n"
+                                    "Connection: Upgrade\r\n"
+                                    "Sec-WebSocket-Accept: %s\r\n"
+                                    "\r\n", accept);
+    if (http_send_all(client_socket, handshake, handshake_length) < 0) {
+        return -1;
+    }
+
+    websocket_t *ws = calloc(1, sizeof(websocket_t));
+    size_t max_message = config->websocket_max_message_size;
+    size_t capacity = config->buffer_size > initial_length ? config->buffer_size : initial_length;
+    unsigned char *buffer = malloc(capacity);
+    unsigned char *message = NULL;
+    size_t message_length = 0;
+    websocket_opcode_t message_opcode = WS_OPCODE_CONTINUATION;  // CONTINUATION = sem mensagem fragmentada
+
+    if (!ws || !buffer || send_queue_init(&ws->queue, client_socket, config->websocket_max_queue_bytes, 0) < 0) {
+        perror("Erro ao inicializar conexão WebSocket");
+        free(ws);
+        free(buffer);
+        return -1;
+    }
+
+    if (initial_length > 0) {
+        memcpy(buffer, initial, initial_length);
+    }
+    size_t have = initial_length;
+
+    int close_code = WS_CLOSE_ABNORMAL;
+    int close_received = 0;
+    int failed = 0;
+
+    if (handler->on_open) {
+        http_request_view_t view;
+        http_request_view_init(&view, request);
+        if (handler->on_open(ws, &view, user_data) < 0) {
+            websocket_close(ws, WS_CLOSE_POLICY_VIOLATION, NULL);
+            failed = 1;
+        }
+    }
+
+    while (1) {
+        // Processa os frames completos já recebidos
+        size_t offset = 0;
+        while (!failed && !close_received && have - offset >= 2) {
+            unsigned char *frame = buffer + offset;
+            int fin = (frame[0] & 0x80) != 0;
+            int rsv = frame[0] & 0x70;
+            int opcode = frame[0] & 0x0F;
+            int masked = (frame[1] & 0x80) != 0;
+            uint64_t payload_length = frame[1] & 0x7F;
+            size_t header_length = 2;
+
+            if (payload_length == 126) {
+                if (have - offset < 4) {
+                    break;
+                }
+                payload_length = ((uint64_t)frame[2] << 8) | frame[3];
+                header_length = 4;
+            } else if (payload_length == 127) {
+                if (have - offset < 10) {
+                    break;
+                }
+                payload_length = 0;
+                for (int i = 0; i < 8; i++) {
+                    payload_length = (payload_length << 8) | frame[2 + i];
+                }
+                header_length = 10;
+            }
+
+            // Frames do cliente devem vir mascarados e sem extensões negociadas
+            int is_control = (opcode & 0x8) != 0;
+            if (rsv || !masked || (is_control && (!fin || payload_length > WS_MAX_CONTROL_PAYLOAD)) ||
+                (opcode > WS_OPCODE_BINARY && opcode < WS_OPCODE_CLOSE) || opcode > WS_OPCODE_PONG) {
+                websocket_close(ws, WS_CLOSE_PROTOCOL_ERROR, NULL);
+                failed = 1;
+                break;
+            }
+
+            if (payload_length > max_message ||
+                (!is_control && message_length + payload_length > max_message)) {
+                websocket_close(ws, WS_CLOSE_TOO_BIG, NULL);
+                failed = 1;
+                break;
+            }
+
+            header_length += 4;
+            size_t frame_length = header_length + payload_length;
+            if (have - offset < frame_length) {
+                // Frame incompleto: garante espaço para recebê-lo inteiro
+                if (frame_length > capacity) {
+                    memmove(buffer, buffer + offset, have - offset);
+                    have -= offset;
+                    offset = 0;
+                    unsigned char *grown = realloc(buffer, frame_length);
+                    if (!grown) {
+                        failed = 1;
+                        break;
+                    }
+                    buffer = grown;
+                    capacity = frame_length;
+                }
+                break;
+            }
+
+            unsigned char *payload = frame + header_length;
+            unmask_payload(payload, payload_length, frame + header_length - 4);
+            offset += frame_length;
+
+            switch (opcode) {
+                case WS_OPCODE_TEXT:
+                case WS_OPCODE_BINARY:
+                case WS_OPCODE_CONTINUATION: {
+                    int is_continuation = opcode == WS_OPCODE_CONTINUATION;
+                    if (is_continuation != (message_opcode != WS_OPCODE_CONTINUATION)) {
+                        websocket_close(ws, WS_CLOSE_PROTOCOL_ERROR, NULL);
+                        failed = 1;
+                        break;
+                    }
+
+                    const unsigned char *data = payload;
+                    size_t data_length = payload_length;
+                    websocket_opcode_t type = is_continuation ? message_opcode : (websocket_opcode_t)opcode;
+
+                    // Mensagens de um único frame são entregues direto do buffer de recepção
+                    if (!fin || is_continuation) {
+                        unsigned char *grown = realloc(message, message_length + payload_length + 1);
+                        if (!grown) {
+                            failed = 1;
+                            break;
+                        }
+                        message = grown;
+                        memcpy(message + message_length, payload, payload_length);
+                        message_length += payload_length;
+                        message_opcode = type;
+                        data = message;
+                        data_length = message_length;
+                    }
+
+                    if (!fin) {
+                        break;
+                    }
+
+                    if (type == WS_OPCODE_TEXT && !utf8_valid(data, data_length)) {
+                        websocket_close(ws, WS_CLOSE_INVALID_DATA, NULL);
+                        failed = 1;
+                        break;
+                    }
+
+                    if (handler->on_message) {
+                        handler->on_message(ws, type, (const char*)data, data_length, user_data);
+                    }
+                    message_length = 0;
+                    message_opcode = WS_OPCODE_CONTINUATION;
+                    break;
+                }
+
+                case WS_OPCODE_CLOSE: {
+                    int code = WS_CLOSE_NO_STATUS;
+                    if (payload_length == 1) {
+                        websocket_close(ws, WS_CLOSE_PROTOCOL_ERROR, NULL);
+                        failed = 1;
+                        break;
+                    }
+                    if (payload_length >= 2) {
+                        code = (payload[0] << 8) | payload[1];
+                        if (!valid_close_code(code) || !utf8_valid(payload + 2, payload_length - 2)) {
+                            websocket_close(ws, WS_CLOSE_PROTOCOL_ERROR, NULL);
+                            failed = 1;
+                            break;
+                        }
+                    }
+
+                    // Responde com o mesmo código (1000 se o cliente não informou)
+                    websocket_close(ws, code == WS_CLOSE_NO_STATUS ? WS_CLOSE_NORMAL : code, NULL);
+                    close_code = code;
+                    close_received = 1;
+                    break;
+                }
+
+                case WS_OPCODE_PING: {
+                    websocket_frame_t *pong = websocket_frame_create(WS_OPCODE_PONG, payload, payload_length);
+                    if (pong) {
+                        send_queue_push(&ws->queue, pong, 0);
+                        websocket_frame_release(pong);
+                    }
+                    break;
+                }
+
+                default:
+                    // PONG não exige resposta
+                    break;
+            }
+        }
+
+        if (offset > 0) {
+            memmove(buffer, buffer + offset, have - offset);
+            have -= offset;
+        }
+
+        // Envia o que foi enfileirado pela aplicação ou pelo próprio laço
+        if (send_queue_flush(&ws->queue) < 0) {
+            break;
+        }
+
+        pthread_mutex_lock(&ws->queue.lock);
+        int close_sent = ws->queue.shut;
+        int dropped = ws->queue.dropped;
+        pthread_mutex_unlock(&ws->queue.lock);
+
+        if (dropped) {
+            close_code = WS_CLOSE_POLICY_VIOLATION;
+            break;
+        }
+        if (close_received || (failed && close_sent)) {
+            break;
+        }
+
+        // Aguarda dados do cliente ou novos frames na fila
+        if (socket_pending(client_socket) == 0) {
+            struct pollfd fds[2] = {
+                { .fd = client_socket, .events = POLLIN },
+                { .fd = ws->queue.wake_fd, .events = POLLIN }
+            };
+            int ready = socket_poll(fds, 2, close_sent ? WS_CLOSE_TIMEOUT_MS : -1);
+            if (ready < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ready <= 0) {
+                break;
+            }
+            if ((fds[1].revents & POLLIN) && send_queue_clear_wake(&ws->queue) < 0) {
+                break;
+            }
+            if (!(fds[0].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+        }
+
+        ssize_t n = socket_recv(client_socket, buffer + have, capacity - have, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            // Conexão encerrada sem close (ou servidor parando): tenta avisar o cliente
+            if (!close_sent && websocket_close(ws, WS_CLOSE_GOING_AWAY, NULL) == 0) {
+                send_queue_flush(&ws->queue);
+            }
+            break;
+        }
+        have += n;
+    }
+
+    if (handler->on_close) {
+        handler->on_close(ws, close_code, user_data);
+    }
+
+    send_queue_destroy(&ws->queue);
+    free(ws);
+    free(message);
+    free(buffer);
+
+    return close_code == WS_CLOSE_ABNORMAL || close_code == WS_CLOSE_POLICY_VIOLATION ? -1 : 0;
+}
+
+websocket_frame_t* websocket_frame_create(websocket_opcode_t opcode, const void *data, size_t length)
+{
+    size_t header_length = length < 126 ? 2 : (length <= 0xFFFF ? 4 : 10);
+    websocket_frame_t *frame = send_buffer_create(header_length + length);
+    if (!frame) {
+        return NULL;
+    }
+    frame->header_length = header_length;
+
+    // Frames do servidor não são mascarados
+    unsigned char *p = frame->data;
+    p[0] = 0x80 | (opcode & 0x0F);
+    if (length < 126) {
+        p[1] = (unsigned char)length;
+    } else if (length <= 0xFFFF) {
+        p[1] = 126;
+        p[2] = length >> 8;
+        p[3] = length & 0xFF;
+    } else {
+        p[1] = 127;
+        for (int i = 0; i < 8; i++) {
+            p[2 + i] = (uint64_t)length >> (56 - 8 * i);
+        }
+    }
+
+    if (length > 0) {
+        memcpy(p + header_length, data, length);
+    }
+    return frame;
+}
+
+void websocket_frame_retain(websocket_frame_t *frame)
+{
+    send_buffer_retain(frame);
+}
+
+void websocket_frame_release(websocket_frame_t *frame)
+{
+    send_buffer_release(frame);
+}
+
+int websocket_send_frame(websocket_t *ws, websocket_frame_t *frame)
+{
+    // O opcode fica no primeiro byte do frame serializado
+    if (!ws || !frame || (frame->data[0] & 0x0F) == WS_OPCODE_CLOSE) {
+        return -1;
+    }
+    return send_queue_push(&ws->queue, frame, 0);
+}
+
+int websocket_send(websocket_t *ws, websocket_opcode_t opcode, const void *data, size_t length)
+{
+    if (!ws || opcode == WS_OPCODE_CLOSE || opcode == WS_OPCODE_CONTINUATION ||
+        ((opcode & 0x8) && length > WS_MAX_CONTROL_PAYLOAD)) {
+        return -1;
+    }
+
+    websocket_frame_t *frame = websocket_frame_create(opcode, data, length);
+    if (!frame) {
+        return -1;
+    }
+
+    int result = send_queue_push(&ws->queue, frame, 0);
+    websocket_frame_release(frame);
+    return result;
+}
+
+int websocket_close(websocket_t *ws, uint16_t code, const char *reason)
+{
+    if (!ws) {
+        return -1;
+    }
+
+    unsigned char payload[WS_MAX_CONTROL_PAYLOAD];
+    size_t reason_length = reason ? strlen(reason) : 0;
+    if (reason_length > WS_MAX_CONTROL_PAYLOAD - 2) {
+        reason_length = WS_MAX_CONTROL_PAYLOAD - 2;
+    }
+
+    payload[0] = code >> 8;
+    payload[1] = code & 0xFF;
+    if (reason_length > 0) {
+        memcpy(payload + 2, reason, reason_length);
+    }
+
+    websocket_frame_t *frame = websocket_frame_create(WS_OPCODE_CLOSE, payload, 2 + reason_length);
+    if (!frame) {
+        return -1;
+    }
+
+    // O close não é descartado pelo limite e encerra a fila
+    int result = send_queue_push(&ws->queue, frame, SEND_QUEUE_UNLIMITED | SEND_QUEUE_FINAL);
+    websocket_frame_release(frame);
+    return result;
+}
+
+websocket_group_t* websocket_group_create(void)
+{
+    return send_group_create();
+}
+
+void websocket_group_destroy(websocket_group_t *group)
+{
+    send_group_destroy(group);
+}
+
+int websocket_group_add(websocket_group_t *group, websocket_t *ws)
+{
+    return ws ? send_group_add(group, &ws->queue) : -1;
+}
+
+void websocket_group_remove(websocket_group_t *group, websocket_t *ws)
+{
+    if (ws) {
+        send_group_remove(group, &ws->queue);
+    }
+}
+
+int websocket_group_broadcast(websocket_group_t *group, websocket_opcode_t opcode,
+                              const void *data, size_t length)
+{
+    if (!group) {
+        return -1;
+    }
+
+    // Serializado uma única vez; cada fila apenas adiciona uma referência
+    websocket_frame_t *frame = websocket_frame_create(opcode, data, length);
+    if (!frame) {
+        return -1;
+    }
+
+    int delivered = send_group_broadcast(group, frame);
+    websocket_frame_release(frame);
+    return delivered;
+}
+
+// Implementação das funções auxiliares internas
+
+#if defined(__x86_64__)
+// 32 bytes por iteração com AVX2
+__attribute__((target("avx2")))
+static size_t unmask_avx2(unsigned char *data, size_t length, uint32_t pattern)
+{
+    __m256i mask = _mm256_set1_epi32((int)pattern);
+    size_t i = 0;
+
+    for (; i + 32 <= length; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(data + i));
+        _mm256_storeu_si256((__m256i*)(data + i), _mm256_xor_si256(block, mask));
+    }
+    return i;
+}
+
+// 16 bytes por iteração com SSE2 (sempre disponível em x86-64)
+static size_t unmask_sse2(unsigned char *data, size_t length, uint32_t pattern)
+{
+    __m128i mask = _mm_set1_epi32((int)pattern);
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+        _mm_storeu_si128((__m128i*)(data + i), _mm_xor_si128(block, mask));
+    }
+    return i;
+}
+#elif defined(__aarch64__)
+// 16 bytes por iteração com NEON
+static size_t unmask_neon(unsigned char *data, size_t length, uint32_t pattern)
+{
+    uint8x16_t mask = vreinterpretq_u8_u32(vdupq_n_u32(pattern));
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        vst1q_u8(data + i, veorq_u8(vld1q_u8(data + i), mask));
+    }
+    return i;
+}
+#endif
+
+static void unmask_payload(unsigned char *data, size_t length, const unsigned char mask[4])
+{
+    // A máscara repete a cada 4 bytes; blocos múltiplos de 4 preservam a fase
+    uint32_t pattern;
+    memcpy(&pattern, mask, sizeof(pattern));
+    size_t i = 0;
+
+#if defined(__x86_64__)
+    if (length >= 32 && __builtin_cpu_supports("avx2")) {
+        i = unmask_avx2(data, length, pattern);
+    }
+    i += unmask_sse2(data + i, length - i, pattern);
+#elif defined(__aarch64__)
+    i = unmask_neon(data, length, pattern);
+#else
+    uint64_t wide = ((uint64_t)pattern << 32) | pattern;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t block;
+        memcpy(&block, data + i, sizeof(block));
+        block ^= wide;
+        memcpy(data + i, &block, sizeof(block));
+    }
+#endif
+
+    for (; i < length; i++) {
+        data[i] ^= mask[i & 3];
+    }
+}
+
+static int header_has_token(const http_request_t *request, const char *name, const char *token)
+{
+    // Headers como Connection podem ter vários tokens separados por vírgula
+    size_t token_length = strlen(token);
+
+    for (size_t i = 0; i < request->header_count; i++) {
+        if (strcasecmp(request->headers[i].name, name) != 0) {
+            continue;
+        }
+
+        const char *p = request->headers[i].value;
+        while (*p) {
+            while (*p == ' ' || *p == '\t' || *p == ',') {
+                p++;
+            }
+            const char *start = p;
+            while (*p && *p != ',') {
+                p++;
+            }
+            const char *end = p;
+            while (end > start && (end[-1] == ' ' || end[-1] == '\t')) {
+                end--;
+            }
+            if ((size_t)(end - start) == token_length && strncasecmp(start, token, token_length) == 0) {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int utf8_valid(const unsigned char *data, size_t length)
+{
+    size_t i = 0;
+
+    while (i < length) {
+        unsigned char c = data[i];
+        if (c < 0x80) {
+            i++;
+            continue;
+        }
+
+        size_t extra;
+        uint32_t codepoint;
+        if ((c & 0xE0) == 0xC0) {
+            extra = 1;
+            codepoint = c & 0x1F;
+        } else if ((c & 0xF0) == 0xE0) {
+            extra = 2;
+            codepoint = c & 0x0F;
+        } else if ((c & 0xF8) == 0xF0) {
+            extra = 3;
+            codepoint = c & 0x07;
+        } else {
+            return 0;
+        }
+
+        if (i + extra >= length) {
+            return 0;
+        }
+        for (size_t j = 1; j <= extra; j++) {
+            if ((data[i + j] & 0xC0) != 0x80) {
+                return 0;
+            }
+            codepoint = (codepoint << 6) | (data[i + j] & 0x3F);
+        }
+
+        // Rejeita codificações longas, surrogates e valores fora do Unicode
+        if ((extra == 1 && codepoint < 0x80) || (extra == 2 && codepoint < 0x800) ||
+            (extra == 3 && codepoint < 0x10000) || codepoint > 0x10FFFF ||
+            (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+            return 0;
+        }
+        i += extra + 1;
+    }
+
+    return 1;
+}
+
+static int valid_close_code(int code)
+{
+    if (code >= 3000 && code <= 4999) {
+        return 1;
+    }
+    return (code >= 1000 && code <= 1003) || (code >= 1007 && code <= 1011);
+}
+
+// SHA-1 (RFC 3174), usado apenas para Sec-WebSocket-Accept
+
+static uint32_t rotate_left(uint32_t value, int bits)
+{
+    return (value << bits) | (value >> (32 - bits));
+}
+
+static void sha1_block(uint32_t state[5], const unsigned char block[64])
+{
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+               ((uint32_t)block[i * 4 + 2] << 8) | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = rotate_left(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t temp = rotate_left(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rotate_left(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+static void sha1(const unsigned char *data, size_t length, unsigned char digest[20])
+{
+    uint32_t state[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    unsigned char block[64];
+    size_t i = 0;
+
+    for (; i + 64 <= length; i += 64) {
+        sha1_block(state, data + i);
+    }
+
+    // Padding: 0x80, zeros e o tamanho em bits (big-endian)
+    size_t rest = length - i;
+    memset(block, 0, sizeof(block));
+    memcpy(block, data + i, rest);
+    block[rest] = 0x80;
+    if (rest >= 56) {
+        sha1_block(state, block);
+        memset(block, 0, sizeof(block));
+    }
+    uint64_t bits = (uint64_t)length * 8;
+    for (int j = 0; j < 8; j++) {
+        block[63 - j] = bits >> (8 * j);
+    }
+    sha1_block(state, block);
+
+    for (int j = 0; j < 5; j++) {
+        digest[j * 4] = state[j] >> 24;
+        digest[j * 4 + 1] = state[j] >> 16;
+        digest[j * 4 + 2] = state[j] >> 8;
+        digest[j * 4 + 3] = state[j];
+    }
+}
+
+static void base64_encode(const unsigned char *data, size_t length, char *out)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t i = 0;
+
+    for (; i + 3 <= length; i += 3) {
+        uint32_t group = ((uint32_t)data[i] << 16) | ((uint32_t)data[i + 1] << 8) | data[i + 2];
+        *out++ = alphabet[(group >> 18) & 0x3F];
+        *out++ = alphabet[(group >> 12) & 0x3F];
+        *out++ = alphabet[(group >> 6) & 0x3F];
+        *out++ = alphabet[group & 0x3F];
+    }
+
+    if (i < length) {
+        uint32_t group = (uint32_t)data[i] << 16;
+        if (i + 1 < length) {
+            group |= (uint32_t)data[i + 1] << 8;
+        }
+        *out++ = alphabet[(group >> 18) & 0x3F];
+        *out++ = alphabet[(group >> 12) & 0x3F];
+        *out++ = i + 1 < length ? alphabet[(group >> 6) & 0x3F] : '=';
+        *out++ = '=';
+    }
+
+    *out = '\0';
+}
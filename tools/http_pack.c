@@ -0,0 +1,736 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+#include <dirent.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+#include "asset_pack.h"
+
+/*
+ * http_pack: compila um diretório em um pacote de arquivos (asset_pack)
+ *
+ * Cada arquivo regular (exceto os ocultos) vira uma entrada com o caminho
+ * relativo ao diretório; index.html também responde pelo diretório ("/" e
+ * "/docs/"). As versões gzip e brotli são guardadas apenas quando reduzem o
+ * arquivo em pelo menos 5%. O pacote é gravado em um arquivo temporário e
+ * renomeado, portanto servidores com o pacote antigo mapeado não são afetados.
+ */
+
+#define MAX_DISPLACEMENT (1u << 24)
+#define SEED_ATTEMPTS 16
+
+// Arquivo lido do diretório e suas versões comprimidas
+typedef struct {
+    char *path;                   // Caminho normalizado ("/css/site.css")
+    const char *content_type;
+    size_t source;                // Índice do arquivo com o conteúdo (aliases de diretório)
+    size_t order;                 // Posição antes da ordenação por caminho
+    unsigned char *data[ASSET_ENCODING_COUNT];
+    size_t length[ASSET_ENCODING_COUNT];
+    char etag[ASSET_ENCODING_COUNT][32];
+    uint64_t hash;
+} pack_file_t;
+
+typedef struct {
+    pack_file_t *files;
+    size_t count;
+    size_t capacity;
+    int compress;
+} pack_builder_t;
+
+// Buffer que cresce conforme as strings e headers são acrescentados
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} string_table_t;
+
+static const struct {
+    const char *extension;
+    const char *content_type;
+} mime_types[] = {
+    { "html", "text/html; charset=utf-8" },
+    { "htm", "text/html; charset=utf-8" },
+    { "css", "text/css; charset=utf-8" },
+    { "js", "text/javascript; charset=utf-8" },
+    { "mjs", "text/javascript; charset=utf-8" },
+    { "json", "application/json" },
+    { "map", "application/json" },
+    { "txt", "text/plain; charset=utf-8" },
+    { "xml", "application/xml" },
+    { "svg", "image/svg+xml" },
+    { "png", "image/png" },
+    { "jpg", "image/jpeg" },
+    { "jpeg", "image/jpeg" },
+    { "gif", "image/gif" },
+    { "webp", "image/webp" },
+    { "avif", "image/avif" },
+    { "ico", "image/x-icon" },
+    { "woff", "font/woff" },
+    { "woff2", "font/woff2" },
+    { "ttf", "font/ttf" },
+    { "wasm", "application/wasm" },
+    { "pdf", "application/pdf" },
+    { "mp4", "video/mp4" },
+    { "webm", "video/webm" },
+    { NULL, NULL }
+};
+
+static const char* content_type_for(const char *path)
+{
+    const char *dot = strrchr(path, '.');
+    const char *slash = strrchr(path, '/');
+    if (dot && (!slash || dot > slash)) {
+        for (size_t i = 0; mime_types[i].extension; i++) {
+            if (strcasecmp(dot + 1, mime_types[i].extension) == 0) {
+                return mime_types[i].content_type;
+            }
+        }
+    }
+    return "application/octet-stream";
+}
+
+static uint64_t content_hash(const unsigned char *data, size_t length)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static int read_file(const char *path, unsigned char **data, size_t *length)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+
+    *length = st.st_size;
+    *data = malloc(*length > 0 ? *length : 1);
+    if (!*data) {
+        perror("Erro ao alocar memória");
+        close(fd);
+        return -1;
+    }
+
+    size_t total = 0;
+    while (total < *length) {
+        ssize_t n = read(fd, *data + total, *length - total);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            fprintf(stderr, "Erro ao ler %s\n", path);
+            free(*data);
+            close(fd);
+            return -1;
+        }
+        total += n;
+    }
+
+    close(fd);
+    return 0;
+}
+
+#ifdef HAVE_ZLIB
+static int compress_gzip(const unsigned char *data, size_t length, unsigned char **out, size_t *out_length)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // windowBits 15 + 16 produz o formato gzip em vez de zlib
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return -1;
+    }
+
+    size_t capacity = deflateBound(&stream, length);
+    *out = malloc(capacity);
+    if (!*out) {
+        deflateEnd(&stream);
+        return -1;
+    }
+
+    stream.next_in = (unsigned char*)data;
+    stream.avail_in = length;
+    stream.next_out = *out;
+    stream.avail_out = capacity;
+    int result = deflate(&stream, Z_FINISH);
+    *out_length = stream.total_out;
+    deflateEnd(&stream);
+
+    if (result != Z_STREAM_END) {
+        free(*out);
+        return -1;
+    }
+    return 0;
+}
+#endif
+
+#ifdef HAVE_BROTLI
+static int compress_brotli(const unsigned char *data, size_t length, unsigned char **out, size_t *out_length)
+{
+    *out_length = BrotliEncoderMaxCompressedSize(length);
+    if (*out_length == 0) {
+        return -1;
+    }
+    *out = malloc(*out_length);
+    if (!*out) {
+        return -1;
+    }
+
+    if (!BrotliEncoderCompress(BROTLI_MAX_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_GENERIC,
+                               length, data, out_length, *out)) {
+        free(*out);
+        return -1;
+    }
+    return 0;
+}
+#endif
+
+// Guarda a versão comprimida apenas se ela economizar pelo menos 5%
+static void add_variant(pack_file_t *file, asset_encoding_t encoding, unsigned char *data, size_t length)
+{
+    size_t original = file->length[ASSET_ENCODING_IDENTITY];
+    if (length >= original - original / 20) {
+        free(data);
+        return;
+    }
+    file->data[encoding] = data;
+    file->length[encoding] = length;
+}
+
+static pack_file_t* add_entry(pack_builder_t *builder, const char *path)
+{
+    if (builder->count == builder->capacity) {
+        size_t capacity = builder->capacity ? builder->capacity * 2 : 64;
+        pack_file_t *files = realloc(builder->files, capacity * sizeof(pack_file_t));
+        if (!files) {
+            perror("Erro ao alocar memória");
+            return NULL;
+        }
+        builder->files = files;
+        builder->capacity = capacity;
+    }
+
+    pack_file_t *file = &builder->files[builder->count];
+    memset(file, 0, sizeof(*file));
+    file->path = strdup(path);
+    if (!file->path) {
+        perror("Erro ao alocar memória");
+        return NULL;
+    }
+    file->source = builder->count;
+    builder->count++;
+    return file;
+}
+
+static int add_file(pack_builder_t *builder, const char *disk_path, const char *path)
+{
+    pack_file_t *file = add_entry(builder, path);
+    if (!file) {
+        return -1;
+    }
+    file->content_type = content_type_for(path);
+
+    if (read_file(disk_path, &file->data[ASSET_ENCODING_IDENTITY], &file->length[ASSET_ENCODING_IDENTITY]) < 0) {
+        return -1;
+    }
+
+    const unsigned char *data = file->data[ASSET_ENCODING_IDENTITY];
+    size_t length = file->length[ASSET_ENCODING_IDENTITY];
+    if (builder->compress && length > 0) {
+        unsigned char *out;
+        size_t out_length;
+#ifdef HAVE_ZLIB
+        if (compress_gzip(data, length, &out, &out_length) == 0) {
+            add_variant(file, ASSET_ENCODING_GZIP, out, out_length);
+        }
+#endif
+#ifdef HAVE_BROTLI
+        if (compress_brotli(data, length, &out, &out_length) == 0) {
+            add_variant(file, ASSET_ENCODING_BROTLI, out, out_length);
+        }
+#endif
+        (void)out;
+        (void)out_length;
+    }
+
+    // ETags distintas por codificação: os bytes enviados são diferentes
+    static const char *suffixes[ASSET_ENCODING_COUNT] = { "", "-gz", "-br" };
+    uint64_t hash = content_hash(data, length);
+    for (int e = 0; e < ASSET_ENCODING_COUNT; e++) {
+        snprintf(file->etag[e], sizeof(file->etag[e]), "\"%016llx%s\"", (unsigned long long)hash, suffixes[e]);
+    }
+    return 0;
+}
+
+// Percorre o diretório recursivamente; prefix é o caminho HTTP correspondente
+static int walk_directory(pack_builder_t *builder, const char *directory, const char *prefix)
+{
+    DIR *dir = opendir(directory);
+    if (!dir) {
+        perror(directory);
+        return -1;
+    }
+
+    int result = 0;
+    struct dirent *item;
+    while (result == 0 && (item = readdir(dir)) != NULL) {
+        if (item->d_name[0] == '.') {
+            continue;
+        }
+
+        char disk_path[4096];
+        char path[4096];
+        if (snprintf(disk_path, sizeof(disk_path), "%s/%s", directory, item->d_name) >= (int)sizeof(disk_path) ||
+            snprintf(path, sizeof(path), "%s%s", prefix, item->d_name) >= 1024) {
+            fprintf(stderr, "Caminho longo demais ignorado: %s/%s\n", directory, item->d_name);
+            continue;
+        }
+
+        struct stat st;
+        if (stat(disk_path, &st) < 0) {
+            perror(disk_path);
+            result = -1;
+        } else if (S_ISDIR(st.st_mode)) {
+            strcat(path, "/");
+            result = walk_directory(builder, disk_path, path);
+        } else if (S_ISREG(st.st_mode)) {
+            result = add_file(builder, disk_path, path);
+        }
+    }
+
+    closedir(dir);
+    return result;
+}
+
+static int compare_paths(const void *a, const void *b)
+{
+    return strcmp(((const pack_file_t*)a)->path, ((const pack_file_t*)b)->path);
+}
+
+// "/docs/index.html" também atende "/docs/"
+static int add_directory_aliases(pack_builder_t *builder)
+{
+    size_t count = builder->count;
+    for (size_t i = 0; i < count; i++) {
+        const char *path = builder->files[i].path;
+        size_t length = strlen(path);
+        if (length < 11 || strcmp(path + length - 11, "/index.html") != 0) {
+            continue;
+        }
+
+        char alias[1024];
+        snprintf(alias, sizeof(alias), "%.*s", (int)(length - 10), path);
+        pack_file_t *file = add_entry(builder, alias);
+        if (!file) {
+            return -1;
+        }
+        file->source = i;
+    }
+    return 0;
+}
+
+static int string_append(string_table_t *table, const void *data, size_t length, uint64_t *offset)
+{
+    if (table->length + length > table->capacity) {
+        size_t capacity = table->capacity ? table->capacity : 4096;
+        while (capacity < table->length + length) {
+            capacity *= 2;
+        }
+        char *grown = realloc(table->data, capacity);
+        if (!grown) {
+            perror("Erro ao alocar memória");
+            return -1;
+        }
+        table->data = grown;
+        table->capacity = capacity;
+    }
+
+    *offset = table->length;
+    memcpy(table->data + table->length, data, length);
+    table->length += length;
+    return 0;
+}
+
+static int compare_buckets_by_size(const void *a, const void *b, void *sizes)
+{
+    uint32_t x = ((const uint32_t*)sizes)[*(const uint32_t*)a];
+    uint32_t y = ((const uint32_t*)sizes)[*(const uint32_t*)b];
+    return x > y ? -1 : (x < y);
+}
+
+/*
+ * Hash and displace: os buckets são resolvidos do maior para o menor, cada
+ * um procurando o primeiro deslocamento que leve todas as suas chaves a
+ * posições livres.
+ */
+static int build_perfect_hash(pack_builder_t *builder, uint32_t seed, uint32_t bucket_count,
+                              uint32_t *buckets, uint32_t *slots)
+{
+    uint32_t count = builder->count;
+    uint32_t *sizes = calloc(bucket_count, sizeof(uint32_t));
+    uint32_t *order = malloc(bucket_count * sizeof(uint32_t));
+    uint32_t *members = malloc(count * sizeof(uint32_t));
+    uint32_t *starts = calloc(bucket_count + 1, sizeof(uint32_t));
+    unsigned char *used = calloc(count, 1);
+    uint32_t *candidate = malloc(count * sizeof(uint32_t));
+    int result = -1;
+
+    if (!sizes || !order || !members || !starts || !used || !candidate) {
+        perror("Erro ao alocar memória");
+        goto done;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        pack_file_t *file = &builder->files[i];
+        file->hash = asset_pack_hash(file->path, strlen(file->path), seed);
+        sizes[(uint32_t)file->hash % bucket_count]++;
+    }
+    for (uint32_t b = 0; b < bucket_count; b++) {
+        starts[b + 1] = starts[b] + sizes[b];
+        order[b] = b;
+    }
+    uint32_t *fill = calloc(bucket_count, sizeof(uint32_t));
+    if (!fill) {
+        perror("Erro ao alocar memória");
+        goto done;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t b = (uint32_t)builder->files[i].hash % bucket_count;
+        members[starts[b] + fill[b]++] = i;
+    }
+    free(fill);
+    qsort_r(order, bucket_count, sizeof(uint32_t), compare_buckets_by_size, sizes);
+
+    for (uint32_t o = 0; o < bucket_count && sizes[order[o]] > 0; o++) {
+        uint32_t b = order[o];
+        uint32_t displacement;
+        for (displacement = 0; displacement < MAX_DISPLACEMENT; displacement++) {
+            uint32_t k;
+            for (k = 0; k < sizes[b]; k++) {
+                uint32_t slot = asset_pack_slot(builder->files[members[starts[b] + k]].hash, displacement) % count;
+                if (used[slot]) {
+                    break;
+                }
+                // Duas chaves do mesmo bucket na mesma posição
+                uint32_t j;
+                for (j = 0; j < k && candidate[j] != slot; j++) {
+                }
+                if (j < k) {
+                    break;
+                }
+                candidate[k] = slot;
+            }
+            if (k == sizes[b]) {
+                break;
+            }
+        }
+        if (displacement == MAX_DISPLACEMENT) {
+            goto done;
+        }
+
+        buckets[b] = displacement;
+        for (uint32_t k = 0; k < sizes[b]; k++) {
+            used[candidate[k]] = 1;
+            slots[candidate[k]] = members[starts[b] + k];
+        }
+    }
+    result = 0;
+
+done:
+    free(sizes);
+    free(order);
+    free(members);
+    free(starts);
+    free(used);
+    free(candidate);
+    return result;
+}
+
+static int write_all(int fd, const void *data, size_t length, uint64_t offset)
+{
+    const char *p = data;
+    while (length > 0) {
+        ssize_t n = pwrite(fd, p, length, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        p += n;
+        length -= n;
+        offset += n;
+    }
+    return 0;
+}
+
+static uint64_t align_up(uint64_t value)
+{
+    return (value + ASSET_PACK_ALIGNMENT - 1) & ~(uint64_t)(ASSET_PACK_ALIGNMENT - 1);
+}
+
+static int write_pack(pack_builder_t *builder, const char *output)
+{
+    uint32_t count = builder->count;
+    uint32_t bucket_count = count / 2 + 1;
+    asset_pack_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ASSET_PACK_MAGIC, ASSET_PACK_MAGIC_LENGTH);
+    header.version = ASSET_PACK_VERSION;
+    header.entry_count = count;
+    header.bucket_count = bucket_count;
+    header.entries_offset = sizeof(header);
+    header.buckets_offset = header.entries_offset + (uint64_t)count * sizeof(asset_pack_entry_t);
+    header.slots_offset = header.buckets_offset + (uint64_t)bucket_count * sizeof(uint32_t);
+    uint64_t strings_offset = header.slots_offset + (uint64_t)count * sizeof(uint32_t);
+
+    asset_pack_entry_t *entries = calloc(count ? count : 1, sizeof(asset_pack_entry_t));
+    uint32_t *buckets = calloc(bucket_count, sizeof(uint32_t));
+    uint32_t *slots = calloc(count ? count : 1, sizeof(uint32_t));
+    string_table_t strings = { NULL, 0, 0 };
+    int fd = -1;
+    int result = -1;
+    char temporary[4096];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", output);
+
+    if (!entries || !buckets || !slots) {
+        perror("Erro ao alocar memória");
+        goto done;
+    }
+
+    int built = count == 0;
+    for (uint32_t attempt = 0; !built && attempt < SEED_ATTEMPTS; attempt++) {
+        header.seed = 0x5eed0000u + attempt;
+        memset(buckets, 0, bucket_count * sizeof(uint32_t));
+        built = build_perfect_hash(builder, header.seed, bucket_count, buckets, slots) == 0;
+    }
+    if (!built) {
+        fprintf(stderr, "Não foi possível construir o hash perfeito\n");
+        goto done;
+    }
+
+    // Strings e headers; o conteúdo começa na primeira página após eles
+    for (uint32_t i = 0; i < count; i++) {
+        const pack_file_t *file = &builder->files[i];
+        const pack_file_t *source = &builder->files[file->source];
+        asset_pack_entry_t *entry = &entries[i];
+        uint64_t offset;
+
+        entry->path_length = strlen(file->path);
+        if (string_append(&strings, file->path, entry->path_length + 1, &offset) < 0) {
+            goto done;
+        }
+        entry->path_offset = strings_offset + offset;
+        if (string_append(&strings, source->content_type, strlen(source->content_type) + 1, &offset) < 0) {
+            goto done;
+        }
+        entry->content_type_offset = strings_offset + offset;
+
+        int compressed = source->data[ASSET_ENCODING_GZIP] || source->data[ASSET_ENCODING_BROTLI];
+        static const char *encodings[ASSET_ENCODING_COUNT] = { NULL, "gzip", "br" };
+        for (int e = 0; e < ASSET_ENCODING_COUNT; e++) {
+            if (!source->data[e]) {
+                continue;
+            }
+            asset_pack_variant_t *variant = &entry->variants[e];
+            variant->length = source->length[e];
+
+            if (string_append(&strings, source->etag[e], strlen(source->etag[e]) + 1, &offset) < 0) {
+                goto done;
+            }
+            variant->etag_offset = strings_offset + offset;
+
+            char block[1024];
+            int length = snprintf(block, sizeof(block),
+                                  "HTTP/1.1 200 OK\r\n"
+                                  "Content-Type: %s\r\n"
+                                  "Content-Length: %zu\r\n"
+                                  "ETag: %s\r\n"
+                                  "%s%s%s"
+                                  "%s"
+                                  "\r\n",
+                                  source->content_type, source->length[e], source->etag[e],
+                                  encodings[e] ? "Content-Encoding: " : "", encodings[e] ? encodings[e] : "",
+                                  encodings[e] ? "\r\n" : "",
+                                  compressed ? "Vary: Accept-Encoding\r\n" : "");
+            // O nulo final mantém a string válida para depuração; não é enviado
+            if (string_append(&strings, block, length + 1, &offset) < 0) {
+                goto done;
+            }
+            variant->header_offset = strings_offset + offset;
+            variant->header_length = length;
+        }
+    }
+
+    // Conteúdo alinhado à página; aliases reutilizam o conteúdo do arquivo original
+    uint64_t content_offset = align_up(strings_offset + strings.length);
+    uint64_t (*offsets)[ASSET_ENCODING_COUNT] = calloc(count ? count : 1, sizeof(*offsets));
+    if (!offsets) {
+        perror("Erro ao alocar memória");
+        goto done;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const pack_file_t *file = &builder->files[i];
+        if (file->source != i) {
+            continue;
+        }
+        for (int e = 0; e < ASSET_ENCODING_COUNT; e++) {
+            if (file->data[e]) {
+                offsets[i][e] = content_offset;
+                content_offset = align_up(content_offset + file->length[e]);
+            }
+        }
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        for (int e = 0; e < ASSET_ENCODING_COUNT; e++) {
+            entries[i].variants[e].offset = offsets[builder->files[i].source][e];
+        }
+    }
+    header.file_size = content_offset;
+
+    fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror(temporary);
+        free(offsets);
+        goto done;
+    }
+
+    int ok = write_all(fd, &header, sizeof(header), 0) == 0 &&
+             write_all(fd, entries, (uint64_t)count * sizeof(asset_pack_entry_t), header.entries_offset) == 0 &&
+             write_all(fd, buckets, (uint64_t)bucket_count * sizeof(uint32_t), header.buckets_offset) == 0 &&
+             write_all(fd, slots, (uint64_t)count * sizeof(uint32_t), header.slots_offset) == 0 &&
+             write_all(fd, strings.data, strings.length, strings_offset) == 0;
+    for (uint32_t i = 0; ok && i < count; i++) {
+        const pack_file_t *file = &builder->files[i];
+        for (int e = 0; ok && file->source == i && e < ASSET_ENCODING_COUNT; e++) {
+            if (file->data[e]) {
+                ok = write_all(fd, file->data[e], file->length[e], offsets[i][e]) == 0;
+            }
+        }
+    }
+    free(offsets);
+
+    if (!ok || ftruncate(fd, header.file_size) < 0 || fsync(fd) < 0) {
+        perror("Erro ao gravar o pacote");
+        unlink(temporary);
+        goto done;
+    }
+    if (rename(temporary, output) < 0) {
+        perror("Erro ao renomear o pacote");
+        unlink(temporary);
+        goto done;
+    }
+
+    printf("%u entradas, %llu bytes gravados em %s\n", count, (unsigned long long)header.file_size, output);
+    result = 0;
+
+done:
+    if (fd >= 0) {
+        close(fd);
+    }
+    free(entries);
+    free(buckets);
+    free(slots);
+    free(strings.data);
+    return result;
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "Uso: %s [opções] diretório arquivo_de_saída\n"
+            "  -n              não gera versões comprimidas\n"
+            "Compressão disponível:%s%s\n",
+            program,
+#ifdef HAVE_ZLIB
+            " gzip",
+#else
+            "",
+#endif
+#ifdef HAVE_BROTLI
+            " brotli"
+#else
+            ""
+#endif
+            );
+}
+
+int main(int argc, char *argv[])
+{
+    pack_builder_t builder;
+    memset(&builder, 0, sizeof(builder));
+    builder.compress = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n")) != -1) {
+        switch (opt) {
+            case 'n': builder.compress = 0; break;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind != argc - 2) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int result = walk_directory(&builder, argv[optind], "/");
+    if (result == 0) {
+        result = add_directory_aliases(&builder);
+    }
+    if (result == 0) {
+        // Índice ordenado por caminho; os aliases apontam para o original pelo índice
+        for (size_t i = 0; i < builder.count; i++) {
+            builder.files[i].order = i;
+        }
+        qsort(builder.files, builder.count, sizeof(pack_file_t), compare_paths);
+        size_t *position = malloc((builder.count ? builder.count : 1) * sizeof(size_t));
+        if (!position) {
+            perror("Erro ao alocar memória");
+            result = -1;
+        } else {
+            for (size_t i = 0; i < builder.count; i++) {
+                position[builder.files[i].order] = i;
+            }
+            for (size_t i = 0; i < builder.count; i++) {
+                builder.files[i].source = position[builder.files[i].source];
+            }
+            free(position);
+            result = write_pack(&builder, argv[optind + 1]);
+        }
+    }
+
+    for (size_t i = 0; i < builder.count; i++) {
+        free(builder.files[i].path);
+        for (int e = 0; e < ASSET_ENCODING_COUNT; e++) {
+            free(builder.files[i].data[e]);
+        }
+    }
+    free(builder.files);
+
+    return result == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,534 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "capture.h"
+
+/*
+ * http_replay: reproduz um arquivo de captura (capture_file) contra um servidor
+ *
+ * Modos de ritmo:
+ *   original  respeita os intervalos gravados
+ *   fast      intervalos divididos por -s
+ *   max       sem espera, limitado apenas pela concorrência
+ *
+ * Nos modos com ritmo a latência é medida a partir do instante programado, e
+ * não do envio, para que atrasos causados por conexões ocupadas apareçam nos
+ * percentis em vez de reduzirem a taxa silenciosamente.
+ */
+
+#define RESPONSE_BUFFER 65536
+
+typedef enum {
+    PACE_ORIGINAL,
+    PACE_FAST,
+    PACE_MAX
+} pace_mode_t;
+
+typedef struct {
+    const char *host;
+    const char *port;
+    int concurrency;
+    int keep_alive;
+    pace_mode_t mode;
+    double speed;
+    int passes;
+    int timeout_seconds;
+} replay_options_t;
+
+typedef struct {
+    const replay_options_t *options;
+    const capture_trace_t *trace;
+    struct addrinfo *address;
+    size_t total;             // Registros do trace vezes passadas
+    size_t next;              // Próximo registro a enviar (atômico)
+    uint64_t start_us;
+    uint64_t pass_us;         // Duração de uma passada no ritmo escolhido
+
+    uint64_t *latencies_us;   // Por requisição; UINT64_MAX indica erro
+    int *statuses;
+    uint64_t bytes_received;  // Atômico
+} replay_t;
+
+// Conexão de um worker e o buffer de leitura da resposta
+typedef struct {
+    int fd;
+    char *buffer;
+    size_t start;
+    size_t end;
+} connection_t;
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleep_until(uint64_t deadline_us)
+{
+    uint64_t now = now_us();
+    if (deadline_us <= now) {
+        return;
+    }
+
+    struct timespec ts;
+    ts.tv_sec = (deadline_us - now) / 1000000;
+    ts.tv_nsec = ((deadline_us - now) % 1000000) * 1000;
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR) {
+    }
+}
+
+static int open_connection(replay_t *replay)
+{
+    struct addrinfo *ai = replay->address;
+    int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct timeval tv = { .tv_sec = replay->options->timeout_seconds, .tv_usec = 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    if (connect(fd, ai->ai_addr, ai->ai_addrlen) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void close_connection(connection_t *conn)
+{
+    if (conn->fd >= 0) {
+        close(conn->fd);
+        conn->fd = -1;
+    }
+    conn->start = 0;
+    conn->end = 0;
+}
+
+static int send_request(int fd, const char *data, size_t length)
+{
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += sent;
+        length -= sent;
+    }
+    return 0;
+}
+
+// Lê mais dados para o buffer; retorna bytes lidos, 0 em EOF, -1 em erro
+static ssize_t fill(connection_t *conn)
+{
+    if (conn->start > 0) {
+        memmove(conn->buffer, conn->buffer + conn->start, conn->end - conn->start);
+        conn->end -= conn->start;
+        conn->start = 0;
+    }
+    if (conn->end == RESPONSE_BUFFER) {
+        return -1;  // Linha de status e headers maiores que o buffer
+    }
+
+    ssize_t n;
+    do {
+        n = recv(conn->fd, conn->buffer + conn->end, RESPONSE_BUFFER - conn->end, 0);
+    } while (n < 0 && errno == EINTR);
+
+    if (n > 0) {
+        conn->end += n;
+    }
+    return n;
+}
+
+// Descarta length bytes de corpo; retorna 0 em caso de sucesso
+static int skip_bytes(connection_t *conn, uint64_t length, uint64_t *received)
+{
+    while (length > 0) {
+        if (conn->start == conn->end && fill(conn) <= 0) {
+            return -1;
+        }
+        size_t available = conn->end - conn->start;
+        size_t take = available < length ? available : length;
+        conn->start += take;
+        length -= take;
+        *received += take;
+    }
+    return 0;
+}
+
+// Localiza uma linha terminada em CRLF a partir de conn->start
+static char* find_line(connection_t *conn)
+{
+    while (1) {
+        char *line = memmem(conn->buffer + conn->start, conn->end - conn->start, "\r\n", 2);
+        if (line) {
+            return line;
+        }
+        if (fill(conn) <= 0) {
+            return NULL;
+        }
+    }
+}
+
+static int skip_chunked(connection_t *conn, uint64_t *received)
+{
+    while (1) {
+        char *line = find_line(conn);
+        if (!line) {
+            return -1;
+        }
+
+        uint64_t size = strtoull(conn->buffer + conn->start, NULL, 16);
+        *received += line + 2 - (conn->buffer + conn->start);
+        conn->start = line + 2 - conn->buffer;
+
+        if (size == 0) {
+            // Trailers até a linha vazia
+            while (1) {
+                line = find_line(conn);
+                if (!line) {
+                    return -1;
+                }
+                int empty = line == conn->buffer + conn->start;
+                conn->start = line + 2 - conn->buffer;
+                if (empty) {
+                    return 0;
+                }
+            }
+        }
+
+        if (skip_bytes(conn, size + 2, received) < 0) {
+            return -1;
+        }
+    }
+}
+
+// Lê uma resposta completa; retorna o status, ou -1 em caso de erro.
+// *reusable indica se a conexão pode receber outra requisição.
+static int read_response(connection_t *conn, int is_head, uint64_t *received, int *reusable)
+{
+    char *headers_end;
+    while (!(headers_end = memmem(conn->buffer + conn->start, conn->end - conn->start, "\r\n\r\n", 4))) {
+        if (fill(conn) <= 0) {
+            return -1;
+        }
+    }
+
+    char *headers = conn->buffer + conn->start;
+    size_t header_length = headers_end + 4 - headers;
+    *received += header_length;
+
+    int status = 0;
+    if (sscanf(headers, "HTTP/%*d.%*d %d", &status) != 1) {
+        return -1;
+    }
+
+    // Interpreta os headers que determinam o tamanho do corpo
+    int64_t content_length = -1;
+    int chunked = 0;
+    int close_after = strncmp(headers, "HTTP/1.0", 8) == 0;
+    char *line = memchr(headers, '\n', header_length) + 1;
+    while (line < headers_end) {
+        char *eol = memchr(line, '\r', headers_end + 2 - line);
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            content_length = strtoll(line + 15, NULL, 10);
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+            chunked = memmem(line, eol - line, "chunked", 7) != NULL;
+        } else if (strncasecmp(line, "Connection:", 11) == 0) {
+            char *value = line + 11;
+            while (*value == ' ') {
+                value++;
+            }
+            close_after = strncasecmp(value, "close", 5) == 0;
+        }
+        line = eol + 2;
+    }
+    conn->start += header_length;
+
+    *reusable = !close_after;
+    if (is_head || status == 204 || status == 304 || (status >= 100 && status < 200)) {
+        return status;
+    }
+
+    if (chunked) {
+        return skip_chunked(conn, received) < 0 ? -1 : status;
+    }
+    if (content_length >= 0) {
+        return skip_bytes(conn, content_length, received) < 0 ? -1 : status;
+    }
+
+    // Corpo delimitado pelo fechamento da conexão
+    *reusable = 0;
+    while (1) {
+        *received += conn->end - conn->start;
+        conn->start = conn->end;
+        ssize_t n = fill(conn);
+        if (n == 0) {
+            return status;
+        }
+        if (n < 0) {
+            return -1;
+        }
+    }
+}
+
+static void* worker_main(void *arg)
+{
+    replay_t *replay = (replay_t*)arg;
+    const replay_options_t *options = replay->options;
+    const capture_trace_t *trace = replay->trace;
+    connection_t conn = { .fd = -1, .buffer = malloc(RESPONSE_BUFFER) };
+
+    if (!conn.buffer) {
+        return NULL;
+    }
+
+    while (1) {
+        size_t index = __atomic_fetch_add(&replay->next, 1, __ATOMIC_RELAXED);
+        if (index >= replay->total) {
+            break;
+        }
+
+        const capture_record_t *record = &trace->records[index % trace->count];
+        uint64_t start = now_us();
+
+        if (options->mode != PACE_MAX) {
+            uint64_t offset = (uint64_t)(record->timestamp_us / options->speed);
+            uint64_t scheduled = replay->start_us + (index / trace->count) * replay->pass_us + offset;
+            sleep_until(scheduled);
+            start = scheduled;
+        }
+
+        int is_head = record->length >= 5 && memcmp(record->data, "HEAD ", 5) == 0;
+        uint64_t received = 0;
+        int status = -1;
+
+        // Uma conexão reaproveitada pode ter sido fechada pelo servidor: tenta de novo em uma nova
+        for (int attempt = 0; attempt < 2 && status < 0; attempt++) {
+            int reused = conn.fd >= 0;
+            if (!reused) {
+                conn.fd = open_connection(replay);
+                if (conn.fd < 0) {
+                    break;
+                }
+            }
+
+            int reusable = 0;
+            if (send_request(conn.fd, record->data, record->length) == 0) {
+                status = read_response(&conn, is_head, &received, &reusable);
+            }
+
+            if (status < 0 || !reusable || !options->keep_alive) {
+                close_connection(&conn);
+            }
+            if (!reused) {
+                break;
+            }
+        }
+
+        replay->latencies_us[index] = status < 0 ? UINT64_MAX : now_us() - start;
+        replay->statuses[index] = status;
+        __atomic_add_fetch(&replay->bytes_received, received, __ATOMIC_RELAXED);
+    }
+
+    close_connection(&conn);
+    free(conn.buffer);
+    return NULL;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : (x > y);
+}
+
+static void print_report(const replay_t *replay, uint64_t elapsed_us)
+{
+    size_t ok = 0;
+    size_t errors = 0;
+    size_t classes[6] = { 0 };
+
+    uint64_t *sorted = malloc(replay->total * sizeof(uint64_t));
+    if (!sorted) {
+        perror("Erro ao alocar relatório");
+        return;
+    }
+
+    for (size_t i = 0; i < replay->total; i++) {
+        if (replay->latencies_us[i] == UINT64_MAX) {
+            errors++;
+            continue;
+        }
+        sorted[ok++] = replay->latencies_us[i];
+        int status_class = replay->statuses[i] / 100;
+        if (status_class >= 1 && status_class <= 5) {
+            classes[status_class]++;
+        }
+    }
+    qsort(sorted, ok, sizeof(uint64_t), compare_u64);
+
+    double seconds = elapsed_us / 1e6;
+    printf("Requisições: %zu (erros: %zu)\n", replay->total, errors);
+    printf("Tempo: %.3f s\n", seconds);
+    printf("Vazão: %.1f req/s, %.2f MB/s recebidos\n",
+           ok / seconds, replay->bytes_received / seconds / (1024 * 1024));
+    printf("Status: 1xx %zu, 2xx %zu, 3xx %zu, 4xx %zu, 5xx %zu\n",
+           classes[1], classes[2], classes[3], classes[4], classes[5]);
+
+    if (ok > 0) {
+        static const double percentiles[] = { 50, 90, 99, 99.9 };
+        printf("Latência (ms):");
+        for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+            size_t rank = (size_t)(percentiles[i] / 100 * (ok - 1) + 0.5);
+            printf(" p%g %.3f", percentiles[i], sorted[rank] / 1000.0);
+        }
+        printf(" max %.3f\n", sorted[ok - 1] / 1000.0);
+    }
+
+    free(sorted);
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "Uso: %s [opções] arquivo_de_captura\n"
+            "  -H host         servidor de destino (padrão 127.0.0.1)\n"
+            "  -p porta        porta de destino (padrão 3000)\n"
+            "  -c conexões     requisições simultâneas (padrão 16)\n"
+            "  -k              reaproveita conexões (keep-alive)\n"
+            "  -m modo         original, fast ou max (padrão original)\n"
+            "  -s fator        aceleração do modo fast (padrão 10)\n"
+            "  -n passadas     repetições do trace (padrão 1)\n"
+            "  -t segundos     timeout de envio e recepção (padrão 10)\n",
+            program);
+}
+
+int main(int argc, char *argv[])
+{
+    replay_options_t options = {
+        .host = "127.0.0.1",
+        .port = "3000",
+        .concurrency = 16,
+        .keep_alive = 0,
+        .mode = PACE_ORIGINAL,
+        .speed = 10,
+        .passes = 1,
+        .timeout_seconds = 10
+    };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "H:p:c:km:s:n:t:")) != -1) {
+        switch (opt) {
+            case 'H': options.host = optarg; break;
+            case 'p': options.port = optarg; break;
+            case 'c': options.concurrency = atoi(optarg); break;
+            case 'k': options.keep_alive = 1; break;
+            case 's': options.speed = atof(optarg); break;
+            case 'n': options.passes = atoi(optarg); break;
+            case 't': options.timeout_seconds = atoi(optarg); break;
+            case 'm':
+                if (strcmp(optarg, "original") == 0) {
+                    options.mode = PACE_ORIGINAL;
+                } else if (strcmp(optarg, "fast") == 0) {
+                    options.mode = PACE_FAST;
+                } else if (strcmp(optarg, "max") == 0) {
+                    options.mode = PACE_MAX;
+                } else {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind != argc - 1 || options.concurrency < 1 || options.passes < 1 ||
+        options.speed <= 0 || options.timeout_seconds < 1) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (options.mode == PACE_ORIGINAL) {
+        options.speed = 1;
+    }
+
+    capture_trace_t trace;
+    if (capture_trace_load(argv[optind], &trace) < 0) {
+        return EXIT_FAILURE;
+    }
+    if (trace.count == 0) {
+        fprintf(stderr, "Arquivo de captura sem requisições\n");
+        capture_trace_free(&trace);
+        return EXIT_FAILURE;
+    }
+
+    replay_t replay;
+    memset(&replay, 0, sizeof(replay));
+    replay.options = &options;
+    replay.trace = &trace;
+    replay.total = trace.count * options.passes;
+    replay.latencies_us = calloc(replay.total, sizeof(uint64_t));
+    replay.statuses = calloc(replay.total, sizeof(int));
+
+    // Passadas seguintes começam um intervalo médio após a última requisição
+    uint64_t last = trace.records[trace.count - 1].timestamp_us;
+    replay.pass_us = (uint64_t)((last + last / trace.count) / options.speed);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    int gai = getaddrinfo(options.host, options.port, &hints, &replay.address);
+
+    pthread_t *threads = calloc(options.concurrency, sizeof(pthread_t));
+    if (gai != 0 || !replay.latencies_us || !replay.statuses || !threads) {
+        fprintf(stderr, "Erro ao preparar a reprodução: %s\n", gai ? gai_strerror(gai) : strerror(ENOMEM));
+        return EXIT_FAILURE;
+    }
+
+    printf("Reproduzindo %zu requisições (%d passada(s)) em %s:%s com %d conexões\n",
+           trace.count, options.passes, options.host, options.port, options.concurrency);
+
+    replay.start_us = now_us();
+    int started = 0;
+    for (; started < options.concurrency; started++) {
+        if (pthread_create(&threads[started], NULL, worker_main, &replay) != 0) {
+            perror("Erro ao criar a thread");
+            break;
+        }
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    print_report(&replay, now_us() - replay.start_us);
+
+    freeaddrinfo(replay.address);
+    free(threads);
+    free(replay.latencies_us);
+    free(replay.statuses);
+    capture_trace_free(&trace);
+    return started > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}